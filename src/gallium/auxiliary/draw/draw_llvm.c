@@ -1408,7 +1408,8 @@ static void
 draw_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_base,
                          struct lp_build_tgsi_context * bld_base,
                          LLVMValueRef (*outputs)[4],
-                         LLVMValueRef emitted_vertices_vec)
+                         LLVMValueRef emitted_vertices_vec,
+                         unsigned stream)
 {
    const struct draw_gs_llvm_iface *gs_iface = draw_gs_llvm_iface(gs_base);
    struct draw_gs_llvm_variant *variant = gs_iface->variant;
@@ -1442,7 +1443,8 @@ static void
 draw_gs_llvm_end_primitive(const struct lp_build_tgsi_gs_iface *gs_base,
                            struct lp_build_tgsi_context * bld_base,
                            LLVMValueRef verts_per_prim_vec,
-                           LLVMValueRef emitted_prims_vec)
+                           LLVMValueRef emitted_prims_vec,
+                           unsigned stream)
 {
    const struct draw_gs_llvm_iface *gs_iface = draw_gs_llvm_iface(gs_base);
    struct draw_gs_llvm_variant *variant = gs_iface->variant;
@@ -2073,3 +2073,91 @@ lp_build_sample_offset(struct lp_build_context *bld,
 
    *out_offset = offset;
 }
+
+
+/**
+ * Compute the offset of a pixel block in a tiled texture.
+ *
+ * Same as lp_build_sample_offset, but for the LP_TILE_* layout.  The tiled
+ * offset is separable in x and y, so each coordinate only needs a few
+ * shifts and masks.  Requires power of two block sizes of at most
+ * LP_TILE_COLUMN_BYTES.
+ */
+void
+lp_build_sample_tiled_offset(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef z,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef z_stride,
+                             LLVMValueRef *out_offset,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   const unsigned block_bytes = format_desc->block.bits/8;
+   const unsigned column_shift = util_logbase2(LP_TILE_COLUMN_BYTES);
+   const unsigned tile_width_shift = util_logbase2(LP_TILE_WIDTH_BYTES);
+   const unsigned tile_height_shift = util_logbase2(LP_TILE_HEIGHT);
+   LLVMValueRef x_bytes, x_offset, column, offset;
+
+   assert(util_is_power_of_two(block_bytes));
+   assert(block_bytes <= LP_TILE_COLUMN_BYTES);
+
+   lp_build_sample_partial_offset(bld,
+                                  format_desc->block.width,
+                                  x, bld->one,
+                                  &x, out_i);
+
+   /* byte within column, then column within tile, then tile */
+   x_bytes = lp_build_shl_imm(bld, x, util_logbase2(block_bytes));
+   x_offset = lp_build_and(bld, x_bytes,
+                           lp_build_const_int_vec(gallivm, bld->type,
+                                                  LP_TILE_COLUMN_BYTES - 1));
+   column = lp_build_and(bld, x_bytes,
+                         lp_build_const_int_vec(gallivm, bld->type,
+                                                LP_TILE_WIDTH_BYTES -
+                                                LP_TILE_COLUMN_BYTES));
+   column = lp_build_shl_imm(bld, column, tile_height_shift);
+   x_offset = lp_build_or(bld, x_offset, column);
+   x_bytes = lp_build_shr_imm(bld, x_bytes, tile_width_shift);
+   x_bytes = lp_build_shl_imm(bld, x_bytes,
+                              tile_width_shift + tile_height_shift);
+   offset = lp_build_or(bld, x_offset, x_bytes);
+
+   if (y && y_stride) {
+      LLVMValueRef y_offset, row;
+
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.height,
+                                     y, bld->one,
+                                     &y, out_j);
+
+      /* row within tile, then row of tiles */
+      row = lp_build_and(bld, y,
+                         lp_build_const_int_vec(gallivm, bld->type,
+                                                LP_TILE_HEIGHT - 1));
+      row = lp_build_shl_imm(bld, row, column_shift);
+      y = lp_build_shr_imm(bld, y, tile_height_shift);
+      y_offset = lp_build_mul(bld, y,
+                              lp_build_shl_imm(bld, y_stride,
+                                               tile_height_shift));
+      offset = lp_build_add(bld, offset, lp_build_add(bld, y_offset, row));
+   }
+   else {
+      *out_j = bld->zero;
+   }
+
+   if (z && z_stride) {
+      LLVMValueRef z_offset;
+      LLVMValueRef k;
+      lp_build_sample_partial_offset(bld,
+                                     1, /* pixel blocks are always 2D */
+                                     z, z_stride,
+                                     &z_offset, &k);
+      offset = lp_build_add(bld, offset, z_offset);
+   }
+
+   *out_offset = offset;
+}
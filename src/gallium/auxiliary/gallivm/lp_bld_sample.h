@@ -131,9 +131,24 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< texels stored in LP_TILE_* Y-major tiles */
 };
 
 
+/**
+ * Layout of textures with lp_static_texture_state::tiled set.
+ *
+ * Each mip level and slice is divided in 4KB tiles of 32 rows of 128 bytes,
+ * stored row of tiles after row of tiles.  Inside a tile, texels are stored
+ * in 16 byte wide columns of 32 rows, so a texel and its neighbours above
+ * and below usually share a cache line.  Row strides are multiples of the
+ * tile width and image strides multiples of the tile size.
+ */
+#define LP_TILE_WIDTH_BYTES   128
+#define LP_TILE_HEIGHT        32
+#define LP_TILE_COLUMN_BYTES  16
+
+
 /**
  * Sampler static state.
  *
@@ -572,6 +587,19 @@ lp_build_sample_offset(struct lp_build_context *bld,
                        LLVMValueRef *out_j);
 
 
+void
+lp_build_sample_tiled_offset(struct lp_build_context *bld,
+                             const struct util_format_description *format_desc,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef z,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef z_stride,
+                             LLVMValueRef *out_offset,
+                             LLVMValueRef *out_i,
+                             LLVMValueRef *out_j);
+
+
 void
 lp_build_sample_soa(const struct lp_static_texture_state *static_texture_state,
                     const struct lp_static_sampler_state *static_sampler_state,
@@ -420,11 +420,13 @@ struct lp_build_tgsi_gs_iface
    void (*emit_vertex)(const struct lp_build_tgsi_gs_iface *gs_iface,
                        struct lp_build_tgsi_context * bld_base,
                        LLVMValueRef (*outputs)[4],
-                       LLVMValueRef emitted_vertices_vec);
+                       LLVMValueRef emitted_vertices_vec,
+                       unsigned stream);
    void (*end_primitive)(const struct lp_build_tgsi_gs_iface *gs_iface,
                          struct lp_build_tgsi_context * bld_base,
                          LLVMValueRef verts_per_prim_vec,
-                         LLVMValueRef emitted_prims_vec);
+                         LLVMValueRef emitted_prims_vec,
+                         unsigned stream);
    void (*gs_epilogue)(const struct lp_build_tgsi_gs_iface *gs_iface,
                        struct lp_build_tgsi_context * bld_base,
                        LLVMValueRef total_emitted_vertices_vec,
@@ -3414,6 +3414,30 @@ clamp_mask_to_max_output_vertices(struct lp_build_tgsi_soa_context * bld,
    return LLVMBuildAnd(builder, current_mask_vec, max_mask, "");
 }
 
+/**
+ * Returns the vertex stream operand of EMIT/ENDPRIM, which is always an
+ * immediate.
+ */
+static unsigned
+get_gs_stream(struct lp_build_tgsi_soa_context * bld,
+              const struct tgsi_full_instruction *inst)
+{
+   struct gallivm_state *gallivm = bld->bld_base.base.gallivm;
+   const struct tgsi_src_register *reg = &inst->Src[0].Register;
+   LLVMValueRef imm;
+
+   assert(reg->File == TGSI_FILE_IMMEDIATE);
+   /* With indirectly addressed immediates the values only live in
+    * imms_array, so they can't be read back here. */
+   if (reg->File != TGSI_FILE_IMMEDIATE || bld->use_immediates_array)
+      return 0;
+
+   imm = LLVMConstBitCast(bld->immediates[reg->Index][reg->SwizzleX],
+                          bld->bld_base.uint_bld.vec_type);
+   imm = LLVMConstExtractElement(imm, lp_build_const_int32(gallivm, 0));
+   return LLVMConstIntGetZExtValue(imm) & 0x3;
+}
+
 static void
 emit_vertex(
    const struct lp_build_tgsi_action * action,
@@ -3432,7 +3456,8 @@ emit_vertex(
       gather_outputs(bld);
       bld->gs_iface->emit_vertex(bld->gs_iface, &bld->bld_base,
                                  bld->outputs,
-                                 total_emitted_vertices_vec);
+                                 total_emitted_vertices_vec,
+                                 get_gs_stream(bld, emit_data->inst));
       increment_vec_ptr_by_mask(bld_base, bld->emitted_vertices_vec_ptr,
                                 mask);
       increment_vec_ptr_by_mask(bld_base, bld->total_emitted_vertices_vec_ptr,
@@ -3451,7 +3476,8 @@ emit_vertex(
 
 static void
 end_primitive_masked(struct lp_build_tgsi_context * bld_base,
-                     LLVMValueRef mask)
+                     LLVMValueRef mask,
+                     unsigned stream)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    LLVMBuilderRef builder = bld->bld_base.base.gallivm->builder;
@@ -3474,7 +3500,8 @@ end_primitive_masked(struct lp_build_tgsi_context * bld_base,
 
       bld->gs_iface->end_primitive(bld->gs_iface, &bld->bld_base,
                                    emitted_vertices_vec,
-                                   emitted_prims_vec);
+                                   emitted_prims_vec,
+                                   stream);
 
 #if DUMP_GS_EMITS
       lp_build_print_value(bld->bld_base.base.gallivm,
@@ -3512,7 +3539,8 @@ end_primitive(
 
    if (bld->gs_iface->end_primitive) {
       LLVMValueRef mask = mask_vec(bld_base);
-      end_primitive_masked(bld_base, mask);
+      end_primitive_masked(bld_base, mask,
+                           get_gs_stream(bld, emit_data->inst));
    }
 }
 
@@ -3831,7 +3859,7 @@ static void emit_epilogue(struct lp_build_tgsi_context * bld_base)
       /* implicit end_primitives, needed in case there are any unflushed
          vertices in the cache. Note must not call end_primitive here
          since the exec_mask is not valid at this point. */
-      end_primitive_masked(bld_base, lp_build_mask_value(bld->mask));
+      end_primitive_masked(bld_base, lp_build_mask_value(bld->mask), 0);
       
       total_emitted_vertices_vec =
          LLVMBuildLoad(builder, bld->total_emitted_vertices_vec_ptr, "");
@@ -74,6 +74,7 @@
 
 typedef void			VOID;
 typedef void*           LPVOID;
+typedef void*           PVOID;
 typedef CARD8			BOOL;
 typedef wchar_t			WCHAR;
 typedef uint16_t		UINT16;
@@ -170,6 +171,7 @@ unsigned int _mm_popcnt_u32(unsigned int v)
 
 #define _aligned_free free
 #define InterlockedCompareExchange(Dest, Exchange, Comparand) __sync_val_compare_and_swap(Dest, Comparand, Exchange)
+#define InterlockedCompareExchangePointer(Dest, Exchange, Comparand) __sync_val_compare_and_swap(Dest, Comparand, Exchange)
 #define InterlockedExchangeAdd(Addend, Value) __sync_fetch_and_add(Addend, Value)
 #define InterlockedDecrement(Append) __sync_sub_and_fetch(Append, 1)
 #define _ReadWriteBarrier() asm volatile("" ::: "memory")
@@ -40,6 +40,10 @@ void BucketManager::RegisterThread(const std::string& name)
     newThread.root.id = 0;
     newThread.root.pParent = nullptr;
     newThread.pCurrent = &newThread.root;
+    if (mTraceEvents && !mThreadViz)
+    {
+        newThread.trace.resize(mTraceEvents);
+    }
 
     mThreadMutex.lock();
 
@@ -162,6 +166,64 @@ void BucketManager::DumpThreadViz()
     fclose(f);
 }
 
+void BucketManager::DumpChromeTrace(const std::string& filename)
+{
+    if (!IsTracing())
+    {
+        return;
+    }
+
+    // derive the rdtsc rate from the time elapsed since capture started
+    uint64_t endTsc = __rdtsc();
+    double elapsedUs = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - mCaptureStartTime).count();
+    double ticksPerUs = (elapsedUs > 0.0) ? (double)(endTsc - mCaptureStartTsc) / elapsedUs : 1.0;
+
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == nullptr)
+    {
+        return;
+    }
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    mThreadMutex.lock();
+    bool first = true;
+    for (const BUCKET_THREAD& thread : mThreads)
+    {
+        // name the thread's lane
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            first ? "" : ",\n", thread.id, thread.name.c_str(), thread.id);
+        first = false;
+
+        // oldest event first, the ring only keeps the most recent ones
+        uint64_t numEvents = std::min<uint64_t>(thread.numTraceEvents, mTraceEvents);
+        for (uint64_t i = thread.numTraceEvents - numEvents; i < thread.numTraceEvents; ++i)
+        {
+            const TRACE_EVENT& event = thread.trace[i % mTraceEvents];
+            if (event.start < mCaptureStartTsc)
+            {
+                continue;
+            }
+
+            double ts = (double)(event.start - mCaptureStartTsc) / ticksPerUs;
+            double dur = (double)(event.end - event.start) / ticksPerUs;
+
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"swr\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"drawId\":%" PRIu64,
+                mBuckets[event.bucketId].name.c_str(), thread.id, ts, dur, event.drawId);
+            if (event.macroTile != TRACE_NO_MACROTILE)
+            {
+                fprintf(f, ",\"macroTile\":%u", event.macroTile);
+            }
+            fprintf(f, "}}");
+        }
+    }
+    mThreadMutex.unlock();
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+}
+
 void BucketManager::PrintReport(const std::string& filename)
 {
     if (mThreadViz)
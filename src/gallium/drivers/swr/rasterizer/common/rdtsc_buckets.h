@@ -32,6 +32,7 @@
 #include "os.h"
 #include <vector>
 #include <mutex>
+#include <chrono>
 
 #include "rdtsc_buckets_shared.h"
 
@@ -46,7 +47,10 @@ extern THREAD UINT tlsThreadId;
 class BucketManager
 {
 public:
-    BucketManager(bool enableThreadViz) : mThreadViz(enableThreadViz) {}
+    /// @param enableThreadViz - dump threadviz data instead of building reports
+    /// @param traceEvents - per thread ring size for trace export, 0 disables tracing
+    BucketManager(bool enableThreadViz, uint32_t traceEvents = 0) :
+        mThreadViz(enableThreadViz), mTraceEvents(traceEvents) {}
 
     // removes all registered thread data
     void ClearThreads()
@@ -78,9 +82,28 @@ public:
     // print report
     void PrintReport(const std::string& filename);
 
+    /// Writes the recorded trace events in Chrome JSON trace format, which
+    /// chrome://tracing and Perfetto load. One lane per registered thread.
+    /// @param filename - output file
+    void DumpChromeTrace(const std::string& filename);
+
+    // is trace recording enabled
+    INLINE bool IsTracing() const
+    {
+        return mTraceEvents != 0 && !mThreadViz;
+    }
+
+    // is a capture in progress
+    INLINE bool IsCapturing() const
+    {
+        return mCapturing;
+    }
+
     // start capturing
     INLINE void StartCapture()
     {
+        mCaptureStartTsc = __rdtsc();
+        mCaptureStartTime = std::chrono::steady_clock::now();
         mCapturing = true;
     }
 
@@ -143,8 +166,20 @@ public:
         bt.level++;
     }
 
+    // set the draw and macrotile the calling thread works on, recorded with trace events
+    INLINE void SetTraceContext(uint64_t drawId, uint32_t macroTile)
+    {
+        if (!mCapturing) return;
+
+        SWR_ASSERT(tlsThreadId < mThreads.size());
+        BUCKET_THREAD &bt = mThreads[tlsThreadId];
+        bt.traceDrawId = drawId;
+        bt.traceMacroTile = macroTile;
+    }
+
     // stop the currently executing bucket
-    INLINE void StopBucket(UINT id)
+    // @param drawId - draw the bucket worked on, 0 to use the thread's trace context
+    INLINE void StopBucket(UINT id, uint64_t drawId = 0)
     {
         SWR_ASSERT(tlsThreadId < mThreads.size());
         BUCKET_THREAD &bt = mThreads[tlsThreadId];
@@ -165,9 +200,20 @@ public:
             if (bt.pCurrent->start == 0) return;
             SWR_ASSERT(bt.pCurrent->id == id, "Mismatched buckets detected");
 
-            bt.pCurrent->elapsed += (__rdtsc() - bt.pCurrent->start);
+            uint64_t end = __rdtsc();
+            bt.pCurrent->elapsed += (end - bt.pCurrent->start);
             bt.pCurrent->count++;
 
+            if (mTraceEvents)
+            {
+                TRACE_EVENT& event = bt.trace[bt.numTraceEvents++ % mTraceEvents];
+                event.bucketId = id;
+                event.macroTile = bt.traceMacroTile;
+                event.drawId = drawId ? drawId : bt.traceDrawId;
+                event.start = bt.pCurrent->start;
+                event.end = end;
+            }
+
             // pop to parent
             bt.pCurrent = bt.pCurrent->pParent;
         }
@@ -214,4 +260,11 @@ private:
 
     // enable threadviz
     bool mThreadViz{ false };
+
+    // per thread trace ring size, 0 if tracing is disabled
+    uint32_t mTraceEvents{ 0 };
+
+    // reference points to convert rdtsc to wall clock time for traces
+    uint64_t mCaptureStartTsc{ 0 };
+    std::chrono::steady_clock::time_point mCaptureStartTime;
 };
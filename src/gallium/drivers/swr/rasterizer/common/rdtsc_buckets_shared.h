@@ -58,6 +58,18 @@ struct BUCKET_DESC
     uint32_t color;
 };
 
+// one completed bucket invocation, recorded for trace export
+struct TRACE_EVENT
+{
+    uint32_t bucketId;
+    uint32_t macroTile;     // TRACE_NO_MACROTILE if not working on a macrotile
+    uint64_t drawId;
+    uint64_t start;
+    uint64_t end;
+};
+
+static const uint32_t TRACE_NO_MACROTILE = 0xffffffff;
+
 struct BUCKET_THREAD
 {
     // name of thread, used in reports
@@ -78,6 +90,14 @@ struct BUCKET_THREAD
     // threadviz file object
     FILE* vizFile{ nullptr };
 
+    // ring of the most recent trace events, and total number recorded
+    std::vector<TRACE_EVENT> trace;
+    uint64_t numTraceEvents{ 0 };
+
+    // draw and macrotile the thread is currently working on
+    uint64_t traceDrawId{ 0 };
+    uint32_t traceMacroTile{ TRACE_NO_MACROTILE };
+
     BUCKET_THREAD() {}
     BUCKET_THREAD(const BUCKET_THREAD& that)
     {
@@ -86,6 +106,8 @@ struct BUCKET_THREAD
         root = that.root;
         pCurrent = &root;
         vizFile = that.vizFile;
+        trace = that.trace;
+        numTraceEvents = that.numTraceEvents;
     }
 };
 
@@ -305,6 +305,7 @@ int _simdemu_movemask_epi8(__m256i a)
 #define _simd_setzero_si _mm256_setzero_si256
 #define _simd_cvttps_epi32 _mm256_cvttps_epi32
 #define _simd_store_si _mm256_store_si256
+#define _simd_storeu_si _mm256_storeu_si256
 #define _simd_broadcast_ss _mm256_broadcast_ss
 #define _simd_maskstore_ps _mm256_maskstore_ps
 #define _simd_load_si _mm256_load_si256
@@ -27,11 +27,13 @@
 ******************************************************************************/
 
 #include <cfloat>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 
 #include "core/api.h"
 #include "core/backend.h"
+#include "core/capture.h"
 #include "core/context.h"
 #include "core/frontend.h"
 #include "core/rasterizer.h"
@@ -45,6 +47,9 @@
 
 void SetupDefaultState(SWR_CONTEXT *pContext);
 
+// Size of the per worker scratch space used for compute shader TGSM.
+static const uint32_t WORKER_SCRATCH_SIZE = 32 * 1024;
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Create SWR Context.
 /// @param pCreateInfo - pointer to creation info.
@@ -67,23 +72,20 @@ HANDLE SwrCreateContext(
     pContext->dsRing = (DRAW_STATE*)_aligned_malloc(sizeof(DRAW_STATE)*KNOB_MAX_DRAWS_IN_FLIGHT, 64);
     memset(pContext->dsRing, 0, sizeof(DRAW_STATE)*KNOB_MAX_DRAWS_IN_FLIGHT);
 
+    // Ring slots are kept light so the ring can be deep: arenas draw from a shared
+    // block cache and tile/dispatch queues are created when a slot is first used.
+    pContext->pArenaBlockCache = new ArenaBlockCache();
     for (uint32_t dc = 0; dc < KNOB_MAX_DRAWS_IN_FLIGHT; ++dc)
     {
-        pContext->dcRing[dc].arena.Init();
+        pContext->dcRing[dc].arena.Init(pContext->pArenaBlockCache);
         pContext->dcRing[dc].inUse = false;
-        pContext->dcRing[dc].pTileMgr = new MacroTileMgr(pContext->dcRing[dc].arena);
-        pContext->dcRing[dc].pDispatch = new DispatchQueue(); /// @todo Could lazily allocate this if Dispatch seen.
 
-        pContext->dsRing[dc].arena.Init();
+        pContext->dsRing[dc].arena.Init(pContext->pArenaBlockCache);
     }
+    pContext->ringStats.RingSize = KNOB_MAX_DRAWS_IN_FLIGHT;
 
     if (!KNOB_SINGLE_THREADED)
     {
-        memset(&pContext->WaitLock, 0, sizeof(pContext->WaitLock));
-        memset(&pContext->FifosNotEmpty, 0, sizeof(pContext->FifosNotEmpty));
-        new (&pContext->WaitLock) std::mutex();
-        new (&pContext->FifosNotEmpty) std::condition_variable();
-
         CreateThreadPool(pContext, &pContext->threadPool);
     }
 
@@ -93,12 +95,12 @@ HANDLE SwrCreateContext(
         pContext->NumWorkerThreads = 1;
     }
 
-    // Allocate scratch space for workers.
+    // Allocate scratch space for workers on their NUMA node.
     ///@note We could lazily allocate this but its rather small amount of memory.
     for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
     {
-        ///@todo Use numa API for allocations using numa information from thread data (if exists).
-        pContext->pScratch[i] = (uint8_t*)_aligned_malloc((32 * 1024), KNOB_SIMD_WIDTH * 4);
+        uint32_t numaNode = KNOB_SINGLE_THREADED ? 0 : pContext->threadPool.pThreadData[i].numaId;
+        pContext->pScratch[i] = (uint8_t*)AllocNumaMemory(WORKER_SCRATCH_SIZE, GetOsNumaNode(&pContext->threadPool, numaNode));
     }
 
     pContext->LastRetiredId = 0;
@@ -118,6 +120,12 @@ HANDLE SwrCreateContext(
 
     // initialize hot tile manager
     pContext->pHotTileMgr = new HotTileMgr();
+    pContext->pDirtyTiles = new MacroTileMask[SWR_NUM_ATTACHMENTS];
+    pContext->pValidTiles = new MacroTileMask[SWR_NUM_ATTACHMENTS];
+    for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; ++i)
+    {
+        pContext->lastStoreRect[i] = BBOX(0, -1, 0, -1);
+    }
 
     // initialize function pointer tables
     InitClearTilesTable();
@@ -127,14 +135,25 @@ HANDLE SwrCreateContext(
     pContext->pfnStoreTile = pCreateInfo->pfnStoreTile;
     pContext->pfnClearTile = pCreateInfo->pfnClearTile;
 
+    CaptureCreateContext(pContext, pCreateInfo);
+
     return (HANDLE)pContext;
 }
 
+void FlushDrawBatch(SWR_CONTEXT *pContext);
+
 void SwrDestroyContext(HANDLE hContext)
 {
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    FlushDrawBatch(pContext);
     DestroyThreadPool(pContext, &pContext->threadPool);
 
+    if (pContext->pCapture)
+    {
+        CaptureDestroyContext(pContext);
+    }
+    RDTSC_SHUTDOWN();
+
     // free the fifos
     for (uint32_t i = 0; i < KNOB_MAX_DRAWS_IN_FLIGHT; ++i)
     {
@@ -144,26 +163,29 @@ void SwrDestroyContext(HANDLE hContext)
         delete(pContext->dcRing[i].pDispatch);
     }
 
-    // Free scratch space.
+    // Free scratch and spill fill space.
     for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
     {
-        _aligned_free(pContext->pScratch[i]);
+        FreeNumaMemory(pContext->pScratch[i], WORKER_SCRATCH_SIZE);
+
+        if (pContext->pSpillFill[i] != nullptr)
+        {
+            FreeNumaMemory(pContext->pSpillFill[i], pContext->spillFillSize[i]);
+        }
     }
 
     _aligned_free(pContext->dcRing);
     _aligned_free(pContext->dsRing);
+    delete(pContext->pArenaBlockCache);
 
     delete(pContext->pHotTileMgr);
+    delete[](pContext->pDirtyTiles);
+    delete[](pContext->pValidTiles);
 
     pContext->~SWR_CONTEXT();
     _aligned_free((SWR_CONTEXT*)hContext);
 }
 
-void WakeAllThreads(SWR_CONTEXT *pContext)
-{
-    pContext->FifosNotEmpty.notify_all();
-}
-
 bool StillDrawing(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
 {
     // For single thread nothing should still be drawing.
@@ -181,17 +203,18 @@ bool StillDrawing(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
     // Check if backend work is done. First make sure all triangles have been binned.
     if (pDC->doneFE == true)
     {
+        bool isWorkComplete = pDC->isCompute ? pDC->doneCompute : pDC->pTileMgr->isWorkComplete();
+
         // ensure workers have all moved passed this draw
         for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
         {
-            if (pContext->WorkerFE[i] <= pDC->drawId)
+            if ((pContext->WorkerFE[i] <= pDC->drawId) || (pContext->WorkerBE[i] <= pDC->drawId))
             {
-                return true;
-            }
-
-            if (pContext->WorkerBE[i] <= pDC->drawId)
-            {
-                return true;
+                // Parked workers aren't woken for every draw, pass them through completed draws.
+                if (!isWorkComplete || !PassParkedWorker(pContext, i, pDC->drawId))
+                {
+                    return true;
+                }
             }
         }
 
@@ -201,6 +224,43 @@ bool StillDrawing(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
     return pDC->inUse;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Releases the arenas of DS ring entries that no draw in flight
+///        references. The newest entry is kept, as later draws share it.
+/// @param pContext - pointer to SWR context.
+static void ReleaseRetiredDrawStates(SWR_CONTEXT *pContext)
+{
+    while ((uint32_t)(pContext->curStateId - pContext->dsReleaseId) > 1)
+    {
+        DRAW_STATE* pState = &pContext->dsRing[pContext->dsReleaseId % KNOB_MAX_DRAWS_IN_FLIGHT];
+        if (pState->lastDrawId > pContext->LastRetiredId)
+        {
+            break;
+        }
+
+        pState->arena.Reset();
+        pState->pPrivateState = nullptr;
+        pContext->dsReleaseId++;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Takes the next entry of the DS ring for a new draw state.
+/// @param pContext - pointer to SWR context.
+static DRAW_STATE* NextDrawState(SWR_CONTEXT *pContext)
+{
+    // The entry is reset below, so the release cursor can't be left pointing at it.
+    if ((uint32_t)(pContext->curStateId - pContext->dsReleaseId) >= KNOB_MAX_DRAWS_IN_FLIGHT)
+    {
+        pContext->dsReleaseId = pContext->curStateId - KNOB_MAX_DRAWS_IN_FLIGHT + 1;
+    }
+
+    uint32_t dsIndex = pContext->curStateId % KNOB_MAX_DRAWS_IN_FLIGHT;
+    pContext->curStateId++;  // Progress state ring index forward.
+
+    return &pContext->dsRing[dsIndex];
+}
+
 void UpdateLastRetiredId(SWR_CONTEXT *pContext)
 {
     uint64_t head = pContext->LastRetiredId + 1;
@@ -213,15 +273,24 @@ void UpdateLastRetiredId(SWR_CONTEXT *pContext)
     if ((tail - head) > KNOB_MAX_DRAWS_IN_FLIGHT - 1)
     {
         head = tail - KNOB_MAX_DRAWS_IN_FLIGHT + 1;
+
+        // Their entries were reused, so those draws are retired.
+        pContext->LastRetiredId = head - 1;
     }
 
     DRAW_CONTEXT *pDC = &pContext->dcRing[head % KNOB_MAX_DRAWS_IN_FLIGHT];
     while ((head < tail) && !StillDrawing(pContext, pDC))
     {
         pContext->LastRetiredId = pDC->drawId;
+
+        // Workers have moved past the draw, hand its memory back right away.
+        pDC->arena.Reset();
+
         head++;
         pDC = &pContext->dcRing[head % KNOB_MAX_DRAWS_IN_FLIGHT];
     }
+
+    ReleaseRetiredDrawStates(pContext);
 }
 
 void WaitForDependencies(SWR_CONTEXT *pContext, uint64_t drawId)
@@ -243,11 +312,11 @@ void CopyState(DRAW_STATE& dst, const DRAW_STATE& src)
 
 void QueueDraw(SWR_CONTEXT *pContext)
 {
+    // An open batch holds an older drawId, so it has to go first.
+    FlushDrawBatch(pContext);
+
     _ReadWriteBarrier();
-    {
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
-        pContext->DrawEnqueued ++;
-    }
+    pContext->DrawEnqueued++;
 
     if (KNOB_SINGLE_THREADED)
     {
@@ -257,16 +326,16 @@ void QueueDraw(SWR_CONTEXT *pContext)
 
         std::unordered_set<uint32_t> lockedTiles;
         WorkOnFifoFE(pContext, 0, pContext->WorkerFE[0], 0);
-        WorkOnFifoBE(pContext, 0, pContext->WorkerBE[0], lockedTiles);
+        WorkOnFifoBE(pContext, 0, pContext->WorkerBE[0], lockedTiles, 0, 0);
 
         // restore csr
         _mm_setcsr(mxcsr);
     }
     else
     {
-        RDTSC_START(APIDrawWakeAllThreads);
-        WakeAllThreads(pContext);
-        RDTSC_STOP(APIDrawWakeAllThreads, 1, 0);
+        RDTSC_START(APIDrawWakeThreads);
+        WakeThreads(pContext, pContext->pCurDrawContext);
+        RDTSC_STOP(APIDrawWakeThreads, 0, 0);
     }
 
     // Set current draw context to NULL so that next state call forces a new draw context to be created and populated.
@@ -277,11 +346,10 @@ void QueueDraw(SWR_CONTEXT *pContext)
 ///@todo Combine this with QueueDraw
 void QueueDispatch(SWR_CONTEXT *pContext)
 {
+    FlushDrawBatch(pContext);
+
     _ReadWriteBarrier();
-    {
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
-        pContext->DrawEnqueued++;
-    }
+    pContext->DrawEnqueued++;
 
     if (KNOB_SINGLE_THREADED)
     {
@@ -289,16 +357,16 @@ void QueueDispatch(SWR_CONTEXT *pContext)
         uint32_t mxcsr = _mm_getcsr();
         _mm_setcsr(mxcsr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
 
-        WorkOnCompute(pContext, 0, pContext->WorkerBE[0]);
+        WorkOnCompute(pContext, 0, pContext->WorkerBE[0], 0);
 
         // restore csr
         _mm_setcsr(mxcsr);
     }
     else
     {
-        RDTSC_START(APIDrawWakeAllThreads);
-        WakeAllThreads(pContext);
-        RDTSC_STOP(APIDrawWakeAllThreads, 1, 0);
+        RDTSC_START(APIDrawWakeThreads);
+        WakeThreads(pContext, pContext->pCurDrawContext);
+        RDTSC_STOP(APIDrawWakeThreads, 0, 0);
     }
 
     // Set current draw context to NULL so that next state call forces a new draw context to be created and populated.
@@ -320,55 +388,54 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
         // Update LastRetiredId
         UpdateLastRetiredId(pContext);
 
-        // Need to wait until this draw context is available to use.
-        while (StillDrawing(pContext, pCurDrawContext))
+        // Need to wait until this draw context is available to use. Parked workers are
+        // passed through draws in retirement order, so keep retiring while waiting.
+        if (StillDrawing(pContext, pCurDrawContext))
         {
-            _mm_pause();
-        }
+            uint64_t stallStart = __rdtsc();
+            do
+            {
+                _mm_pause();
+                UpdateLastRetiredId(pContext);
+            } while (StillDrawing(pContext, pCurDrawContext));
 
-        // Assign next available entry in DS ring to this DC.
-        uint32_t dsIndex = pContext->curStateId % KNOB_MAX_DRAWS_IN_FLIGHT;
-        pCurDrawContext->pState = &pContext->dsRing[dsIndex];
+            pContext->ringStats.StallCount++;
+            pContext->ringStats.StallTicks += __rdtsc() - stallStart;
+        }
 
-        Arena& stateArena = pCurDrawContext->pState->arena;
+        uint32_t numInFlight = (uint32_t)(pContext->nextDrawId - pContext->LastRetiredId - 1);
+        pContext->ringStats.DrawContexts++;
+        pContext->ringStats.InFlightSum += numInFlight;
+        pContext->ringStats.MaxInFlight = std::max(pContext->ringStats.MaxInFlight, numInFlight);
 
-        // Copy previous state to current state.
-        if (pContext->pPrevDrawContext)
+        if (pCurDrawContext->pTileMgr == nullptr)
         {
-            DRAW_CONTEXT* pPrevDrawContext = pContext->pPrevDrawContext;
-
-            // If we're splitting our draw then we can just use the same state from the previous
-            // draw. In this case, we won't increment the DS ring index so the next non-split
-            // draw can receive the state.
-            if (isSplitDraw == false)
-            {
-                CopyState(*pCurDrawContext->pState, *pPrevDrawContext->pState);
-
-                stateArena.Reset();    // Reset memory.
-
-                // Copy private state to new context.
-                if (pPrevDrawContext->pState->pPrivateState != nullptr)
-                {
-                    pCurDrawContext->pState->pPrivateState = stateArena.AllocAligned(pContext->privateStateSize, KNOB_SIMD_WIDTH*sizeof(float));
-                    memcpy(pCurDrawContext->pState->pPrivateState, pPrevDrawContext->pState->pPrivateState, pContext->privateStateSize);
-                }
+            pCurDrawContext->pTileMgr = new MacroTileMgr(pCurDrawContext->arena);
+        }
 
-                pContext->curStateId++;  // Progress state ring index forward.
-            }
-            else
-            {
-                // If its a split draw then just copy the state pointer over
-                // since its the same draw.
-                pCurDrawContext->pState = pPrevDrawContext->pState;
-            }
+        // Reference the previous state. It's copied on the first state call that modifies it
+        // (see GetDrawState), so draws that don't change state all share one DS ring entry.
+        // An open draw batch holds the latest state.
+        DRAW_CONTEXT* pPrevDrawContext = pContext->pBatchDrawContext ?
+            pContext->pBatchDrawContext : pContext->pPrevDrawContext;
+        if (pPrevDrawContext)
+        {
+            pCurDrawContext->pState = pPrevDrawContext->pState;
+            pCurDrawContext->sharedState = true;
         }
         else
         {
-            stateArena.Reset();    // Reset memory.
-            pContext->curStateId++;  // Progress state ring index forward.
+            SWR_ASSERT(isSplitDraw == false);
+
+            // Assign next available entry in DS ring to this DC.
+            pCurDrawContext->pState = NextDrawState(pContext);
+            pCurDrawContext->pState->arena.Reset();    // Reset memory.
+            pCurDrawContext->pState->pipelineValid = false;
+            pCurDrawContext->sharedState = false;
         }
 
         pCurDrawContext->dependency = 0;
+        pCurDrawContext->dependentFE = false;
         pCurDrawContext->arena.Reset();
         pCurDrawContext->pContext = pContext;
         pCurDrawContext->isCompute = false; // Dispatch has to set this to true.
@@ -382,6 +449,7 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
 
         // Assign unique drawId for this DC
         pCurDrawContext->drawId = pContext->nextDrawId++;
+        pCurDrawContext->pState->lastDrawId = pCurDrawContext->drawId;
     }
     else
     {
@@ -392,12 +460,72 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
     return pContext->pCurDrawContext;
 }
 
-API_STATE* GetDrawState(SWR_CONTEXT *pContext)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Queues the open draw batch, if any.
+/// @param pContext - pointer to SWR context.
+void FlushDrawBatch(SWR_CONTEXT *pContext)
+{
+    DRAW_CONTEXT* pBatchDC = pContext->pBatchDrawContext;
+    if (pBatchDC == nullptr)
+    {
+        return;
+    }
+
+    pContext->pBatchDrawContext = nullptr;
+
+    // Queue the batch without losing state already set on the current DC.
+    DRAW_CONTEXT* pCurDC = pContext->pCurDrawContext;
+    pContext->pCurDrawContext = pBatchDC;
+    QueueDraw(pContext);
+    pContext->pCurDrawContext = pCurDC;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the current draw state for modification. If it's still
+///        shared with earlier draws it is copied to the next DS ring entry
+///        first. Derived pipeline state is set up again for the copy.
+/// @param pContext - pointer to SWR context.
+DRAW_STATE* GetWritableDrawState(SWR_CONTEXT *pContext)
 {
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
     SWR_ASSERT(pDC->pState != nullptr);
 
-    return &pDC->pState->state;
+    if (pDC->sharedState)
+    {
+        const DRAW_STATE* pPrevState = pDC->pState;
+
+        // Assign next available entry in DS ring to this DC.
+        DRAW_STATE* pState = NextDrawState(pContext);
+        SWR_ASSERT(pState != pPrevState);
+
+        CopyState(*pState, *pPrevState);
+        pState->arena.Reset();    // Reset memory.
+        pState->pPrivateState = nullptr;
+
+        // Copy private state to new context.
+        if (pPrevState->pPrivateState != nullptr)
+        {
+            pState->pPrivateState = pState->arena.AllocAligned(pContext->privateStateSize, KNOB_SIMD_WIDTH*sizeof(float));
+            memcpy(pState->pPrivateState, pPrevState->pPrivateState, pContext->privateStateSize);
+        }
+
+        pState->pipelineValid = false;
+        pState->lastDrawId = pDC->drawId;
+
+        pDC->pState = pState;
+        pDC->sharedState = false;
+    }
+    else
+    {
+        pDC->pState->pipelineValid = false;
+    }
+
+    return pDC->pState;
+}
+
+API_STATE* GetDrawState(SWR_CONTEXT *pContext)
+{
+    return &GetWritableDrawState(pContext)->state;
 }
 
 void SetupDefaultState(SWR_CONTEXT *pContext)
@@ -420,6 +548,10 @@ void SwrSync(HANDLE hContext, PFN_CALLBACK_FUNC pfnFunc, uint64_t userData, uint
     SWR_ASSERT(pfnFunc != nullptr);
 
     SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        CaptureCall(pContext, SWR_CAPTURE_SYNC);
+    }
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
     pDC->inUse = true;
@@ -442,6 +574,12 @@ void SwrSync(HANDLE hContext, PFN_CALLBACK_FUNC pfnFunc, uint64_t userData, uint
 void SwrWaitForIdle(HANDLE hContext)
 {
     SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        CaptureCall(pContext, SWR_CAPTURE_WAIT_FOR_IDLE);
+    }
+
+    FlushDrawBatch(pContext);
 
     RDTSC_START(APIWaitForIdle);
     // Wait on the previous DrawContext's drawId, as this function doesn't queue anything.
@@ -524,6 +662,15 @@ void SwrSetVertexFunc(
     pState->pfnVertexFunc = pfnVertexFunc;
 }
 
+void SwrSetFetchVsFunc(
+    HANDLE hContext,
+    PFN_FETCH_VS_FUNC pfnFetchVsFunc)
+{
+    API_STATE* pState = GetDrawState(GetContext(hContext));
+
+    pState->pfnFetchVsFunc = pfnFetchVsFunc;
+}
+
 void SwrSetFrontendState(
     HANDLE hContext,
     SWR_FRONTEND_STATE *pFEState)
@@ -551,11 +698,13 @@ void SwrSetGsFunc(
 void SwrSetCsFunc(
     HANDLE hContext,
     PFN_CS_FUNC pfnCsFunc,
-    uint32_t totalThreadsInGroup)
+    uint32_t totalThreadsInGroup,
+    uint32_t totalSpillFillSize)
 {
     API_STATE* pState = GetDrawState(GetContext(hContext));
     pState->pfnCsFunc = pfnCsFunc;
     pState->totalThreadsInGroup = totalThreadsInGroup;
+    pState->totalSpillFillSize = totalSpillFillSize;
 }
 
 void SwrSetTsState(
@@ -844,6 +993,7 @@ void SetupPipeline(DRAW_CONTEXT *pDC)
     if ((pState->state.psState.pfnPixelShader == nullptr) &&
         (pState->state.depthStencilState.depthTestEnable == FALSE) &&
         (pState->state.depthStencilState.depthWriteEnable == FALSE) &&
+        (pState->state.depthStencilState.stencilTestEnable == FALSE) &&
         (pState->state.linkageCount == 0))
     {
         pState->pfnProcessPrims = nullptr;
@@ -874,30 +1024,107 @@ void InitDraw(
     DRAW_CONTEXT *pDC,
     bool isSplitDraw)
 {
-    // We don't need to re-setup the scissors/pipeline state again for split draw.
-    if (isSplitDraw == false)
+    // Scissors/pipeline state only need setting up once per state. Split draws and
+    // draws that didn't change state share it with an earlier draw.
+    SWR_ASSERT(isSplitDraw == false || pDC->pState->pipelineValid);
+    if (pDC->pState->pipelineValid == false)
     {
         SetupMacroTileScissors(pDC);
         SetupPipeline(pDC);
+        pDC->pState->pipelineValid = true;
     }
 
     pDC->inUse = true;    // We are using this one now.
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if a non-indexed draw can reserve its stream out
+///        ranges up front. This needs the number of prims streamed out to
+///        be known on the API thread, which rules out GS and tessellation.
+/// @param state - API state of the draw
+/// @param topology - Topology used for draw
+static bool CanReserveStreamOut(const API_STATE& state, PRIMITIVE_TOPOLOGY topology)
+{
+    if (!state.soState.soEnable || state.gsState.gsEnable || state.tsState.tsEnable)
+    {
+        return false;
+    }
+
+    switch (topology)
+    {
+    case TOP_POINT_LIST:
+    case TOP_LINE_LIST:
+    case TOP_LINE_STRIP:
+    case TOP_TRIANGLE_LIST:
+    case TOP_TRIANGLE_STRIP:
+    case TOP_TRIANGLE_FAN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Moves the SO buffer offsets of the following draws past the
+///        ranges reserved for a draw. Prims that don't fit in every buffer
+///        of the stream are dropped by the SOS, so the offsets only
+///        advance by the prims that fit.
+/// @param pContext - pointer to SWR context.
+/// @param soState - Stream out state of the draw
+/// @param soBuffer - SO buffers of the draw
+/// @param topology - Topology used for draw
+/// @param numPrims - Number of prims streamed out by the draw
+static void AdvanceStreamOutOffsets(
+    SWR_CONTEXT *pContext,
+    const SWR_STREAMOUT_STATE& soState,
+    const SWR_STREAMOUT_BUFFER (&soBuffer)[4],
+    PRIMITIVE_TOPOLOGY topology,
+    uint64_t numPrims)
+{
+    uint32_t vertsPerPrim = NumVertsPerPrim(topology, false);
+    uint32_t bufferMask = soState.bufferMasks[0];
+
+    uint64_t numPrimsWritten = numPrims;
+    DWORD b;
+    for (uint32_t mask = bufferMask; _BitScanForward(&b, mask); mask &= ~(1 << b))
+    {
+        uint32_t primSize = soBuffer[b].pitch * vertsPerPrim;
+        if (!soBuffer[b].enable || soBuffer[b].streamOffset > soBuffer[b].bufferSize)
+        {
+            numPrimsWritten = 0;
+        }
+        else if (primSize != 0)
+        {
+            numPrimsWritten = std::min<uint64_t>(numPrimsWritten,
+                (soBuffer[b].bufferSize - soBuffer[b].streamOffset) / primSize);
+        }
+    }
+
+    API_STATE* pState = GetDrawState(pContext);
+    for (uint32_t mask = bufferMask; _BitScanForward(&b, mask); mask &= ~(1 << b))
+    {
+        pState->soBuffer[b].streamOffset = soBuffer[b].streamOffset +
+            (uint32_t)numPrimsWritten * soBuffer[b].pitch * vertsPerPrim;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief We can split the draw for certain topologies for better performance.
 /// @param totalVerts - Total vertices for draw
 /// @param topology - Topology used for draw
+/// @param reserveStreamOut - Stream out ranges of the draw are reserved
 uint32_t MaxVertsPerDraw(
     DRAW_CONTEXT* pDC,
     uint32_t totalVerts,
-    PRIMITIVE_TOPOLOGY topology)
+    PRIMITIVE_TOPOLOGY topology,
+    bool reserveStreamOut = false)
 {
     API_STATE& state = pDC->pState->state;
 
     uint32_t vertsPerDraw = totalVerts;
 
-    if (state.soState.soEnable)
+    // Stream out appends in order unless each prim's range is reserved.
+    if (state.soState.soEnable && !reserveStreamOut)
     {
         return totalVerts;
     }
@@ -992,6 +1219,214 @@ static PFN_FE_WORK_FUNC GetFEDrawFunc(bool IsIndexed, bool HasTessellation, bool
     return FEDrawChooser<>::GetFunc(IsIndexed, HasTessellation, HasGeometryShader, HasStreamOut, RasterizerEnabled);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Sets the topology related draw state. The state is only copied
+///        if this changes it.
+/// @param pContext - pointer to SWR context.
+/// @param topology - Topology used for draw
+/// @return current draw state.
+API_STATE* SetDrawTopology(SWR_CONTEXT *pContext, PRIMITIVE_TOPOLOGY topology)
+{
+    API_STATE* pState = &GetDrawContext(pContext)->pState->state;
+
+    bool isPoints = (topology == TOP_POINT_LIST);
+    if (pState->topology != topology ||
+        pState->forceFront != isPoints ||
+        (isPoints && pState->rastState.cullMode != SWR_CULLMODE_NONE))
+    {
+        pState = GetDrawState(pContext);
+        pState->topology = topology;
+        pState->forceFront = isPoints;
+        if (isPoints)
+        {
+            pState->rastState.cullMode = SWR_CULLMODE_NONE;
+        }
+    }
+
+    return pState;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the size in bytes of an index of the given format.
+/// @param format - Index buffer format
+INLINE uint32_t GetIndexSize(SWR_FORMAT format)
+{
+    switch (format)
+    {
+    case R32_UINT: return sizeof(uint32_t);
+    case R16_UINT: return sizeof(uint16_t);
+    case R8_UINT: return sizeof(uint8_t);
+    default:
+        SWR_ASSERT(0);
+        return 0;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if a draw is small enough to be batched.
+/// @param topology - Topology used for draw
+/// @param numVerts - Vertices (or indices) per instance
+/// @param numInstances - Number of instances
+INLINE bool IsBatchableDraw(PRIMITIVE_TOPOLOGY topology, uint32_t numVerts, uint32_t numInstances)
+{
+    // Point lists override culling state per draw, so they aren't batched.
+    return KNOB_MAX_DRAWS_PER_BATCH > 1 &&
+        topology != TOP_POINT_LIST &&
+        numVerts > 0 &&
+        (uint64_t)numVerts * numInstances <= KNOB_MAX_BATCHED_DRAW_VERTS;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Turns the current DC, holding a single queued-to-be draw, into
+///        an open batch that following draws can be appended to.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - Draw context holding the draw.
+void OpenDrawBatch(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
+{
+    SWR_ASSERT(pContext->pBatchDrawContext == nullptr);
+    SWR_ASSERT(pContext->pCurDrawContext == pDC);
+
+    DRAW_WORK& work = pDC->FeWork.desc.draw;
+    DRAW_WORK* pSubDraws = (DRAW_WORK*)pDC->arena.AllocAligned(sizeof(DRAW_WORK) * KNOB_MAX_DRAWS_PER_BATCH, 64);
+    pSubDraws[0] = work;
+    work.pSubDraws = pSubDraws;
+    work.numSubDraws = 1;
+
+    pContext->pBatchDrawContext = pDC;
+    pContext->pCurDrawContext = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Appends a draw to the open batch if it shares all state with it.
+///        Otherwise the batch is queued.
+/// @param pContext - pointer to SWR context.
+/// @param topology - Topology used for draw
+/// @param isIndexed - Is this an indexed draw
+/// @param draw - Draw parameters
+/// @return true if the draw was merged into the batch.
+bool TryMergeDraw(SWR_CONTEXT *pContext, PRIMITIVE_TOPOLOGY topology, bool isIndexed, const DRAW_WORK& draw)
+{
+    DRAW_CONTEXT* pBatchDC = pContext->pBatchDrawContext;
+    if (pBatchDC == nullptr)
+    {
+        return false;
+    }
+
+    DRAW_WORK& batch = pBatchDC->FeWork.desc.draw;
+    const DRAW_STATE& batchState = *pBatchDC->pState;
+
+    bool canMerge = IsBatchableDraw(topology, draw.numVerts, draw.numInstances) &&
+        batch.numSubDraws < KNOB_MAX_DRAWS_PER_BATCH &&
+        batchState.state.topology == topology &&
+        pBatchDC->FeWork.pfnWork == GetFEDrawFunc(
+            isIndexed,
+            batchState.state.tsState.tsEnable,
+            batchState.state.gsState.gsEnable,
+            batchState.state.soState.soEnable,
+            batchState.pfnProcessPrims != nullptr);
+
+    // State calls made since the batch was opened went to a new DC. Merging is only
+    // possible if they left the state unchanged.
+    DRAW_CONTEXT* pDC = pContext->pCurDrawContext;
+    if (canMerge && pDC != nullptr && pDC->pState != pBatchDC->pState)
+    {
+        const DRAW_STATE& curState = *pDC->pState;
+        canMerge = memcmp(&curState.state, &batchState.state, sizeof(API_STATE)) == 0 &&
+            (curState.pPrivateState == batchState.pPrivateState ||
+             (curState.pPrivateState != nullptr && batchState.pPrivateState != nullptr &&
+              memcmp(curState.pPrivateState, batchState.pPrivateState, pContext->privateStateSize) == 0));
+    }
+
+    if (!canMerge)
+    {
+        FlushDrawBatch(pContext);
+        return false;
+    }
+
+    DRAW_WORK& subDraw = batch.pSubDraws[batch.numSubDraws++];
+    subDraw = draw;
+    subDraw.pDC = pBatchDC;
+
+    // The new DC is no longer needed, hand back its drawId and state slot.
+    if (pDC != nullptr)
+    {
+        pDC->inUse = false;
+        pContext->pCurDrawContext = nullptr;
+        pContext->nextDrawId--;
+        if (!pDC->sharedState)
+        {
+            pDC->pState->arena.Reset();
+            pDC->pState->pPrivateState = nullptr;
+            pContext->curStateId--;
+        }
+    }
+
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Marks the macrotiles within the scissor of the DC's state as
+///        dirty for the given attachments.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - Draw context, set up by InitDraw.
+/// @param attachmentMask - attachments rendered to.
+void MarkDirtyTiles(SWR_CONTEXT *pContext, const DRAW_CONTEXT *pDC, uint32_t attachmentMask)
+{
+    const BBOX& scissor = GetApiState(pDC).scissorInFixedPoint;
+    if (attachmentMask == 0 || scissor.right < 0 || scissor.bottom < 0)
+    {
+        return;
+    }
+
+    uint32_t left = std::max(scissor.left, 0) / KNOB_MACROTILE_X_DIM_FIXED;
+    uint32_t top = std::max(scissor.top, 0) / KNOB_MACROTILE_Y_DIM_FIXED;
+    uint32_t right = std::min<uint32_t>(scissor.right / KNOB_MACROTILE_X_DIM_FIXED, KNOB_NUM_HOT_TILES_X - 1);
+    uint32_t bottom = std::min<uint32_t>(scissor.bottom / KNOB_MACROTILE_Y_DIM_FIXED, KNOB_NUM_HOT_TILES_Y - 1);
+    if (left > right || top > bottom)
+    {
+        return;
+    }
+
+    DWORD attachment;
+    while (_BitScanForward(&attachment, attachmentMask))
+    {
+        attachmentMask &= ~(1 << attachment);
+        pContext->pDirtyTiles[attachment].set(left, top, right, bottom);
+        pContext->pValidTiles[attachment].set(left, top, right, bottom);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Marks the macrotiles a draw may render to as dirty. The
+///        attachments match the hot tiles the backend sets up for it.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - Draw context, set up by InitDraw.
+void MarkDrawDirtyTiles(SWR_CONTEXT *pContext, const DRAW_CONTEXT *pDC)
+{
+    if (pDC->pState->pfnProcessPrims == nullptr)
+    {
+        return;
+    }
+
+    const API_STATE& state = GetApiState(pDC);
+    uint32_t attachmentMask = 0;
+
+    if (state.psState.pfnPixelShader != nullptr)
+    {
+        attachmentMask |= ((1 << (state.psState.maxRTSlotUsed + 1)) - 1) << SWR_ATTACHMENT_COLOR0;
+    }
+    if (state.depthStencilState.depthTestEnable || state.depthStencilState.depthWriteEnable)
+    {
+        attachmentMask |= 1 << SWR_ATTACHMENT_DEPTH;
+    }
+    if (state.depthStencilState.stencilTestEnable || state.depthStencilState.stencilWriteEnable)
+    {
+        attachmentMask |= 1 << SWR_ATTACHMENT_STENCIL;
+    }
+
+    MarkDirtyTiles(pContext, pDC, attachmentMask);
+}
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief DrawInstanced
@@ -1019,23 +1454,44 @@ void DrawInstanced(
 #endif
 
     SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        SWR_CAPTURE_DRAW_ARGS args = { topology, numVertices, startVertex, 0, numInstances, startInstance };
+        CaptureCall(pContext, SWR_CAPTURE_DRAW, &args, sizeof(args));
+    }
+
+    DRAW_WORK batchDraw = {};
+    batchDraw.numVerts = numVertices;
+    batchDraw.startVertex = startVertex;
+    batchDraw.numInstances = numInstances;
+    batchDraw.startInstance = startInstance;
+    if (TryMergeDraw(pContext, topology, false, batchDraw))
+    {
+        RDTSC_STOP(APIDraw, numVertices * numInstances, 0);
+        return;
+    }
+
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
-    int32_t maxVertsPerDraw = MaxVertsPerDraw(pDC, numVertices, topology);
+    // Reserve the stream out ranges of the whole draw, so its split draws can
+    // stream out in parallel.
+    bool reserveStreamOut = CanReserveStreamOut(pDC->pState->state, topology);
+    uint32_t soPrimsPerInstance = reserveStreamOut ? GetNumPrims(topology, numVertices) : 0;
+    SWR_STREAMOUT_BUFFER soBuffer[4];
+    if (reserveStreamOut)
+    {
+        memcpy(soBuffer, pDC->pState->state.soBuffer, sizeof(soBuffer));
+    }
+
+    int32_t maxVertsPerDraw = MaxVertsPerDraw(pDC, numVertices, topology, reserveStreamOut);
     uint32_t primsPerDraw = GetNumPrims(topology, maxVertsPerDraw);
     int32_t remainingVerts = numVertices;
 
     API_STATE    *pState = &pDC->pState->state;
-    pState->topology = topology;
-    pState->forceFront = false;
 
     // disable culling for points/lines
     uint32_t oldCullMode = pState->rastState.cullMode;
-    if (topology == TOP_POINT_LIST)
-    {
-        pState->rastState.cullMode = SWR_CULLMODE_NONE;
-        pState->forceFront = true;
-    }
+    pState = SetDrawTopology(pContext, topology);
 
     int draw = 0;
     while (remainingVerts)
@@ -1046,6 +1502,10 @@ void DrawInstanced(
         bool isSplitDraw = (draw > 0) ? true : false;
         DRAW_CONTEXT* pDC = GetDrawContext(pContext, isSplitDraw);
         InitDraw(pDC, isSplitDraw);
+        if (!isSplitDraw)
+        {
+            MarkDrawDirtyTiles(pContext, pDC);
+        }
 
         pDC->FeWork.type = DRAW;
         pDC->FeWork.pfnWork = GetFEDrawFunc(
@@ -1059,17 +1519,35 @@ void DrawInstanced(
         pDC->FeWork.desc.draw.numInstances = numInstances;
         pDC->FeWork.desc.draw.startInstance = startInstance;
         pDC->FeWork.desc.draw.startPrimID = draw * primsPerDraw;
-
-        //enqueue DC
-        QueueDraw(pContext);
+        pDC->FeWork.desc.draw.soPrimsPerInstance = soPrimsPerInstance;
+        pDC->FeWork.desc.draw.pIndirectArgs = nullptr;
+        pDC->FeWork.desc.draw.pSubDraws = nullptr;
 
         remainingVerts -= numVertsForDraw;
         draw++;
+
+        //enqueue DC, or hold a small unsplit draw back for batching
+        if (draw == 1 && remainingVerts == 0 && IsBatchableDraw(topology, numVertices, numInstances))
+        {
+            OpenDrawBatch(pContext, pDC);
+        }
+        else
+        {
+            QueueDraw(pContext);
+        }
     }
 
     // restore culling state
-    pDC = GetDrawContext(pContext);
-    pDC->pState->state.rastState.cullMode = oldCullMode;
+    if (topology == TOP_POINT_LIST && oldCullMode != SWR_CULLMODE_NONE)
+    {
+        GetDrawState(pContext)->rastState.cullMode = oldCullMode;
+    }
+
+    if (soPrimsPerInstance != 0)
+    {
+        AdvanceStreamOutOffsets(pContext, pState->soState, soBuffer, topology,
+            (uint64_t)soPrimsPerInstance * numInstances);
+    }
 
     RDTSC_STOP(APIDraw, numVertices * numInstances, 0);
 }
@@ -1130,6 +1608,32 @@ void DrawIndexedInstance(
     RDTSC_START(APIDrawIndexed);
 
     SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        SWR_CAPTURE_DRAW_ARGS args = { topology, numIndices, indexOffset, baseVertex, numInstances, startInstance };
+        CaptureCall(pContext, SWR_CAPTURE_DRAW_INDEXED, &args, sizeof(args));
+    }
+
+    // Batched draws share state with the open batch, so its index buffer applies.
+    if (pContext->pBatchDrawContext != nullptr)
+    {
+        const SWR_INDEX_BUFFER_STATE& indexBuffer = pContext->pBatchDrawContext->pState->state.indexBuffer;
+
+        DRAW_WORK batchDraw = {};
+        batchDraw.numIndices = numIndices;
+        batchDraw.pIB = (const int32_t*)((const uint8_t*)indexBuffer.pIndices +
+            (uint64_t)indexOffset * GetIndexSize(indexBuffer.format));
+        batchDraw.type = indexBuffer.format;
+        batchDraw.baseVertex = baseVertex;
+        batchDraw.numInstances = numInstances;
+        batchDraw.startInstance = startInstance;
+        if (TryMergeDraw(pContext, topology, true, batchDraw))
+        {
+            RDTSC_STOP(APIDrawIndexed, numIndices * numInstances, 0);
+            return;
+        }
+    }
+
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
     API_STATE* pState = &pDC->pState->state;
 
@@ -1137,30 +1641,15 @@ void DrawIndexedInstance(
     uint32_t primsPerDraw = GetNumPrims(topology, maxIndicesPerDraw);
     int32_t remainingIndices = numIndices;
 
-    uint32_t indexSize = 0;
-    switch (pState->indexBuffer.format)
-    {
-    case R32_UINT: indexSize = sizeof(uint32_t); break;
-    case R16_UINT: indexSize = sizeof(uint16_t); break;
-    case R8_UINT: indexSize = sizeof(uint8_t); break;
-    default:
-        SWR_ASSERT(0);
-    }
+    uint32_t indexSize = GetIndexSize(pState->indexBuffer.format);
 
     int draw = 0;
     uint8_t *pIB = (uint8_t*)pState->indexBuffer.pIndices;
     pIB += (uint64_t)indexOffset * (uint64_t)indexSize;
 
-    pState->topology = topology;
-    pState->forceFront = false;
-
     // disable culling for points/lines
     uint32_t oldCullMode = pState->rastState.cullMode;
-    if (topology == TOP_POINT_LIST)
-    {
-        pState->rastState.cullMode = SWR_CULLMODE_NONE;
-        pState->forceFront = true;
-    }
+    pState = SetDrawTopology(pContext, topology);
 
     while (remainingIndices)
     {
@@ -1171,6 +1660,10 @@ void DrawIndexedInstance(
         bool isSplitDraw = (draw > 0) ? true : false;
         pDC = GetDrawContext(pContext, isSplitDraw);
         InitDraw(pDC, isSplitDraw);
+        if (!isSplitDraw)
+        {
+            MarkDrawDirtyTiles(pContext, pDC);
+        }
 
         pDC->FeWork.type = DRAW;
         pDC->FeWork.pfnWork = GetFEDrawFunc(
@@ -1188,18 +1681,30 @@ void DrawIndexedInstance(
         pDC->FeWork.desc.draw.startInstance = startInstance;
         pDC->FeWork.desc.draw.baseVertex = baseVertex;
         pDC->FeWork.desc.draw.startPrimID = draw * primsPerDraw;
-
-        //enqueue DC
-        QueueDraw(pContext);
+        pDC->FeWork.desc.draw.soPrimsPerInstance = 0;
+        pDC->FeWork.desc.draw.pIndirectArgs = nullptr;
+        pDC->FeWork.desc.draw.pSubDraws = nullptr;
 
         pIB += maxIndicesPerDraw * indexSize;
         remainingIndices -= numIndicesForDraw;
         draw++;
+
+        //enqueue DC, or hold a small unsplit draw back for batching
+        if (draw == 1 && remainingIndices == 0 && IsBatchableDraw(topology, numIndices, numInstances))
+        {
+            OpenDrawBatch(pContext, pDC);
+        }
+        else
+        {
+            QueueDraw(pContext);
+        }
     }
 
     // restore culling state
-    pDC = GetDrawContext(pContext);
-    pDC->pState->state.rastState.cullMode = oldCullMode;
+    if (topology == TOP_POINT_LIST && oldCullMode != SWR_CULLMODE_NONE)
+    {
+        GetDrawState(pContext)->rastState.cullMode = oldCullMode;
+    }
 
     RDTSC_STOP(APIDrawIndexed, numIndices * numInstances, 0);
 }
@@ -1244,19 +1749,175 @@ void SwrDrawIndexedInstanced(
     DrawIndexedInstance(hContext, topology, numIndices, indexOffset, baseVertex, numInstances, startInstance);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief DrawIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param isIndexed - Are the arguments SWR_DRAW_INDEXED_INDIRECT_ARGS?
+/// @param pArgs - Draw arguments, read by the FE when the draw executes.
+/// @param drawCount - Number of draws in pArgs.
+/// @param stride - Byte stride between consecutive draw arguments.
+void DrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    bool isIndexed,
+    const void* pArgs,
+    uint32_t drawCount,
+    uint32_t stride)
+{
+    RDTSC_START(APIDrawIndirect);
+
+#if KNOB_ENABLE_TOSS_POINTS
+    if (KNOB_TOSS_DRAW)
+    {
+        return;
+    }
+#endif
+
+    if (drawCount == 0)
+    {
+        RDTSC_STOP(APIDrawIndirect, 0, 0);
+        return;
+    }
+
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        uint32_t argsSize = isIndexed ? sizeof(SWR_DRAW_INDEXED_INDIRECT_ARGS) : sizeof(SWR_DRAW_INDIRECT_ARGS);
+        uint32_t argsStride = stride ? stride : argsSize;
+        SWR_CAPTURE_INDIRECT_ARGS args = { topology, drawCount, argsStride, 0 };
+        CaptureCall(pContext, isIndexed ? SWR_CAPTURE_DRAW_INDEXED_INDIRECT : SWR_CAPTURE_DRAW_INDIRECT,
+            &args, sizeof(args), pArgs, (drawCount - 1) * argsStride + argsSize);
+    }
+
+    DRAW_CONTEXT* pDC = GetDrawContext(pContext);
+    API_STATE* pState = &pDC->pState->state;
+
+    // disable culling for points/lines
+    uint32_t oldCullMode = pState->rastState.cullMode;
+    pState = SetDrawTopology(pContext, topology);
+
+    // The vertex counts aren't known until the FE runs, so all sub-draws are
+    // processed by one DC without splitting.
+    InitDraw(pDC, false);
+    MarkDrawDirtyTiles(pContext, pDC);
+
+    // Arguments may be produced by stream out of earlier draws, which runs in
+    // their FE. Don't start this FE until those are complete.
+    pDC->dependentFE = true;
+
+    pDC->FeWork.type = DRAW;
+    pDC->FeWork.pfnWork = GetFEDrawFunc(
+        isIndexed,
+        pState->tsState.tsEnable,
+        pState->gsState.gsEnable,
+        pState->soState.soEnable,
+        pDC->pState->pfnProcessPrims != nullptr);
+    pDC->FeWork.desc.draw.pDC = pDC;
+    if (isIndexed)
+    {
+        pDC->FeWork.desc.draw.pIB = (const int32_t*)pState->indexBuffer.pIndices;
+        pDC->FeWork.desc.draw.type = pState->indexBuffer.format;
+    }
+    pDC->FeWork.desc.draw.startPrimID = 0;
+    pDC->FeWork.desc.draw.soPrimsPerInstance = 0;
+    pDC->FeWork.desc.draw.pIndirectArgs = (const uint8_t*)pArgs;
+    pDC->FeWork.desc.draw.numIndirectDraws = drawCount;
+    pDC->FeWork.desc.draw.pSubDraws = nullptr;
+    pDC->FeWork.desc.draw.indirectStride = stride ? stride :
+        (isIndexed ? sizeof(SWR_DRAW_INDEXED_INDIRECT_ARGS) : sizeof(SWR_DRAW_INDIRECT_ARGS));
+
+    //enqueue DC
+    QueueDraw(pContext);
+
+    // restore culling state
+    if (topology == TOP_POINT_LIST && oldCullMode != SWR_CULLMODE_NONE)
+    {
+        GetDrawState(pContext)->rastState.cullMode = oldCullMode;
+    }
+
+    RDTSC_STOP(APIDrawIndirect, drawCount, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Array of SWR_DRAW_INDIRECT_ARGS.
+/// @param drawCount - Number of draws in pArgs.
+/// @param stride - Byte stride between consecutive draw arguments.
+void SwrDrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const void* pArgs,
+    uint32_t drawCount,
+    uint32_t stride)
+{
+    DrawIndirect(hContext, topology, false, pArgs, drawCount, stride);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndexedIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Array of SWR_DRAW_INDEXED_INDIRECT_ARGS.
+/// @param drawCount - Number of draws in pArgs.
+/// @param stride - Byte stride between consecutive draw arguments.
+void SwrDrawIndexedIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const void* pArgs,
+    uint32_t drawCount,
+    uint32_t stride)
+{
+    DrawIndirect(hContext, topology, true, pArgs, drawCount, stride);
+}
+
 // Attach surfaces to pipeline
 void SwrInvalidateTiles(
     HANDLE hContext,
     uint32_t attachmentMask)
 {
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    if (pContext->pCapture)
+    {
+        CaptureCall(pContext, SWR_CAPTURE_INVALIDATE_TILES, &attachmentMask, sizeof(attachmentMask));
+    }
+
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
     pDC->inUse = true;
 
+    // Only macrotiles that may have hot tile contents need invalidating.
+    MacroTileMask validTiles;
+    uint32_t mask = attachmentMask;
+    DWORD attachment;
+    while (_BitScanForward(&attachment, mask))
+    {
+        mask &= ~(1 << attachment);
+        MacroTileMask& attachmentTiles = pContext->pValidTiles[attachment];
+        attachmentTiles.forEach([&](uint32_t x, uint32_t y)
+        {
+            validTiles.set(x, y, x, y);
+        });
+        attachmentTiles.clear();
+        pContext->pDirtyTiles[attachment].clear();
+    }
+
+    const BBOX bounds = validTiles.bounds();
+    uint32_t maxTiles = std::max(bounds.right - bounds.left + 1, 0) * std::max(bounds.bottom - bounds.top + 1, 0);
+    uint32_t* pMacroTiles = (uint32_t*)pDC->arena.AllocAligned(std::max(maxTiles, 1u) * sizeof(uint32_t), sizeof(uint32_t));
+    uint32_t numMacroTiles = 0;
+    validTiles.forEach([&](uint32_t x, uint32_t y)
+    {
+        pMacroTiles[numMacroTiles++] = MacroTileMgr::getTileId(x, y);
+    });
+
     // Queue a load to the hottile
     pDC->FeWork.type = INVALIDATETILES;
     pDC->FeWork.pfnWork = ProcessInvalidateTiles;
     pDC->FeWork.desc.invalidateTiles.attachmentMask = attachmentMask;
+    pDC->FeWork.desc.invalidateTiles.pMacroTiles = pMacroTiles;
+    pDC->FeWork.desc.invalidateTiles.numMacroTiles = numMacroTiles;
 
     //enqueue
     QueueDraw(pContext);
@@ -1276,14 +1937,17 @@ void SwrDispatch(
 {
     RDTSC_START(APIDispatch);
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    if (pContext->pCapture)
+    {
+        SWR_CAPTURE_DISPATCH_ARGS args = { threadGroupCountX, threadGroupCountY, threadGroupCountZ };
+        CaptureCall(pContext, SWR_CAPTURE_DISPATCH, &args, sizeof(args));
+    }
+
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
     pDC->isCompute = true;      // This is a compute context.
     pDC->inUse = true;
 
-    // Ensure spill fill pointers are initialized to nullptr.
-    memset(pDC->pSpillFill, 0, sizeof(pDC->pSpillFill));
-
     COMPUTE_DESC* pTaskData = (COMPUTE_DESC*)pDC->arena.AllocAligned(sizeof(COMPUTE_DESC), 64);
 
     pTaskData->threadGroupCountX = threadGroupCountX;
@@ -1291,7 +1955,11 @@ void SwrDispatch(
     pTaskData->threadGroupCountZ = threadGroupCountZ;
 
     uint32_t totalThreadGroups = threadGroupCountX * threadGroupCountY * threadGroupCountZ;
-    pDC->pDispatch->initialize(totalThreadGroups, pTaskData);
+    if (pDC->pDispatch == nullptr)
+    {
+        pDC->pDispatch = new DispatchQueue();
+    }
+    pDC->pDispatch->initialize(totalThreadGroups, pTaskData, pContext->threadPool.numaMask);
 
     QueueDispatch(pContext);
     RDTSC_STOP(APIDispatch, threadGroupCountX * threadGroupCountY * threadGroupCountZ, 0);
@@ -1307,15 +1975,70 @@ void SwrStoreTiles(
     RDTSC_START(APIStoreTiles);
 
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    if (pContext->pCapture)
+    {
+        SWR_CAPTURE_STORE_ARGS args = { attachment, postStoreTileState };
+        CaptureCall(pContext, SWR_CAPTURE_STORE_TILES, &args, sizeof(args));
+    }
+
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
-    pDC->inUse = true;
 
-    SetupMacroTileScissors(pDC);
+    // Sets up the macrotile scissors, unless the state already has them.
+    InitDraw(pDC, false);
+
+    // Store the macrotiles rendered to since the last store, within the
+    // viewport. Invalidating drops the other tiles with hot tile contents too.
+    const API_STATE& state = GetApiState(pDC);
+    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (KNOB_MACROTILE_X_DIM - 1)) / KNOB_MACROTILE_X_DIM;
+    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (KNOB_MACROTILE_Y_DIM - 1)) / KNOB_MACROTILE_Y_DIM;
+
+    MacroTileMask& dirtyTiles = pContext->pDirtyTiles[attachment];
+    MacroTileMask& validTiles = pContext->pValidTiles[attachment];
+
+    const BBOX bounds = validTiles.bounds();
+    uint32_t maxTiles = std::max(bounds.right - bounds.left + 1, 0) * std::max(bounds.bottom - bounds.top + 1, 0);
+    uint32_t* pMacroTiles = (uint32_t*)pDC->arena.AllocAligned(std::max(maxTiles, 1u) * sizeof(uint32_t), sizeof(uint32_t));
+    uint32_t numStoreTiles = 0;
+    uint32_t numCleanTiles = 0;
+
+    BBOX& storeRect = pContext->lastStoreRect[attachment];
+    storeRect = BBOX(INT_MAX, INT_MIN, INT_MAX, INT_MIN);
+    dirtyTiles.forEach([&](uint32_t x, uint32_t y)
+    {
+        if (x < numMacroTilesX && y < numMacroTilesY)
+        {
+            pMacroTiles[numStoreTiles++] = MacroTileMgr::getTileId(x, y);
+            storeRect.left = std::min(storeRect.left, (int)(x * KNOB_MACROTILE_X_DIM));
+            storeRect.right = std::max(storeRect.right, (int)((x + 1) * KNOB_MACROTILE_X_DIM));
+            storeRect.top = std::min(storeRect.top, (int)(y * KNOB_MACROTILE_Y_DIM));
+            storeRect.bottom = std::max(storeRect.bottom, (int)((y + 1) * KNOB_MACROTILE_Y_DIM));
+        }
+    });
+
+    if (postStoreTileState == SWR_TILE_INVALID)
+    {
+        validTiles.forEach([&](uint32_t x, uint32_t y)
+        {
+            if (x < numMacroTilesX && y < numMacroTilesY && !dirtyTiles.test(x, y))
+            {
+                pMacroTiles[numStoreTiles + numCleanTiles++] = MacroTileMgr::getTileId(x, y);
+            }
+        });
+        validTiles.clear();
+    }
+
+    if (postStoreTileState != SWR_TILE_DIRTY)
+    {
+        dirtyTiles.clear();
+    }
 
     pDC->FeWork.type = STORETILES;
     pDC->FeWork.pfnWork = ProcessStoreTiles;
     pDC->FeWork.desc.storeTiles.attachment = attachment;
     pDC->FeWork.desc.storeTiles.postStoreTileState = postStoreTileState;
+    pDC->FeWork.desc.storeTiles.pMacroTiles = pMacroTiles;
+    pDC->FeWork.desc.storeTiles.numStoreTiles = numStoreTiles;
+    pDC->FeWork.desc.storeTiles.numCleanTiles = numCleanTiles;
 
     //enqueue
     QueueDraw(pContext);
@@ -1323,6 +2046,23 @@ void SwrStoreTiles(
     RDTSC_STOP(APIStoreTiles, 0, 0);
 }
 
+// Returns the bounds of the macrotiles written by the attachment's last store
+bool SwrGetLastStoreRect(
+    HANDLE hContext,
+    SWR_RENDERTARGET_ATTACHMENT attachment,
+    BBOX* pRect)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    const BBOX& storeRect = pContext->lastStoreRect[attachment];
+    if (storeRect.right <= storeRect.left)
+    {
+        return false;
+    }
+
+    *pRect = storeRect;
+    return true;
+}
+
 void SwrClearRenderTarget(
     HANDLE hContext,
     uint32_t clearMask,
@@ -1333,16 +2073,26 @@ void SwrClearRenderTarget(
     RDTSC_START(APIClearRenderTarget);
 
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    if (pContext->pCapture)
+    {
+        SWR_CAPTURE_CLEAR_ARGS args = { clearMask,
+            { clearColor[0], clearColor[1], clearColor[2], clearColor[3] }, z, stencil };
+        CaptureCall(pContext, SWR_CAPTURE_CLEAR, &args, sizeof(args));
+    }
 
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
-    SetupMacroTileScissors(pDC);
-
-    pDC->inUse = true;
+    // Sets up the macrotile scissors, unless the state already has them.
+    InitDraw(pDC, false);
 
     CLEAR_FLAGS flags;
     flags.mask = clearMask;
 
+    MarkDirtyTiles(pContext, pDC,
+        ((clearMask & SWR_CLEAR_COLOR) ? (1 << SWR_ATTACHMENT_COLOR0) : 0) |
+        ((clearMask & SWR_CLEAR_DEPTH) ? (1 << SWR_ATTACHMENT_DEPTH) : 0) |
+        ((clearMask & SWR_CLEAR_STENCIL) ? (1 << SWR_ATTACHMENT_STENCIL) : 0));
+
     pDC->FeWork.type = CLEAR;
     pDC->FeWork.pfnWork = ProcessClear;
     pDC->FeWork.desc.clear.flags = flags;
@@ -1369,8 +2119,7 @@ VOID* SwrGetPrivateContextState(
     HANDLE hContext)
 {
     SWR_CONTEXT* pContext = GetContext(hContext);
-    DRAW_CONTEXT* pDC = GetDrawContext(pContext);
-    DRAW_STATE* pState = pDC->pState;
+    DRAW_STATE* pState = GetWritableDrawState(pContext);
 
     if (pState->pPrivateState == nullptr)
     {
@@ -1394,9 +2143,13 @@ VOID* SwrAllocDrawContextMemory(
     uint32_t align)
 {
     SWR_CONTEXT* pContext = GetContext(hContext);
-    DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
-    return pDC->pState->arena.AllocAligned(size, align);
+    // Clients reference this memory from draw state (e.g. vertex buffers), so
+    // it has to live in the DS ring entry this draw will own, not in one that
+    // is still shared with earlier draws and may be reset under them.
+    DRAW_STATE* pState = GetWritableDrawState(pContext);
+
+    return pState->arena.AllocAligned(size, align);
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1436,10 +2189,9 @@ void SwrEnableStats(
     HANDLE hContext,
     bool enable)
 {
-    SWR_CONTEXT *pContext = GetContext(hContext);
-    DRAW_CONTEXT* pDC = GetDrawContext(pContext);
+    API_STATE* pState = GetDrawState(GetContext(hContext));
 
-    pDC->pState->state.enableStats = enable;
+    pState->enableStats = enable;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1448,5 +2200,49 @@ void SwrEnableStats(
 void SWR_API SwrEndFrame(
     HANDLE hContext)
 {
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    if (pContext->pCapture)
+    {
+        CaptureCall(pContext, SWR_CAPTURE_END_FRAME);
+    }
+
+    // Evicting hot tiles needs the backend idle. Presenting has usually
+    // drained the pipeline already, so only wait when over budget.
+    size_t budget = (size_t)KNOB_HOT_TILE_BUDGET_MB << 20;
+    SWR_HOT_TILE_STATS stats;
+    pContext->pHotTileMgr->GetStats(stats);
+    if (budget != 0 && stats.ResidentBytes > budget)
+    {
+        FlushDrawBatch(pContext);
+        if (pContext->pPrevDrawContext)
+            WaitForDependencies(pContext, pContext->pPrevDrawContext->drawId);
+    }
+    pContext->pHotTileMgr->Trim(budget);
+    pContext->pArenaBlockCache->Trim();
+
     RDTSC_ENDFRAME();
 }
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns draw context ring usage of the context.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - Receives the ring stats.
+void SWR_API SwrGetDrawRingStats(
+    HANDLE hContext,
+    SWR_DRAW_RING_STATS* pStats)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    *pStats = pContext->ringStats;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns hot tile memory usage of the context.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - Receives the hot tile stats.
+void SWR_API SwrGetHotTileStats(
+    HANDLE hContext,
+    SWR_HOT_TILE_STATS* pStats)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    pContext->pHotTileMgr->GetStats(*pStats);
+}
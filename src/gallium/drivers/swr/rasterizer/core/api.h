@@ -62,20 +62,25 @@ typedef void(SWR_API *PFN_LOAD_TILE)(HANDLE hPrivateContext, SWR_FORMAT dstForma
 /// @param renderTargetIndex - render target to store, can be color, depth or stencil
 /// @param x - destination x coordinate
 /// @param y - destination y coordinate
+/// @param numSamples - number of samples in the hot tile; resolved when storing to a
+///                     single sample surface
 /// @param pSrcHotTile - pointer to the hot tile surface
 typedef void(SWR_API *PFN_STORE_TILE)(HANDLE hPrivateContext, SWR_FORMAT srcFormat,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
-    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, BYTE *pSrcHotTile);
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSamples, BYTE *pSrcHotTile);
 
 /// @brief Function signature for clearing from the hot tiles clear value
 /// @param hPrivateContext - handle to private data
 /// @param renderTargetIndex - render target to store, can be color, depth or stencil
 /// @param x - destination x coordinate
 /// @param y - destination y coordinate
+/// @param renderTargetArrayIndex - array slice of the destination
 /// @param pClearColor - pointer to the hot tile's clear value
-typedef void(SWR_API *PFN_CLEAR_TILE)(HANDLE hPrivateContext,
+/// @return false if the surface format can't be cleared directly; the core
+///         then stores the materialized hot tile instead.
+typedef bool(SWR_API *PFN_CLEAR_TILE)(HANDLE hPrivateContext,
     SWR_RENDERTARGET_ATTACHMENT rtIndex,
-    uint32_t x, uint32_t y, const float* pClearColor);
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, const float* pClearColor);
 
 //////////////////////////////////////////////////////////////////////////
 /// SWR_CREATECONTEXT_INFO
@@ -197,6 +202,16 @@ void SWR_API SwrSetVertexFunc(
     HANDLE hContext,
     PFN_VERTEX_FUNC pfnVertexFunc);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Set fused fetch + vertex shader pointer. When set, it replaces
+///        the separate fetch and vertex shaders; vertex inputs are never
+///        written to memory. Pass nullptr to use the separate shaders.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pfnFetchVsFunc - Pointer to shader.
+void SWR_API SwrSetFetchVsFunc(
+    HANDLE hContext,
+    PFN_FETCH_VS_FUNC pfnFetchVsFunc);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set frontend state.
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -226,10 +241,12 @@ void SWR_API SwrSetGsFunc(
 /// @param hContext - Handle passed back from SwrCreateContext
 /// @param pState - Pointer to compute shader function
 /// @param totalThreadsInGroup - product of thread group dimensions.
+/// @param totalSpillFillSize - size in bytes of the spill fill buffer a thread group needs.
 void SWR_API SwrSetCsFunc(
     HANDLE hContext,
     PFN_CS_FUNC pfnCsFunc,
-    uint32_t totalThreadsInGroup);
+    uint32_t totalThreadsInGroup,
+    uint32_t totalSpillFillSize);
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set tessellation state.
@@ -370,6 +387,60 @@ void SWR_API SwrDrawIndexedInstanced(
     int32_t baseVertex,
     uint32_t startInstance);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Arguments of one non-indexed indirect draw, as laid out in
+///        the indirect buffer.
+struct SWR_DRAW_INDIRECT_ARGS
+{
+    uint32_t numVertsPerInstance;
+    uint32_t numInstances;
+    uint32_t startVertex;
+    uint32_t startInstance;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Arguments of one indexed indirect draw, as laid out in the
+///        indirect buffer.
+struct SWR_DRAW_INDEXED_INDIRECT_ARGS
+{
+    uint32_t numIndices;
+    uint32_t numInstances;
+    uint32_t indexOffset;
+    int32_t  baseVertex;
+    uint32_t startInstance;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Array of SWR_DRAW_INDIRECT_ARGS. Read by the front end
+///                when the draw executes, so it may be written by earlier
+///                draws (e.g. stream out) that are still in flight.
+/// @param drawCount - Number of draws in pArgs.
+/// @param stride - Byte stride between consecutive draw arguments.
+void SWR_API SwrDrawIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const void* pArgs,
+    uint32_t drawCount,
+    uint32_t stride);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrDrawIndexedIndirect
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param topology - Specifies topology for draw.
+/// @param pArgs - Array of SWR_DRAW_INDEXED_INDIRECT_ARGS. Read by the
+///                front end when the draw executes.
+/// @param drawCount - Number of draws in pArgs.
+/// @param stride - Byte stride between consecutive draw arguments.
+void SWR_API SwrDrawIndexedIndirect(
+    HANDLE hContext,
+    PRIMITIVE_TOPOLOGY topology,
+    const void* pArgs,
+    uint32_t drawCount,
+    uint32_t stride);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief SwrInvalidateTiles
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -404,6 +475,21 @@ void SWR_API SwrStoreTiles(
     SWR_RENDERTARGET_ATTACHMENT attachment,
     SWR_TILE_STATE postStoreTileState);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief SwrGetLastStoreRect
+///        Only macrotiles rendered to since the previous store of an
+///        attachment are stored, so the written region can be used as the
+///        damage region of a present.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param attachment - Attachment to query.
+/// @param pRect - Receives the pixel bounds of the macrotiles written by the
+///                attachment's last SwrStoreTiles, right/bottom exclusive.
+/// @return false if the last store had no dirty macrotiles to write.
+bool SWR_API SwrGetLastStoreRect(
+    HANDLE hContext,
+    SWR_RENDERTARGET_ATTACHMENT attachment,
+    BBOX* pRect);
+
 void SWR_API SwrClearRenderTarget(
     HANDLE hContext,
     uint32_t clearMask,
@@ -481,8 +567,27 @@ void SWR_API SwrEnableStats(
     bool enable);
 
 //////////////////////////////////////////////////////////////////////////
-/// @brief Mark end of frame - used for performance profiling
+/// @brief Mark end of frame - used for performance profiling. Also trims
+///        the context's hot tiles to KNOB_HOT_TILE_BUDGET_MB.
 /// @param hContext - Handle passed back from SwrCreateContext
 void SWR_API SwrEndFrame(
     HANDLE hContext);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns hot tile memory usage of the context.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - Receives the hot tile stats.
+void SWR_API SwrGetHotTileStats(
+    HANDLE hContext,
+    SWR_HOT_TILE_STATS* pStats);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns draw context ring usage of the context: draws in flight
+///        and how long the API thread waited for a free draw context.
+///        Counts accumulate from context creation.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - Receives the ring stats.
+void SWR_API SwrGetDrawRingStats(
+    HANDLE hContext,
+    SWR_DRAW_RING_STATS* pStats);
 #endif//__SWR_API_H__
@@ -36,6 +36,48 @@
 
 #include <cmath>
 
+ArenaBlockCache::~ArenaBlockCache()
+{
+    for (void* pMem : m_blocks)
+    {
+        _aligned_free(pMem);
+    }
+}
+
+void* ArenaBlockCache::Alloc()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (m_blocks.empty())
+    {
+        m_minCached = 0;
+        return _aligned_malloc(BlockSize, KNOB_SIMD_WIDTH*4);
+    }
+
+    void* pMem = m_blocks.back();
+    m_blocks.pop_back();
+    m_minCached = std::min(m_minCached, m_blocks.size());
+    return pMem;
+}
+
+void ArenaBlockCache::Free(void* pMem)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_blocks.push_back(pMem);
+}
+
+void ArenaBlockCache::Trim()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    for (size_t i = 0; i < m_minCached; ++i)
+    {
+        _aligned_free(m_blocks.back());
+        m_blocks.pop_back();
+    }
+    m_minCached = m_blocks.size();
+}
+
 Arena::~Arena()
 {
     Reset();        // Reset just in case to avoid leaking memory.
@@ -43,11 +85,12 @@ Arena::~Arena()
     delete m_pMutex;
 }
 
-void Arena::Init()
+void Arena::Init(ArenaBlockCache* pCache)
 {
     m_memUsed = 0;
     m_pCurBlock = nullptr;
     m_pUsedBlocks = nullptr;
+    m_pCache = pCache;
 
     m_pMutex = new std::mutex();
 }
@@ -72,8 +115,7 @@ void* Arena::AllocAligned(uint32_t size, uint32_t align)
         m_pCurBlock = nullptr;
     }
 
-    static const uint32_t ArenaBlockSize = 1024*1024;
-    uint32_t defaultBlockSize = ArenaBlockSize;
+    uint32_t defaultBlockSize = ArenaBlockCache::BlockSize;
     if (m_pUsedBlocks == nullptr)
     {
         m_memUsed = 0;
@@ -82,7 +124,15 @@ void* Arena::AllocAligned(uint32_t size, uint32_t align)
     uint32_t blockSize = std::max(size, defaultBlockSize);
     blockSize = AlignUp(blockSize, KNOB_SIMD_WIDTH*4);
 
-    void *pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
+    void *pMem;
+    if (m_pCache != nullptr && blockSize == defaultBlockSize)
+    {
+        pMem = m_pCache->Alloc();
+    }
+    else
+    {
+        pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
+    }
     SWR_ASSERT(pMem != nullptr);
 
     m_pCurBlock = (ArenaBlock*)malloc(sizeof(ArenaBlock));
@@ -132,6 +182,14 @@ void* Arena::AllocSync(uint32_t size)
 
 void Arena::Reset()
 {
+    if (m_pCache != nullptr && m_pCurBlock)
+    {
+        // blocks go back to the shared cache, the arena keeps none
+        m_pCurBlock->pNext = m_pUsedBlocks;
+        m_pUsedBlocks = m_pCurBlock;
+        m_pCurBlock = nullptr;
+    }
+
     if (m_pCurBlock)
     {
         m_pCurBlock->offset = 0;
@@ -152,7 +210,14 @@ void Arena::Reset()
         ArenaBlock* pBlock = m_pUsedBlocks;
         m_pUsedBlocks = pBlock->pNext;
 
-        _aligned_free(pBlock->pMem);
+        if (m_pCache != nullptr && pBlock->blockSize == ArenaBlockCache::BlockSize)
+        {
+            m_pCache->Free(pBlock->pMem);
+        }
+        else
+        {
+            _aligned_free(pBlock->pMem);
+        }
         free(pBlock);
     }
 }
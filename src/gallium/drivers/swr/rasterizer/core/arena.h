@@ -33,14 +33,41 @@
 #pragma once
 
 #include <mutex>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+/// ArenaBlockCache - Default sized arena blocks released by the arenas of
+/// a context, kept for reuse. Arenas that share a cache only hold memory
+/// while they have allocations, so memory follows the number of draws in
+/// flight rather than the number of draw context slots.
+//////////////////////////////////////////////////////////////////////////
+class ArenaBlockCache
+{
+public:
+    ~ArenaBlockCache();
+
+    void*   Alloc();
+    void    Free(void* pMem);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees the blocks that stayed in the cache since the last trim.
+    void    Trim();
+
+    static const uint32_t BlockSize = 1024*1024;
+
+private:
+    std::mutex          m_mutex;
+    std::vector<void*>  m_blocks;
+    size_t              m_minCached{ 0 };   // fewest blocks cached since the last trim
+};
 
 class Arena
 {
 public:
-    Arena() : m_pCurBlock(nullptr), m_pUsedBlocks(nullptr), m_memUsed(0), m_pMutex(nullptr) {}
+    Arena() : m_pCurBlock(nullptr), m_pUsedBlocks(nullptr), m_memUsed(0), m_pMutex(nullptr), m_pCache(nullptr) {}
     ~Arena();
 
-    void    Init();
+    void    Init(ArenaBlockCache* pCache = nullptr);
 
     void*   AllocAligned(uint32_t  size, uint32_t  align);
     void*   Alloc(uint32_t  size);
@@ -69,4 +96,6 @@ private:
 
     /// @note Mutex is only used by sync allocation functions.
     std::mutex*      m_pMutex;
+
+    ArenaBlockCache* m_pCache;      // optional, Reset() returns default sized blocks here
 };
@@ -79,22 +79,18 @@ void ProcessComputeBE(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t threadGroup
     const COMPUTE_DESC* pTaskData = (COMPUTE_DESC*)pDC->pDispatch->GetTasksData();
     SWR_ASSERT(pTaskData != nullptr);
 
-    // Ensure spill fill memory has been allocated.
-    if (pDC->pSpillFill[workerId] == nullptr)
-    {
-        ///@todo Add state which indicates the spill fill size.
-        pDC->pSpillFill[workerId] = (uint8_t*)pDC->arena.AllocAlignedSync(4096 * 1024, sizeof(float) * 8);
-    }
-
     const API_STATE& state = GetApiState(pDC);
 
+    // WorkOnCompute sizes the worker's spill fill buffer before handing out groups.
+    SWR_ASSERT(pContext->spillFillSize[workerId] >= state.totalSpillFillSize);
+
     SWR_CS_CONTEXT csContext{ 0 };
     csContext.tileCounter = threadGroupId;
     csContext.dispatchDims[0] = pTaskData->threadGroupCountX;
     csContext.dispatchDims[1] = pTaskData->threadGroupCountY;
     csContext.dispatchDims[2] = pTaskData->threadGroupCountZ;
     csContext.pTGSM = pContext->pScratch[workerId];
-    csContext.pSpillFillBuffer = pDC->pSpillFill[workerId];
+    csContext.pSpillFillBuffer = pContext->pSpillFill[workerId];
 
     state.pfnCsFunc(GetPrivateState(pDC), &csContext);
 
@@ -140,6 +136,7 @@ void ProcessQueryStatsBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTil
         pStats->CsInvocations += pContext->stats[i].CsInvocations;
         pStats->CPrimitives   += pContext->stats[i].CPrimitives;
         pStats->GsPrimitives  += pContext->stats[i].GsPrimitives;
+        pStats->DrawsMerged   += pContext->stats[i].DrawsMerged;
 
         for (uint32_t stream = 0; stream < MAX_SO_STREAMS; ++stream)
         {
@@ -247,43 +244,137 @@ INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, ui
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the current scissor covers the entire macrotile.
+/// @param pDC - pointer to draw context.
+/// @param macroTile - macrotile id.
+INLINE bool ScissorCoversMacroTile(DRAW_CONTEXT *pDC, uint32_t macroTile)
+{
+    const API_STATE& state = GetApiState(pDC);
+
+    uint32_t tileX, tileY;
+    MacroTileMgr::getTileIndices(macroTile, tileX, tileY);
+
+    int top = KNOB_MACROTILE_Y_DIM_FIXED * tileY;
+    int bottom = top + KNOB_MACROTILE_Y_DIM_FIXED - 1;
+    int left = KNOB_MACROTILE_X_DIM_FIXED * tileX;
+    int right = left + KNOB_MACROTILE_X_DIM_FIXED - 1;
+
+    return (state.scissorInFixedPoint.top <= top) && (state.scissorInFixedPoint.bottom >= bottom) &&
+           (state.scissorInFixedPoint.left <= left) && (state.scissorInFixedPoint.right >= right);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writes a pending clear value into every sample of the hot tile.
+/// @param pHotTile - hot tile in HOTTILE_CLEAR state.
+/// @param attachment - attachment the hot tile belongs to.
+INLINE void MaterializeHotTileClear(HOTTILE *pHotTile, SWR_RENDERTARGET_ATTACHMENT attachment)
+{
+    SWR_ASSERT(pHotTile->state == HOTTILE_CLEAR);
+
+    RDTSC_START(BEClearMaterialize);
+    switch (attachment)
+    {
+    case SWR_ATTACHMENT_DEPTH: ClearDepthHotTile(pHotTile); break;
+    case SWR_ATTACHMENT_STENCIL: ClearStencilHotTile(pHotTile); break;
+    default: ClearColorHotTile(pHotTile); break;
+    }
+    pHotTile->state = HOTTILE_DIRTY;
+    RDTSC_STOP(BEClearMaterialize, 1, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Applies a fast clear to a single attachment of a macrotile. A
+///        clear that covers the whole macrotile is only recorded in the hot
+///        tile; it is materialized on first touch by the backend or written
+///        straight to the surface by ProcessStoreTileBE. A clear that covers
+///        part of the macrotile is applied in place to up-to-date contents.
+/// @param pDC - pointer to draw context.
+/// @param macroTile - macrotile id.
+/// @param attachment - attachment to clear.
+/// @param format - hot tile format of the attachment.
+/// @param coversMacroTile - true if the clear region covers the whole macrotile.
+/// @param clearData - clear value in hot tile clearData layout.
+INLINE void FastClearHotTile(DRAW_CONTEXT *pDC, uint32_t macroTile, SWR_RENDERTARGET_ATTACHMENT attachment,
+    SWR_FORMAT format, bool coversMacroTile, DWORD clearData[4])
+{
+    SWR_CONTEXT *pContext = pDC->pContext;
+    uint32_t numSamples = GetNumSamples(pDC->pState->state.rastState.sampleCount);
+
+    HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, attachment, true, numSamples);
+
+    if (coversMacroTile)
+    {
+        // All we want to do here is to mark the hot tile as being in a "needs clear" state.
+        pHotTile->clearData[0] = clearData[0];
+        pHotTile->clearData[1] = clearData[1];
+        pHotTile->clearData[2] = clearData[2];
+        pHotTile->clearData[3] = clearData[3];
+        pHotTile->state = HOTTILE_CLEAR;
+        return;
+    }
+
+    // Pixels outside of the scissor must keep their current value, so the tile
+    // needs valid contents before the scissored region is cleared.
+    if (pHotTile->state == HOTTILE_INVALID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(macroTile, x, y);
+
+        RDTSC_START(BELoadTiles);
+        pContext->pfnLoadTile(GetPrivateState(pDC), format, attachment,
+            x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+        pHotTile->state = HOTTILE_DIRTY;
+        RDTSC_STOP(BELoadTiles, 0, 0);
+    }
+    else if (pHotTile->state == HOTTILE_CLEAR)
+    {
+        MaterializeHotTileClear(pHotTile, attachment);
+    }
+
+    PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[format];
+    SWR_ASSERT(pfnClearTiles != nullptr);
+
+    pfnClearTiles(pDC, attachment, macroTile, clearData);
+}
+
 void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pUserData)
 {
     if (KNOB_FAST_CLEAR)
     {
         CLEAR_DESC *pClear = (CLEAR_DESC*)pUserData;
-        SWR_CONTEXT *pContext = pDC->pContext;
-        SWR_MULTISAMPLE_COUNT sampleCount = pDC->pState->state.rastState.sampleCount;
-        uint32_t numSamples = GetNumSamples(sampleCount);
 
         SWR_ASSERT(pClear->flags.bits != 0); // shouldn't be here without a reason.
 
         RDTSC_START(BEClear);
 
+        bool coversMacroTile = ScissorCoversMacroTile(pDC, macroTile);
+
         if (pClear->flags.mask & SWR_CLEAR_COLOR)
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, SWR_ATTACHMENT_COLOR0, true, numSamples);
-            // All we want to do here is to mark the hot tile as being in a "needs clear" state.
-            pHotTile->clearData[0] = *(DWORD*)&(pClear->clearRTColor[0]);
-            pHotTile->clearData[1] = *(DWORD*)&(pClear->clearRTColor[1]);
-            pHotTile->clearData[2] = *(DWORD*)&(pClear->clearRTColor[2]);
-            pHotTile->clearData[3] = *(DWORD*)&(pClear->clearRTColor[3]);
-            pHotTile->state = HOTTILE_CLEAR;
+            DWORD clearData[4];
+            clearData[0] = *(DWORD*)&(pClear->clearRTColor[0]);
+            clearData[1] = *(DWORD*)&(pClear->clearRTColor[1]);
+            clearData[2] = *(DWORD*)&(pClear->clearRTColor[2]);
+            clearData[3] = *(DWORD*)&(pClear->clearRTColor[3]);
+
+            FastClearHotTile(pDC, macroTile, SWR_ATTACHMENT_COLOR0, KNOB_COLOR_HOT_TILE_FORMAT, coversMacroTile, clearData);
         }
 
         if (pClear->flags.mask & SWR_CLEAR_DEPTH)
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, SWR_ATTACHMENT_DEPTH, true, numSamples);
-            pHotTile->clearData[0] = *(DWORD*)&pClear->clearDepth;
-            pHotTile->state = HOTTILE_CLEAR;
+            DWORD clearData[4];
+            clearData[0] = *(DWORD*)&pClear->clearDepth;
+
+            FastClearHotTile(pDC, macroTile, SWR_ATTACHMENT_DEPTH, KNOB_DEPTH_HOT_TILE_FORMAT, coversMacroTile, clearData);
         }
 
         if (pClear->flags.mask & SWR_CLEAR_STENCIL)
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, SWR_ATTACHMENT_STENCIL, true, numSamples);
+            DWORD clearData[4];
+            clearData[0] = pClear->clearStencil;
 
-            pHotTile->clearData[0] = *(DWORD*)&pClear->clearStencil;
-            pHotTile->state = HOTTILE_CLEAR;
+            FastClearHotTile(pDC, macroTile, SWR_ATTACHMENT_STENCIL, KNOB_STENCIL_HOT_TILE_FORMAT, coversMacroTile, clearData);
         }
 
         RDTSC_STOP(BEClear, 0, 0);
@@ -339,6 +430,50 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stores one array slice of a hot tile and applies the post store state.
+INLINE void StoreHotTileSlice(DRAW_CONTEXT *pDC, const STORE_TILES_DESC *pDesc, SWR_FORMAT srcFormat,
+    int destX, int destY, HOTTILE *pHotTile)
+{
+    SWR_CONTEXT *pContext = pDC->pContext;
+
+    if (pHotTile->state == HOTTILE_CLEAR)
+    {
+        if (pContext->pfnClearTile != nullptr && pDesc->attachment != SWR_ATTACHMENT_STENCIL)
+        {
+            // Tile was cleared but never rendered to. Write the clear value straight to
+            // the surface and keep the clear pending, as it still describes the contents.
+            RDTSC_START(BEStoreTilesClear);
+            bool cleared = pContext->pfnClearTile(GetPrivateState(pDC), pDesc->attachment, destX, destY,
+                pHotTile->renderTargetArrayIndex, (const float*)pHotTile->clearData);
+            RDTSC_STOP(BEStoreTilesClear, 1, pDC->drawId);
+
+            if (cleared)
+            {
+                if (pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_INVALID)
+                {
+                    pHotTile->state = HOTTILE_INVALID;
+                }
+                return;
+            }
+        }
+
+        // clear if clear is pending (i.e., not rendered to), then mark as dirty for store.
+        MaterializeHotTileClear(pHotTile, pDesc->attachment);
+    }
+
+    if (pHotTile->state == HOTTILE_DIRTY || pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
+    {
+        pContext->pfnStoreTile(GetPrivateState(pDC), srcFormat,
+            pDesc->attachment, destX, destY, pHotTile->renderTargetArrayIndex, pHotTile->numSamples, pHotTile->pBuffer);
+    }
+
+    if (pHotTile->state == HOTTILE_DIRTY || pHotTile->state == HOTTILE_RESOLVED)
+    {
+        pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
+    }
+}
+
 void ProcessStoreTileBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
 {
     RDTSC_START(BEStoreTiles);
@@ -348,51 +483,28 @@ void ProcessStoreTileBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile
 #ifdef KNOB_ENABLE_RDTSC
     uint32_t numTiles = 0;
 #endif
-    SWR_FORMAT srcFormat;
-    switch (pDesc->attachment)
-    {
-    case SWR_ATTACHMENT_COLOR0:
-    case SWR_ATTACHMENT_COLOR1:
-    case SWR_ATTACHMENT_COLOR2:
-    case SWR_ATTACHMENT_COLOR3:
-    case SWR_ATTACHMENT_COLOR4:
-    case SWR_ATTACHMENT_COLOR5:
-    case SWR_ATTACHMENT_COLOR6:
-    case SWR_ATTACHMENT_COLOR7: srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_DEPTH: srcFormat = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_STENCIL: srcFormat = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-    default: SWR_ASSERT(false, "Unknown attachment: %d", pDesc->attachment); srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    }
+    SWR_FORMAT srcFormat = HotTileMgr::GetHotTileFormat(pDesc->attachment);
 
     uint32_t x, y;
     MacroTileMgr::getTileIndices(macroTile, x, y);
 
-    // Only need to store the hottile if it's been rendered to...
-    HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, pDesc->attachment, false);
-    if (pHotTile)
-    {
-        // clear if clear is pending (i.e., not rendered to), then mark as dirty for store.
-        if (pHotTile->state == HOTTILE_CLEAR)
-        {
-            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[srcFormat];
-            SWR_ASSERT(pfnClearTiles != nullptr);
-
-            pfnClearTiles(pDC, pDesc->attachment, macroTile, pHotTile->clearData);
-        }
-
-        if (pHotTile->state == HOTTILE_DIRTY || pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
-        {
-            int destX = KNOB_MACROTILE_X_DIM * x;
-            int destY = KNOB_MACROTILE_Y_DIM * y;
+    int destX = KNOB_MACROTILE_X_DIM * x;
+    int destY = KNOB_MACROTILE_Y_DIM * y;
 
-            pContext->pfnStoreTile(GetPrivateState(pDC), srcFormat,
-                pDesc->attachment, destX, destY, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
-        }
-        
-
-        if (pHotTile->state == HOTTILE_DIRTY || pHotTile->state == HOTTILE_RESOLVED)
+    // Only need to store the hottile if it's been rendered to. All resident array
+    // slices of the macrotile are resolved together, without switching slices.
+    HOTTILE *pHotTile = &pContext->pHotTileMgr->GetHotTile(macroTile).Attachment[pDesc->attachment];
+    if (pHotTile->pBuffer == NULL && pHotTile->state == HOTTILE_CLEAR)
+    {
+        // evicted by Trim() with its clear still pending, which has to reach the surface
+        pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, pDesc->attachment, true,
+            pHotTile->numSamples, pHotTile->renderTargetArrayIndex);
+    }
+    if (pHotTile->pBuffer != NULL)
+    {
+        for (; pHotTile != nullptr; pHotTile = pHotTile->pNextSlice)
         {
-            pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
+            StoreHotTileSlice(pDC, pDesc, srcFormat, destX, destY, pHotTile);
         }
     }
     RDTSC_STOP(BEStoreTiles, numTiles, pDC->drawId);
@@ -404,12 +516,12 @@ void ProcessInvalidateTilesBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t mac
     INVALIDATE_TILES_DESC *pDesc = (INVALIDATE_TILES_DESC*)pData;
     SWR_CONTEXT *pContext = pDC->pContext;
 
+    HotTileSet &tile = pContext->pHotTileMgr->GetHotTile(macroTile);
     for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; ++i)
     {
         if (pDesc->attachmentMask & (1 << i))
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, (SWR_RENDERTARGET_ATTACHMENT)i, false);
-            if (pHotTile)
+            for (HOTTILE *pHotTile = &tile.Attachment[i]; pHotTile != nullptr; pHotTile = pHotTile->pNextSlice)
             {
                 pHotTile->state = HOTTILE_INVALID;
             }
@@ -1184,6 +1296,7 @@ void BackendNullPS(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y,
 
     SWR_CONTEXT *pContext = pDC->pContext;
     const API_STATE& state = GetApiState(pDC);
+    const SWR_RASTSTATE& rastState = state.rastState;
     // todo multisample
     uint64_t coverageMask = work.coverageMask[0];
 
@@ -1230,13 +1343,22 @@ void BackendNullPS(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y,
 
                 RDTSC_STOP(BEBarycentric, 0, 0);
 
-                simdscalar depthPassMask = vMask(coverageMask & MASK);
-                simdscalar stencilPassMask = depthPassMask;
+                simdmask clipCoverageMask = coverageMask & MASK;
+
+                // interpolate user clip distance if available
+                if (rastState.clipDistanceMask)
+                {
+                    clipCoverageMask &= ~ComputeUserClipMask(rastState.clipDistanceMask, work.pUserClipBuffer,
+                        psContext.vI, psContext.vJ);
+                }
+
+                simdscalar vCoverageMask = vMask(clipCoverageMask);
+                simdscalar stencilPassMask = vCoverageMask;
 
                 RDTSC_START(BEEarlyDepthTest);
-                depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
-                                      psContext.vZ, pDepthBase, depthPassMask, pStencilBase, &stencilPassMask);
-                DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ, pDepthBase, depthPassMask, depthPassMask,
+                simdscalar depthPassMask = DepthStencilTest(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing,
+                                      psContext.vZ, pDepthBase, vCoverageMask, pStencilBase, &stencilPassMask);
+                DepthStencilWrite(&state.vp[0], &state.depthStencilState, work.triFlags.frontFacing, psContext.vZ, pDepthBase, depthPassMask, vCoverageMask,
                     pStencilBase, stencilPassMask);
                 RDTSC_STOP(BEEarlyDepthTest, 0, 0);
 
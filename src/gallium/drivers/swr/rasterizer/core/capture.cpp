@@ -0,0 +1,347 @@
+/****************************************************************************
+* Copyright (C) 2014-2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file capture.cpp
+*
+* @brief API stream capture, replayed against the core by swr_replay.
+*
+******************************************************************************/
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+#include "core/capture.h"
+#include "core/context.h"
+#include "core/utils.h"
+
+API_STATE* GetDrawState(SWR_CONTEXT *pContext);
+void FlushDrawBatch(SWR_CONTEXT *pContext);
+
+// state deltas are found by comparing chunks of this size
+static const uint32_t CAPTURE_STATE_CHUNK = 64;
+
+//////////////////////////////////////////////////////////////////////////
+/// CAPTURE_CONTEXT
+/// @brief Recorder state of a context.
+/////////////////////////////////////////////////////////////////////////
+struct CAPTURE_CONTEXT
+{
+    API_STATE lastState;            // state of the previous submission, as written
+    API_STATE state;                // state of this submission, as written
+    std::vector<uint8_t> runs;      // state delta being built
+    bool pendingGpuWrites;          // earlier submissions may still write buffers
+};
+
+// last contents written for a buffer address
+struct CAPTURE_BUFFER
+{
+    uint64_t id;
+    uint32_t size;
+    uint32_t crc;
+};
+
+// one capture file per process, shared by all contexts
+static struct
+{
+    std::mutex lock;
+    FILE* pFile;
+    bool initialized;
+    uint64_t nextBufferId;
+    std::unordered_map<const void*, CAPTURE_BUFFER> buffers;
+    std::unordered_map<const void*, uint32_t> fetchStreams;     // vertex streams read by each fetch function
+} gCapture;
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Opens the capture file named by KNOB_CAPTURE_FILE on first use.
+///        Returns null if capture is disabled.
+static FILE* OpenCaptureFile()
+{
+    if (!gCapture.initialized)
+    {
+        gCapture.initialized = true;
+
+        if (!KNOB_CAPTURE_FILE.empty())
+        {
+            gCapture.pFile = fopen(KNOB_CAPTURE_FILE.c_str(), "wb");
+            SWR_ASSERT(gCapture.pFile != nullptr, "Failed to open capture file %s", KNOB_CAPTURE_FILE.c_str());
+
+            if (gCapture.pFile != nullptr)
+            {
+                SWR_CAPTURE_HEADER header = { SWR_CAPTURE_MAGIC, SWR_CAPTURE_VERSION, sizeof(API_STATE), KNOB_SIMD_WIDTH };
+                fwrite(&header, sizeof(header), 1, gCapture.pFile);
+            }
+        }
+    }
+
+    return gCapture.pFile;
+}
+
+static void WriteRecord(uint32_t op, uint64_t context, const void* pArgs, uint32_t argsSize,
+    const void* pData = nullptr, uint32_t dataSize = 0)
+{
+    static const uint8_t padding[SWR_CAPTURE_ALIGN] = {};
+
+    SWR_CAPTURE_RECORD record = { op, argsSize + dataSize, context };
+    fwrite(&record, sizeof(record), 1, gCapture.pFile);
+
+    if (argsSize)
+    {
+        fwrite(pArgs, argsSize, 1, gCapture.pFile);
+    }
+
+    if (dataSize)
+    {
+        fwrite(pData, dataSize, 1, gCapture.pFile);
+    }
+
+    uint32_t paddingSize = AlignUp(record.size, SWR_CAPTURE_ALIGN) - record.size;
+    if (paddingSize)
+    {
+        fwrite(padding, paddingSize, 1, gCapture.pFile);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the id of a buffer's current contents, writing them if
+///        they were not written before.
+static uint64_t CaptureBuffer(uint64_t context, const void* pData, uint32_t size)
+{
+    if (pData == nullptr)
+    {
+        return 0;
+    }
+
+    uint32_t crc = ComputeCRC(0, pData, size);
+
+    CAPTURE_BUFFER& buffer = gCapture.buffers[pData];
+    if (buffer.id == 0 || buffer.size != size || buffer.crc != crc)
+    {
+        buffer.id = ++gCapture.nextBufferId;
+        buffer.size = size;
+        buffer.crc = crc;
+
+        SWR_CAPTURE_BUFFER_ARGS args = { buffer.id, size, 0 };
+        WriteRecord(SWR_CAPTURE_BUFFER, context, &args, sizeof(args), pData, size);
+    }
+
+    return buffer.id;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the state the next submission on the context uses.
+static const API_STATE& GetCurrentState(SWR_CONTEXT *pContext)
+{
+    DRAW_CONTEXT* pDC = pContext->pCurDrawContext;
+    if (pDC == nullptr)
+    {
+        pDC = pContext->pBatchDrawContext ? pContext->pBatchDrawContext : pContext->pPrevDrawContext;
+    }
+
+    SWR_ASSERT(pDC != nullptr);
+    return GetApiState(pDC);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writes the changes to the state since the previous submission.
+///        Draws also write the buffers they read.
+static void CaptureState(CAPTURE_CONTEXT* pCapture, uint64_t context, const API_STATE& apiState,
+    bool isDraw, bool isIndexed)
+{
+    API_STATE& state = pCapture->state;
+    memcpy(&state, &apiState, sizeof(API_STATE));
+
+    if (isDraw)
+    {
+        // Bindings the fetch shader doesn't read may be stale, so only those it reads are written.
+        uint32_t streamMask = 0xffffffff;
+        auto fetch = gCapture.fetchStreams.find((const void*)state.pfnFetchFunc);
+        if (fetch != gCapture.fetchStreams.end())
+        {
+            streamMask = fetch->second;
+        }
+
+        for (uint32_t i = 0; i < KNOB_NUM_STREAMS; ++i)
+        {
+            SWR_VERTEX_BUFFER_STATE& vb = state.vertexBuffers[i];
+            bool isRead = (streamMask >> i) & 1;
+            vb.pData = isRead ? (const uint8_t*)CaptureBuffer(context, vb.pData, vb.size) : nullptr;
+        }
+
+        state.indexBuffer.pIndices = isIndexed ?
+            (const void*)CaptureBuffer(context, state.indexBuffer.pIndices, state.indexBuffer.size) : nullptr;
+
+        for (uint32_t i = 0; i < MAX_SO_STREAMS; ++i)
+        {
+            SWR_STREAMOUT_BUFFER& so = state.soBuffer[i];
+            if (state.soState.soEnable && so.enable)
+            {
+                so.pBuffer = (uint32_t*)CaptureBuffer(context, so.pBuffer, so.bufferSize * sizeof(uint32_t));
+                so.pWriteOffset = (uint32_t*)CaptureBuffer(context, so.pWriteOffset, sizeof(uint32_t));
+            }
+            else
+            {
+                so.pBuffer = nullptr;
+                so.pWriteOffset = nullptr;
+            }
+        }
+    }
+    else
+    {
+        // Buffers are unused, keep the ones of the previous submission.
+        memcpy(state.vertexBuffers, pCapture->lastState.vertexBuffers, sizeof(state.vertexBuffers));
+        state.indexBuffer = pCapture->lastState.indexBuffer;
+        memcpy(state.soBuffer, pCapture->lastState.soBuffer, sizeof(state.soBuffer));
+    }
+
+    // Write runs of changed chunks.
+    const uint8_t* pNew = (const uint8_t*)&state;
+    const uint8_t* pOld = (const uint8_t*)&pCapture->lastState;
+    pCapture->runs.clear();
+
+    uint32_t offset = 0;
+    while (offset < sizeof(API_STATE))
+    {
+        uint32_t start = offset;
+        while (offset < sizeof(API_STATE))
+        {
+            uint32_t size = std::min<uint32_t>(CAPTURE_STATE_CHUNK, sizeof(API_STATE) - offset);
+            if (memcmp(&pNew[offset], &pOld[offset], size) == 0)
+            {
+                break;
+            }
+            offset += size;
+        }
+
+        if (offset > start)
+        {
+            SWR_CAPTURE_STATE_RUN run = { start, offset - start };
+            pCapture->runs.insert(pCapture->runs.end(), (const uint8_t*)&run, (const uint8_t*)(&run + 1));
+            pCapture->runs.insert(pCapture->runs.end(), &pNew[start], &pNew[offset]);
+        }
+
+        offset += CAPTURE_STATE_CHUNK;
+    }
+
+    if (!pCapture->runs.empty())
+    {
+        WriteRecord(SWR_CAPTURE_STATE, context, pCapture->runs.data(), (uint32_t)pCapture->runs.size());
+        memcpy(&pCapture->lastState, &state, sizeof(API_STATE));
+    }
+}
+
+void CaptureCreateContext(SWR_CONTEXT *pContext, const SWR_CREATECONTEXT_INFO* pCreateInfo)
+{
+    std::lock_guard<std::mutex> guard(gCapture.lock);
+
+    if (OpenCaptureFile() == nullptr)
+    {
+        return;
+    }
+
+    void* pCaptureMem = _aligned_malloc(sizeof(CAPTURE_CONTEXT), 64);
+    memset(pCaptureMem, 0, sizeof(CAPTURE_CONTEXT));
+    pContext->pCapture = new (pCaptureMem) CAPTURE_CONTEXT();
+
+    SWR_CAPTURE_CREATE_ARGS args = { pCreateInfo->driver, pCreateInfo->privateStateSize };
+    WriteRecord(SWR_CAPTURE_CREATE_CONTEXT, (uint64_t)pContext, &args, sizeof(args));
+}
+
+void CaptureDestroyContext(SWR_CONTEXT *pContext)
+{
+    std::lock_guard<std::mutex> guard(gCapture.lock);
+
+    WriteRecord(SWR_CAPTURE_DESTROY_CONTEXT, (uint64_t)pContext, nullptr, 0);
+    fflush(gCapture.pFile);
+
+    pContext->pCapture->~CAPTURE_CONTEXT();
+    _aligned_free(pContext->pCapture);
+    pContext->pCapture = nullptr;
+}
+
+void CaptureCall(SWR_CONTEXT *pContext, SWR_CAPTURE_OP op, const void* pArgs, uint32_t argsSize,
+    const void* pData, uint32_t dataSize)
+{
+    CAPTURE_CONTEXT* pCapture = pContext->pCapture;
+    SWR_ASSERT(pCapture != nullptr);
+
+    bool isSubmit = op >= SWR_CAPTURE_DRAW && op <= SWR_CAPTURE_INVALIDATE_TILES;
+    bool isDraw = op >= SWR_CAPTURE_DRAW && op <= SWR_CAPTURE_DRAW_INDEXED_INDIRECT;
+    bool isIndexed = op == SWR_CAPTURE_DRAW_INDEXED || op == SWR_CAPTURE_DRAW_INDEXED_INDIRECT;
+
+    // Buffer contents and indirect arguments are read below. Let earlier streamout
+    // and compute work finish writing them first.
+    if (isDraw && pCapture->pendingGpuWrites)
+    {
+        FlushDrawBatch(pContext);
+        if (pContext->pPrevDrawContext)
+        {
+            WaitForDependencies(pContext, pContext->pPrevDrawContext->drawId);
+        }
+        pCapture->pendingGpuWrites = false;
+    }
+
+    std::lock_guard<std::mutex> guard(gCapture.lock);
+
+    if (isSubmit)
+    {
+        const API_STATE& state = GetCurrentState(pContext);
+        CaptureState(pCapture, (uint64_t)pContext, state, isDraw, isIndexed);
+
+        if ((isDraw && state.soState.soEnable) || op == SWR_CAPTURE_DISPATCH)
+        {
+            pCapture->pendingGpuWrites = true;
+        }
+    }
+
+    WriteRecord(op, (uint64_t)pContext, pArgs, argsSize, pData, dataSize);
+
+    if (op == SWR_CAPTURE_END_FRAME)
+    {
+        fflush(gCapture.pFile);
+    }
+}
+
+void CaptureJitFunction(SWR_CAPTURE_JIT_TYPE type, const void* pfnFunc,
+    const void* pState, uint32_t stateSize, uint32_t streamMask)
+{
+    std::lock_guard<std::mutex> guard(gCapture.lock);
+
+    if (OpenCaptureFile() == nullptr)
+    {
+        return;
+    }
+
+    if (type == SWR_CAPTURE_JIT_FETCH)
+    {
+        gCapture.fetchStreams[pfnFunc] = streamMask;
+    }
+
+    SWR_CAPTURE_JIT_ARGS args = { type, stateSize, (uint64_t)pfnFunc };
+    WriteRecord(SWR_CAPTURE_JIT_FUNCTION, 0, &args, sizeof(args), pState, stateSize);
+}
+
+void CaptureApplyState(HANDLE hContext, const API_STATE& state)
+{
+    API_STATE* pState = GetDrawState((SWR_CONTEXT*)hContext);
+    memcpy(pState, &state, sizeof(API_STATE));
+}
@@ -0,0 +1,200 @@
+/****************************************************************************
+* Copyright (C) 2014-2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file capture.h
+*
+* @brief API stream capture, replayed against the core by swr_replay.
+*
+*        A capture is a header followed by records. Each record is a
+*        SWR_CAPTURE_RECORD, padded to SWR_CAPTURE_ALIGN bytes, followed by
+*        its payload. State is recorded at each submission as a delta of
+*        API_STATE against the previous submission on the context, with
+*        buffer pointers replaced by buffer ids. Function pointers are
+*        recorded as is and identify the shader; fetch, streamout and blend
+*        functions are described by a JIT record with their compile state.
+*
+******************************************************************************/
+#pragma once
+
+#include "core/api.h"
+
+struct SWR_CONTEXT;
+struct API_STATE;
+
+#define SWR_CAPTURE_MAGIC   0x43525753  // "SWRC"
+#define SWR_CAPTURE_VERSION 1
+#define SWR_CAPTURE_ALIGN   16
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_CAPTURE_HEADER
+/////////////////////////////////////////////////////////////////////////
+struct SWR_CAPTURE_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t apiStateSize;  // sizeof(API_STATE), replay requires a matching core
+    uint32_t simdWidth;
+};
+
+enum SWR_CAPTURE_OP
+{
+    SWR_CAPTURE_CREATE_CONTEXT,         // SWR_CAPTURE_CREATE_ARGS
+    SWR_CAPTURE_DESTROY_CONTEXT,
+    SWR_CAPTURE_JIT_FUNCTION,           // SWR_CAPTURE_JIT_ARGS, compile state
+    SWR_CAPTURE_BUFFER,                 // SWR_CAPTURE_BUFFER_ARGS, buffer contents
+    SWR_CAPTURE_STATE,                  // SWR_CAPTURE_STATE_RUN, changed bytes, ...
+
+    // submissions, preceded by the state they use
+    SWR_CAPTURE_DRAW,                   // SWR_CAPTURE_DRAW_ARGS
+    SWR_CAPTURE_DRAW_INDEXED,           // SWR_CAPTURE_DRAW_ARGS
+    SWR_CAPTURE_DRAW_INDIRECT,          // SWR_CAPTURE_INDIRECT_ARGS, draw arguments
+    SWR_CAPTURE_DRAW_INDEXED_INDIRECT,  // SWR_CAPTURE_INDIRECT_ARGS, draw arguments
+    SWR_CAPTURE_DISPATCH,               // SWR_CAPTURE_DISPATCH_ARGS
+    SWR_CAPTURE_CLEAR,                  // SWR_CAPTURE_CLEAR_ARGS
+    SWR_CAPTURE_STORE_TILES,            // SWR_CAPTURE_STORE_ARGS
+    SWR_CAPTURE_INVALIDATE_TILES,       // uint32_t attachment mask
+
+    SWR_CAPTURE_SYNC,
+    SWR_CAPTURE_WAIT_FOR_IDLE,
+    SWR_CAPTURE_END_FRAME,
+};
+
+enum SWR_CAPTURE_JIT_TYPE
+{
+    SWR_CAPTURE_JIT_FETCH,      // FETCH_COMPILE_STATE
+    SWR_CAPTURE_JIT_STREAMOUT,  // STREAMOUT_COMPILE_STATE
+    SWR_CAPTURE_JIT_BLEND,      // BLEND_COMPILE_STATE
+};
+
+struct SWR_CAPTURE_RECORD
+{
+    uint32_t op;            // SWR_CAPTURE_OP
+    uint32_t size;          // payload size, not including padding
+    uint64_t context;       // id of the context the call was made on
+};
+
+struct SWR_CAPTURE_CREATE_ARGS
+{
+    uint32_t driver;
+    uint32_t privateStateSize;
+};
+
+struct SWR_CAPTURE_JIT_ARGS
+{
+    uint32_t type;          // SWR_CAPTURE_JIT_TYPE
+    uint32_t stateSize;
+    uint64_t func;          // captured function pointer
+};
+
+struct SWR_CAPTURE_BUFFER_ARGS
+{
+    uint64_t id;            // replaces the buffer pointer in captured state
+    uint32_t size;
+    uint32_t pad;           // keeps the contents SWR_CAPTURE_ALIGN aligned
+};
+
+struct SWR_CAPTURE_STATE_RUN
+{
+    uint32_t offset;        // byte offset into API_STATE
+    uint32_t size;
+};
+
+struct SWR_CAPTURE_DRAW_ARGS
+{
+    uint32_t topology;
+    uint32_t numVerts;      // numIndices for indexed draws
+    uint32_t start;         // startVertex, or indexOffset for indexed draws
+    int32_t  baseVertex;
+    uint32_t numInstances;
+    uint32_t startInstance;
+};
+
+struct SWR_CAPTURE_INDIRECT_ARGS
+{
+    uint32_t topology;
+    uint32_t drawCount;
+    uint32_t stride;
+    uint32_t pad;
+};
+
+struct SWR_CAPTURE_DISPATCH_ARGS
+{
+    uint32_t threadGroupCountX;
+    uint32_t threadGroupCountY;
+    uint32_t threadGroupCountZ;
+};
+
+struct SWR_CAPTURE_CLEAR_ARGS
+{
+    uint32_t clearMask;
+    float clearColor[4];
+    float z;
+    uint32_t stencil;
+};
+
+struct SWR_CAPTURE_STORE_ARGS
+{
+    uint32_t attachment;
+    uint32_t postStoreTileState;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Starts recording a context if KNOB_CAPTURE_FILE is set.
+/// @param pContext - pointer to SWR context.
+/// @param pCreateInfo - context creation info.
+void CaptureCreateContext(SWR_CONTEXT *pContext, const SWR_CREATECONTEXT_INFO* pCreateInfo);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stops recording a context.
+/// @param pContext - pointer to SWR context.
+void CaptureDestroyContext(SWR_CONTEXT *pContext);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Records an API call. Submissions first record the state and
+///        buffer contents they use.
+/// @param pContext - pointer to SWR context, recording.
+/// @param op - API call.
+/// @param pArgs - call arguments, the SWR_CAPTURE_*_ARGS of op.
+/// @param argsSize - size of pArgs.
+/// @param pData - optional data following the arguments.
+/// @param dataSize - size of pData.
+void CaptureCall(SWR_CONTEXT *pContext, SWR_CAPTURE_OP op, const void* pArgs = nullptr,
+    uint32_t argsSize = 0, const void* pData = nullptr, uint32_t dataSize = 0);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Records the compile state of a JIT function, so replay can
+///        compile it again.
+/// @param type - kind of function.
+/// @param pfnFunc - compiled function, as referenced by captured state.
+/// @param pState - compile state.
+/// @param stateSize - size of pState.
+/// @param streamMask - vertex streams a fetch function reads. Other bindings
+///                     aren't recorded, they may be stale.
+void CaptureJitFunction(SWR_CAPTURE_JIT_TYPE type, const void* pfnFunc,
+    const void* pState, uint32_t stateSize, uint32_t streamMask = 0xffffffff);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Replaces the state of a context. Used by replay to apply
+///        captured state.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param state - new state.
+void CaptureApplyState(HANDLE hContext, const API_STATE& state);
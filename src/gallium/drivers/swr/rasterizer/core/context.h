@@ -93,6 +93,18 @@ struct TRIANGLE_WORK_DESC
     TRI_FLAGS triFlags;
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// POINTS_WORK_DESC - single pixel points of a SIMD binned to one
+/// macrotile. Work items for the macrotiles of a SIMD share the buffers.
+/////////////////////////////////////////////////////////////////////////
+struct POINTS_WORK_DESC
+{
+    float *pPointBuffer;    // SIMDs of pixel x, pixel y, z, primID, render target array index
+    float *pAttribs;        // attribs of each lane, numAttribs * 3 verts * 4 components apart
+    uint32_t numAttribs;
+    uint32_t pointMask;     // lanes binned to the macrotile
+};
+
 union CLEAR_FLAGS
 {
     struct
@@ -113,6 +125,8 @@ struct CLEAR_DESC
 struct INVALIDATE_TILES_DESC
 {
     uint32_t attachmentMask;
+    const uint32_t* pMacroTiles;    // macrotiles with hot tile contents, packed as tile ids
+    uint32_t numMacroTiles;
 };
 
 struct SYNC_DESC
@@ -131,6 +145,9 @@ struct STORE_TILES_DESC
 {
     SWR_RENDERTARGET_ATTACHMENT attachment;
     SWR_TILE_STATE postStoreTileState;
+    const uint32_t* pMacroTiles;    // dirty macrotiles followed by clean ones, packed as tile ids
+    uint32_t numStoreTiles;         // dirty macrotiles to store
+    uint32_t numCleanTiles;         // clean macrotiles, only invalidated if postStoreTileState is invalid
 };
 
 struct COMPUTE_DESC
@@ -160,6 +177,7 @@ struct BE_WORK
     {
         SYNC_DESC sync;
         TRIANGLE_WORK_DESC tri;
+        POINTS_WORK_DESC points;
         CLEAR_DESC clear;
         INVALIDATE_TILES_DESC invalidateTiles;
         STORE_TILES_DESC storeTiles;
@@ -185,6 +203,21 @@ struct DRAW_WORK
     uint32_t   startInstance;       // Instance offset
     uint32_t   startPrimID;         // starting primitiveID for this draw batch
     SWR_FORMAT type;                // index buffer type
+
+    // Stream out: when set, SO buffer ranges were reserved by the API for the whole
+    // draw and each prim writes at its own offset, so split draws can stream out in
+    // parallel. Prims of instance N start at N * soPrimsPerInstance.
+    uint32_t   soPrimsPerInstance;
+
+    // Indirect draws: when pIndirectArgs is set the per-draw fields above are
+    // read from the app's argument buffer by the FE, pIB holds the index buffer base.
+    const uint8_t* pIndirectArgs;   // SWR_DRAW_(INDEXED_)INDIRECT_ARGS array
+    uint32_t   numIndirectDraws;    // Number of draws in pIndirectArgs
+    uint32_t   indirectStride;      // Byte stride between draw arguments
+
+    // Batched draws: consecutive draws sharing all state, processed in order.
+    DRAW_WORK* pSubDraws;           // Draws of the batch, including this one
+    uint32_t   numSubDraws;         // Number of draws in pSubDraws
 };
 
 typedef void(*PFN_FE_WORK_FUNC)(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t workerId, void* pDesc);
@@ -228,6 +261,9 @@ OSALIGNLINE(struct) API_STATE
     // VS - Vertex Shader State
     PFN_VERTEX_FUNC         pfnVertexFunc;
 
+    // Fused FS + VS. Replaces pfnFetchFunc/pfnVertexFunc when set.
+    PFN_FETCH_VS_FUNC       pfnFetchVsFunc;
+
     // GS - Geometry Shader State
     PFN_GS_FUNC             pfnGsFunc;
     SWR_GS_STATE            gsState;
@@ -235,6 +271,7 @@ OSALIGNLINE(struct) API_STATE
     // CS - Compute Shader
     PFN_CS_FUNC             pfnCsFunc;
     uint32_t                totalThreadsInGroup;
+    uint32_t                totalSpillFillSize;
 
     // FE - Frontend State
     SWR_FRONTEND_STATE      frontendState;
@@ -316,6 +353,9 @@ struct DRAW_STATE
     // pipeline function pointers, filled in by API thread when setting up the draw
     PFN_BACKEND_FUNC pfnBackend;
     PFN_PROCESS_PRIMS pfnProcessPrims;
+    bool pipelineValid;   // Derived state above and scissors are set up for this state.
+
+    uint64_t lastDrawId;  // Last draw referencing this state. Its arena is released once it retires.
 
     Arena    arena;     // This should only be used by API thread.
 };
@@ -337,6 +377,7 @@ struct DRAW_CONTEXT
     volatile OSALIGNLINE(bool) doneFE;    // Is FE work done for this draw?
 
     uint64_t dependency;
+    bool dependentFE;   // FE waits until all prior draws finish their FE work
 
     MacroTileMgr* pTileMgr;
 
@@ -345,9 +386,8 @@ struct DRAW_CONTEXT
     DispatchQueue* pDispatch;               // Queue for thread groups. (isCompute)
 
     DRAW_STATE* pState;
+    bool sharedState;   // pState belongs to an earlier DC. Copied before it's modified.
     Arena    arena;
-
-    uint8_t* pSpillFill[KNOB_MAX_NUM_THREADS];  // Scratch space used for spill fills.
 };
 
 INLINE const API_STATE& GetApiState(const DRAW_CONTEXT* pDC)
@@ -367,6 +407,8 @@ INLINE void* GetPrivateState(const DRAW_CONTEXT* pDC)
 }
 
 class HotTileMgr;
+class MacroTileMask;
+struct CAPTURE_CONTEXT;
 
 struct SWR_CONTEXT
 {
@@ -391,6 +433,12 @@ struct SWR_CONTEXT
     DRAW_CONTEXT *pCurDrawContext;    // This points to DC entry in ring for an unsubmitted draw.
     DRAW_CONTEXT *pPrevDrawContext;   // This points to DC entry for the previous context submitted that we can copy state from.
 
+    // Draw batching
+    //  A small draw is left unsubmitted in pBatchDrawContext. Following draws with identical state
+    //  are appended to its sub-draw table instead of taking a DC of their own. Any other submission
+    //  queues the batch first, so it keeps its place in draw order.
+    DRAW_CONTEXT *pBatchDrawContext;
+
     // Draw State Ring
     //  When draw are very large (lots of primitives) then the API thread will break these up.
     //  These split draws all have identical state. So instead of storing the state directly
@@ -399,14 +447,12 @@ struct SWR_CONTEXT
     DRAW_STATE*   dsRing;
 
     uint32_t curStateId;               // Current index to the next available entry in the DS ring.
+    uint32_t dsReleaseId;              // Oldest entry in the DS ring whose arena may still hold memory.
 
     uint32_t NumWorkerThreads;
 
     THREAD_POOL threadPool; // Thread pool associated with this context
 
-    std::condition_variable FifosNotEmpty;
-    std::mutex WaitLock;
-
     // Draw Contexts will get a unique drawId generated from this
     uint64_t nextDrawId;
 
@@ -417,6 +463,15 @@ struct SWR_CONTEXT
     // written by api thread, read by multiple workers
     OSALIGNLINE(volatile uint64_t) DrawEnqueued;
 
+    // Arena blocks shared by the DC and DS rings. A DC's arena is released as soon as
+    // its draw retires, and a DS's once the last draw referencing it retires and a
+    // newer state has replaced it, so ring slots hold no memory while they are free.
+    ArenaBlockCache* pArenaBlockCache;
+
+    // Occupancy of the DC ring and time the API thread waited for a free DC.
+    // Only used by the API thread.
+    SWR_DRAW_RING_STATS ringStats;
+
     // Current FE status of each worker.
     OSALIGNLINE(volatile uint64_t) WorkerFE[KNOB_MAX_NUM_THREADS];
     OSALIGNLINE(volatile uint64_t) WorkerBE[KNOB_MAX_NUM_THREADS];
@@ -427,6 +482,13 @@ struct SWR_CONTEXT
 
     HotTileMgr *pHotTileMgr;
 
+    // Macrotiles of each attachment that draws and clears may have rendered to
+    // since its last store, and macrotiles it may have hot tile contents for.
+    // Stores and invalidates skip the others. Only used by the API thread.
+    MacroTileMask* pDirtyTiles;     // [SWR_NUM_ATTACHMENTS]
+    MacroTileMask* pValidTiles;     // [SWR_NUM_ATTACHMENTS]
+    BBOX lastStoreRect[SWR_NUM_ATTACHMENTS];
+
     // tile load/store functions, passed in at create context time
     PFN_LOAD_TILE pfnLoadTile;
     PFN_STORE_TILE pfnStoreTile;
@@ -437,10 +499,16 @@ struct SWR_CONTEXT
 
     // Scratch space for workers.
     uint8_t* pScratch[KNOB_MAX_NUM_THREADS];
+
+    // Spill fill space for workers, grown to the largest dispatch seen.
+    uint8_t* pSpillFill[KNOB_MAX_NUM_THREADS];
+    uint32_t spillFillSize[KNOB_MAX_NUM_THREADS];
+
+    // API capture recorder, null unless KNOB_CAPTURE_FILE is set.
+    CAPTURE_CONTEXT* pCapture;
 };
 
 void WaitForDependencies(SWR_CONTEXT *pContext, uint64_t drawId);
-void WakeAllThreads(SWR_CONTEXT *pContext);
 
 #define UPDATE_STAT(name, count) if (GetApiState(pDC).enableStats) { pContext->stats[workerId].name += count; }
 #define SET_STAT(name, count) if (GetApiState(pDC).enableStats) { pContext->stats[workerId].name = count; }
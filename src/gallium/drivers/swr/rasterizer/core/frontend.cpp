@@ -168,27 +168,32 @@ void ProcessStoreTiles(
     STORE_TILES_DESC *pStore = (STORE_TILES_DESC*)pUserData;
     MacroTileMgr *pTileMgr = pDC->pTileMgr;
 
-    const API_STATE& state = GetApiState(pDC);
-
-    // queue a store to each macro tile
-    // compute macro tile bounds for the current render target
-    const uint32_t macroWidth = KNOB_MACROTILE_X_DIM;
-    const uint32_t macroHeight = KNOB_MACROTILE_Y_DIM;
-
-    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (macroWidth - 1)) / macroWidth;
-    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (macroHeight - 1)) / macroHeight;
-
-    // store tiles
+    // queue a store to each dirty macro tile, the API thread picked them
     BE_WORK work;
     work.type = STORETILES;
     work.pfnWork = ProcessStoreTileBE;
     work.desc.storeTiles = *pStore;
 
-    for (uint32_t x = 0; x < numMacroTilesX; ++x)
+    uint32_t x, y;
+    for (uint32_t i = 0; i < pStore->numStoreTiles; ++i)
+    {
+        MacroTileMgr::getTileIndices(pStore->pMacroTiles[i], x, y);
+        pTileMgr->enqueue(x, y, &work);
+    }
+
+    // clean tiles already match the surface, they are only invalidated
+    if (pStore->numCleanTiles > 0)
     {
-        for (uint32_t y = 0; y < numMacroTilesY; ++y)
+        BE_WORK invalidateWork;
+        invalidateWork.type = INVALIDATETILES;
+        invalidateWork.pfnWork = ProcessInvalidateTilesBE;
+        invalidateWork.desc.invalidateTiles.attachmentMask = 1 << pStore->attachment;
+
+        const uint32_t *pCleanTiles = pStore->pMacroTiles + pStore->numStoreTiles;
+        for (uint32_t i = 0; i < pStore->numCleanTiles; ++i)
         {
-            pTileMgr->enqueue(x, y, &work);
+            MacroTileMgr::getTileIndices(pCleanTiles[i], x, y);
+            pTileMgr->enqueue(x, y, &invalidateWork);
         }
     }
 
@@ -215,28 +220,17 @@ void ProcessInvalidateTiles(
     INVALIDATE_TILES_DESC *pInv = (INVALIDATE_TILES_DESC*)pUserData;
     MacroTileMgr *pTileMgr = pDC->pTileMgr;
 
-    const API_STATE& state = GetApiState(pDC);
-
-    // queue a store to each macro tile
-    // compute macro tile bounds for the current render target
-    uint32_t macroWidth = KNOB_MACROTILE_X_DIM;
-    uint32_t macroHeight = KNOB_MACROTILE_Y_DIM;
-
-    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (macroWidth - 1)) / macroWidth;
-    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (macroHeight - 1)) / macroHeight;
-
-    // load tiles
+    // queue an invalidate to each macro tile that may have hot tile contents
     BE_WORK work;
     work.type = INVALIDATETILES;
     work.pfnWork = ProcessInvalidateTilesBE;
     work.desc.invalidateTiles = *pInv;
 
-    for (uint32_t x = 0; x < numMacroTilesX; ++x)
+    for (uint32_t i = 0; i < pInv->numMacroTiles; ++i)
     {
-        for (uint32_t y = 0; y < numMacroTilesY; ++y)
-        {
-            pTileMgr->enqueue(x, y, &work);
-        }
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(pInv->pMacroTiles[i], x, y);
+        pTileMgr->enqueue(x, y, &work);
     }
 
     _ReadWriteBarrier();
@@ -402,7 +396,7 @@ uint32_t GetNumVerts(
 /// @brief Return number of verts per primitive.
 /// @param topology - topology
 /// @param includeAdjVerts - include adjacent verts in primitive vertices
-INLINE uint32_t NumVertsPerPrim(PRIMITIVE_TOPOLOGY topology, bool includeAdjVerts)
+uint32_t NumVertsPerPrim(PRIMITIVE_TOPOLOGY topology, bool includeAdjVerts)
 {
     uint32_t numVerts = 0;
     switch (topology)
@@ -493,11 +487,16 @@ INLINE uint32_t NumVertsPerPrim(PRIMITIVE_TOPOLOGY topology, bool includeAdjVert
 /// @param pDC - pointer to draw context.
 /// @param workerId - thread's worker id. Even thread has a unique id.
 /// @param numPrims - Number of prims to streamout (e.g. points, lines, tris)
+/// @param streamIndex - SO stream the prims belong to
+/// @param pReservedPrims - Per prim index into the SO ranges reserved by
+///        the API, or nullptr to append to the SO buffers in order.
 static void StreamOut(
     DRAW_CONTEXT* pDC,
     PA_STATE& pa,
     uint32_t workerId,
-    uint32_t* pPrimData)
+    uint32_t* pPrimData,
+    uint32_t streamIndex = 0,
+    const uint32_t* pReservedPrims = nullptr)
 {
     RDTSC_START(FEStreamout);
 
@@ -506,7 +505,6 @@ static void StreamOut(
     const API_STATE& state = GetApiState(pDC);
     const SWR_STREAMOUT_STATE &soState = state.soState;
 
-    uint32_t streamIndex = 0; ///@todo Stream index will come from PA_STATE.
     uint32_t soVertsPerPrim = NumVertsPerPrim(pa.binTopology, false);
 
     // The pPrimData buffer is sparse in that we allocate memory for all 32 attributes for each vertex.
@@ -514,10 +512,21 @@ static void StreamOut(
 
     SWR_STREAMOUT_CONTEXT soContext = { 0 };
 
-    // Setup buffer state pointers.
+    // Setup buffer state pointers. Split draws share the state, so reserved
+    // prims work on a private copy of the buffer offsets.
+    SWR_STREAMOUT_BUFFER reservedBuffer[4];
+    uint32_t reservedEnd[4] = { 0 };
     for (uint32_t i = 0; i < 4; ++i)
     {
-        soContext.pBuffer[i] = &state.soBuffer[i];
+        if (pReservedPrims)
+        {
+            reservedBuffer[i] = state.soBuffer[i];
+            soContext.pBuffer[i] = &reservedBuffer[i];
+        }
+        else
+        {
+            soContext.pBuffer[i] = &state.soBuffer[i];
+        }
     }
 
     uint32_t numPrims = pa.NumPrims();
@@ -552,20 +561,71 @@ static void StreamOut(
         // Update pPrimData pointer 
         soContext.pPrimData = pPrimData;
 
+        uint32_t reservedStart[4];
+        if (pReservedPrims)
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                reservedStart[i] = state.soBuffer[i].streamOffset +
+                    pReservedPrims[primIndex] * soVertsPerPrim * state.soBuffer[i].pitch;
+                reservedBuffer[i].streamOffset = reservedStart[i];
+            }
+        }
+
         // Call SOS
         state.pfnSoFunc[streamIndex](soContext);
+
+        if (pReservedPrims)
+        {
+            // The SOS only advances the buffers it wrote the prim to.
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                if (reservedBuffer[i].streamOffset != reservedStart[i])
+                {
+                    reservedEnd[i] = std::max(reservedEnd[i], reservedBuffer[i].streamOffset);
+                }
+            }
+        }
     }
 
-    // Update SO write offset. The driver provides memory for the update.
-    for (uint32_t i = 0; i < 4; ++i)
+    if (pReservedPrims)
+    {
+        // Prims were written out of order, the write offset is the end of the
+        // furthest range written so far.
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            uint32_t* pWriteOffset = state.soBuffer[i].pWriteOffset;
+            uint32_t writeOffset = reservedEnd[i] * sizeof(uint32_t);
+            if (pWriteOffset == nullptr || reservedEnd[i] == 0)
+            {
+                continue;
+            }
+
+            uint32_t prevOffset = *pWriteOffset;
+            while (prevOffset < writeOffset)
+            {
+                uint32_t curOffset = InterlockedCompareExchange((volatile uint32_t*)pWriteOffset, writeOffset, prevOffset);
+                if (curOffset == prevOffset)
+                {
+                    break;
+                }
+                prevOffset = curOffset;
+            }
+        }
+    }
+    else
     {
-        if (state.soBuffer[i].pWriteOffset)
+        // Update SO write offset. The driver provides memory for the update.
+        for (uint32_t i = 0; i < 4; ++i)
         {
-            *state.soBuffer[i].pWriteOffset = soContext.pBuffer[i]->streamOffset * sizeof(uint32_t);
+            if (state.soBuffer[i].pWriteOffset)
+            {
+                *state.soBuffer[i].pWriteOffset = soContext.pBuffer[i]->streamOffset * sizeof(uint32_t);
 
-            // The SOS increments the existing write offset. So we don't want to increment
-            // the SoWriteOffset stat using an absolute offset instead of relative.
-            SET_STAT(SoWriteOffset[i], soContext.pBuffer[i]->streamOffset);
+                // The SOS increments the existing write offset. So we don't want to increment
+                // the SoWriteOffset stat using an absolute offset instead of relative.
+                SET_STAT(SoWriteOffset[i], soContext.pBuffer[i]->streamOffset);
+            }
         }
     }
 
@@ -590,6 +650,41 @@ static INLINE uint32_t GetNumInvocations(
     return (remainder >= KNOB_SIMD_WIDTH) ? KNOB_SIMD_WIDTH : remainder;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Layout of the GS output buffers. Each stream holds, per GS
+///        instance and per input prim (SIMD lane), maxNumVerts vertices in
+///        simd batches. Vertices are packed to outputVertexSize slots.
+struct GsBufferLayout
+{
+    uint32_t numStreams;
+    uint32_t numSlots;              // simdvector slots per vertex
+    uint32_t inputPrimStride;       // bytes per input prim
+    uint32_t instanceStride;        // bytes per GS instance
+    uint32_t streamStride;          // bytes per stream
+    uint32_t cutPrimStride;         // cut buffer bytes per input prim
+    uint32_t cutInstanceStride;     // cut buffer bytes per GS instance
+    uint32_t cutStreamStride;       // cut buffer bytes per stream
+
+    GsBufferLayout(const SWR_GS_STATE& gsState)
+    {
+        numStreams = std::max<uint32_t>(gsState.numStreams, 1);
+        numSlots = gsState.outputVertexSize ? gsState.outputVertexSize : KNOB_NUM_ATTRIBUTES;
+        SWR_ASSERT(numStreams <= MAX_SO_STREAMS);
+        SWR_ASSERT(numSlots <= KNOB_NUM_ATTRIBUTES);
+
+        const uint32_t vertexStride = numSlots * sizeof(simdvector);
+        const uint32_t numSimdBatches = (gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
+        inputPrimStride = numSimdBatches * vertexStride;
+        instanceStride = inputPrimStride * KNOB_SIMD_WIDTH;
+        streamStride = instanceStride * gsState.instanceCount;
+
+        // the cut buffer is a bitfield sized to the maximum vertex output
+        cutPrimStride = (gsState.maxNumVerts + 7) / 8;
+        cutInstanceStride = cutPrimStride * KNOB_SIMD_WIDTH;
+        cutStreamStride = cutInstanceStride * gsState.instanceCount;
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Implements GS stage.
 /// @param pDC - pointer to draw context.
@@ -618,9 +713,16 @@ static void GeometryShaderStage(
 
     SWR_ASSERT(pGsOut != nullptr, "GS output buffer should be initialized");
     SWR_ASSERT(pCutBuffer != nullptr, "GS output cut buffer should be initialized");
+    SWR_ASSERT(pState->instanceCount <= MAX_GS_INSTANCES);
+
+    const GsBufferLayout layout(*pState);
 
-    gsContext.pStream[0] = (uint8_t*)pGsOut;
-    gsContext.pCutBuffer = (uint8_t*)pCutBuffer;
+    for (uint32_t stream = 0; stream < MAX_SO_STREAMS; ++stream)
+    {
+        bool valid = stream < layout.numStreams;
+        gsContext.pStream[stream] = valid ? (uint8_t*)pGsOut + stream * layout.streamStride : nullptr;
+        gsContext.pCutBuffer[stream] = valid ? (uint8_t*)pCutBuffer + stream * layout.cutStreamStride : nullptr;
+    }
     gsContext.PrimitiveID = primID;
 
     uint32_t numVertsPerPrim = NumVertsPerPrim(pa.binTopology, true);
@@ -645,12 +747,12 @@ static void GeometryShaderStage(
         gsContext.vert[i].attrib[VERTEX_POSITION_SLOT] = attrib[i];
     }
 
-    const uint32_t vertexStride = sizeof(simdvertex);
-    const uint32_t numSimdBatches = (state.gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
-    const uint32_t inputPrimStride = numSimdBatches * vertexStride;
-    const uint32_t instanceStride = inputPrimStride * KNOB_SIMD_WIDTH;
-    const uint32_t cutPrimStride = (state.gsState.maxNumVerts + 7) / 8;
-    const uint32_t cutInstanceStride = cutPrimStride * KNOB_SIMD_WIDTH;
+    // the GS only sets cut bits
+    memset(pCutBuffer, 0, layout.cutStreamStride * layout.numStreams);
+
+    // per instance emitted vertex counts, vertexCount is overwritten by each instance
+    simdscalari vertexCounts[MAX_SO_STREAMS][MAX_GS_INSTANCES];
+
     for (uint32_t instance = 0; instance < pState->instanceCount; ++instance)
     {
         gsContext.InstanceID = instance;
@@ -658,8 +760,12 @@ static void GeometryShaderStage(
         // execute the geometry shader
         state.pfnGsFunc(GetPrivateState(pDC), &gsContext);
 
-        gsContext.pStream[0] += instanceStride;
-        gsContext.pCutBuffer += cutInstanceStride;
+        for (uint32_t stream = 0; stream < layout.numStreams; ++stream)
+        {
+            vertexCounts[stream][instance] = gsContext.vertexCount[stream];
+            gsContext.pStream[stream] += layout.instanceStride;
+            gsContext.pCutBuffer[stream] += layout.cutInstanceStride;
+        }
     }
 
     // record valid prims from the frontend to avoid over binning the newly generated
@@ -679,68 +785,81 @@ static void GeometryShaderStage(
         }
     }
 
-    // foreach input prim:
+    DWORD numAttribs;
+    _BitScanReverse(&numAttribs, state.feAttribMask);
+    numAttribs++;
+
+    // foreach stream, foreach input prim:
     // - setup a new PA based on the emitted verts for that prim
     // - loop over the new verts, calling PA to assemble each prim
-    uint32_t* pVertexCount = (uint32_t*)&gsContext.vertexCount;
     uint32_t* pPrimitiveId = (uint32_t*)&primID;
 
     uint32_t totalPrimsGenerated = 0;
-    for (uint32_t inputPrim = 0; inputPrim < numInputPrims; ++inputPrim)
+    for (uint32_t stream = 0; stream < layout.numStreams; ++stream)
     {
-        uint8_t* pInstanceBase = (uint8_t*)pGsOut + inputPrim * inputPrimStride;
-        uint8_t* pCutBufferBase = (uint8_t*)pCutBuffer + inputPrim * cutPrimStride;
-        for (uint32_t instance = 0; instance < pState->instanceCount; ++instance)
+        // stream 0 is always streamed out; other streams only if enabled
+        bool streamOut = HasStreamOutT && ((stream == 0) || state.soState.streamEnable[stream]);
+        bool rasterize = HasRastT && (stream == state.soState.streamToRasterizer);
+        if (!streamOut && !rasterize)
         {
-            uint32_t numEmittedVerts = pVertexCount[inputPrim];
-            if (numEmittedVerts == 0)
-            {
-                continue;
-            }
-
-            uint8_t* pBase = pInstanceBase + instance * instanceStride;
-            uint8_t* pCutBase = pCutBufferBase + instance * cutInstanceStride;
-            
-            DWORD numAttribs;
-            _BitScanReverse(&numAttribs, state.feAttribMask);
-            numAttribs++;
+            continue;
+        }
 
-            PA_STATE_CUT gsPa(pDC, pBase, numEmittedVerts, pCutBase, numEmittedVerts, numAttribs, pState->outputTopology, true);
+        uint8_t* pStreamBase = (uint8_t*)pGsOut + stream * layout.streamStride;
+        uint8_t* pCutStreamBase = (uint8_t*)pCutBuffer + stream * layout.cutStreamStride;
 
-            while (gsPa.GetNextStreamOutput())
+        for (uint32_t inputPrim = 0; inputPrim < numInputPrims; ++inputPrim)
+        {
+            uint8_t* pInstanceBase = pStreamBase + inputPrim * layout.inputPrimStride;
+            uint8_t* pCutBufferBase = pCutStreamBase + inputPrim * layout.cutPrimStride;
+            for (uint32_t instance = 0; instance < pState->instanceCount; ++instance)
             {
-                do
+                uint32_t numEmittedVerts = ((uint32_t*)&vertexCounts[stream][instance])[inputPrim];
+                if (numEmittedVerts == 0)
                 {
-                    bool assemble = gsPa.Assemble(VERTEX_POSITION_SLOT, attrib);
+                    continue;
+                }
+
+                uint8_t* pBase = pInstanceBase + instance * layout.instanceStride;
+                uint8_t* pCutBase = pCutBufferBase + instance * layout.cutInstanceStride;
 
-                    if (assemble)
+                PA_STATE_CUT gsPa(pDC, pBase, numEmittedVerts, pCutBase, numEmittedVerts, numAttribs, pState->outputTopology, true, layout.numSlots);
+
+                while (gsPa.GetNextStreamOutput())
+                {
+                    do
                     {
-                        totalPrimsGenerated += gsPa.NumPrims();
+                        bool assemble = gsPa.Assemble(VERTEX_POSITION_SLOT, attrib);
 
-                        if (HasStreamOutT)
+                        if (assemble)
                         {
-                            StreamOut(pDC, gsPa, workerId, pSoPrimData);
-                        }
+                            totalPrimsGenerated += gsPa.NumPrims();
 
-                        if (HasRastT)
-                        {
-                            simdscalari vPrimId;
-                            // pull primitiveID from the GS output if available
-                            if (state.gsState.emitsPrimitiveID)
+                            if (streamOut)
                             {
-                                simdvector primIdAttrib[3];
-                                gsPa.Assemble(VERTEX_PRIMID_SLOT, primIdAttrib);
-                                vPrimId = _simd_castps_si(primIdAttrib[0].x);
+                                StreamOut(pDC, gsPa, workerId, pSoPrimData, stream);
                             }
-                            else
+
+                            if (rasterize)
                             {
-                                vPrimId = _simd_set1_epi32(pPrimitiveId[inputPrim]);
-                            }
+                                simdscalari vPrimId;
+                                // pull primitiveID from the GS output if available
+                                if (state.gsState.emitsPrimitiveID)
+                                {
+                                    simdvector primIdAttrib[3];
+                                    gsPa.Assemble(VERTEX_PRIMID_SLOT, primIdAttrib);
+                                    vPrimId = _simd_castps_si(primIdAttrib[0].x);
+                                }
+                                else
+                                {
+                                    vPrimId = _simd_set1_epi32(pPrimitiveId[inputPrim]);
+                                }
 
-                            pfnClipFunc(pDC, gsPa, workerId, attrib, GenMask(gsPa.NumPrims()), vPrimId);
+                                pfnClipFunc(pDC, gsPa, workerId, attrib, GenMask(gsPa.NumPrims()), vPrimId);
+                            }
                         }
-                    }
-                } while (gsPa.NextPrim());
+                    } while (gsPa.NextPrim());
+                }
             }
         }
     }
@@ -761,19 +880,15 @@ static void GeometryShaderStage(
 static INLINE void AllocateGsBuffers(DRAW_CONTEXT* pDC, const API_STATE& state, void** ppGsOut, void** ppCutBuffer)
 {
     SWR_ASSERT(state.gsState.gsEnable);
-    // allocate arena space to hold GS output verts
-    // @todo pack attribs
-    // @todo support multiple streams
-    const uint32_t vertexStride = sizeof(simdvertex);
-    const uint32_t numSimdBatches = (state.gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
-    uint32_t size = state.gsState.instanceCount * numSimdBatches * vertexStride * KNOB_SIMD_WIDTH;
-    *ppGsOut = pDC->arena.AllocAligned(size, KNOB_SIMD_WIDTH * sizeof(float));
+
+    // allocate arena space to hold GS output verts for all streams. Vertices
+    // only hold the slots the GS writes.
+    const GsBufferLayout layout(state.gsState);
+    *ppGsOut = pDC->arena.AllocAligned(layout.streamStride * layout.numStreams, KNOB_SIMD_WIDTH * sizeof(float));
 
     // allocate arena space to hold cut buffer, which is essentially a bitfield sized to the
-    // maximum vertex output as defined by the GS state, per SIMD lane, per GS instance
-    const uint32_t cutPrimStride = (state.gsState.maxNumVerts + 7) / 8;
-    const uint32_t cutBufferSize = cutPrimStride * state.gsState.instanceCount * KNOB_SIMD_WIDTH;
-    *ppCutBuffer = pDC->arena.AllocAligned(cutBufferSize, KNOB_SIMD_WIDTH * sizeof(float));
+    // maximum vertex output as defined by the GS state, per SIMD lane, per GS instance, per stream
+    *ppCutBuffer = pDC->arena.AllocAligned(layout.cutStreamStride * layout.numStreams, KNOB_SIMD_WIDTH * sizeof(float));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -1003,7 +1118,7 @@ static void TessellationStages(
 }
 
 //////////////////////////////////////////////////////////////////////////
-/// @brief FE handler for SwrDraw.
+/// @brief Runs the FE pipeline for one draw.
 /// @tparam IsIndexedT - Is indexed drawing enabled
 /// @tparam HasTessellationT - Is tessellation enabled
 /// @tparam HasGeometryShaderT - Is the geometry shader stage enabled
@@ -1012,31 +1127,25 @@ static void TessellationStages(
 /// @param pContext - pointer to SWR context.
 /// @param pDC - pointer to draw context.
 /// @param workerId - thread's worker id.
-/// @param pUserData - Pointer to DRAW_WORK
+/// @param work - draw parameters.
+/// @param pGsOut - GS output buffer (HasGeometryShaderT)
+/// @param pCutBuffer - GS cut buffer (HasGeometryShaderT)
+/// @param pSoPrimData - stream out primitive buffer (HasStreamOutT)
 template <
     bool IsIndexedT,
     bool HasTessellationT,
     bool HasGeometryShaderT,
     bool HasStreamOutT,
     bool HasRastT>
-void ProcessDraw(
+static void ProcessDrawSingle(
     SWR_CONTEXT *pContext,
     DRAW_CONTEXT *pDC,
     uint32_t workerId,
-    void *pUserData)
+    const DRAW_WORK& work,
+    void* pGsOut,
+    void* pCutBuffer,
+    uint32_t* pSoPrimData)
 {
-
-#if KNOB_ENABLE_TOSS_POINTS
-    if (KNOB_TOSS_QUEUE_FE)
-    {
-        pDC->doneFE = 1;
-        return;
-    }
-#endif
-
-    RDTSC_START(FEProcessDraw);
-
-    DRAW_WORK&          work = *(DRAW_WORK*)pUserData;
     const API_STATE&    state = GetApiState(pDC);
     __m256i             vScale = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
     SWR_VS_CONTEXT      vsContext;
@@ -1098,39 +1207,6 @@ void ProcessDraw(
         fetchInfo.StartVertex = work.startVertex;
     }
 
-#ifdef KNOB_ENABLE_RDTSC
-    uint32_t numPrims = GetNumPrims(state.topology, work.numVerts);
-#endif
-
-    void* pGsOut = nullptr;
-    void* pCutBuffer = nullptr;
-    if (HasGeometryShaderT)
-    {
-        AllocateGsBuffers(pDC, state, &pGsOut, &pCutBuffer);
-    }
-
-    if (HasTessellationT)
-    {
-        SWR_ASSERT(state.tsState.tsEnable == true);
-        SWR_ASSERT(state.pfnHsFunc != nullptr);
-        SWR_ASSERT(state.pfnDsFunc != nullptr);
-
-        AllocateTessellationData(pContext);
-    }
-    else
-    {
-        SWR_ASSERT(state.tsState.tsEnable == false);
-        SWR_ASSERT(state.pfnHsFunc == nullptr);
-        SWR_ASSERT(state.pfnDsFunc == nullptr);
-    }
-
-    // allocate space for streamout input prim data
-    uint32_t* pSoPrimData = nullptr;
-    if (HasStreamOutT)
-    {
-        pSoPrimData = (uint32_t*)pDC->arena.AllocAligned(4096, 16);
-    }
-
     // choose primitive assembler
     PA_FACTORY<IsIndexedT> paFactory(pDC, state.topology, work.numVerts);
     PA_STATE& pa = paFactory.GetPA();
@@ -1167,7 +1243,28 @@ void ProcessDraw(
             simdvertex& vout = pa.GetNextVsOutput();
             vsContext.pVout = &vout;
 
-            if (i < endVertex)
+            if (i < endVertex && state.pfnFetchVsFunc != nullptr)
+            {
+                // 1. Execute fused FS+VS for a single SIMD. Vertex inputs stay in
+                //    registers, so only the VS outputs are written to memory.
+                vsContext.mask = GenerateMask(endVertex - i);
+
+                RDTSC_START(FEFetchVertexShader);
+                state.pfnFetchVsFunc(GetPrivateState(pDC), fetchInfo, &vsContext);
+                RDTSC_STOP(FEFetchVertexShader, 0, 0);
+
+                vsContext.VertexID = fetchInfo.VertexID;
+
+                // forward cut mask to the PA
+                if (IsIndexedT)
+                {
+                    *pvCutIndices = _simd_movemask_ps(_simd_castsi_ps(fetchInfo.CutMask));
+                }
+
+                UPDATE_STAT(IaVertices, GetNumInvocations(i, endVertex));
+                UPDATE_STAT(VsInvocations, GetNumInvocations(i, endVertex));
+            }
+            else if (i < endVertex)
             {
 
                 // 1. Execute FS/VS for a single SIMD.
@@ -1235,7 +1332,15 @@ void ProcessDraw(
                             else
                             {
                                 // If streamout is enabled then stream vertices out to memory.
-                                if (HasStreamOutT)
+                                if (HasStreamOutT && work.soPrimsPerInstance != 0)
+                                {
+                                    // Each prim writes to the range the API reserved for it.
+                                    OSALIGNSIMD(uint32_t) soPrims[KNOB_SIMD_WIDTH];
+                                    _simd_store_si((simdscalari*)soPrims, _simd_add_epi32(pa.GetPrimID(work.startPrimID),
+                                        _simd_set1_epi32(instanceNum * work.soPrimsPerInstance)));
+                                    StreamOut(pDC, pa, workerId, pSoPrimData, 0, soPrims);
+                                }
+                                else if (HasStreamOutT)
                                 {
                                     StreamOut(pDC, pa, workerId, pSoPrimData);
                                 }
@@ -1264,10 +1369,152 @@ void ProcessDraw(
         }
         pa.Reset();
     }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief FE handler for SwrDraw.
+/// @tparam IsIndexedT - Is indexed drawing enabled
+/// @tparam HasTessellationT - Is tessellation enabled
+/// @tparam HasGeometryShaderT - Is the geometry shader stage enabled
+/// @tparam HasStreamOutT - Is stream-out enabled
+/// @tparam HasRastT - Is rasterization enabled
+/// @param pContext - pointer to SWR context.
+/// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id.
+/// @param pUserData - Pointer to DRAW_WORK
+template <
+    bool IsIndexedT,
+    bool HasTessellationT,
+    bool HasGeometryShaderT,
+    bool HasStreamOutT,
+    bool HasRastT>
+void ProcessDraw(
+    SWR_CONTEXT *pContext,
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId,
+    void *pUserData)
+{
+
+#if KNOB_ENABLE_TOSS_POINTS
+    if (KNOB_TOSS_QUEUE_FE)
+    {
+        pDC->doneFE = 1;
+        return;
+    }
+#endif
+
+    RDTSC_START(FEProcessDraw);
+
+    DRAW_WORK&          work = *(DRAW_WORK*)pUserData;
+    const API_STATE&    state = GetApiState(pDC);
+
+    void* pGsOut = nullptr;
+    void* pCutBuffer = nullptr;
+    if (HasGeometryShaderT)
+    {
+        AllocateGsBuffers(pDC, state, &pGsOut, &pCutBuffer);
+    }
+
+    if (HasTessellationT)
+    {
+        SWR_ASSERT(state.tsState.tsEnable == true);
+        SWR_ASSERT(state.pfnHsFunc != nullptr);
+        SWR_ASSERT(state.pfnDsFunc != nullptr);
+
+        AllocateTessellationData(pContext);
+    }
+    else
+    {
+        SWR_ASSERT(state.tsState.tsEnable == false);
+        SWR_ASSERT(state.pfnHsFunc == nullptr);
+        SWR_ASSERT(state.pfnDsFunc == nullptr);
+    }
+
+    // allocate space for streamout input prim data
+    uint32_t* pSoPrimData = nullptr;
+    if (HasStreamOutT)
+    {
+        pSoPrimData = (uint32_t*)pDC->arena.AllocAligned(4096, 16);
+    }
+
+#ifdef KNOB_ENABLE_RDTSC
+    uint64_t numPrims = 0;
+#endif
+
+    if (work.pIndirectArgs != nullptr)
+    {
+        // Indirect draw: fetch each sub-draw's arguments now that all prior FE work is done.
+        const uint8_t* pIBBase = (const uint8_t*)work.pIB;
+        uint32_t indexSize = (work.type == R32_UINT) ? sizeof(uint32_t) :
+                             (work.type == R16_UINT) ? sizeof(uint16_t) : sizeof(uint8_t);
+
+        DRAW_WORK subDraw = work;
+        subDraw.pIndirectArgs = nullptr;
+
+        for (uint32_t draw = 0; draw < work.numIndirectDraws; ++draw)
+        {
+            const uint8_t* pArgs = work.pIndirectArgs + (uint64_t)draw * work.indirectStride;
+            if (IsIndexedT)
+            {
+                const SWR_DRAW_INDEXED_INDIRECT_ARGS& args = *(const SWR_DRAW_INDEXED_INDIRECT_ARGS*)pArgs;
+                subDraw.numIndices = args.numIndices;
+                subDraw.pIB = (const int32_t*)(pIBBase + (uint64_t)args.indexOffset * indexSize);
+                subDraw.baseVertex = args.baseVertex;
+                subDraw.numInstances = args.numInstances;
+                subDraw.startInstance = args.startInstance;
+            }
+            else
+            {
+                const SWR_DRAW_INDIRECT_ARGS& args = *(const SWR_DRAW_INDIRECT_ARGS*)pArgs;
+                subDraw.numVerts = args.numVertsPerInstance;
+                subDraw.startVertex = args.startVertex;
+                subDraw.numInstances = args.numInstances;
+                subDraw.startInstance = args.startInstance;
+            }
+
+            if (subDraw.numVerts == 0 || subDraw.numInstances == 0)
+            {
+                continue;
+            }
+
+            ProcessDrawSingle<IsIndexedT, HasTessellationT, HasGeometryShaderT, HasStreamOutT, HasRastT>(
+                pContext, pDC, workerId, subDraw, pGsOut, pCutBuffer, pSoPrimData);
+
+#ifdef KNOB_ENABLE_RDTSC
+            numPrims += (uint64_t)GetNumPrims(state.topology, subDraw.numVerts) * subDraw.numInstances;
+#endif
+        }
+    }
+    else if (work.pSubDraws != nullptr)
+    {
+        // Batched draws: consecutive API draws sharing all state, in submission order.
+        for (uint32_t draw = 0; draw < work.numSubDraws; ++draw)
+        {
+            const DRAW_WORK& subDraw = work.pSubDraws[draw];
+
+            ProcessDrawSingle<IsIndexedT, HasTessellationT, HasGeometryShaderT, HasStreamOutT, HasRastT>(
+                pContext, pDC, workerId, subDraw, pGsOut, pCutBuffer, pSoPrimData);
+
+#ifdef KNOB_ENABLE_RDTSC
+            numPrims += (uint64_t)GetNumPrims(state.topology, subDraw.numVerts) * subDraw.numInstances;
+#endif
+        }
+
+        UPDATE_STAT(DrawsMerged, work.numSubDraws - 1);
+    }
+    else
+    {
+        ProcessDrawSingle<IsIndexedT, HasTessellationT, HasGeometryShaderT, HasStreamOutT, HasRastT>(
+            pContext, pDC, workerId, work, pGsOut, pCutBuffer, pSoPrimData);
+
+#ifdef KNOB_ENABLE_RDTSC
+        numPrims = (uint64_t)GetNumPrims(state.topology, work.numVerts) * work.numInstances;
+#endif
+    }
 
     _ReadWriteBarrier();
     pDC->doneFE = true;
-    RDTSC_STOP(FEProcessDraw, numPrims * work.numInstances, pDC->drawId);
+    RDTSC_STOP(FEProcessDraw, numPrims, pDC->drawId);
 }
 // Explicit Instantiation of all combinations
 template void ProcessDraw<false, false, false, false, false>(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint32_t workerId, void *pUserData);
@@ -1702,22 +1949,33 @@ void BinTriangles(
 
     // store render target array index
     OSALIGNSIMD(uint32_t) aRTAI[KNOB_SIMD_WIDTH];
+    simdscalari vRtaii;
     if (gsState.gsEnable && gsState.emitsRenderTargetArrayIndex)
     {
         simdvector vRtai[3];
         pa.Assemble(VERTEX_RTAI_SLOT, vRtai);
-        simdscalari vRtaii;
         vRtaii = _simd_castps_si(vRtai[0].x);
-        _simd_store_si((simdscalari*)aRTAI, vRtaii);
     }
     else
     {
-        _simd_store_si((simdscalari*)aRTAI, _simd_setzero_si());
+        vRtaii = _simd_setzero_si();
     }
+    _simd_store_si((simdscalari*)aRTAI, vRtaii);
 
-    // scan remaining valid triangles and bin each separately
-    while (_BitScanForward(&triIndex, triMask))
+    // scan remaining valid triangles and bin each separately. triangles are binned one
+    // render target array slice at a time so the backend switches hot tile slices once
+    // per slice; triangles on different slices never touch the same samples, so only
+    // the order within a slice has to be kept.
+    for (uint32_t sliceMask = 0; triMask != 0; )
     {
+        if (sliceMask == 0)
+        {
+            _BitScanForward(&triIndex, triMask);
+            sliceMask = triMask & _simd_movemask_ps(_simd_castsi_ps(_simd_cmpeq_epi32(vRtaii, _simd_set1_epi32(aRTAI[triIndex]))));
+        }
+        _BitScanForward(&triIndex, sliceMask);
+        sliceMask &= ~(1 << triIndex);
+
         uint32_t linkageCount = state.linkageCount;
         uint32_t linkageMask  = state.linkageMask;
         uint32_t numScalarAttribs = linkageCount * 4;
@@ -1845,98 +2103,76 @@ void BinPoints(
     _simd_store_si((simdscalari*)aMacroX, macroX);
     _simd_store_si((simdscalari*)aMacroY, macroY);
 
-    // compute raster tile coordinates
-    simdscalari rasterX = _simd_srai_epi32(vXi, KNOB_TILE_X_DIM_SHIFT + FIXED_POINT_SHIFT);
-    simdscalari rasterY = _simd_srai_epi32(vYi, KNOB_TILE_Y_DIM_SHIFT + FIXED_POINT_SHIFT);
-
-    // compute raster tile relative x,y for coverage mask
-    simdscalari tileAlignedX = _simd_slli_epi32(rasterX, KNOB_TILE_X_DIM_SHIFT);
-    simdscalari tileAlignedY = _simd_slli_epi32(rasterY, KNOB_TILE_Y_DIM_SHIFT);
-
-    simdscalari tileRelativeX = _simd_sub_epi32(_simd_srai_epi32(vXi, FIXED_POINT_SHIFT), tileAlignedX);
-    simdscalari tileRelativeY = _simd_sub_epi32(_simd_srai_epi32(vYi, FIXED_POINT_SHIFT), tileAlignedY);
-
-    OSALIGNSIMD(uint32_t) aTileRelativeX[KNOB_SIMD_WIDTH];
-    OSALIGNSIMD(uint32_t) aTileRelativeY[KNOB_SIMD_WIDTH];
-    _simd_store_si((simdscalari*)aTileRelativeX, tileRelativeX);
-    _simd_store_si((simdscalari*)aTileRelativeY, tileRelativeY);
-
-    OSALIGNSIMD(uint32_t) aTileAlignedX[KNOB_SIMD_WIDTH];
-    OSALIGNSIMD(uint32_t) aTileAlignedY[KNOB_SIMD_WIDTH];
-    _simd_store_si((simdscalari*)aTileAlignedX, tileAlignedX);
-    _simd_store_si((simdscalari*)aTileAlignedY, tileAlignedY);
-
-    OSALIGNSIMD(float) aZ[KNOB_SIMD_WIDTH];
-    _simd_store_ps((float*)aZ, primVerts.z);
-
-    // store render target array index
-    OSALIGNSIMD(uint32_t) aRTAI[KNOB_SIMD_WIDTH];
-    if (gsState.gsEnable && gsState.emitsRenderTargetArrayIndex)
-    {
-        simdvector vRtai;
-        pa.Assemble(VERTEX_RTAI_SLOT, &vRtai);
-        simdscalari vRtaii = _simd_castps_si(vRtai.x);
-        _simd_store_si((simdscalari*)aRTAI, vRtaii);
-    }
-    else
+    if (!primMask)
     {
-        _simd_store_si((simdscalari*)aRTAI, _simd_setzero_si());
+        goto endBinPoints;
     }
 
-    uint32_t *pPrimID = (uint32_t *)&primID;
-    DWORD primIndex = 0;
-    // scan remaining valid triangles and bin each separately
-    while (_BitScanForward(&primIndex, primMask))
     {
         uint32_t linkageCount = state.linkageCount;
         uint32_t linkageMask = state.linkageMask;
-
         uint32_t numScalarAttribs = linkageCount * 4;
 
-        BE_WORK work;
-        work.type = DRAW;
-
-        TRIANGLE_WORK_DESC &desc = work.desc.tri;
-
-        // points are always front facing
-        desc.triFlags.frontFacing = 1;
-        desc.triFlags.primID = pPrimID[primIndex];
-        desc.triFlags.renderTargetArrayIndex = aRTAI[primIndex];
-
-        work.pfnWork = rastPoint;
-
-        // store attributes
-        float *pAttribs = (float*)pDC->arena.AllocAligned(3 * numScalarAttribs * sizeof(float), 16);
-        desc.pAttribs = pAttribs;
-        desc.numAttribs = linkageCount;
+        // store pixel x, y, perspective correct z, primID and render target array index
+        // of the SIMD once, shared by the work items of all macrotiles it touches
+        float *pPointBuffer = (float*)pDC->arena.AllocAligned(5 * KNOB_SIMD_WIDTH * sizeof(float), KNOB_SIMD_WIDTH * sizeof(float));
+        _simd_store_si((simdscalari*)pPointBuffer, _simd_srai_epi32(vXi, FIXED_POINT_SHIFT));
+        _simd_store_si((simdscalari*)(pPointBuffer + KNOB_SIMD_WIDTH), _simd_srai_epi32(vYi, FIXED_POINT_SHIFT));
+        _simd_store_ps(pPointBuffer + 2 * KNOB_SIMD_WIDTH, primVerts.z);
+        _simd_store_si((simdscalari*)(pPointBuffer + 3 * KNOB_SIMD_WIDTH), primID);
+
+        // store render target array index
+        simdscalari* pRTAI = (simdscalari*)(pPointBuffer + 4 * KNOB_SIMD_WIDTH);
+        if (gsState.gsEnable && gsState.emitsRenderTargetArrayIndex)
+        {
+            simdvector vRtai;
+            pa.Assemble(VERTEX_RTAI_SLOT, &vRtai);
+            _simd_store_si(pRTAI, _simd_castps_si(vRtai.x));
+        }
+        else
+        {
+            _simd_store_si(pRTAI, _simd_setzero_si());
+        }
 
-        ProcessAttributes<1>(pDC, pa, linkageMask, state.linkageMap, primIndex, pAttribs);
+        // store attributes of the valid lanes
+        float *pAttribs = (float*)pDC->arena.AllocAligned(KNOB_SIMD_WIDTH * 3 * numScalarAttribs * sizeof(float), 16);
+        DWORD primIndex = 0;
+        uint32_t attribMask = primMask;
+        while (_BitScanForward(&primIndex, attribMask))
+        {
+            ProcessAttributes<1>(pDC, pa, linkageMask, state.linkageMap, primIndex, pAttribs + primIndex * 3 * numScalarAttribs);
+            attribMask &= ~(1 << primIndex);
+        }
 
-        // store raster tile aligned x, y, perspective correct z
-        float *pTriBuffer = (float*)pDC->arena.AllocAligned(4 * sizeof(float), 16);
-        desc.pTriBuffer = pTriBuffer;
-        *(uint32_t*)pTriBuffer++ = aTileAlignedX[primIndex];
-        *(uint32_t*)pTriBuffer++ = aTileAlignedY[primIndex];
-        *pTriBuffer = aZ[primIndex];
+        // bin one work item per macrotile, covering all the lanes that fall in it
+        MacroTileMgr *pTileMgr = pDC->pTileMgr;
+        while (_BitScanForward(&primIndex, primMask))
+        {
+            simdscalari vSameTile = _simd_and_si(_simd_cmpeq_epi32(macroX, _simd_set1_epi32(aMacroX[primIndex])),
+                                                 _simd_cmpeq_epi32(macroY, _simd_set1_epi32(aMacroY[primIndex])));
+            uint32_t tileMask = primMask & _simd_movemask_ps(_simd_castsi_ps(vSameTile));
 
-        uint32_t tX = aTileRelativeX[primIndex];
-        uint32_t tY = aTileRelativeY[primIndex];
+            BE_WORK work;
+            work.type = DRAW;
+            work.pfnWork = RasterizePoints;
 
-        // pack the relative x,y into the coverageMask, the rasterizer will
-        // generate the true coverage mask from it
-        work.desc.tri.triFlags.coverageMask = tX | (tY << 4);
+            POINTS_WORK_DESC &desc = work.desc.points;
+            desc.pPointBuffer = pPointBuffer;
+            desc.pAttribs = pAttribs;
+            desc.numAttribs = linkageCount;
+            desc.pointMask = tileMask;
 
-        // bin it
-        MacroTileMgr *pTileMgr = pDC->pTileMgr;
 #if KNOB_ENABLE_TOSS_POINTS
-        if (!KNOB_TOSS_SETUP_TRIS)
+            if (!KNOB_TOSS_SETUP_TRIS)
 #endif
-        {
-            pTileMgr->enqueue(aMacroX[primIndex], aMacroY[primIndex], &work);
+            {
+                pTileMgr->enqueue(aMacroX[primIndex], aMacroY[primIndex], &work);
+            }
+            primMask &= ~tileMask;
         }
-        primMask &= ~(1 << primIndex);
     }
 
+endBinPoints:
     RDTSC_STOP(FEBinPoints, 1, 0);
 }
 
@@ -2022,19 +2258,14 @@ void BinLines(
     bbox.top = _simd_min_epi32(vYi[0], vYi[1]);
     bbox.bottom = _simd_max_epi32(vYi[0], vYi[1]);
 
-    // bloat bbox by line width along minor axis
-    simdscalar vHalfWidth = _simd_set1_ps(rastState.lineWidth / 2.0f);
+    // bloat bbox by line width along minor axis, and along major axis too since the
+    // diamond exit rule can light the pixel half a pixel before the first endpoint
+    simdscalar vHalfWidth = _simd_set1_ps(std::max(rastState.lineWidth, 1.0f) / 2.0f);
     simdscalari vHalfWidthi = fpToFixedPointVertical(vHalfWidth);
-    simdBBox bloatBox;
-    bloatBox.left = _simd_sub_epi32(bbox.left, vHalfWidthi);
-    bloatBox.right = _simd_add_epi32(bbox.right, vHalfWidthi);
-    bloatBox.top = _simd_sub_epi32(bbox.top, vHalfWidthi);
-    bloatBox.bottom = _simd_add_epi32(bbox.bottom, vHalfWidthi);
-
-    bbox.left = _simd_blendv_epi32(bbox.left, bloatBox.left, vYmajorMask);
-    bbox.right = _simd_blendv_epi32(bbox.right, bloatBox.right, vYmajorMask);
-    bbox.top = _simd_blendv_epi32(bloatBox.top, bbox.top, vYmajorMask);
-    bbox.bottom = _simd_blendv_epi32(bloatBox.bottom, bbox.bottom, vYmajorMask);
+    bbox.left = _simd_sub_epi32(bbox.left, vHalfWidthi);
+    bbox.right = _simd_add_epi32(bbox.right, vHalfWidthi);
+    bbox.top = _simd_sub_epi32(bbox.top, vHalfWidthi);
+    bbox.bottom = _simd_add_epi32(bbox.bottom, vHalfWidthi);
 
     // Intersect with scissor/viewport. Subtract 1 ULP in x.8 fixed point since right/bottom edge is exclusive.
     bbox.left = _simd_max_epi32(bbox.left, _simd_set1_epi32(state.scissorInFixedPoint.left));
@@ -2078,22 +2309,32 @@ void BinLines(
 
     // store render target array index
     OSALIGNSIMD(uint32_t) aRTAI[KNOB_SIMD_WIDTH];
+    simdscalari vRtaii;
     if (gsState.gsEnable && gsState.emitsRenderTargetArrayIndex)
     {
         simdvector vRtai[2];
         pa.Assemble(VERTEX_RTAI_SLOT, vRtai);
-        simdscalari vRtaii = _simd_castps_si(vRtai[0].x);
-        _simd_store_si((simdscalari*)aRTAI, vRtaii);
+        vRtaii = _simd_castps_si(vRtai[0].x);
     }
     else
     {
-        _simd_store_si((simdscalari*)aRTAI, _simd_setzero_si());
+        vRtaii = _simd_setzero_si();
     }
+    _simd_store_si((simdscalari*)aRTAI, vRtaii);
 
-    // scan remaining valid prims and bin each separately
+    // scan remaining valid prims and bin each separately, grouped by render target
+    // array slice like triangles
     DWORD primIndex;
-    while (_BitScanForward(&primIndex, primMask))
+    for (uint32_t sliceMask = 0; primMask != 0; )
     {
+        if (sliceMask == 0)
+        {
+            _BitScanForward(&primIndex, primMask);
+            sliceMask = primMask & _simd_movemask_ps(_simd_castsi_ps(_simd_cmpeq_epi32(vRtaii, _simd_set1_epi32(aRTAI[primIndex]))));
+        }
+        _BitScanForward(&primIndex, sliceMask);
+        sliceMask &= ~(1 << primIndex);
+
         uint32_t linkageCount = state.linkageCount;
         uint32_t linkageMask = state.linkageMask;
         uint32_t numScalarAttribs = linkageCount * 4;
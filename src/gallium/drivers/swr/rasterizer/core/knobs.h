@@ -45,14 +45,17 @@
 #define KNOB_ARCH_ISA AVX
 #define KNOB_ARCH_STR "AVX"
 #define KNOB_SIMD_WIDTH 8
+#define KNOB_SIMD_WIDTH_LOG2 3
 #elif (KNOB_ARCH == KNOB_ARCH_AVX2)
 #define KNOB_ARCH_ISA AVX2
 #define KNOB_ARCH_STR "AVX2"
 #define KNOB_SIMD_WIDTH 8
+#define KNOB_SIMD_WIDTH_LOG2 3
 #elif (KNOB_ARCH == KNOB_ARCH_AVX512)
 #define KNOB_ARCH_ISA AVX512F
 #define KNOB_ARCH_STR "AVX512"
 #define KNOB_SIMD_WIDTH 16
+#define KNOB_SIMD_WIDTH_LOG2 4
 #error "AVX512 not yet supported"
 #else
 #error "Unknown architecture"
@@ -92,6 +95,8 @@
 // dynamically set based on tile format and pixel size
 #define KNOB_MACROTILE_X_DIM                64
 #define KNOB_MACROTILE_Y_DIM                64
+#define KNOB_MACROTILE_X_DIM_SHIFT          6
+#define KNOB_MACROTILE_Y_DIM_SHIFT          6
 #define KNOB_MACROTILE_X_DIM_FIXED          (KNOB_MACROTILE_X_DIM << 8)
 #define KNOB_MACROTILE_Y_DIM_FIXED          (KNOB_MACROTILE_Y_DIM << 8)
 #define KNOB_MACROTILE_X_DIM_FIXED_SHIFT    14
@@ -99,10 +104,18 @@
 #define KNOB_MACROTILE_X_DIM_IN_TILES       (KNOB_MACROTILE_X_DIM >> KNOB_TILE_X_DIM_SHIFT)
 #define KNOB_MACROTILE_Y_DIM_IN_TILES       (KNOB_MACROTILE_Y_DIM >> KNOB_TILE_Y_DIM_SHIFT)
 
-// total # of hot tiles available. This should be enough to
-// fully render a 16kx16k 128bpp render target
-#define KNOB_NUM_HOT_TILES_X                 256
-#define KNOB_NUM_HOT_TILES_Y                 256
+// maximum render target dimension in pixels
+#define KNOB_MAX_RENDERTARGET_DIM            16384
+
+// max # of hot tiles addressable in each dimension. Hot tile storage is
+// allocated on demand in chunks, so only the area actually rendered to
+// is backed by memory.
+#define KNOB_NUM_HOT_TILES_X                 (KNOB_MAX_RENDERTARGET_DIM >> KNOB_MACROTILE_X_DIM_SHIFT)
+#define KNOB_NUM_HOT_TILES_Y                 (KNOB_MAX_RENDERTARGET_DIM >> KNOB_MACROTILE_Y_DIM_SHIFT)
+
+// hot tile sets are allocated in chunks of NxN macrotiles
+#define KNOB_HOT_TILE_CHUNK_DIM              16
+#define KNOB_HOT_TILE_CHUNK_DIM_SHIFT        4
 #define KNOB_COLOR_HOT_TILE_FORMAT           R32G32B32A32_FLOAT
 #define KNOB_DEPTH_HOT_TILE_FORMAT           R32_FLOAT
 #define KNOB_STENCIL_HOT_TILE_FORMAT         R8_UINT
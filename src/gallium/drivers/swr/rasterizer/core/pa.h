@@ -336,6 +336,8 @@ struct PA_STATE_CUT : public PA_STATE
     simdmask* pCutIndices;          // cut indices buffer, 1 bit per vertex
     uint32_t numVerts;              // number of vertices available in buffer store
     uint32_t numAttribs;            // number of attributes
+    uint32_t vertexStride;          // bytes per simd batch of vertices in the stream
+    uint32_t numSlots;              // number of slots stored per vertex; slots beyond read as 0
     int32_t numRemainingVerts;      // number of verts remaining to be assembled
     uint32_t numVertsToAssemble;    // total number of verts to assemble for the draw
     OSALIGNSIMD(uint32_t) indices[MAX_NUM_VERTS_PER_PRIM][KNOB_SIMD_WIDTH];    // current index buffer for gather
@@ -363,11 +365,13 @@ struct PA_STATE_CUT : public PA_STATE
 
     PA_STATE_CUT() {}
     PA_STATE_CUT(DRAW_CONTEXT* pDC, uint8_t* in_pStream, uint32_t in_streamSizeInVerts, simdmask* in_pIndices, uint32_t in_numVerts, 
-        uint32_t in_numAttribs, PRIMITIVE_TOPOLOGY topo, bool in_processCutVerts)
+        uint32_t in_numAttribs, PRIMITIVE_TOPOLOGY topo, bool in_processCutVerts, uint32_t in_numSlots = KNOB_NUM_ATTRIBUTES)
         : PA_STATE(pDC, in_pStream, in_streamSizeInVerts)
     {
         numVerts = in_streamSizeInVerts;
         numAttribs = in_numAttribs;
+        numSlots = in_numSlots;
+        vertexStride = in_numSlots * sizeof(simdvector);
         binTopology = topo;
         needOffsets = false;
         processCutVerts = in_processCutVerts;
@@ -476,7 +480,7 @@ struct PA_STATE_CUT : public PA_STATE
 
     bool IsCutIndex(uint32_t vertex)
     {
-        uint32_t vertexIndex = vertex / KNOB_SIMD_WIDTH;
+        uint32_t vertexIndex = vertex >> KNOB_SIMD_WIDTH_LOG2;
         uint32_t vertexOffset = vertex & (KNOB_SIMD_WIDTH - 1);
         return _bittest((const LONG*)&this->pCutIndices[vertexIndex], vertexOffset) == 1;
     }
@@ -485,6 +489,12 @@ struct PA_STATE_CUT : public PA_STATE
     // have assembled SIMD prims
     void ProcessVerts()
     {
+        // whole batches without cuts are assembled in one step
+        if (KNOB_STRIP_BATCH_ASSEMBLY && ProcessStripBatch())
+        {
+            return;
+        }
+
         while (this->numPrimsAssembled != KNOB_SIMD_WIDTH &&
             this->numRemainingVerts > 0 &&
             this->curVertex != this->headVertex)
@@ -519,6 +529,96 @@ struct PA_STATE_CUT : public PA_STATE
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Assembles a full SIMD of strip prims from the next SIMD of verts.
+    ///        Once a strip is primed, every new vertex completes a prim, so
+    ///        the prim indices are the ramp of the next verts shifted by the
+    ///        verts carried over from the previous prim. Only used when that
+    ///        many verts are available and none of them is a cut index;
+    ///        everything else takes the per-vertex path.
+    /// @return true if the prims were assembled.
+    bool ProcessStripBatch()
+    {
+        uint32_t history;
+        if (this->pfnPa == &PA_STATE_CUT::ProcessVertTriStrip)
+        {
+            history = 2;
+        }
+        else if (this->pfnPa == &PA_STATE_CUT::ProcessVertLineStrip)
+        {
+            history = 1;
+        }
+        else
+        {
+            return false;
+        }
+
+        // the carried over verts leave curVertex unaligned, so the next verts
+        // usually span two VS output batches
+        uint32_t numAvailable = (this->headVertex + this->numVerts - this->curVertex) % this->numVerts;
+        if (this->curIndex != history ||
+            this->numPrimsAssembled != 0 ||
+            this->numRemainingVerts < KNOB_SIMD_WIDTH ||
+            numAvailable < KNOB_SIMD_WIDTH)
+        {
+            return false;
+        }
+
+        uint32_t batch = this->curVertex >> KNOB_SIMD_WIDTH_LOG2;
+        uint32_t nextBatch = (batch + 1) % (this->numVerts >> KNOB_SIMD_WIDTH_LOG2);
+        uint32_t cutMask = this->pCutIndices[batch] | (this->pCutIndices[nextBatch] << KNOB_SIMD_WIDTH);
+        if (((cutMask >> (this->curVertex & (KNOB_SIMD_WIDTH - 1))) & ((1 << KNOB_SIMD_WIDTH) - 1)) != 0)
+        {
+            return false;
+        }
+
+        // the lane ramp and winding masks below are 8 wide
+        static_assert(KNOB_SIMD_WIDTH == 8, "Need to revisit this when AVX512 is implemented");
+        static_assert((1 << KNOB_SIMD_WIDTH_LOG2) == KNOB_SIMD_WIDTH, "Mismatched KNOB_SIMD_WIDTH_LOG2");
+
+        // next verts, wrapped around the end of the vertex store
+        simdscalari vNumVerts = _simd_set1_epi32(this->numVerts);
+        simdscalari vVerts = _simd_add_epi32(_simd_set1_epi32(this->curVertex), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        vVerts = _simd_sub_epi32(vVerts, _simd_andnot_si(_simd_cmpgt_epi32(vNumVerts, vVerts), vNumVerts));
+
+        // carried over verts followed by the next verts; unaligned loads at
+        // increasing offsets produce the per-vertex index vectors
+        uint32_t ramp[2 + KNOB_SIMD_WIDTH];
+        ramp[0] = this->vert[0];
+        ramp[1] = this->vert[1];
+        _simd_storeu_si((simdscalari*)&ramp[history], vVerts);
+
+        simdscalari vIndex0 = _simd_loadu_si((const simdscalari*)&ramp[0]);
+        simdscalari vIndex1 = _simd_loadu_si((const simdscalari*)&ramp[1]);
+
+        if (history == 2)
+        {
+            simdscalari vIndex2 = _simd_loadu_si((const simdscalari*)&ramp[2]);
+
+            // every other tri has reversed winding
+            simdscalar vReverse = vMask(this->reverseWinding ? 0x55 : 0xAA);
+            _simd_store_si((simdscalari*)this->indices[0], vIndex0);
+            _simd_store_si((simdscalari*)this->indices[1], _simd_blendv_epi32(vIndex1, vIndex2, vReverse));
+            _simd_store_si((simdscalari*)this->indices[2], _simd_blendv_epi32(vIndex2, vIndex1, vReverse));
+
+            // KNOB_SIMD_WIDTH is even, so the winding of the next tri is unchanged
+            this->vert[0] = ramp[KNOB_SIMD_WIDTH];
+            this->vert[1] = ramp[KNOB_SIMD_WIDTH + 1];
+        }
+        else
+        {
+            _simd_store_si((simdscalari*)this->indices[0], vIndex0);
+            _simd_store_si((simdscalari*)this->indices[1], vIndex1);
+
+            this->vert[0] = ramp[KNOB_SIMD_WIDTH];
+        }
+
+        this->numPrimsAssembled = KNOB_SIMD_WIDTH;
+        this->curVertex = (this->curVertex + KNOB_SIMD_WIDTH) % this->numVerts;
+        this->numRemainingVerts -= KNOB_SIMD_WIDTH;
+        return true;
+    }
+
     void Advance()
     {
         // done with current batch
@@ -545,13 +645,11 @@ struct PA_STATE_CUT : public PA_STATE
             simdscalari vIndices = *(simdscalari*)&this->indices[v][0];
 
             // step to simdvertex batch
-            const uint32_t simdShift = 3; // @todo make knob
-            simdscalari vVertexBatch = _simd_srai_epi32(vIndices, simdShift);
-            this->vOffsets[v] = _simd_mullo_epi32(vVertexBatch, _simd_set1_epi32(sizeof(simdvertex)));
+            simdscalari vVertexBatch = _simd_srai_epi32(vIndices, KNOB_SIMD_WIDTH_LOG2);
+            this->vOffsets[v] = _simd_mullo_epi32(vVertexBatch, _simd_set1_epi32(this->vertexStride));
 
             // step to index
-            const uint32_t simdMask = 0x7; // @todo make knob
-            simdscalari vVertexIndex = _simd_and_si(vIndices, _simd_set1_epi32(simdMask));
+            simdscalari vVertexIndex = _simd_and_si(vIndices, _simd_set1_epi32(KNOB_SIMD_WIDTH - 1));
             this->vOffsets[v] = _simd_add_epi32(this->vOffsets[v], _simd_mullo_epi32(vVertexIndex, _simd_set1_epi32(sizeof(float))));
         }
     }
@@ -574,6 +672,19 @@ struct PA_STATE_CUT : public PA_STATE
             this->needOffsets = false;
         }
 
+        // slot not stored in a packed stream
+        if (slot >= this->numSlots)
+        {
+            for (uint32_t v = 0; v < this->vertsPerPrim; ++v)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    result[v].v[c] = _simd_setzero_ps();
+                }
+            }
+            return true;
+        }
+
         for (uint32_t v = 0; v < this->vertsPerPrim; ++v)
         {
             simdscalari offsets = this->vOffsets[v];
@@ -596,6 +707,16 @@ struct PA_STATE_CUT : public PA_STATE
 
     void AssembleSingle(uint32_t slot, uint32_t triIndex, __m128 tri[3])
     {
+        // slot not stored in a packed stream
+        if (slot >= this->numSlots)
+        {
+            for (uint32_t v = 0; v < this->vertsPerPrim; ++v)
+            {
+                tri[v] = _mm_setzero_ps();
+            }
+            return;
+        }
+
         // move to slot
         for (uint32_t v = 0; v < this->vertsPerPrim; ++v)
         {
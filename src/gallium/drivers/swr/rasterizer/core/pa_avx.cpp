@@ -82,22 +82,13 @@ void PaPatchListSingle(PA_STATE_OPT& pa, uint32_t slot, uint32_t primIndex, __m1
     // KNOB_SIMD_WIDTH * 1 patch.  This function is called once per attribute.
     // Each attribute has 4 components.
 
-    /// @todo Optimize this
-
-    float* pOutVec = (float*)verts;
-
     for (uint32_t cp = 0; cp < TotalControlPoints; ++cp)
     {
         uint32_t input_cp = primIndex * TotalControlPoints + cp;
-        uint32_t input_vec = input_cp / KNOB_SIMD_WIDTH;
-        uint32_t input_lane = input_cp % KNOB_SIMD_WIDTH;
+        uint32_t input_vec = input_cp >> KNOB_SIMD_WIDTH_LOG2;
+        uint32_t input_lane = input_cp & (KNOB_SIMD_WIDTH - 1);
 
-        // Loop over all components of the attribute
-        for (uint32_t i = 0; i < 4; ++i)
-        {
-            const float* pInputVec = (const float*)(&PaGetSimdVector(pa, input_vec, slot)[i]);
-            pOutVec[cp * 4 + i] = pInputVec[input_lane];
-        }
+        verts[cp] = swizzleLaneN(PaGetSimdVector(pa, input_vec, slot), input_lane);
     }
 }
 
@@ -119,24 +110,26 @@ static bool PaPatchListTerm(PA_STATE_OPT& pa, uint32_t slot, simdvector verts[])
     // KNOB_SIMD_WIDTH * 1 patch.  This function is called once per attribute.
     // Each attribute has 4 components.
 
-    /// @todo Optimize this
+    // Control point cp of output lane comes from input control point
+    // lane * TotalControlPoints + cp. Turn that into byte offsets from the
+    // first input vector once per control point and gather all components.
+    static_assert(KNOB_SIMD_WIDTH == 8, "Need to revisit this when AVX512 is implemented");
+    const simdscalari vInputCp = _simd_mullo_epi32(
+        _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _simd_set1_epi32(TotalControlPoints));
+    const float* pBase = (const float*)&PaGetSimdVector(pa, 0, slot);
 
-    // Loop over all components of the attribute
-    for (uint32_t i = 0; i < 4; ++i)
+    for (uint32_t cp = 0; cp < TotalControlPoints; ++cp)
     {
-        for (uint32_t cp = 0; cp < TotalControlPoints; ++cp)
-        {
-            float vec[KNOB_SIMD_WIDTH];
-            for (uint32_t lane = 0; lane < KNOB_SIMD_WIDTH; ++lane)
-            {
-                uint32_t input_cp = lane * TotalControlPoints + cp;
-                uint32_t input_vec = input_cp / KNOB_SIMD_WIDTH;
-                uint32_t input_lane = input_cp % KNOB_SIMD_WIDTH;
+        simdscalari vInput = _simd_add_epi32(vInputCp, _simd_set1_epi32(cp));
+        simdscalari vOffsets = _simd_mullo_epi32(_simd_srai_epi32(vInput, KNOB_SIMD_WIDTH_LOG2),
+            _simd_set1_epi32(sizeof(simdvertex)));
+        vOffsets = _simd_add_epi32(vOffsets, _simd_mullo_epi32(
+            _simd_and_si(vInput, _simd_set1_epi32(KNOB_SIMD_WIDTH - 1)), _simd_set1_epi32(sizeof(float))));
 
-                const float* pInputVec = (const float*)(&PaGetSimdVector(pa, input_vec, slot)[i]);
-                vec[lane] = pInputVec[input_lane];
-            }
-            verts[cp][i] = _simd_loadu_ps(vec);
+        // Loop over all components of the attribute
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            verts[cp][i] = _simd_i32gather_ps(pBase + i * KNOB_SIMD_WIDTH, vOffsets, 1);
         }
     }
 
@@ -28,6 +28,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <cfloat>
 
 #include "rasterizer.h"
 #include "multisample.h"
@@ -107,8 +108,10 @@ struct EDGE
 /// @param vA, vB - A & B coefs for each edge of the triangle (Ax + Bx + C)
 /// @param vStepQuad0-2 - edge equations evaluated at the UL corners of the 2x2 pixel quad.
 ///        Used to step between quads when sweeping over the raster tile.
+/// @param ppRastEdges - only the edges that partially cover the raster tile; edges that
+///        trivially accept the whole tile don't affect coverage and are skipped.
 template<uint32_t NumEdges>
-INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdges], EDGE *pRastEdges)
+INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdges], EDGE **ppRastEdges)
 {
     uint64_t coverageMask = 0;
 
@@ -119,11 +122,11 @@ INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdg
     for (uint32_t e = 0; e < NumEdges; ++e)
     {
         // Step to the pixel sample locations of the 1st quad
-        vEdges[e] = _mm256_add_pd(_mm256_set1_pd(startEdges[e]), pRastEdges[e].vQuadOffsets);
+        vEdges[e] = _mm256_add_pd(_mm256_set1_pd(startEdges[e]), ppRastEdges[e]->vQuadOffsets);
 
         // compute step to next quad (mul by 2 in x and y direction)
-        vStepX[e] = _mm256_set1_pd(pRastEdges[e].stepQuadX);
-        vStepY[e] = _mm256_set1_pd(pRastEdges[e].stepQuadY);
+        vStepX[e] = _mm256_set1_pd(ppRastEdges[e]->stepQuadX);
+        vStepY[e] = _mm256_set1_pd(ppRastEdges[e]->stepQuadY);
     }
 
     // fast unrolled version for 8x8 tile
@@ -267,6 +270,21 @@ INLINE uint64_t rasterizePartialTile(DRAW_CONTEXT *pDC, double startEdges[NumEdg
     return coverageMask;
 
 }
+
+typedef uint64_t(*PFN_RASTERIZE_PARTIAL_TILE)(DRAW_CONTEXT*, double*, EDGE**);
+
+// partial tile rasterizers indexed by number of partially covering edges - 1
+static const PFN_RASTERIZE_PARTIAL_TILE gRasterizePartialTileTable[7] =
+{
+    rasterizePartialTile<1>,
+    rasterizePartialTile<2>,
+    rasterizePartialTile<3>,
+    rasterizePartialTile<4>,
+    rasterizePartialTile<5>,
+    rasterizePartialTile<6>,
+    rasterizePartialTile<7>,
+};
+
 // Top left rule:
 // Top: if an edge is horizontal, and it is above other edges in tri pixel space, it is a 'top' edge
 // Left: if an edge is not horizontal, and it is on the left side of the triangle in pixel space, it is a 'left' edge
@@ -688,9 +706,10 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 
     // Evaluate edge equations at sample positions of each of the 4 corners of a raster tile
     // used to for testing if entire raster tile is inside a triangle
-    vEdgeFix16[0] = _mm256_add_pd(vEdgeFix16[0], rastEdges[0].vRasterTileOffsets);
-    vEdgeFix16[1] = _mm256_add_pd(vEdgeFix16[1], rastEdges[1].vRasterTileOffsets);
-    vEdgeFix16[2] = _mm256_add_pd(vEdgeFix16[2], rastEdges[2].vRasterTileOffsets);
+    for (uint32_t e = 0; e < numEdges; ++e)
+    {
+        vEdgeFix16[e] = _mm256_add_pd(vEdgeFix16[e], rastEdges[e].vRasterTileOffsets);
+    }
 
     // at this point vEdge has been evaluated at the UL pixel corners of raster tile bbox
     // step sample positions to the raster tile bbox of multisample points
@@ -698,7 +717,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     //                             |      |
     //                             |      |
     // min(xSamples),max(ySamples)  ------  max(xSamples),max(ySamples)
-    __m256d vEdge0TileBbox, vEdge1TileBbox, vEdge2TileBbox;
+    __m256d vEdgeTileBbox[numEdges];
     if (sampleCount > SWR_MULTISAMPLE_1X)
     {
         __m128i vTileSampleBBoxXh = MultisampleTraits<sampleCount>::TileSampleOffsetsX();
@@ -709,17 +728,43 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 
         // step edge equation tests from Tile
         // used to for testing if entire raster tile is inside a triangle
-        __m256d vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[0].a), vTileSampleBBoxXFix8);
-        __m256d vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[0].b), vTileSampleBBoxYFix8);
-        vEdge0TileBbox = _mm256_add_pd(vResultAxFix16, vResultByFix16);
+        for (uint32_t e = 0; e < numEdges; ++e)
+        {
+            __m256d vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[e].a), vTileSampleBBoxXFix8);
+            __m256d vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[e].b), vTileSampleBBoxYFix8);
+            vEdgeTileBbox[e] = _mm256_add_pd(vResultAxFix16, vResultByFix16);
+        }
+    }
 
-        vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[1].a), vTileSampleBBoxXFix8);
-        vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[1].b), vTileSampleBBoxYFix8);
-        vEdge1TileBbox = _mm256_add_pd(vResultAxFix16, vResultByFix16);
+    // Classify the raster tile aligned region of the bbox within this macrotile before walking it.
+    // Edge equations are linear, so the corners of the region bound every raster tile inside it:
+    //  - an edge with all 4 region corners outside rejects every raster tile in the macrotile
+    //  - if all edges have all 4 region corners inside, every raster tile is fully covered
+    bool trivialAcceptMacroTile = true;
+    for (uint32_t e = 0; e < numEdges; ++e)
+    {
+        const double stepRegionX = rastEdges[e].stepRasterTileX * (numTilesX - 1);
+        const double stepRegionY = rastEdges[e].stepRasterTileY * (numTilesY - 1);
+        __m256d vRegionCorners = _mm256_add_pd(vEdgeFix16[e], _mm256_set_pd(stepRegionX + stepRegionY, stepRegionY, stepRegionX, 0.0));
+        if (sampleCount > SWR_MULTISAMPLE_1X)
+        {
+            vRegionCorners = _mm256_add_pd(vRegionCorners, vEdgeTileBbox[e]);
+        }
 
-        vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[2].a), vTileSampleBBoxXFix8);
-        vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[2].b), vTileSampleBBoxYFix8);
-        vEdge2TileBbox = _mm256_add_pd(vResultAxFix16, vResultByFix16);
+        int regionMask = _mm256_movemask_pd(vRegionCorners);
+        if (regionMask == 0)
+        {
+            RDTSC_STOP(BEStepSetup, 0, pDC->drawId);
+            RDTSC_EVENT(BEMacroTileTrivialReject, 1, 0);
+            RDTSC_STOP(BERasterizeTriangle, 1, 0);
+            return;
+        }
+        trivialAcceptMacroTile = trivialAcceptMacroTile && (regionMask == 0xf);
+    }
+
+    if (trivialAcceptMacroTile)
+    {
+        RDTSC_EVENT(BEMacroTileTrivialAccept, 1, 0);
     }
 
     RDTSC_STOP(BEStepSetup, 0, pDC->drawId);
@@ -759,52 +804,71 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
             uint64_t anyCoveredSamples = 0;
 
             // is the corner of the edge outside of the raster tile? (vEdge < 0)
-            int mask0, mask1, mask2;
-            if (sampleCount == SWR_MULTISAMPLE_1X)
+            // edges with all 4 corners inside don't affect coverage of this raster tile
+            bool trivialReject = false;
+            uint32_t numPartialEdges = 0;
+            uint32_t partialEdges[numEdges];
+            if (!trivialAcceptMacroTile)
             {
-                mask0 = _mm256_movemask_pd(vEdgeFix16[0]);
-                mask1 = _mm256_movemask_pd(vEdgeFix16[1]);
-                mask2 = _mm256_movemask_pd(vEdgeFix16[2]);
-            }
-            else
-            {
-                __m256d vSampleBboxTest0, vSampleBboxTest1, vSampleBboxTest2;
-                // evaluate edge equations at the tile multisample bounding box
-                vSampleBboxTest0 = _mm256_add_pd(vEdge0TileBbox, vEdgeFix16[0]);
-                vSampleBboxTest1 = _mm256_add_pd(vEdge1TileBbox, vEdgeFix16[1]);
-                vSampleBboxTest2 = _mm256_add_pd(vEdge2TileBbox, vEdgeFix16[2]);
-                mask0 = _mm256_movemask_pd(vSampleBboxTest0);
-                mask1 = _mm256_movemask_pd(vSampleBboxTest1);
-                mask2 = _mm256_movemask_pd(vSampleBboxTest2);
+                for (uint32_t e = 0; e < numEdges; ++e)
+                {
+                    __m256d vTileCorners = vEdgeFix16[e];
+                    if (sampleCount > SWR_MULTISAMPLE_1X)
+                    {
+                        // evaluate edge equations at the tile multisample bounding box
+                        vTileCorners = _mm256_add_pd(vEdgeTileBbox[e], vTileCorners);
+                    }
+
+                    int mask = _mm256_movemask_pd(vTileCorners);
+                    if (mask == 0)
+                    {
+                        trivialReject = true;
+                        break;
+                    }
+                    if (mask != 0xf)
+                    {
+                        partialEdges[numPartialEdges++] = e;
+                    }
+                }
             }
 
-            for (uint32_t sampleNum = 0; sampleNum < maxSamples; sampleNum++)
+            if (trivialReject)
             {
                 // trivial reject, at least one edge has all 4 corners of raster tile outside
-                bool trivialReject = (!(mask0 && mask1 && mask2)) ? true : false;
-
-                if (!trivialReject)
+                // no covered samples, don't need to do anything
+                RDTSC_EVENT(BETrivialReject, 1, 0);
+            }
+            else if (numPartialEdges == 0)
+            {
+                // trivial accept, all 4 corners of all edges are negative
+                // i.e. raster tile completely inside triangle
+                for (uint32_t sampleNum = 0; sampleNum < maxSamples; sampleNum++)
                 {
-                    // trivial accept mask
                     triDesc.coverageMask[sampleNum] = 0xffffffffffffffffULL;
-                    if ((mask0 & mask1 & mask2) == 0xf)
-                    {
-                        anyCoveredSamples = triDesc.coverageMask[sampleNum];
-                        // trivial accept, all 4 corners of all 3 edges are negative 
-                        // i.e. raster tile completely inside triangle
-                        RDTSC_EVENT(BETrivialAccept, 1, 0);
-                    }
-                    else
+                }
+                anyCoveredSamples = 0xffffffffffffffffULL;
+                RDTSC_EVENT(BETrivialAccept, 1, 0);
+            }
+            else
+            {
+                // not trivial accept or reject, must rasterize full tile against the partial edges
+                EDGE* pPartialEdges[numEdges];
+                for (uint32_t i = 0; i < numPartialEdges; ++i)
+                {
+                    pPartialEdges[i] = &rastEdges[partialEdges[i]];
+                }
+                PFN_RASTERIZE_PARTIAL_TILE pfnRasterizePartialTile = gRasterizePartialTileTable[numPartialEdges - 1];
+
+                for (uint32_t sampleNum = 0; sampleNum < maxSamples; sampleNum++)
+                {
+                    double startQuadEdges[numEdges];
+                    const __m256i vLane0Mask = _mm256_set_epi32(0, 0, 0, 0, 0, 0, -1, -1);
+
+                    for (uint32_t i = 0; i < numPartialEdges; ++i)
                     {
-                        __m256d vEdge0AtSample, vEdge1AtSample, vEdge2AtSample; 
-                        if(sampleCount == SWR_MULTISAMPLE_1X)
-                        {
-                            // should get optimized out for single sample case (global value numbering or copy propagation)
-                            vEdge0AtSample = vEdgeFix16[0];
-                            vEdge1AtSample = vEdgeFix16[1];
-                            vEdge2AtSample = vEdgeFix16[2];
-                        }
-                        else
+                        const EDGE& edge = *pPartialEdges[i];
+                        __m256d vEdgeAtSample = vEdgeFix16[partialEdges[i]];
+                        if (sampleCount > SWR_MULTISAMPLE_1X)
                         {
                             __m128i vSampleOffsetXh = MultisampleTraits<sampleCount>::vXi(sampleNum);
                             __m128i vSampleOffsetYh = MultisampleTraits<sampleCount>::vYi(sampleNum);
@@ -815,56 +879,18 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                             // for each edge and broadcasts it before offsetting to individual pixel quads
 
                             // step edge equation tests from UL tile corner to pixel sample position
-                            __m256d vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[0].a), vSampleOffsetX);
-                            __m256d vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[0].b), vSampleOffsetY);
-                            vEdge0AtSample = _mm256_add_pd(vResultAxFix16, vResultByFix16);
-                            vEdge0AtSample = _mm256_add_pd(vEdgeFix16[0], vEdge0AtSample);
-
-                            vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[1].a), vSampleOffsetX);
-                            vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[1].b), vSampleOffsetY);
-                            vEdge1AtSample = _mm256_add_pd(vResultAxFix16, vResultByFix16);
-                            vEdge1AtSample = _mm256_add_pd(vEdgeFix16[1], vEdge1AtSample);
-
-                            vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[2].a), vSampleOffsetX);
-                            vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(rastEdges[2].b), vSampleOffsetY);
-                            vEdge2AtSample = _mm256_add_pd(vResultAxFix16, vResultByFix16);
-                            vEdge2AtSample = _mm256_add_pd(vEdgeFix16[2], vEdge2AtSample);
-                        }
-
-                        double startQuadEdges[numEdges];
-                        const __m256i vLane0Mask = _mm256_set_epi32(0, 0, 0, 0, 0, 0, -1, -1);
-                        _mm256_maskstore_pd(&startQuadEdges[0], vLane0Mask, vEdge0AtSample);
-                        _mm256_maskstore_pd(&startQuadEdges[1], vLane0Mask, vEdge1AtSample);
-                        _mm256_maskstore_pd(&startQuadEdges[2], vLane0Mask, vEdge2AtSample);
-
-                        for (uint32_t e = 3; e < numEdges; ++e)
-                        {
-                            _mm256_maskstore_pd(&startQuadEdges[e], vLane0Mask, vEdgeFix16[e]);
+                            __m256d vResultAxFix16 = _mm256_mul_pd(_mm256_set1_pd(edge.a), vSampleOffsetX);
+                            __m256d vResultByFix16 = _mm256_mul_pd(_mm256_set1_pd(edge.b), vSampleOffsetY);
+                            vEdgeAtSample = _mm256_add_pd(vEdgeAtSample, _mm256_add_pd(vResultAxFix16, vResultByFix16));
                         }
+                        _mm256_maskstore_pd(&startQuadEdges[i], vLane0Mask, vEdgeAtSample);
+                    }
 
-                        // not trivial accept or reject, must rasterize full tile
-                        RDTSC_START(BERasterizePartial);
-                        if (RasterizeScissorEdges)
-                        {
-                            triDesc.coverageMask[sampleNum] = rasterizePartialTile<7>(pDC, startQuadEdges, rastEdges);
-                        }
-                        else
-                        {
-                            triDesc.coverageMask[sampleNum] = rasterizePartialTile<3>(pDC, startQuadEdges, rastEdges);
-                        }
-                        RDTSC_STOP(BERasterizePartial, 0, 0);
+                    RDTSC_START(BERasterizePartial);
+                    triDesc.coverageMask[sampleNum] = pfnRasterizePartialTile(pDC, startQuadEdges, pPartialEdges);
+                    RDTSC_STOP(BERasterizePartial, 0, 0);
 
-                        anyCoveredSamples |= triDesc.coverageMask[sampleNum]; 
-                    }
-                }
-                else
-                {
-                    // if we're calculating coverage per sample, need to store it off. otherwise no covered samples, don't need to do anything
-                    if(sampleCount > SWR_MULTISAMPLE_1X)
-                    {
-                        triDesc.coverageMask[sampleNum] = 0;
-                    }
-                    RDTSC_EVENT(BETrivialReject, 1, 0);
+                    anyCoveredSamples |= triDesc.coverageMask[sampleNum];
                 }
             }
 
@@ -901,71 +927,6 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     RDTSC_STOP(BERasterizeTriangle, 1, 0);
 }
 
-void RasterizePoint(DRAW_CONTEXT *pDC, uint32_t workerId, const TRIANGLE_WORK_DESC &workDesc, uint32_t macroTile)
-{
-#if KNOB_ENABLE_TOSS_POINTS
-    if (KNOB_TOSS_BIN_TRIS)
-    {
-        return;
-    }
-#endif
-
-    // map x,y relative offsets from start of raster tile to bit position in 
-    // coverage mask for the point
-    static const uint32_t coverageMap[8][8] = {
-        { 0, 1, 4, 5, 8, 9, 12, 13 },
-        { 2, 3, 6, 7, 10, 11, 14, 15 },
-        { 16, 17, 20, 21, 24, 25, 28, 29 },
-        { 18, 19, 22, 23, 26, 27, 30, 31 },
-        { 32, 33, 36, 37, 40, 41, 44, 45 },
-        { 34, 35, 38, 39, 42, 43, 46, 47 },
-        { 48, 49, 52, 53, 56, 57, 60, 61 },
-        { 50, 51, 54, 55, 58, 59, 62, 63 }
-    };
-
-    OSALIGN(SWR_TRIANGLE_DESC, 16) triDesc;
-
-    // pull point information from triangle buffer
-    // @todo use structs for readability
-    uint32_t tileAlignedX = *(uint32_t*)workDesc.pTriBuffer;
-    uint32_t tileAlignedY = *(uint32_t*)(workDesc.pTriBuffer + 1);
-    float z = *(workDesc.pTriBuffer + 2);
-
-    // construct triangle descriptor for point
-    // no interpolation, set up i,j for constant interpolation of z and attribs
-    // @todo implement an optimized backend that doesn't require triangle information
-
-    // compute coverage mask from x,y packed into the coverageMask flag
-    // mask indices by the maximum valid index for x/y of coveragemap.
-    uint32_t tX = workDesc.triFlags.coverageMask & 0x7;
-    uint32_t tY = (workDesc.triFlags.coverageMask >> 4) & 0x7;
-    // todo: multisample points?
-    triDesc.coverageMask[0] = 1ULL << coverageMap[tY][tX];
-
-    // no persp divide needed for points
-    triDesc.pAttribs = triDesc.pPerspAttribs = workDesc.pAttribs;
-    triDesc.triFlags = workDesc.triFlags;
-    triDesc.recipDet = 1.0f;
-    triDesc.OneOverW[0] = triDesc.OneOverW[1] = triDesc.OneOverW[2] = 1.0f;
-    triDesc.I[0] = triDesc.I[1] = triDesc.I[2] = 0.0f;
-    triDesc.J[0] = triDesc.J[1] = triDesc.J[2] = 0.0f;
-    triDesc.Z[0] = triDesc.Z[1] = triDesc.Z[2] = z;
-
-    RenderOutputBuffers renderBuffers;
-    GetRenderHotTiles(pDC, macroTile, tileAlignedX >> KNOB_TILE_X_DIM_SHIFT , tileAlignedY >> KNOB_TILE_Y_DIM_SHIFT, 
-        renderBuffers, 1, triDesc.triFlags.renderTargetArrayIndex);
-
-    RDTSC_START(BEPixelBackend);
-    pDC->pState->pfnBackend(pDC, workerId, tileAlignedX, tileAlignedY, triDesc, renderBuffers);
-    RDTSC_STOP(BEPixelBackend, 0, 0);
-}
-
-void rastPoint(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
-{
-    TRIANGLE_WORK_DESC *pDesc = (TRIANGLE_WORK_DESC*)pData;
-    RasterizePoint(pDC, workerId, *pDesc, macroTile);
-
-}
 // Get pointers to hot tile memory for color RT, depth, stencil
 void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint32_t tileY, RenderOutputBuffers &renderBuffers, 
     uint32_t numSamples, uint32_t renderTargetArrayIndex)
@@ -1045,6 +1006,213 @@ void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputB
     buffers.pStencil = startBufferRow.pStencil;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Offsets single sampled hot tile pointers from the start of the
+///        macrotile to one of its raster tiles.
+/// @param tileX - raster tile x, relative to the macrotile.
+/// @param tileY - raster tile y, relative to the macrotile.
+INLINE
+void OffsetRasterTile(uint32_t MaxRT, const RenderOutputBuffers &base, RenderOutputBuffers &buffers, uint32_t tileX, uint32_t tileY)
+{
+    static const uint32_t colorRasterTileStep{KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8)};
+    static const uint32_t depthRasterTileStep{KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8)};
+    static const uint32_t stencilRasterTileStep{KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_STENCIL_HOT_TILE_FORMAT>::bpp / 8)};
+    const uint32_t tileIndex = tileY * KNOB_MACROTILE_X_DIM_IN_TILES + tileX;
+
+    for(uint32_t rt = 0; rt <= MaxRT; ++rt)
+    {
+        buffers.pColor[rt] = base.pColor[rt] + tileIndex * colorRasterTileStep;
+    }
+
+    buffers.pDepth = base.pDepth + tileIndex * depthRasterTileStep;
+    buffers.pStencil = base.pStencil + tileIndex * stencilRasterTileStep;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Computes the position of pixels in the storage of their raster
+///        tile, which is also their bit in the raster tile coverage mask.
+/// @param vX - pixel x, relative to the raster tile.
+/// @param vY - pixel y, relative to the raster tile.
+INLINE simdscalari ComputeRasterTilePixelIndex(simdscalari vX, simdscalari vY)
+{
+    // raster tiles store rows of 4x2 SIMD tiles, which store 2x2 quads
+    static_assert(SIMD_TILE_X_DIM == 4 && SIMD_TILE_Y_DIM == 2 && KNOB_SIMD_WIDTH == 8, "Unsupported SIMD tile dimensions");
+
+    simdscalari vSimdTile = _simd_add_epi32(_simd_slli_epi32(_simd_srli_epi32(vY, 1), KNOB_TILE_X_DIM_SHIFT - 2), _simd_srli_epi32(vX, 2));
+    simdscalari vQuad = _simd_slli_epi32(_simd_and_si(vX, _simd_set1_epi32(2)), 1);
+    simdscalari vQuadPixel = _simd_or_si(_simd_and_si(vX, _simd_set1_epi32(1)), _simd_slli_epi32(_simd_and_si(vY, _simd_set1_epi32(1)), 1));
+
+    return _simd_or_si(_simd_slli_epi32(vSimdTile, 3), _simd_or_si(vQuad, vQuadPixel));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the points of a work item can be depth tested
+///        together before any is shaded. Writes of earlier points only make
+///        less/greater tests stricter, so a point failing against the depth
+///        at the start of the work item fails when its turn comes too.
+INLINE bool CanRejectPointsEarly(const API_STATE& state)
+{
+    const SWR_DEPTH_STENCIL_STATE& dsState = state.depthStencilState;
+    if (!dsState.depthTestEnable || dsState.stencilTestEnable || state.psState.writesODepth)
+    {
+        return false;
+    }
+
+    switch (dsState.depthTestFunc)
+    {
+    case ZFUNC_NEVER:
+    case ZFUNC_LT:
+    case ZFUNC_LE:
+    case ZFUNC_GT:
+    case ZFUNC_GE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Rasterizes single pixel points binned to a macrotile. Points are
+///        located and depth tested a SIMD at a time, then each point left
+///        is shaded with constant attributes.
+void RasterizePoints(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
+{
+    const POINTS_WORK_DESC &workDesc = *((POINTS_WORK_DESC*)pData);
+#if KNOB_ENABLE_TOSS_POINTS
+    if (KNOB_TOSS_BIN_TRIS)
+    {
+        return;
+    }
+#endif
+
+    RDTSC_START(BERasterizePoints);
+
+    const API_STATE &state = GetApiState(pDC);
+    const uint32_t *pX = (const uint32_t*)workDesc.pPointBuffer;
+    const uint32_t *pY = pX + KNOB_SIMD_WIDTH;
+    const float *pZ = workDesc.pPointBuffer + 2 * KNOB_SIMD_WIDTH;
+    const uint32_t *pPrimID = pX + 3 * KNOB_SIMD_WIDTH;
+    const uint32_t *pRTAI = pX + 4 * KNOB_SIMD_WIDTH;
+
+    uint32_t macroX, macroY;
+    MacroTileMgr::getTileIndices(macroTile, macroX, macroY);
+
+    // locate the points in the macrotile
+    simdscalari vX = _simd_sub_epi32(_simd_load_si((const simdscalari*)pX), _simd_set1_epi32(macroX * KNOB_MACROTILE_X_DIM));
+    simdscalari vY = _simd_sub_epi32(_simd_load_si((const simdscalari*)pY), _simd_set1_epi32(macroY * KNOB_MACROTILE_Y_DIM));
+    simdscalari vTileX = _simd_srli_epi32(vX, KNOB_TILE_X_DIM_SHIFT);
+    simdscalari vTileY = _simd_srli_epi32(vY, KNOB_TILE_Y_DIM_SHIFT);
+    simdscalari vPixel = ComputeRasterTilePixelIndex(_simd_and_si(vX, _simd_set1_epi32(KNOB_TILE_X_DIM - 1)),
+                                                     _simd_and_si(vY, _simd_set1_epi32(KNOB_TILE_Y_DIM - 1)));
+
+    OSALIGNSIMD(uint32_t) aTileX[KNOB_SIMD_WIDTH], aTileY[KNOB_SIMD_WIDTH], aPixel[KNOB_SIMD_WIDTH];
+    _simd_store_si((simdscalari*)aTileX, vTileX);
+    _simd_store_si((simdscalari*)aTileY, vTileY);
+    _simd_store_si((simdscalari*)aPixel, vPixel);
+
+    uint32_t pointMask = workDesc.pointMask;
+
+    if (CanRejectPointsEarly(state))
+    {
+        RDTSC_START(BEEarlyDepthTest);
+        static_assert(KNOB_DEPTH_HOT_TILE_FORMAT == R32_FLOAT, "Unsupported depth hot tile format");
+
+        // Only the render target array slice of the first point was made ready by
+        // InitializeHotTiles, so points on other slices skip the early test.
+        DWORD firstLane;
+        _BitScanForward(&firstLane, pointMask);
+        const uint32_t earlyRTAI = pRTAI[firstLane];
+
+        uint32_t earlyMask = 0;
+        OSALIGNSIMD(int32_t) aActive[KNOB_SIMD_WIDTH];
+        for (uint32_t i = 0; i < KNOB_SIMD_WIDTH; ++i)
+        {
+            bool active = (pointMask & (1 << i)) && pRTAI[i] == earlyRTAI;
+            aActive[i] = active ? -1 : 0;
+            earlyMask |= active ? (1 << i) : 0;
+        }
+        simdscalar vActive = _simd_castsi_ps(_simd_load_si((const simdscalari*)aActive));
+
+        // depth of each point's pixel in the macrotile's depth hot tile
+        simdscalari vTileIndex = _simd_add_epi32(_simd_slli_epi32(vTileY, KNOB_MACROTILE_X_DIM_SHIFT - KNOB_TILE_X_DIM_SHIFT), vTileX);
+        simdscalari vIndex = _simd_add_epi32(_simd_slli_epi32(vTileIndex, KNOB_TILE_X_DIM_SHIFT + KNOB_TILE_Y_DIM_SHIFT), vPixel);
+        HOTTILE *pDepth = pDC->pContext->pHotTileMgr->GetHotTile(pDC->pContext, pDC, macroTile, SWR_ATTACHMENT_DEPTH, true, 1, earlyRTAI);
+        simdscalar vDepth = _simd_mask_i32gather_ps(_simd_setzero_ps(), (const float*)pDepth->pBuffer, vIndex, vActive, 4);
+
+        // clamp Z to viewport [minZ..maxZ], the core has a single viewport like the backends assume
+        simdscalar vZ = _simd_load_ps(pZ);
+        vZ = _simd_min_ps(_simd_broadcast_ss(&state.vp[0].maxZ), _simd_max_ps(_simd_broadcast_ss(&state.vp[0].minZ), vZ));
+
+        simdscalar vPass;
+        switch (state.depthStencilState.depthTestFunc)
+        {
+        case ZFUNC_LT: vPass = _simd_cmplt_ps(vZ, vDepth); break;
+        case ZFUNC_LE: vPass = _simd_cmple_ps(vZ, vDepth); break;
+        case ZFUNC_GT: vPass = _simd_cmpgt_ps(vZ, vDepth); break;
+        case ZFUNC_GE: vPass = _simd_cmpge_ps(vZ, vDepth); break;
+        default: vPass = _simd_setzero_ps(); break;
+        }
+
+        pointMask &= _simd_movemask_ps(vPass) | ~earlyMask;
+        RDTSC_STOP(BEEarlyDepthTest, 0, 0);
+    }
+
+    // constant attribute shading: with i = j = 0 the backend interpolates the third
+    // vertex only, which the binner filled with the point's attributes
+    OSALIGN(SWR_TRIANGLE_DESC, 16) triDesc;
+    triDesc.recipDet = 1.0f;
+    triDesc.OneOverW[0] = triDesc.OneOverW[1] = triDesc.OneOverW[2] = 1.0f;
+    triDesc.I[0] = triDesc.I[1] = triDesc.I[2] = 0.0f;
+    triDesc.J[0] = triDesc.J[1] = triDesc.J[2] = 0.0f;
+    triDesc.Z[0] = triDesc.Z[1] = 0.0f;
+    triDesc.pUserClipBuffer = nullptr;
+    triDesc.pSamplePos = pDC->pState->state.samplePos;
+    triDesc.triFlags = {};
+    triDesc.triFlags.frontFacing = 1;
+
+    RenderOutputBuffers macroBuffers = {}, renderBuffers;
+    uint32_t hotTileRTAI = 0xffffffff;
+    uint32_t numPoints = 0;
+
+    DWORD lane;
+    while (_BitScanForward(&lane, pointMask))
+    {
+        pointMask &= ~(1 << lane);
+
+        if (pRTAI[lane] != hotTileRTAI)
+        {
+            hotTileRTAI = pRTAI[lane];
+            GetRenderHotTiles(pDC, macroTile, macroX * KNOB_MACROTILE_X_DIM_IN_TILES, macroY * KNOB_MACROTILE_Y_DIM_IN_TILES,
+                macroBuffers, 1, hotTileRTAI);
+        }
+        OffsetRasterTile(state.psState.maxRTSlotUsed, macroBuffers, renderBuffers, aTileX[lane], aTileY[lane]);
+
+        triDesc.triFlags.primID = pPrimID[lane];
+        triDesc.triFlags.renderTargetArrayIndex = pRTAI[lane];
+        triDesc.Z[2] = pZ[lane];
+        triDesc.pAttribs = triDesc.pPerspAttribs = workDesc.pAttribs + lane * 3 * 4 * workDesc.numAttribs;
+        triDesc.coverageMask[0] = 1ULL << aPixel[lane];
+
+#if KNOB_ENABLE_TOSS_POINTS
+        if(KNOB_TOSS_RS)
+        {
+            gToss = triDesc.coverageMask[0];
+            continue;
+        }
+#endif
+
+        uint32_t x = (macroX * KNOB_MACROTILE_X_DIM_IN_TILES + aTileX[lane]) << KNOB_TILE_X_DIM_SHIFT;
+        uint32_t y = (macroY * KNOB_MACROTILE_Y_DIM_IN_TILES + aTileY[lane]) << KNOB_TILE_Y_DIM_SHIFT;
+
+        RDTSC_START(BEPixelBackend);
+        pDC->pState->pfnBackend(pDC, workerId, x, y, triDesc, renderBuffers);
+        RDTSC_STOP(BEPixelBackend, 0, 0);
+        ++numPoints;
+    }
+
+    RDTSC_STOP(BERasterizePoints, numPoints, pDC->drawId);
+}
+
 // initialize rasterizer function table
 PFN_WORK_FUNC gRasterizerTable[2][SWR_MULTISAMPLE_TYPE_MAX] =
 {
@@ -1060,19 +1228,12 @@ PFN_WORK_FUNC gRasterizerTable[2][SWR_MULTISAMPLE_TYPE_MAX] =
     RasterizeTriangle<true, SWR_MULTISAMPLE_16X>
 };
 
-void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Rasterizes a line as two triangles. Used for multisampled lines,
+///        the native line rasterizer only samples pixel centers.
+static void RasterizeLineAsTriangles(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, const TRIANGLE_WORK_DESC &workDesc)
 {
-    const TRIANGLE_WORK_DESC &workDesc = *((TRIANGLE_WORK_DESC*)pData);
-#if KNOB_ENABLE_TOSS_POINTS
-    if (KNOB_TOSS_BIN_TRIS)
-    {
-        return;
-    }
-#endif
-
     // bloat line to two tris and call the triangle rasterizer twice
-    RDTSC_START(BERasterizeLine);
-
     const API_STATE &state = GetApiState(pDC);
     const SWR_RASTSTATE &rastState = state.rastState;
 
@@ -1255,7 +1416,326 @@ void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, voi
         // rasterize triangle
         gRasterizerTable[rastState.scissorEnable][rastState.sampleCount](pDC, workerId, macroTile, (void*)&newWorkDesc);
     }
+}
 
-    RDTSC_STOP(BERasterizeLine, 1, 0);
+#if KNOB_SIMD_WIDTH == 8
+// pixel centers of a SIMD, in the order the backend shades them
+static const __m256 vQuadCenterOffsetsX = { 0.5, 1.5, 0.5, 1.5, 2.5, 3.5, 2.5, 3.5 };
+static const __m256 vQuadCenterOffsetsY = { 0.5, 0.5, 1.5, 1.5, 0.5, 0.5, 1.5, 1.5 };
+#else
+#error Unsupported vector width
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Line setup for the native line rasterizer. Coordinates are
+///        ordered major axis first, so x and y major lines share a path.
+struct LINE_SETUP
+{
+    float p0[2];            // start point
+    float len;              // length along the major axis
+    float dir;              // 1 if the line runs towards +major, else -1
+    float slope;            // minor axis step per unit of travel, |slope| <= 1
+    float recipUpper;       // 1 / (1 + slope)
+    float recipLower;       // 1 / (1 - slope)
+    float halfWidth;
+    bool diamond;           // width 1 lines use the diamond exit rule
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Computes line coverage of a SIMD of pixel centers.
+/// @param line - line setup.
+/// @param vMajor - pixel centers along the major axis.
+/// @param vMinor - pixel centers along the minor axis.
+/// @param vStep - receives the fragment index along the line, for stippling.
+INLINE simdscalar ComputeLineCoverage(const LINE_SETUP& line, simdscalar vMajor, simdscalar vMinor, simdscalar& vStep)
+{
+    const simdscalar vZero = _simd_setzero_ps();
+    const simdscalar vHalf = _simd_set1_ps(0.5f);
+    const simdscalar vSlope = _simd_set1_ps(line.slope);
+    const simdscalar vLen = _simd_set1_ps(line.len);
+
+    // travel from p0 to the pixel center, and minor offset of the line from the center there
+    simdscalar vU = _simd_mul_ps(_simd_sub_ps(vMajor, _simd_set1_ps(line.p0[0])), _simd_set1_ps(line.dir));
+    simdscalar vD = _simd_sub_ps(_simd_fmadd_ps(vU, vSlope, _simd_set1_ps(line.p0[1])), vMinor);
+
+    simdscalar vMask;
+    if (line.diamond)
+    {
+        // a pixel is lit if the line leaves its diamond |major| + |minor| < 1/2 after p0 and
+        // no later than p1. Lines crossing the diamond cross the center's minor extent, and exit
+        // through the upper edge (d + u * slope = 1/2 - u) or the lower edge (d + u * slope = u - 1/2)
+        simdscalar vUpper = _simd_mul_ps(_simd_sub_ps(vHalf, vD), _simd_set1_ps(line.recipUpper));
+        simdscalar vLower = _simd_mul_ps(_simd_add_ps(vHalf, vD), _simd_set1_ps(line.recipLower));
+        simdscalar vExitMinor = _simd_fmadd_ps(vUpper, vSlope, vD);
+        simdscalar vExit = _simd_add_ps(vU, _simd_blendv_ps(vLower, vUpper, _simd_cmpge_ps(vExitMinor, vZero)));
+
+        vMask = _simd_and_ps(_simd_cmpgt_ps(vD, _simd_set1_ps(-0.5f)), _simd_cmple_ps(vD, vHalf));
+        vMask = _simd_and_ps(vMask, _simd_cmpgt_ps(vExit, vZero));
+        vMask = _simd_and_ps(vMask, _simd_cmple_ps(vExit, vLen));
+
+        // fragment n exits in (n, n + 1]
+        vStep = _simd_sub_ps(_simd_round_ps(vExit, _MM_FROUND_TO_POS_INF), _simd_set1_ps(1.0f));
+        vStep = _simd_max_ps(vStep, vZero);
+    }
+    else
+    {
+        // wide lines cover the parallelogram spanning halfWidth either side along the minor axis
+        simdscalar vHalfWidth = _simd_set1_ps(line.halfWidth);
+        vMask = _simd_and_ps(_simd_cmpgt_ps(vD, _simd_sub_ps(vZero, vHalfWidth)), _simd_cmple_ps(vD, vHalfWidth));
+        vMask = _simd_and_ps(vMask, _simd_cmpge_ps(vU, vZero));
+        vMask = _simd_and_ps(vMask, _simd_cmplt_ps(vU, vLen));
+
+        vStep = _simd_max_ps(vU, vZero);
+    }
+
+    return vMask;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Removes stippled out fragments from a SIMD of line coverage.
+/// @param rastState - raster state with the stipple pattern.
+/// @param vStep - fragment index along the line.
+/// @param mask - coverage mask of the SIMD.
+INLINE uint32_t ApplyLineStipple(const SWR_RASTSTATE& rastState, simdscalar vStep, uint32_t mask)
+{
+    OSALIGNSIMD(int32_t) step[KNOB_SIMD_WIDTH];
+    _simd_store_si((simdscalari*)step, _simd_cvttps_epi32(vStep));
+
+    uint32_t lanes = mask;
+    DWORD lane;
+    while (_BitScanForward(&lane, lanes))
+    {
+        lanes &= ~(1 << lane);
+        uint32_t bit = (step[lane] / rastState.lineStippleFactor) & 15;
+        if (!((rastState.lineStipplePattern >> bit) & 1))
+        {
+            mask &= ~(1 << lane);
+        }
+    }
+
+    return mask;
 }
 
+void RasterizeLine(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
+{
+    const TRIANGLE_WORK_DESC &workDesc = *((TRIANGLE_WORK_DESC*)pData);
+#if KNOB_ENABLE_TOSS_POINTS
+    if (KNOB_TOSS_BIN_TRIS)
+    {
+        return;
+    }
+#endif
+
+    RDTSC_START(BERasterizeLine);
+
+    const API_STATE &state = GetApiState(pDC);
+    const SWR_RASTSTATE &rastState = state.rastState;
+
+    if (rastState.sampleCount != SWR_MULTISAMPLE_1X)
+    {
+        RasterizeLineAsTriangles(pDC, workerId, macroTile, workDesc);
+        RDTSC_STOP(BERasterizeLine, 1, 0);
+        return;
+    }
+
+    // pTriBuffer data layout: grouped components of the 2 line points
+    const float *pZ = workDesc.pTriBuffer + 8;
+    const float *pRecipW = workDesc.pTriBuffer + 12;
+    const float p0[2] = { workDesc.pTriBuffer[0], workDesc.pTriBuffer[4] };
+    const float p1[2] = { workDesc.pTriBuffer[1], workDesc.pTriBuffer[5] };
+
+    const uint32_t major = workDesc.triFlags.yMajor;
+    const uint32_t minor = major ^ 1;
+
+    LINE_SETUP line;
+    line.p0[0] = p0[major];
+    line.p0[1] = p0[minor];
+    line.len = fabsf(p1[major] - p0[major]);
+    if (line.len == 0.0f)
+    {
+        RDTSC_STOP(BERasterizeLine, 1, 0);
+        return;
+    }
+    line.dir = (p1[major] < p0[major]) ? -1.0f : 1.0f;
+    line.slope = (p1[minor] - p0[minor]) / line.len;
+    line.recipUpper = 1.0f / std::max(1.0f + line.slope, FLT_EPSILON);
+    line.recipLower = 1.0f / std::max(1.0f - line.slope, FLT_EPSILON);
+    line.halfWidth = rastState.lineWidth * 0.5f;
+    line.diamond = rastState.lineWidth <= 1.0f;
+
+    // pixels the line can light: its bounding box bloated by the width, within scissor and macrotile
+    uint32_t macroX, macroY;
+    MacroTileMgr::getTileIndices(macroTile, macroX, macroY);
+    const float reach = std::max(line.halfWidth, 0.5f);
+    int32_t pixMin[2], pixMax[2];
+    pixMin[0] = std::max((int32_t)floorf(std::min(p0[0], p1[0]) - reach - 0.5f),
+        std::max(state.scissorInFixedPoint.left >> FIXED_POINT_SHIFT, (int32_t)(macroX * KNOB_MACROTILE_X_DIM)));
+    pixMax[0] = std::min((int32_t)floorf(std::max(p0[0], p1[0]) + reach - 0.5f),
+        std::min(state.scissorInFixedPoint.right >> FIXED_POINT_SHIFT, (int32_t)(macroX * KNOB_MACROTILE_X_DIM + KNOB_MACROTILE_X_DIM - 1)));
+    pixMin[1] = std::max((int32_t)floorf(std::min(p0[1], p1[1]) - reach - 0.5f),
+        std::max(state.scissorInFixedPoint.top >> FIXED_POINT_SHIFT, (int32_t)(macroY * KNOB_MACROTILE_Y_DIM)));
+    pixMax[1] = std::min((int32_t)floorf(std::max(p0[1], p1[1]) + reach - 0.5f),
+        std::min(state.scissorInFixedPoint.bottom >> FIXED_POINT_SHIFT, (int32_t)(macroY * KNOB_MACROTILE_Y_DIM + KNOB_MACROTILE_Y_DIM - 1)));
+
+    if (pixMin[0] > pixMax[0] || pixMin[1] > pixMax[1])
+    {
+        RDTSC_STOP(BERasterizeLine, 1, 0);
+        return;
+    }
+
+    const simdscalar vClipMinX = _simd_set1_ps((float)pixMin[0]);
+    const simdscalar vClipMaxX = _simd_set1_ps((float)(pixMax[0] + 1));
+    const simdscalar vClipMinY = _simd_set1_ps((float)pixMin[1]);
+    const simdscalar vClipMaxY = _simd_set1_ps((float)(pixMax[1] + 1));
+
+    OSALIGN(SWR_TRIANGLE_DESC, 16) triDesc;
+    triDesc.triFlags = workDesc.triFlags;
+    triDesc.pSamplePos = pDC->pState->state.samplePos;
+
+    // 1D interpolation: i is the weight of v0, from the projection of the pixel onto the line,
+    // v1 is the third vertex and j is unused
+    const float dx = p1[0] - p0[0];
+    const float dy = p1[1] - p0[1];
+    const float recipLenSq = 1.0f / (dx * dx + dy * dy);
+    triDesc.recipDet = 1.0f;
+    triDesc.I[0] = -dx * recipLenSq;
+    triDesc.I[1] = -dy * recipLenSq;
+    triDesc.I[2] = 1.0f + (p0[0] * dx + p0[1] * dy) * recipLenSq;
+    triDesc.J[0] = triDesc.J[1] = triDesc.J[2] = 0.0f;
+
+    triDesc.OneOverW[0] = pRecipW[0] - pRecipW[1];
+    triDesc.OneOverW[1] = 0.0f;
+    triDesc.OneOverW[2] = pRecipW[1];
+
+    triDesc.Z[0] = pZ[0] - pZ[1];
+    triDesc.Z[1] = 0.0f;
+    triDesc.Z[2] = pZ[1];
+    triDesc.Z[2] += ComputeDepthBias(&rastState, &triDesc, pZ);
+
+    // binner stores attribs as v0, v1, v1; only the two endpoints need the perspective divide
+    float* pPerspAttribs = perspAttribsTLS;
+    const float* pAttribs = workDesc.pAttribs;
+    triDesc.pPerspAttribs = pPerspAttribs;
+    triDesc.pAttribs = workDesc.pAttribs;
+    __m128 vOneOverWV0 = _mm_broadcast_ss(pRecipW);
+    __m128 vOneOverWV1 = _mm_broadcast_ss(pRecipW + 1);
+    for (uint32_t i = 0; i < workDesc.numAttribs; ++i)
+    {
+        __m128 attribA = _mm_mul_ps(_mm_load_ps(pAttribs), vOneOverWV0);
+        __m128 attribB = _mm_mul_ps(_mm_load_ps(pAttribs + 4), vOneOverWV1);
+        pAttribs += 12;
+
+        _mm_store_ps(pPerspAttribs, attribA);
+        _mm_store_ps(pPerspAttribs + 4, attribB);
+        _mm_store_ps(pPerspAttribs + 8, attribB);
+        pPerspAttribs += 12;
+    }
+
+    // user clip distances, c = a * i + b
+    float clipBuffer[3 * 8];
+    triDesc.pUserClipBuffer = workDesc.pUserClipBuffer;
+    uint32_t numClipDist = _mm_popcnt_u32(rastState.clipDistanceMask);
+    if (numClipDist)
+    {
+        for (uint32_t i = 0; i < numClipDist; ++i)
+        {
+            clipBuffer[i * 3 + 0] = workDesc.pUserClipBuffer[i * 2 + 0];
+            clipBuffer[i * 3 + 1] = 0.0f;
+            clipBuffer[i * 3 + 2] = workDesc.pUserClipBuffer[i * 2 + 1];
+        }
+        triDesc.pUserClipBuffer = clipBuffer;
+    }
+
+    // hot tiles are fetched once the line covers a pixel of the macrotile
+    RenderOutputBuffers macroBuffers = {}, renderBuffers;
+    bool haveHotTiles = false;
+
+    const uint32_t tileShift[2] = { KNOB_TILE_X_DIM_SHIFT, KNOB_TILE_Y_DIM_SHIFT };
+    const float segMin = std::min(p0[major], p1[major]) - 0.5f;
+    const float segMax = std::max(p0[major], p1[major]) + 0.5f;
+    const float minorStep = line.dir * line.slope;
+
+    // walk the raster tiles along the major axis, visiting only the tiles the line
+    // crosses along the minor axis
+    for (int32_t tM = pixMin[major] >> tileShift[major]; tM <= (pixMax[major] >> tileShift[major]); ++tM)
+    {
+        float colStart = (float)std::max(tM << tileShift[major], pixMin[major]) + 0.5f;
+        float colEnd = (float)std::min(((tM + 1) << tileShift[major]) - 1, pixMax[major]) + 0.5f;
+        colStart = std::min(std::max(colStart, segMin), segMax);
+        colEnd = std::min(std::max(colEnd, segMin), segMax);
+
+        float minor0 = line.p0[1] + (colStart - line.p0[0]) * minorStep;
+        float minor1 = line.p0[1] + (colEnd - line.p0[0]) * minorStep;
+        int32_t rowMin = std::max((int32_t)floorf(std::min(minor0, minor1) - reach - 0.5f), pixMin[minor]);
+        int32_t rowMax = std::min((int32_t)floorf(std::max(minor0, minor1) + reach - 0.5f), pixMax[minor]);
+
+        for (int32_t tm = rowMin >> tileShift[minor]; rowMin <= rowMax && tm <= (rowMax >> tileShift[minor]); ++tm)
+        {
+            uint32_t tile[2];
+            tile[major] = tM;
+            tile[minor] = tm;
+            uint32_t x = tile[0] << KNOB_TILE_X_DIM_SHIFT;
+            uint32_t y = tile[1] << KNOB_TILE_Y_DIM_SHIFT;
+
+            // coverage bits in the order of the backend's SIMD tiles
+            uint64_t coverage = 0;
+            uint32_t bit = 0;
+            for (uint32_t yy = y; yy < y + KNOB_TILE_Y_DIM; yy += SIMD_TILE_Y_DIM)
+            {
+                for (uint32_t xx = x; xx < x + KNOB_TILE_X_DIM; xx += SIMD_TILE_X_DIM)
+                {
+                    simdscalar vPos[2];
+                    vPos[0] = _simd_add_ps(vQuadCenterOffsetsX, _simd_set1_ps((float)xx));
+                    vPos[1] = _simd_add_ps(vQuadCenterOffsetsY, _simd_set1_ps((float)yy));
+
+                    simdscalar vStep;
+                    simdscalar vMask = ComputeLineCoverage(line, vPos[major], vPos[minor], vStep);
+                    vMask = _simd_and_ps(vMask, _simd_cmpgt_ps(vPos[0], vClipMinX));
+                    vMask = _simd_and_ps(vMask, _simd_cmplt_ps(vPos[0], vClipMaxX));
+                    vMask = _simd_and_ps(vMask, _simd_cmpgt_ps(vPos[1], vClipMinY));
+                    vMask = _simd_and_ps(vMask, _simd_cmplt_ps(vPos[1], vClipMaxY));
+
+                    uint32_t mask = _simd_movemask_ps(vMask);
+                    if (mask && rastState.lineStippleEnable)
+                    {
+                        mask = ApplyLineStipple(rastState, vStep, mask);
+                    }
+
+                    coverage |= (uint64_t)mask << bit;
+                    bit += KNOB_SIMD_WIDTH;
+                }
+            }
+
+            if (!coverage)
+            {
+                continue;
+            }
+
+#if KNOB_ENABLE_TOSS_POINTS
+            if(KNOB_TOSS_RS)
+            {
+                gToss = coverage;
+                continue;
+            }
+#endif
+
+            if (!haveHotTiles)
+            {
+                GetRenderHotTiles(pDC, macroTile, macroX * KNOB_MACROTILE_X_DIM_IN_TILES, macroY * KNOB_MACROTILE_Y_DIM_IN_TILES,
+                    macroBuffers, 1, triDesc.triFlags.renderTargetArrayIndex);
+                haveHotTiles = true;
+            }
+
+            OffsetRasterTile(state.psState.maxRTSlotUsed, macroBuffers, renderBuffers,
+                tile[0] - macroX * KNOB_MACROTILE_X_DIM_IN_TILES, tile[1] - macroY * KNOB_MACROTILE_Y_DIM_IN_TILES);
+
+            triDesc.coverageMask[0] = coverage;
+
+            RDTSC_START(BEPixelBackend);
+            pDC->pState->pfnBackend(pDC, workerId, x, y, triDesc, renderBuffers);
+            RDTSC_STOP(BEPixelBackend, 0, 0);
+        }
+    }
+
+    RDTSC_STOP(BERasterizeLine, 1, 0);
+}
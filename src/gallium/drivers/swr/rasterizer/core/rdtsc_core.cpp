@@ -28,8 +28,9 @@
 BUCKET_DESC gCoreBuckets[] = {
     { "APIClearRenderTarget", "", true, 0xff0b8bea },
     { "APIDraw", "", true, 0xff000066 },
-    { "APIDrawWakeAllThreads", "", false, 0xffffffff },
+    { "APIDrawWakeThreads", "", false, 0xffffffff },
     { "APIDrawIndexed", "", true, 0xff000066 },
+    { "APIDrawIndirect", "", true, 0xff000066 },
     { "APIDispatch", "", true, 0xff660000 },
     { "APIStoreTiles", "", true, 0xff00ffff },
     { "APIGetDrawContext", "", false, 0xffffffff },
@@ -39,6 +40,7 @@ BUCKET_DESC gCoreBuckets[] = {
     { "FEProcessDrawIndexed", "", true, 0xff009900 },
     { "FEFetchShader", "", false, 0xffffffff },
     { "FEVertexShader", "", false, 0xffffffff },
+    { "FEFetchVertexShader", "", false, 0xffffffff },
     { "FEHullShader", "", false, 0xffffffff },
     { "FETessellation", "", false, 0xffffffff },
     { "FEDomainShader", "", false, 0xffffffff },
@@ -63,12 +65,16 @@ BUCKET_DESC gCoreBuckets[] = {
     { "BELoadTiles", "", true, 0xffb0e2ff },
     { "BEDispatch", "", true, 0xff00a2ff },
     { "BEClear", "", true, 0xff00ccbb },
+    { "BEClearMaterialize", "", true, 0xff00b2a4 },
+    { "BERasterizePoints", "", true, 0xffb26a4e },
     { "BERasterizeLine", "", true, 0xffb26a4e },
     { "BERasterizeTriangle", "", true, 0xffb26a4e },
     { "BETriangleSetup", "", false, 0xffffffff },
     { "BEStepSetup", "", false, 0xffffffff },
     { "BECullZeroArea", "", false, 0xffffffff },
     { "BEEmptyTriangle", "", false, 0xffffffff },
+    { "BEMacroTileTrivialAccept", "", false, 0xffffffff },
+    { "BEMacroTileTrivialReject", "", false, 0xffffffff },
     { "BETrivialAccept", "", false, 0xffffffff },
     { "BETrivialReject", "", false, 0xffffffff },
     { "BERasterizePartial", "", false, 0xffffffff },
@@ -80,12 +86,18 @@ BUCKET_DESC gCoreBuckets[] = {
     { "BELateDepthTest", "", false, 0xffffffff },
     { "BEOutputMerger", "", false, 0xffffffff },
     { "BEStoreTiles", "", true, 0xff00cccc },
+    { "BEStoreTilesClear", "", true, 0xff00b2b2 },
+    { "BEStoreTilesStreaming", "", true, 0xff009999 },
     { "BEEndTile", "", false, 0xffffffff },
     { "WorkerWaitForThreadEvent", "", false, 0xffffffff },
+    { "WorkerSpinWait", "", false, 0xffffffff },
 };
 
 /// @todo bucketmanager and mapping should probably be a part of the SWR context
 std::vector<uint32_t> gBucketMap;
-BucketManager gBucketMgr(KNOB_BUCKETS_ENABLE_THREADVIZ);
+BucketManager gBucketMgr(KNOB_BUCKETS_ENABLE_THREADVIZ, KNOB_BUCKETS_TRACE_EVENTS);
 
 uint32_t gCurrentFrame = 0;
+
+// live contexts sharing the buckets
+std::atomic<uint32_t> gNumRdtscContexts{ 0 };
@@ -27,14 +27,16 @@
 #include "common/os.h"
 #include "common/rdtsc_buckets.h"
 
+#include <atomic>
 #include <vector>
 
 enum CORE_BUCKETS
 {
     APIClearRenderTarget,
     APIDraw,
-    APIDrawWakeAllThreads,
+    APIDrawWakeThreads,
     APIDrawIndexed,
+    APIDrawIndirect,
     APIDispatch,
     APIStoreTiles,
     APIGetDrawContext,
@@ -44,6 +46,7 @@ enum CORE_BUCKETS
     FEProcessDrawIndexed,
     FEFetchShader,
     FEVertexShader,
+    FEFetchVertexShader,
     FEHullShader,
     FETessellation,
     FEDomainShader,
@@ -68,12 +71,16 @@ enum CORE_BUCKETS
     BELoadTiles,
     BEDispatch,
     BEClear,
+    BEClearMaterialize,
+    BERasterizePoints,
     BERasterizeLine,
     BERasterizeTriangle,
     BETriangleSetup,
     BEStepSetup,
     BECullZeroArea,
     BEEmptyTriangle,
+    BEMacroTileTrivialAccept,
+    BEMacroTileTrivialReject,
     BETrivialAccept,
     BETrivialReject,
     BERasterizePartial,
@@ -85,8 +92,11 @@ enum CORE_BUCKETS
     BELateDepthTest,
     BEOutputMerger,
     BEStoreTiles,
+    BEStoreTilesClear,
+    BEStoreTilesStreaming,
     BEEndTile,
     WorkerWaitForThreadEvent,
+    WorkerSpinWait,
 
     NumBuckets
 };
@@ -97,6 +107,8 @@ void rdtscStart(uint32_t bucketId);
 void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId);
 void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2);
 void rdtscEndFrame();
+void rdtscTraceContext(uint64_t drawId, uint32_t macroTile);
+void rdtscShutdown();
 
 #ifdef KNOB_ENABLE_RDTSC
 #define RDTSC_RESET() rdtscReset()
@@ -105,6 +117,8 @@ void rdtscEndFrame();
 #define RDTSC_STOP(bucket, count, draw) rdtscStop(bucket, count, draw)
 #define RDTSC_EVENT(bucket, count1, count2) rdtscEvent(bucket, count1, count2)
 #define RDTSC_ENDFRAME() rdtscEndFrame()
+#define RDTSC_TRACE_CONTEXT(drawId, macroTile) rdtscTraceContext(drawId, macroTile)
+#define RDTSC_SHUTDOWN() rdtscShutdown()
 #else
 #define RDTSC_RESET()
 #define RDTSC_INIT(threadId)
@@ -112,15 +126,24 @@ void rdtscEndFrame();
 #define RDTSC_STOP(bucket, count, draw)
 #define RDTSC_EVENT(bucket, count1, count2)
 #define RDTSC_ENDFRAME()
+#define RDTSC_TRACE_CONTEXT(drawId, macroTile)
+#define RDTSC_SHUTDOWN()
 #endif
 
 extern std::vector<uint32_t> gBucketMap;
 extern BucketManager gBucketMgr;
 extern BUCKET_DESC gCoreBuckets[];
 extern uint32_t gCurrentFrame;
+extern std::atomic<uint32_t> gNumRdtscContexts;
 
 INLINE void rdtscReset()
 {
+    // the buckets are shared by all contexts, only the first one resets them
+    if (gNumRdtscContexts.fetch_add(1) != 0)
+    {
+        return;
+    }
+
     gCurrentFrame = 0;
     gBucketMgr.ClearThreads();
     gBucketMgr.ClearBuckets();
@@ -129,7 +152,7 @@ INLINE void rdtscReset()
 INLINE void rdtscInit(int threadId)
 {
     // register all the buckets once
-    if (threadId == 0)
+    if (threadId == 0 && gBucketMap.empty())
     {
         gBucketMap.resize(NumBuckets);
         for (uint32_t i = 0; i < NumBuckets; ++i)
@@ -140,6 +163,12 @@ INLINE void rdtscInit(int threadId)
 
     std::string name = threadId == 0 ? "API" : "WORKER";
     gBucketMgr.RegisterThread(name);
+
+    // start frame 0 captures continuously from context creation
+    if (threadId == 0 && KNOB_BUCKETS_START_FRAME == 0 && !gBucketMgr.IsCapturing())
+    {
+        gBucketMgr.StartCapture();
+    }
 }
 
 INLINE void rdtscStart(uint32_t bucketId)
@@ -151,7 +180,7 @@ INLINE void rdtscStart(uint32_t bucketId)
 INLINE void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId)
 {
     uint32_t id = gBucketMap[bucketId];
-    gBucketMgr.StopBucket(id);
+    gBucketMgr.StopBucket(id, drawId);
 }
 
 INLINE void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2)
@@ -169,9 +198,36 @@ INLINE void rdtscEndFrame()
         gBucketMgr.StartCapture();
     }
 
-    if (gCurrentFrame == KNOB_BUCKETS_END_FRAME)
+    // a continuous capture runs until the last context is destroyed
+    if (gCurrentFrame == KNOB_BUCKETS_END_FRAME && KNOB_BUCKETS_START_FRAME != 0)
     {
         gBucketMgr.StopCapture();
         gBucketMgr.PrintReport("rdtsc.txt");
+        gBucketMgr.DumpChromeTrace("rdtsc_trace.json");
     }
 }
+
+INLINE void rdtscTraceContext(uint64_t drawId, uint32_t macroTile)
+{
+    gBucketMgr.SetTraceContext(drawId, macroTile);
+}
+
+INLINE void rdtscShutdown()
+{
+    // other contexts may still be recording into the shared buckets
+    if (gNumRdtscContexts.fetch_sub(1) != 1)
+    {
+        return;
+    }
+
+    // flush a capture still running at teardown, e.g. a continuous one
+    if (gBucketMgr.IsCapturing())
+    {
+        gBucketMgr.StopCapture();
+        gBucketMgr.PrintReport("rdtsc.txt");
+        gBucketMgr.DumpChromeTrace("rdtsc_trace.json");
+    }
+
+    // the next context registers the buckets again
+    gBucketMap.clear();
+}
@@ -292,8 +292,8 @@ struct SWR_GS_CONTEXT
     simdscalari PrimitiveID;    // IN: input primitive ID generated from the draw call
     uint32_t InstanceID;        // IN: input instance ID
     uint8_t* pStream[4];        // OUT: output streams
-    uint8_t* pCutBuffer;        // OUT: cut buffer
-    simdscalari vertexCount;    // OUT: num vertices emitted per SIMD lane
+    uint8_t* pCutBuffer[4];     // OUT: cut buffer per stream, zeroed before the GS runs
+    simdscalari vertexCount[4]; // OUT: num vertices emitted per SIMD lane, per stream
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -535,17 +535,47 @@ struct SWR_STATS
     uint64_t CPrimitives;   // Number of clipper primitives.
     uint64_t GsPrimitives;  // Number of prims GS outputs.
 
+    // Draw batching
+    uint64_t DrawsMerged;   // Number of draws merged into an earlier draw's context.
+
     // Streamout Stats
     uint32_t SoWriteOffset[4];
     uint64_t SoPrimStorageNeeded[4];
     uint64_t SoNumPrimsWritten[4];
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// SWR_HOT_TILE_STATS
+/// @brief Hot tile memory held by a context.
+/////////////////////////////////////////////////////////////////////////
+struct SWR_HOT_TILE_STATS
+{
+    uint64_t ResidentBytes;     // Hot tile memory allocated, including pooled buffers.
+    uint64_t PooledBytes;       // Memory of freed tiles kept for reuse.
+    uint64_t PeakResidentBytes; // Highest ResidentBytes seen.
+    uint64_t TilesEvicted;      // Number of resolved tiles freed to stay within budget.
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DRAW_RING_STATS
+/// @brief Draw context ring usage of a context, for tuning submission depth.
+/////////////////////////////////////////////////////////////////////////
+struct SWR_DRAW_RING_STATS
+{
+    uint64_t DrawContexts;      // Number of draw contexts taken from the ring.
+    uint64_t InFlightSum;       // Sum of draws in flight when each draw context was taken.
+    uint64_t StallCount;        // Number of times the API thread waited for a free draw context.
+    uint64_t StallTicks;        // rdtsc ticks the API thread spent waiting.
+    uint32_t MaxInFlight;       // Highest number of draws in flight.
+    uint32_t RingSize;          // Number of draw contexts in the ring.
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// STREAMOUT_BUFFERS
 /////////////////////////////////////////////////////////////////////////
 
 #define MAX_SO_STREAMS 4
+#define MAX_GS_INSTANCES 32
 #define MAX_ATTRIBUTES 32
 
 struct SWR_STREAMOUT_BUFFER
@@ -594,6 +624,10 @@ struct SWR_STREAMOUT_STATE
     // Number of attributes, including position, per vertex that are streamed out.
     // This should match number of bits in stream mask.
     uint32_t streamNumEntries[MAX_SO_STREAMS];
+
+    // The buffer masks specify which SO buffers each stream writes to. They let
+    // the API reserve output ranges for draws whose primitive count is known.
+    uint32_t bufferMasks[MAX_SO_STREAMS];
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -628,7 +662,7 @@ struct SWR_GS_STATE
     // maximum number of verts that can be emitted by a single instance of the GS
     uint32_t maxNumVerts;
     
-    // instance count
+    // instance count, at most MAX_GS_INSTANCES
     uint32_t instanceCount;
 
     // geometry shader emits renderTargetArrayIndex
@@ -636,6 +670,13 @@ struct SWR_GS_STATE
 
     // geometry shader emits PrimitiveID
     bool emitsPrimitiveID;
+
+    // number of output streams written by the GS. 0 is treated as 1.
+    uint32_t numStreams;
+
+    // number of simdvector slots in each emitted vertex. Output is packed
+    // to this many slots; slots beyond it read as 0. 0 means a full simdvertex.
+    uint32_t outputVertexSize;
 };
 
 
@@ -721,6 +762,7 @@ static_assert(sizeof(SWR_BLEND_STATE) == 32, "Invalid SWR_BLEND_STATE size");
 
 typedef void(__cdecl *PFN_FETCH_FUNC)(SWR_FETCH_CONTEXT& fetchInfo, simdvertex& out);
 typedef void(__cdecl *PFN_VERTEX_FUNC)(HANDLE hPrivateData, SWR_VS_CONTEXT* pVsContext);
+typedef void(__cdecl *PFN_FETCH_VS_FUNC)(HANDLE hPrivateData, SWR_FETCH_CONTEXT& fetchInfo, SWR_VS_CONTEXT* pVsContext);
 typedef void(__cdecl *PFN_HS_FUNC)(HANDLE hPrivateData, SWR_HS_CONTEXT* pHsContext);
 typedef void(__cdecl *PFN_DS_FUNC)(HANDLE hPrivateData, SWR_DS_CONTEXT* pDsContext);
 typedef void(__cdecl *PFN_GS_FUNC)(HANDLE hPrivateData, SWR_GS_CONTEXT* pGsContext);
@@ -833,6 +875,11 @@ struct SWR_RASTSTATE
     float pointSize;
     float lineWidth;
 
+    // line stipple, bit n of the pattern covers fragments [n * factor, (n + 1) * factor)
+    bool lineStippleEnable;
+    uint16_t lineStipplePattern;
+    uint32_t lineStippleFactor;
+
     // point size output from the VS
     bool pointParam;
 
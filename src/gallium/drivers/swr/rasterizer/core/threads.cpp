@@ -35,6 +35,9 @@
 #include <pthread.h>
 #include <sched.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <numa.h>
+#include <numaif.h>
 #endif
 
 #include "common/os.h"
@@ -55,11 +58,34 @@ struct Core
 
 struct NumaNode
 {
-    std::vector<Core> cores;
+    uint32_t                numaId = 0;     // OS node id, memory is placed with it
+    std::vector<Core>       cores;
 };
 
 typedef std::vector<NumaNode> CPUNumaNodes;
 
+#if !defined(_WIN32)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the NUMA node of a logical processor.
+/// @param threadId - logical processor number.
+/// @param physicalId - package the processor belongs to.
+static uint32_t GetNumaNodeOfProcessor(uint32_t threadId, uint32_t physicalId)
+{
+    // A package only matches a NUMA node when it isn't split into several
+    // (e.g. sub-NUMA clustering), so ask the kernel when it can tell us.
+    if (numa_available() >= 0)
+    {
+        int node = numa_node_of_cpu(threadId);
+        if (node >= 0)
+        {
+            return (uint32_t)node;
+        }
+    }
+
+    return physicalId;
+}
+#endif
+
 void CalculateProcessorTopology(CPUNumaNodes& out_nodes)
 {
     out_nodes.clear();
@@ -147,8 +173,9 @@ void CalculateProcessorTopology(CPUNumaNodes& out_nodes)
             if (threadId != uint32_t(-1))
             {
                 // Save information.
-                if (out_nodes.size() <= numaId) out_nodes.resize(numaId + 1);
-                auto& numaNode = out_nodes[numaId];
+                uint32_t nodeId = GetNumaNodeOfProcessor(threadId, numaId);
+                if (out_nodes.size() <= nodeId) out_nodes.resize(nodeId + 1);
+                auto& numaNode = out_nodes[nodeId];
                 if (numaNode.cores.size() <= coreId) numaNode.cores.resize(coreId + 1);
                 auto& core = numaNode.cores[coreId];
 
@@ -177,8 +204,9 @@ void CalculateProcessorTopology(CPUNumaNodes& out_nodes)
     if (threadId != uint32_t(-1))
     {
         // Save information.
-        if (out_nodes.size() <= numaId) out_nodes.resize(numaId + 1);
-        auto& numaNode = out_nodes[numaId];
+        uint32_t nodeId = GetNumaNodeOfProcessor(threadId, numaId);
+        if (out_nodes.size() <= nodeId) out_nodes.resize(nodeId + 1);
+        auto& numaNode = out_nodes[nodeId];
         if (numaNode.cores.size() <= coreId) numaNode.cores.resize(coreId + 1);
         auto& core = numaNode.cores[coreId];
 
@@ -191,7 +219,7 @@ void CalculateProcessorTopology(CPUNumaNodes& out_nodes)
         auto it = numaNode.cores.begin();
         for ( ; it != numaNode.cores.end(); ) {
             if (it->threadIds.size() == 0)
-                numaNode.cores.erase(it);
+                it = numaNode.cores.erase(it);
             else
                 ++it;
         }
@@ -202,9 +230,52 @@ void CalculateProcessorTopology(CPUNumaNodes& out_nodes)
 #error Unsupported platform
 
 #endif
+
+    // OS node ids can be sparse. Workers and macrotiles are assigned to nodes by
+    // index, so drop nodes without processors and remember the OS id of the rest.
+    CPUNumaNodes nodes;
+    for (uint32_t node = 0; node < out_nodes.size(); ++node)
+    {
+        if (!out_nodes[node].cores.empty())
+        {
+            nodes.push_back(std::move(out_nodes[node]));
+            nodes.back().numaId = node;
+        }
+    }
+    out_nodes.swap(nodes);
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Splits the cores into numNodes emulated NUMA nodes, so scheduling
+///        across nodes can be exercised on hosts with fewer nodes. Cores
+///        are dealt out in turn, which keeps the API thread's core on node 0.
+///        Memory of an emulated node is placed on the OS node of its first core.
+/// @param nodes - processor topology, replaced by the emulated one.
+/// @param numNodes - number of emulated nodes.
+static void EmulateNumaNodes(CPUNumaNodes& nodes, uint32_t numNodes)
+{
+    CPUNumaNodes emulated(numNodes);
+    uint32_t coreIdx = 0;
+    for (auto& node : nodes)
+    {
+        for (auto& core : node.cores)
+        {
+            NumaNode& emulatedNode = emulated[coreIdx++ % numNodes];
+            if (emulatedNode.cores.empty())
+            {
+                emulatedNode.numaId = node.numaId;
+            }
+            emulatedNode.cores.push_back(core);
+        }
+    }
+
+    // Hosts with fewer cores than nodes leave nodes without processors.
+    emulated.erase(std::remove_if(emulated.begin(), emulated.end(),
+        [](const NumaNode& node) { return node.cores.empty(); }), emulated.end());
+    nodes.swap(emulated);
+}
+
 void bindThread(uint32_t threadId, uint32_t procGroupId = 0)
 {
 #if defined(_WIN32)
@@ -239,6 +310,47 @@ void bindThread(uint32_t threadId, uint32_t procGroupId = 0)
 #endif
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Allocates page granular memory on a NUMA node.
+/// @param size - size of the allocation in bytes.
+/// @param numaNode - node the memory should be placed on.
+void* AllocNumaMemory(size_t size, uint32_t numaNode)
+{
+#if defined(_WIN32)
+    return VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE, numaNode);
+#else
+    void* pMem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pMem == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    // Prefer rather than bind, so a full node falls back to its neighbours instead
+    // of failing the page fault. Without NUMA support mbind fails and the pages go
+    // to the node of the first thread touching them, usually a worker on numaNode.
+    if (numaNode < sizeof(unsigned long) * 8)
+    {
+        unsigned long nodeMask = 1UL << numaNode;
+        mbind(pMem, size, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, 0);
+    }
+
+    return pMem;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Frees memory allocated with AllocNumaMemory.
+/// @param pMem - memory to free.
+/// @param size - size passed to AllocNumaMemory.
+void FreeNumaMemory(void* pMem, size_t size)
+{
+#if defined(_WIN32)
+    VirtualFree(pMem, 0, MEM_RELEASE);
+#else
+    munmap(pMem, size);
+#endif
+}
+
 INLINE
 uint64_t GetEnqueuedDraw(SWR_CONTEXT *pContext)
 {
@@ -260,6 +372,30 @@ bool CheckDependency(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint64_t lastReti
     return (pDC->dependency > lastRetiredDraw);
 }
 
+// returns true if an FE dependent draw still has prior FE work in flight
+INLINE
+bool CheckFEDependency(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC)
+{
+    if (!pDC->dependentFE)
+    {
+        return false;
+    }
+
+    // All earlier draws still in the ring must have finished their FE. Only the
+    // draws queued ahead of this one can be, not the whole ring.
+    uint64_t numPrior = std::min<uint64_t>(pDC->drawId - 1, KNOB_MAX_DRAWS_IN_FLIGHT - 1);
+    for (uint64_t i = pDC->drawId - numPrior; i < pDC->drawId; ++i)
+    {
+        DRAW_CONTEXT *pPrior = &pContext->dcRing[i % KNOB_MAX_DRAWS_IN_FLIGHT];
+        if (pPrior->drawId < pDC->drawId && pPrior->inUse && !pPrior->isCompute && !pPrior->doneFE)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
 {
     // Load clear color into SIMD register...
@@ -340,10 +476,10 @@ void ClearStencilHotTile(const HOTTILE* pHotTile)
 // for draw calls, we initialize the active hot tiles and perform deferred
 // load on them if tile is in invalid state. we do this in the outer thread loop instead of inside
 // the draw routine itself mainly for performance, to avoid unnecessary setup
-// every triangle
-// @todo support deferred clear
+// every triangle. tiles with a pending fast clear are cleared here on first touch.
+// the array slice of the first primitive is initialized, for layered rendering.
 INLINE
-void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, const TRIANGLE_WORK_DESC* pWork)
+void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, const BE_WORK* pWork)
 {
     const API_STATE& state = GetApiState(pDC);
     HotTileMgr *pHotTileMgr = pContext->pHotTileMgr;
@@ -357,12 +493,25 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
 
     uint32_t numSamples = GetNumSamples(state.rastState.sampleCount);
 
+    uint32_t renderTargetArrayIndex;
+    if (pWork->pfnWork == RasterizePoints)
+    {
+        const POINTS_WORK_DESC& points = pWork->desc.points;
+        DWORD lane;
+        _BitScanForward(&lane, points.pointMask);
+        renderTargetArrayIndex = ((const uint32_t*)points.pPointBuffer)[4 * KNOB_SIMD_WIDTH + lane];
+    }
+    else
+    {
+        renderTargetArrayIndex = pWork->desc.tri.triFlags.renderTargetArrayIndex;
+    }
+
     // check RT if enabled
     if (state.psState.pfnPixelShader != nullptr)
     {
         for (uint32_t rt = 0; rt < numRTs; ++rt)
         {
-            HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rt), true, numSamples);
+            HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rt), true, numSamples, renderTargetArrayIndex);
 
             if (pHotTile->state == HOTTILE_INVALID)
             {
@@ -374,11 +523,11 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
             }
             else if (pHotTile->state == HOTTILE_CLEAR)
             {
-                RDTSC_START(BELoadTiles);
+                RDTSC_START(BEClearMaterialize);
                 // Clear the tile.
                 ClearColorHotTile(pHotTile);
                 pHotTile->state = HOTTILE_DIRTY;
-                RDTSC_STOP(BELoadTiles, 0, 0);
+                RDTSC_STOP(BEClearMaterialize, 1, 0);
             }
         }
     }
@@ -386,7 +535,7 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
     // check depth if enabled
     if (state.depthStencilState.depthTestEnable || state.depthStencilState.depthWriteEnable)
     {
-        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_DEPTH, true, numSamples);
+        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_DEPTH, true, numSamples, renderTargetArrayIndex);
         if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_START(BELoadTiles);
@@ -397,18 +546,18 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
         {
-            RDTSC_START(BELoadTiles);
+            RDTSC_START(BEClearMaterialize);
             // Clear the tile.
             ClearDepthHotTile(pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BEClearMaterialize, 1, 0);
         }
     }
 
     // check stencil if enabled
     if (state.depthStencilState.stencilTestEnable || state.depthStencilState.stencilWriteEnable)
     {
-        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_STENCIL, true, numSamples);
+        HOTTILE* pHotTile = pHotTileMgr->GetHotTile(pContext, pDC, macroID, SWR_ATTACHMENT_STENCIL, true, numSamples, renderTargetArrayIndex);
         if (pHotTile->state == HOTTILE_INVALID)
         {
             RDTSC_START(BELoadTiles);
@@ -419,11 +568,11 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
         {
-            RDTSC_START(BELoadTiles);
+            RDTSC_START(BEClearMaterialize);
             // Clear the tile.
             ClearStencilHotTile(pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BEClearMaterialize, 1, 0);
         }
     }
 }
@@ -470,11 +619,15 @@ INLINE bool FindFirstIncompleteDraw(SWR_CONTEXT* pContext, volatile uint64_t& cu
 ///                      still have work pending in a previous draw. Additionally, the lockedTiles is
 ///                      hueristic that can steer a worker back to the same macrotile that it had been
 ///                      working on in a previous draw.
+/// @param numaNode - NUMA node of the worker.
+/// @param numaMask - macrotile to NUMA node affinity mask. Only macrotiles owned by numaNode are worked on.
 void WorkOnFifoBE(
     SWR_CONTEXT *pContext,
     uint32_t workerId,
     volatile uint64_t &curDrawBE,
-    std::unordered_set<uint32_t>& lockedTiles)
+    std::unordered_set<uint32_t>& lockedTiles,
+    uint32_t numaNode,
+    uint32_t numaMask)
 {
     // Find the first incomplete draw that has pending work. If no such draw is found then
     // return. FindFirstIncompleteDraw is responsible for incrementing the curDrawBE.
@@ -515,6 +668,14 @@ void WorkOnFifoBE(
 
         for (uint32_t tileID : macroTiles)
         {
+            // Only work on macrotiles owned by this worker's NUMA node.
+            uint32_t x, y;
+            MacroTileMgr::getTileIndices(tileID, x, y);
+            if (MacroTileMgr::getTileNumaNode(x, y, numaMask) != numaNode)
+            {
+                continue;
+            }
+
             MacroTileQueue &tile = pDC->pTileMgr->getMacroTileQueue(tileID);
             
             // can only work on this draw if it's not in use by other threads
@@ -526,6 +687,7 @@ void WorkOnFifoBE(
                     {
                         BE_WORK *pWork;
 
+                        RDTSC_TRACE_CONTEXT(pDC->drawId, tileID);
                         RDTSC_START(WorkerFoundWork);
 
                         uint32_t numWorkItems = tile.getNumQueued();
@@ -536,7 +698,7 @@ void WorkOnFifoBE(
                             SWR_ASSERT(pWork);
                             if (pWork->type == DRAW)
                             {
-                                InitializeHotTiles(pContext, pDC, tileID, (const TRIANGLE_WORK_DESC*)&pWork->desc);
+                                InitializeHotTiles(pContext, pDC, tileID, pWork);
                             }
                         }
 
@@ -559,6 +721,13 @@ void WorkOnFifoBE(
                             curDrawBE++;
                             lastRetiredDraw++;
 
+                            // The next draw may have been waiting on this one.
+                            if (curDrawBE < GetEnqueuedDraw(pContext))
+                            {
+                                DRAW_CONTEXT *pNextDC = &pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT];
+                                WakeThreads(pContext, pNextDC);
+                            }
+
                             lockedTiles.clear();
                             break;
                         }
@@ -598,13 +767,18 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &c
         uint32_t dcSlot = curDraw % KNOB_MAX_DRAWS_IN_FLIGHT;
         DRAW_CONTEXT *pDC = &pContext->dcRing[dcSlot];
 
-        if (!pDC->isCompute && !pDC->FeLock)
+        // Skip draws that consume results of earlier FEs until those are done.
+        if (!pDC->isCompute && !pDC->FeLock && !CheckFEDependency(pContext, pDC))
         {
             uint32_t initial = InterlockedCompareExchange((volatile uint32_t*)&pDC->FeLock, 1, 0);
             if (initial == 0)
             {
                 // successfully grabbed the DC, now run the FE
+                RDTSC_TRACE_CONTEXT(pDC->drawId, TRACE_NO_MACROTILE);
                 pDC->FeWork.pfnWork(pContext, pDC, workerId, &pDC->FeWork.desc);
+
+                // Binned macrotiles are ready for the BE, this worker takes one of them.
+                WakeThreads(pContext, pDC, numaNode);
             }
         }
         curDraw++;
@@ -618,10 +792,12 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &c
 /// @param curDrawBE - This tracks the draw contexts that this thread has processed. Each worker thread
 ///                    has its own curDrawBE counter and this ensures that each worker processes all the
 ///                    draws in order.
+/// @param numaNode - NUMA node of the worker. Thread groups assigned to this node are worked on first.
 void WorkOnCompute(
     SWR_CONTEXT *pContext,
     uint32_t workerId,
-    volatile uint64_t& curDrawBE)
+    volatile uint64_t& curDrawBE,
+    uint32_t numaNode)
 {
     if (FindFirstIncompleteDraw(pContext, curDrawBE) == false)
     {
@@ -645,10 +821,27 @@ void WorkOnCompute(
     // Is there any work remaining?
     if (queue.getNumQueued() > 0)
     {
+        // Grow this worker's spill fill buffer if the dispatch needs more. The buffer
+        // is owned by the worker, so it is placed on the worker's NUMA node.
+        uint32_t spillFillSize = GetApiState(pDC).totalSpillFillSize;
+        if (spillFillSize > pContext->spillFillSize[workerId])
+        {
+            if (pContext->pSpillFill[workerId] != nullptr)
+            {
+                FreeNumaMemory(pContext->pSpillFill[workerId], pContext->spillFillSize[workerId]);
+            }
+
+            spillFillSize = AlignUpPow2(spillFillSize, 4096);
+            pContext->pSpillFill[workerId] = (uint8_t*)AllocNumaMemory(spillFillSize, GetOsNumaNode(&pContext->threadPool, numaNode));
+            pContext->spillFillSize[workerId] = spillFillSize;
+        }
+
         bool lastToComplete = false;
 
+        RDTSC_TRACE_CONTEXT(pDC->drawId, TRACE_NO_MACROTILE);
+
         uint32_t threadGroupId = 0;
-        while (queue.getWork(threadGroupId))
+        while (queue.getWork(threadGroupId, numaNode))
         {
             ProcessComputeBE(pDC, workerId, threadGroupId);
 
@@ -661,10 +854,246 @@ void WorkOnCompute(
         {
             SWR_ASSERT(queue.isWorkComplete() == true);
             pDC->doneCompute = true;
+
+            if (curDrawBE + 1 < GetEnqueuedDraw(pContext))
+            {
+                DRAW_CONTEXT *pNextDC = &pContext->dcRing[(curDrawBE + 1) % KNOB_MAX_DRAWS_IN_FLIGHT];
+                WakeThreads(pContext, pNextDC);
+            }
         }
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns how many workers can work on a queued draw at once.
+/// @param pDC - queued draw context.
+static uint32_t GetNumReadyWork(const DRAW_CONTEXT *pDC)
+{
+    if (pDC->isCompute)
+    {
+        // Some worker has to pass even an empty dispatch.
+        return std::max(pDC->pDispatch->getNumQueued(), 1u);
+    }
+
+    // Until the FE has binned the draw there is only the FE to work on.
+    return pDC->doneFE ? (uint32_t)pDC->pTileMgr->getDirtyTiles().size() : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Wakes up to numWork parked workers.
+/// @param pContext - pointer to SWR context.
+/// @param numWork - number of workers that can work at once.
+/// @param pNumWorkPerNode - if not null, how many workers of each NUMA
+///        node can work at once. Workers of other nodes are not woken.
+/// @return number of workers woken.
+static uint32_t WakeParkedWorkers(SWR_CONTEXT *pContext, uint32_t numWork, uint32_t *pNumWorkPerNode)
+{
+    THREAD_POOL &pool = pContext->threadPool;
+
+    if (KNOB_SINGLE_THREADED || numWork == 0)
+    {
+        return 0;
+    }
+
+    // Pairs with the fence of a parking worker. Either it sees the new work, or we see it parked.
+    _mm_mfence();
+
+    if (pool.numParked == 0)
+    {
+        return 0;
+    }
+
+    uint32_t numWoken = 0;
+    uint32_t first = pool.nextWake;
+    for (uint32_t i = 0; i < pool.numThreads && numWoken < numWork; ++i)
+    {
+        THREAD_DATA &worker = pool.pThreadData[(first + i) % pool.numThreads];
+        if (!worker.parked || worker.woken)
+        {
+            continue;
+        }
+
+        if (pNumWorkPerNode && pNumWorkPerNode[worker.numaId] == 0)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(worker.parkLock);
+        if (worker.parked && !worker.woken)
+        {
+            worker.woken = true;
+            worker.parkCond.notify_one();
+            numWoken++;
+
+            if (pNumWorkPerNode)
+            {
+                pNumWorkPerNode[worker.numaId]--;
+            }
+        }
+    }
+
+    pool.nextWake = (first + numWoken) % pool.numThreads;
+
+    return numWoken;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Wakes parked workers for the work a queued draw has ready.
+///        Workers that are awake find the work on their own.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - queued draw context.
+/// @param callerNumaNode - NUMA node of a calling worker that takes one
+///        piece of the work itself, SWR_NUMA_NODE_ANY for other callers.
+/// @return number of workers woken.
+uint32_t WakeThreads(SWR_CONTEXT *pContext, const DRAW_CONTEXT *pDC, uint32_t callerNumaNode)
+{
+    THREAD_POOL &pool = pContext->threadPool;
+    uint32_t numReady = GetNumReadyWork(pDC);
+
+    // Compute thread groups and FE work can be taken by workers of any node.
+    if (pool.numaMask == 0 || pDC->isCompute || !pDC->doneFE)
+    {
+        if (callerNumaNode != SWR_NUMA_NODE_ANY && numReady != 0)
+        {
+            numReady--;
+        }
+        return WakeParkedWorkers(pContext, numReady, nullptr);
+    }
+
+    // Macrotiles are only worked on by workers of the node owning them, so
+    // workers have to be woken on each node that owns ready macrotiles.
+    uint32_t numReadyPerNode[KNOB_MAX_NUM_THREADS] = {};
+    for (uint32_t tileID : pDC->pTileMgr->getDirtyTiles())
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(tileID, x, y);
+        numReadyPerNode[MacroTileMgr::getTileNumaNode(x, y, pool.numaMask)]++;
+    }
+
+    if (callerNumaNode != SWR_NUMA_NODE_ANY && numReadyPerNode[callerNumaNode] != 0)
+    {
+        numReadyPerNode[callerNumaNode]--;
+        numReady--;
+    }
+
+    return WakeParkedWorkers(pContext, numReady, numReadyPerNode);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Moves a parked worker past a draw whose work is complete. A
+///        parked worker holds no reference to draws, but every worker has
+///        to pass a draw before its DC can be retired. Called by the API
+///        thread while retiring draws in order, so the worker never skips
+///        incomplete work.
+/// @param pContext - pointer to SWR context.
+/// @param workerId - worker to move.
+/// @param drawId - completed draw, all earlier draws are retired.
+/// @return true if the worker is now past the draw.
+bool PassParkedWorker(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t drawId)
+{
+    THREAD_DATA &worker = pContext->threadPool.pThreadData[workerId];
+    if (!worker.parked || (pContext->LastRetiredId + 1 < drawId))
+    {
+        return false;
+    }
+
+    // The worker can't unpark while we hold its lock.
+    std::lock_guard<std::mutex> lock(worker.parkLock);
+    if (!worker.parked)
+    {
+        return false;
+    }
+
+    // Compute draws retire without workers passing them, so the worker may be further behind.
+    if (pContext->WorkerFE[workerId] <= drawId)
+    {
+        pContext->WorkerFE[workerId] = drawId + 1;
+    }
+
+    if (pContext->WorkerBE[workerId] <= drawId)
+    {
+        pContext->WorkerBE[workerId] = drawId + 1;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Sizes the spin of the next idle period from recent ones. Work
+///        that typically arrives within the maximum spin is spun for, so
+///        the worker doesn't pay for parking and waking. Otherwise spinning
+///        is wasted and the worker only spins briefly before parking.
+/// @param worker - idle worker.
+/// @param idleTicks - length of the idle period that just ended.
+static void UpdateSpinCount(THREAD_DATA &worker, uint64_t idleTicks)
+{
+    worker.avgIdleTicks = worker.avgIdleTicks - worker.avgIdleTicks / 8 + idleTicks / 8;
+
+    uint32_t minSpinCount = KNOB_WORKER_SPIN_LOOP_COUNT / 16;
+    uint64_t spinTicks = 2 * worker.avgIdleTicks;
+    uint64_t maxSpinTicks = (uint64_t)KNOB_WORKER_SPIN_LOOP_COUNT * worker.pauseTicks;
+
+    if (worker.pauseTicks == 0 || spinTicks > maxSpinTicks)
+    {
+        worker.spinCount = minSpinCount;
+    }
+    else
+    {
+        worker.spinCount = std::max(minSpinCount, (uint32_t)(spinTicks / worker.pauseTicks));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Waits for work, spinning first and then parking the worker
+///        until WakeThreads wakes it.
+/// @param pContext - pointer to SWR context.
+/// @param worker - idle worker.
+/// @param threadHasWork - returns true once there is work for the worker.
+template <typename HasWorkFunc>
+static void WaitForWork(SWR_CONTEXT *pContext, THREAD_DATA &worker, HasWorkFunc threadHasWork)
+{
+    THREAD_POOL &pool = pContext->threadPool;
+    uint64_t idleStart = __rdtsc();
+
+    RDTSC_START(WorkerSpinWait);
+    uint32_t loop = 0;
+    while (loop < worker.spinCount && !threadHasWork())
+    {
+        _mm_pause();
+        loop++;
+    }
+    RDTSC_STOP(WorkerSpinWait, loop, 0);
+
+    if (loop != 0)
+    {
+        uint64_t pauseTicks = (__rdtsc() - idleStart) / loop;
+        worker.pauseTicks = worker.pauseTicks ? (worker.pauseTicks * 7 + pauseTicks) / 8 : pauseTicks;
+    }
+
+    if (!threadHasWork())
+    {
+        std::unique_lock<std::mutex> lock(worker.parkLock);
+        worker.parked = true;
+        InterlockedExchangeAdd(&pool.numParked, 1);
+
+        // Pairs with the fence in WakeThreads.
+        _mm_mfence();
+
+        if (!threadHasWork() && !pool.inThreadShutdown)
+        {
+            RDTSC_START(WorkerWaitForThreadEvent);
+            worker.parkCond.wait(lock, [&] { return worker.woken || pool.inThreadShutdown; });
+            RDTSC_STOP(WorkerWaitForThreadEvent, 1, 0);
+        }
+
+        InterlockedDecrement(&pool.numParked);
+        worker.parked = false;
+        worker.woken = false;
+    }
+
+    UpdateSpinCount(worker, __rdtsc() - idleStart);
+}
+
 DWORD workerThread(LPVOID pData)
 {
     THREAD_DATA *pThreadData = (THREAD_DATA*)pData;
@@ -702,41 +1131,13 @@ DWORD workerThread(LPVOID pData)
     //    any work left by comparing the total # of binned work items and the total # of completed
     //    work items. If they are equal, then there is no more work to do for this draw, and
     //    the worker can safely increment its oldestDraw counter and move on to the next draw.
-    std::unique_lock<std::mutex> lock(pContext->WaitLock, std::defer_lock);
-
     auto threadHasWork = [&]() { return pContext->WorkerBE[workerId] != pContext->DrawEnqueued; };
 
     while (pContext->threadPool.inThreadShutdown == false)
     {
-        uint32_t loop = 0;
-        while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && !threadHasWork())
-        {
-            _mm_pause();
-        }
-
         if (!threadHasWork())
         {
-            lock.lock();
-
-            // check for thread idle condition again under lock
-            if (threadHasWork())
-            {
-                lock.unlock();
-                continue;
-            }
-
-            if (pContext->threadPool.inThreadShutdown)
-            {
-                lock.unlock();
-                break;
-            }
-
-            RDTSC_START(WorkerWaitForThreadEvent);
-
-            pContext->FifosNotEmpty.wait(lock);
-            lock.unlock();
-
-            RDTSC_STOP(WorkerWaitForThreadEvent, 0, 0);
+            WaitForWork(pContext, *pThreadData, threadHasWork);
 
             if (pContext->threadPool.inThreadShutdown)
             {
@@ -745,10 +1146,10 @@ DWORD workerThread(LPVOID pData)
         }
 
         RDTSC_START(WorkerWorkOnFifoBE);
-        WorkOnFifoBE(pContext, workerId, pContext->WorkerBE[workerId], lockedTiles);
+        WorkOnFifoBE(pContext, workerId, pContext->WorkerBE[workerId], lockedTiles, numaNode, pContext->threadPool.numaMask);
         RDTSC_STOP(WorkerWorkOnFifoBE, 0, 0);
 
-        WorkOnCompute(pContext, workerId, pContext->WorkerBE[workerId]);
+        WorkOnCompute(pContext, workerId, pContext->WorkerBE[workerId], numaNode);
 
         WorkOnFifoFE(pContext, workerId, pContext->WorkerFE[workerId], numaNode);
     }
@@ -761,12 +1162,27 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     // Bind application thread to HW thread 0
     bindThread(0);
 
+    pPool->numaMask = 0;
+
     CPUNumaNodes nodes;
     CalculateProcessorTopology(nodes);
 
+    if (KNOB_EMULATE_NUMA_NODES)
+    {
+        EmulateNumaNodes(nodes, KNOB_EMULATE_NUMA_NODES);
+    }
+
     uint32_t numHWNodes         = (uint32_t)nodes.size();
-    uint32_t numHWCoresPerNode  = (uint32_t)nodes[0].cores.size();
-    uint32_t numHWHyperThreads  = (uint32_t)nodes[0].cores[0].threadIds.size();
+    uint32_t numHWCoresPerNode  = 0;
+    uint32_t numHWHyperThreads  = 0;
+    for (auto& node : nodes)
+    {
+        numHWCoresPerNode = std::max(numHWCoresPerNode, (uint32_t)node.cores.size());
+        for (auto& core : node.cores)
+        {
+            numHWHyperThreads = std::max(numHWHyperThreads, (uint32_t)core.threadIds.size());
+        }
+    }
 
     uint32_t numNodes           = numHWNodes;
     uint32_t numCoresPerNode    = numHWCoresPerNode;
@@ -787,8 +1203,24 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
         numHyperThreads = std::min(numHyperThreads, KNOB_MAX_THREADS_PER_CORE);
     }
 
+    // Nodes may differ in core count and cores in thread count, so the limits
+    // above are applied to each node and core on its own.
+    auto countThreads = [&]()
+    {
+        uint32_t count = 0;
+        for (uint32_t n = 0; n < numNodes; ++n)
+        {
+            uint32_t numCores = std::min(numCoresPerNode, (uint32_t)nodes[n].cores.size());
+            for (uint32_t c = 0; c < numCores; ++c)
+            {
+                count += std::min(numHyperThreads, (uint32_t)nodes[n].cores[c].threadIds.size());
+            }
+        }
+        return count;
+    };
+
     // Calculate numThreads
-    uint32_t numThreads = numNodes * numCoresPerNode * numHyperThreads;
+    uint32_t numThreads = countThreads();
 
     if (numThreads > KNOB_MAX_NUM_THREADS)
     {
@@ -800,12 +1232,13 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     if (numThreads == 1)
     {
         // If only 1 worker thread, try to move it to an available
-        // HW thread.  If that fails, use the API thread.
-        if (numCoresPerNode < numHWCoresPerNode)
+        // HW thread.  If that fails, use the API thread. Only core 0 of
+        // node 0 is in use here.
+        if (numCoresPerNode < nodes[0].cores.size())
         {
             numCoresPerNode++;
         }
-        else if (numHyperThreads < numHWHyperThreads)
+        else if (numHyperThreads < nodes[0].cores[0].threadIds.size())
         {
             numHyperThreads++;
         }
@@ -830,18 +1263,25 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     pContext->NumWorkerThreads = pPool->numThreads;
 
     pPool->inThreadShutdown = false;
-    pPool->pThreadData = (THREAD_DATA *)malloc(pPool->numThreads * sizeof(THREAD_DATA));
+    pPool->pThreadData = new THREAD_DATA[pPool->numThreads];
+    pPool->numParked = 0;
+    pPool->nextWake = 0;
+
+    pPool->numNodes = numNodes;
+    pPool->pNumaNodeIds = new uint32_t[numNodes];
 
     uint32_t workerId = 0;
     for (uint32_t n = 0; n < numNodes; ++n)
     {
         auto& node = nodes[n];
+        pPool->pNumaNodeIds[n] = node.numaId;
 
-        uint32_t numCores = numCoresPerNode;
+        uint32_t numCores = std::min(numCoresPerNode, (uint32_t)node.cores.size());
         for (uint32_t c = 0; c < numCores; ++c)
         {
             auto& core = node.cores[c];
-            for (uint32_t t = 0; t < numHyperThreads; ++t)
+            uint32_t numThreadsPerCore = std::min(numHyperThreads, (uint32_t)core.threadIds.size());
+            for (uint32_t t = 0; t < numThreadsPerCore; ++t)
             {
                 if (c == 0 && n == 0 && t == 0)
                 {
@@ -854,12 +1294,30 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
                 pPool->pThreadData[workerId].threadId = core.threadIds[t];
                 pPool->pThreadData[workerId].numaId = n;
                 pPool->pThreadData[workerId].pContext = pContext;
+                pPool->pThreadData[workerId].spinCount = KNOB_WORKER_SPIN_LOOP_COUNT;
                 pPool->threads[workerId] = new std::thread(workerThread, &pPool->pThreadData[workerId]);
 
                 ++workerId;
             }
         }
     }
+    SWR_ASSERT(workerId == numThreads);
+
+    // Interleave macrotiles across NUMA nodes if every node has workers to own its share.
+    // The affinity map is a mask, so the node count must be a power of 2.
+    if (numNodes > 1 && IsPow2(numNodes))
+    {
+        std::vector<uint32_t> workersPerNode(numNodes, 0);
+        for (uint32_t w = 0; w < workerId; ++w)
+        {
+            workersPerNode[pPool->pThreadData[w].numaId]++;
+        }
+
+        if (std::find(workersPerNode.begin(), workersPerNode.end(), 0u) == workersPerNode.end())
+        {
+            pPool->numaMask = numNodes - 1;
+        }
+    }
 }
 
 void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
@@ -867,11 +1325,15 @@ void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     if (!KNOB_SINGLE_THREADED)
     {
         // Inform threads to finish up
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
         pPool->inThreadShutdown = true;
         _mm_mfence();
-        pContext->FifosNotEmpty.notify_all();
-        lock.unlock();
+
+        for (uint32_t t = 0; t < pPool->numThreads; ++t)
+        {
+            THREAD_DATA &worker = pPool->pThreadData[t];
+            std::lock_guard<std::mutex> lock(worker.parkLock);
+            worker.parkCond.notify_one();
+        }
 
         // Wait for threads to finish and destroy them
         for (uint32_t t = 0; t < pPool->numThreads; ++t)
@@ -881,6 +1343,16 @@ void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
         }
 
         // Clean up data used by threads
-        free(pPool->pThreadData);
+        delete[] pPool->pThreadData;
+        delete[] pPool->pNumaNodeIds;
     }
 }
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the OS id of a NUMA node index, for placing memory on it.
+/// @param pPool - thread pool, may not have been created if single threaded.
+/// @param numaNode - node index of a worker or macrotile.
+uint32_t GetOsNumaNode(const THREAD_POOL *pPool, uint32_t numaNode)
+{
+    return (pPool->pNumaNodeIds != nullptr && numaNode < pPool->numNodes) ? pPool->pNumaNodeIds[numaNode] : numaNode;
+}
@@ -31,17 +31,34 @@
 
 #include <unordered_set>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 typedef std::thread* THREAD_PTR;
 
 struct SWR_CONTEXT;
+struct DRAW_CONTEXT;
+struct HOTTILE;
 
 struct THREAD_DATA
 {
     uint32_t procGroupId;   // Will always be 0 for non-Windows OS
     uint32_t threadId;      // within the procGroup for Windows
-    uint32_t numaId;        // NUMA node id
+    uint32_t numaId;        // NUMA node index, see GetOsNumaNode for the OS id
     uint32_t workerId;
     SWR_CONTEXT *pContext;
+
+    // Idle workers spin for a while, then park on their own condition variable so the
+    // API thread can wake just as many workers as there is work for.
+    std::mutex parkLock;
+    std::condition_variable parkCond;
+    volatile bool parked{ false };  // written under parkLock
+    volatile bool woken{ false };   // written under parkLock
+
+    // Adaptive spin. The spin is sized from the recent time between running out of
+    // work and finding more, so workers stop spinning when work arrives in bursts.
+    uint32_t spinCount{ 0 };        // pause iterations before parking
+    uint64_t avgIdleTicks{ 0 };     // moving average of idle periods, in rdtsc ticks
+    uint64_t pauseTicks{ 0 };       // moving average of the cost of one spin iteration
 };
 
 
@@ -49,14 +66,38 @@ struct THREAD_POOL
 {
     THREAD_PTR threads[KNOB_MAX_NUM_THREADS];
     uint32_t numThreads;
+    uint32_t numaMask;      // macrotile to NUMA node affinity mask, 0 if all nodes share the work
     volatile bool inThreadShutdown;
     THREAD_DATA *pThreadData;
+    volatile LONG numParked;
+    uint32_t nextWake;      // first worker considered by the next wakeup, spreads wakes across workers
+    uint32_t numNodes;
+    uint32_t *pNumaNodeIds; // OS id of each NUMA node index
 };
 
 void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
 void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
 
+// Wake parked workers for the work a queued draw has ready, on the NUMA nodes that own it
+#define SWR_NUMA_NODE_ANY 0xFFFFFFFF
+uint32_t WakeThreads(SWR_CONTEXT *pContext, const DRAW_CONTEXT *pDC, uint32_t callerNumaNode = SWR_NUMA_NODE_ANY);
+
+// Parked workers hold no reference to draws. Moves a parked worker past a completed draw.
+bool PassParkedWorker(SWR_CONTEXT *pContext, uint32_t workerId, uint64_t drawId);
+
 // Expose FE and BE worker functions to the API thread if single threaded
 void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawFE, UCHAR numaNode);
-void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE, std::unordered_set<uint32_t> &usedTiles);
-void WorkOnCompute(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE);
+void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE, std::unordered_set<uint32_t> &usedTiles,
+    uint32_t numaNode, uint32_t numaMask);
+void WorkOnCompute(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE, uint32_t numaNode);
+
+// Page granular allocations placed on the given NUMA node. On Linux any
+// page aligned piece of an allocation may be freed on its own.
+void* AllocNumaMemory(size_t size, uint32_t numaNode);
+uint32_t GetOsNumaNode(const THREAD_POOL *pPool, uint32_t numaNode);
+void FreeNumaMemory(void* pMem, size_t size);
+
+// Materialize a pending fast clear into a hot tile
+void ClearColorHotTile(const HOTTILE* pHotTile);
+void ClearDepthHotTile(const HOTTILE* pHotTile);
+void ClearStencilHotTile(const HOTTILE* pHotTile);
@@ -28,8 +28,12 @@
 ******************************************************************************/
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <set>
 #include <unordered_map>
+#include <vector>
 #include "common/formats.h"
 #include "fifo.hpp"
 #include "context.h"
@@ -131,6 +135,21 @@ public:
         x = (tileID >> 16) & 0xffff;
     }
 
+    static INLINE uint32_t getTileId(uint32_t x, uint32_t y)
+    {
+        return (x << 16) | y;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the NUMA node that owns a macrotile. Macrotiles are
+    ///        interleaved across nodes so any screen region is spread over
+    ///        all of them. Only workers on the owning node work on the
+    ///        macrotile, and its hot tiles are allocated on that node.
+    static INLINE uint32_t getTileNumaNode(uint32_t x, uint32_t y, uint32_t numaMask)
+    {
+        return (x ^ y) & numaMask;
+    }
+
     void *operator new(size_t size);
     void operator delete (void *p);
 
@@ -156,7 +175,9 @@ public:
 
     //////////////////////////////////////////////////////////////////////////
     /// @brief Setup the producer consumer counts.
-    void initialize(uint32_t totalTasks, void* pTaskData)
+    /// @param numaMask - NUMA node mask of the thread pool. Thread groups are
+    ///        split into one contiguous range per node.
+    void initialize(uint32_t totalTasks, void* pTaskData, uint32_t numaMask)
     {
         // The available and outstanding counts start with total tasks.
         // At the start there are N tasks available and outstanding.
@@ -164,7 +185,15 @@ public:
         // When a worker starts on a threadgroup then it decrements the available count.
         // When a worker completes a threadgroup then it decrements the outstanding count.
 
-        mTasksAvailable = totalTasks;
+        mNumNodes = std::min<uint32_t>(numaMask + 1, MAX_NODES);
+
+        for (uint32_t node = 0; node < mNumNodes; ++node)
+        {
+            uint32_t begin = (uint32_t)((uint64_t)totalTasks * node / mNumNodes);
+            uint32_t end = (uint32_t)((uint64_t)totalTasks * (node + 1) / mNumNodes);
+            mTaskBase[node] = begin;
+            mTasks[node].available = end - begin;
+        }
         mTasksOutstanding = totalTasks;
 
         mpTaskData = pTaskData;
@@ -174,21 +203,36 @@ public:
     /// @brief Returns number of tasks available for this dispatch.
     uint32_t getNumQueued()
     {
-        return (mTasksAvailable > 0) ? mTasksAvailable : 0;
+        uint32_t numQueued = 0;
+        for (uint32_t node = 0; node < mNumNodes; ++node)
+        {
+            numQueued += (mTasks[node].available > 0) ? mTasks[node].available : 0;
+        }
+        return numQueued;
     }
 
     //////////////////////////////////////////////////////////////////////////
     /// @brief Atomically decrement the work available count. If the result
     //         is greater than 0 then we can on the associated thread group.
-    //         Otherwise, there is no more work to do.
-    bool getWork(uint32_t& groupId)
+    //         Otherwise, there is no more work to do. Workers drain the range
+    //         of their own NUMA node before helping other nodes.
+    bool getWork(uint32_t& groupId, uint32_t numaNode)
     {
-        LONG result = InterlockedDecrement(&mTasksAvailable);
-
-        if (result >= 0)
+        for (uint32_t i = 0; i < mNumNodes; ++i)
         {
-            groupId = result;
-            return true;
+            uint32_t node = (numaNode + i) % mNumNodes;
+            if (mTasks[node].available <= 0)
+            {
+                continue;
+            }
+
+            LONG result = InterlockedDecrement(&mTasks[node].available);
+
+            if (result >= 0)
+            {
+                groupId = mTaskBase[node] + result;
+                return true;
+            }
         }
 
         return false;
@@ -210,7 +254,7 @@ public:
     /// @brief Work is complete once both the available/outstanding counts have reached 0.
     bool isWorkComplete()
     {
-        return ((mTasksAvailable <= 0) &&
+        return ((getNumQueued() == 0) &&
                 (mTasksOutstanding <= 0));
     }
 
@@ -226,11 +270,126 @@ public:
 
     void* mpTaskData;        // The API thread will set this up and the callback task function will interpet this.
 
-    OSALIGNLINE(volatile LONG) mTasksAvailable{ 0 };
+    static const uint32_t MAX_NODES = 8;
+    uint32_t mNumNodes{ 1 };
+    uint32_t mTaskBase[MAX_NODES]{};
+
+    // one cacheline per node so the nodes' counters don't contend
+    struct NodeTasks
+    {
+        OSALIGNLINE(volatile LONG) available{ 0 };
+    };
+    NodeTasks mTasks[MAX_NODES];
     OSALIGNLINE(volatile LONG) mTasksOutstanding{ 0 };
 };
 
 
+//////////////////////////////////////////////////////////////////////////
+/// MacroTileMask - Set of macrotiles of a render target, with the bounds of
+/// the set kept so that walking and clearing it only touches rows and words
+/// that can hold set bits.
+//////////////////////////////////////////////////////////////////////////
+class MacroTileMask
+{
+public:
+    MacroTileMask()
+    {
+        memset(mBits, 0, sizeof(mBits));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Adds a rectangle of macrotiles, bounds inclusive.
+    void set(uint32_t left, uint32_t top, uint32_t right, uint32_t bottom)
+    {
+        SWR_ASSERT(left <= right && right < KNOB_NUM_HOT_TILES_X);
+        SWR_ASSERT(top <= bottom && bottom < KNOB_NUM_HOT_TILES_Y);
+
+        for (uint32_t y = top; y <= bottom; ++y)
+        {
+            for (uint32_t word = left / 32; word <= right / 32; ++word)
+            {
+                uint32_t first = std::max(left, word * 32) - word * 32;
+                uint32_t last = std::min(right, word * 32 + 31) - word * 32;
+                mBits[y][word] |= (0xffffffff >> (31 - last + first)) << first;
+            }
+        }
+
+        if (empty())
+        {
+            mTop = top;
+            mBottom = bottom;
+            mLeft = left;
+            mRight = right;
+        }
+        else
+        {
+            mTop = std::min(mTop, (int)top);
+            mBottom = std::max(mBottom, (int)bottom);
+            mLeft = std::min(mLeft, (int)left);
+            mRight = std::max(mRight, (int)right);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Removes all macrotiles.
+    void clear()
+    {
+        for (int y = mTop; y <= mBottom; ++y)
+        {
+            for (int word = mLeft / 32; word <= mRight / 32; ++word)
+            {
+                mBits[y][word] = 0;
+            }
+        }
+
+        mTop = mLeft = 0;
+        mBottom = mRight = -1;
+    }
+
+    bool empty() const
+    {
+        return mBottom < mTop;
+    }
+
+    bool test(uint32_t x, uint32_t y) const
+    {
+        return (mBits[y][x / 32] & (1 << (x & 31))) != 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Inclusive macrotile bounds of the set, bottom < top if empty.
+    BBOX bounds() const
+    {
+        return BBOX(mTop, mBottom, mLeft, mRight);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Calls func(x, y) for each macrotile in the set, row by row.
+    template<typename FuncT>
+    void forEach(FuncT func) const
+    {
+        for (int y = mTop; y <= mBottom; ++y)
+        {
+            for (int word = mLeft / 32; word <= mRight / 32; ++word)
+            {
+                uint32_t bits = mBits[y][word];
+                DWORD bit;
+                while (_BitScanForward(&bit, bits))
+                {
+                    bits &= ~(1 << bit);
+                    func(word * 32 + bit, (uint32_t)y);
+                }
+            }
+        }
+    }
+
+private:
+    static const uint32_t NUM_WORDS_X = (KNOB_NUM_HOT_TILES_X + 31) / 32;
+
+    uint32_t mBits[KNOB_NUM_HOT_TILES_Y][NUM_WORDS_X];
+    int mTop{ 0 }, mBottom{ -1 }, mLeft{ 0 }, mRight{ -1 };
+};
+
 enum HOTTILE_STATE
 {
     HOTTILE_INVALID,        // tile is in unitialized state and should be loaded with surface contents before rendering
@@ -246,6 +405,8 @@ struct HOTTILE
     DWORD clearData[4];                 // May need to change based on pfnClearTile implementation.  Reorder for alignment?
     uint32_t numSamples;
     uint32_t renderTargetArrayIndex;    // current render target array index loaded
+    uint32_t lastUsedFrame;             // frame of the last access, for LRU trimming
+    HOTTILE *pNextSlice;                // other resident array slices, most recently used first
 };
 
 union HotTileSet
@@ -264,7 +425,7 @@ class HotTileMgr
 public:
     HotTileMgr()
     {
-        memset(&mHotTiles[0][0], 0, sizeof(mHotTiles));
+        memset(&mHotTileChunks[0][0], 0, sizeof(mHotTileChunks));
 
         // cache hottile size
         for (uint32_t i = SWR_ATTACHMENT_COLOR0; i <= SWR_ATTACHMENT_COLOR7; ++i)
@@ -277,20 +438,43 @@ public:
 
     ~HotTileMgr()
     {
-        for (int x = 0; x < KNOB_NUM_HOT_TILES_X; ++x)
+        for (uint32_t cx = 0; cx < NUM_CHUNKS_X; ++cx)
         {
-            for (int y = 0; y < KNOB_NUM_HOT_TILES_Y; ++y)
+            for (uint32_t cy = 0; cy < NUM_CHUNKS_Y; ++cy)
             {
-                for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
+                HotTileSet* pChunk = mHotTileChunks[cx][cy];
+                if (pChunk == nullptr)
+                {
+                    continue;
+                }
+
+                for (uint32_t t = 0; t < CHUNK_NUM_TILES; ++t)
                 {
-                    if (mHotTiles[x][y].Attachment[a].pBuffer != NULL)
+                    for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
                     {
-                        _aligned_free(mHotTiles[x][y].Attachment[a].pBuffer);
-                        mHotTiles[x][y].Attachment[a].pBuffer = NULL;
+                        HOTTILE& hotTile = pChunk[t].Attachment[a];
+                        while (hotTile.pNextSlice != nullptr)
+                        {
+                            HOTTILE* pSlice = hotTile.pNextSlice;
+                            hotTile.pNextSlice = pSlice->pNextSlice;
+                            FreeNumaMemory(pSlice->pBuffer, pSlice->numSamples * mHotTileSize[a]);
+                            delete pSlice;
+                        }
+
+                        if (hotTile.pBuffer != NULL)
+                        {
+                            FreeNumaMemory(hotTile.pBuffer, hotTile.numSamples * mHotTileSize[a]);
+                            hotTile.pBuffer = NULL;
+                        }
                     }
                 }
+
+                _aligned_free(pChunk);
+                mHotTileChunks[cx][cy] = nullptr;
             }
         }
+
+        ReleasePool(0);
     }
 
     HOTTILE *GetHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment, bool create, uint32_t numSamples = 1, 
@@ -299,20 +483,24 @@ public:
         uint32_t x, y;
         MacroTileMgr::getTileIndices(macroID, x, y);
 
-        assert(x < KNOB_NUM_HOT_TILES_X);
-        assert(y < KNOB_NUM_HOT_TILES_Y);
-
-        HotTileSet &tile = mHotTiles[x][y];
+        HotTileSet &tile = GetHotTileSet(x, y);
         HOTTILE& hotTile = tile.Attachment[attachment];
+        uint32_t numaNode = GetOsNumaNode(&pContext->threadPool, MacroTileMgr::getTileNumaNode(x, y, pContext->threadPool.numaMask));
         if (hotTile.pBuffer == NULL)
         {
             if (create)
             {
                 uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
-                hotTile.state = HOTTILE_INVALID;
+                hotTile.pBuffer = (BYTE*)AllocHotTileMem(size, numaNode);
                 hotTile.numSamples = numSamples;
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+
+                // a tile evicted by Trim() with a pending clear keeps it, along with
+                // the slice it belongs to, and is cleared on first touch
+                if (hotTile.state != HOTTILE_CLEAR)
+                {
+                    hotTile.state = HOTTILE_INVALID;
+                    hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+                }
             }
             else
             {
@@ -321,69 +509,447 @@ public:
         }
         else
         {
-            // free the old tile and create a new one with enough space to hold all samples
-            if (numSamples > hotTile.numSamples)
+            // free the old tile and create a new one for the new sample count. The store path
+            // takes the sample layout from the hot tile, so a smaller count also reallocates.
+            if (create && (numSamples != hotTile.numSamples))
             {
                 // tile should be either uninitialized or resolved if we're deleting and switching to a 
-                // new sample count
-                assert((hotTile.state == HOTTILE_INVALID) ||
-                       (hotTile.state == HOTTILE_RESOLVED));
-                _aligned_free(hotTile.pBuffer);
+                // new sample count. A pending clear has already been written to the surface. A dirty
+                // tile belongs to a surface the current draw state no longer describes, so it can't
+                // be stored here; the driver has to store tiles before changing render targets.
+                SWR_REL_ASSERT((hotTile.state == HOTTILE_INVALID) ||
+                               (hotTile.state == HOTTILE_RESOLVED) ||
+                               (hotTile.state == HOTTILE_CLEAR),
+                               "Hot tile contents lost switching from %d to %d samples", hotTile.numSamples, numSamples);
+                FreeSlices(hotTile, attachment, numaNode);
+                FreeHotTileMem(hotTile.pBuffer, hotTile.numSamples * mHotTileSize[attachment], numaNode);
 
                 uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+                hotTile.pBuffer = (BYTE*)AllocHotTileMem(size, numaNode);
                 hotTile.state = HOTTILE_INVALID;
                 hotTile.numSamples = numSamples;
             }
+        }
 
-            // if requested render target array index isn't currently loaded, need to store out the current hottile 
-            // and load the requested array slice
-            if (renderTargetArrayIndex != hotTile.renderTargetArrayIndex)
+        // if requested render target array index isn't the current slice, make it current
+        if (renderTargetArrayIndex != hotTile.renderTargetArrayIndex)
+        {
+            SwitchSlice(pContext, pDC, x, y, attachment, hotTile, renderTargetArrayIndex, numaNode);
+        }
+        hotTile.lastUsedFrame = mFrame.load(std::memory_order_relaxed);
+        return &tile.Attachment[attachment];
+    }
+
+    static SWR_FORMAT GetHotTileFormat(SWR_RENDERTARGET_ATTACHMENT attachment)
+    {
+        switch (attachment)
+        {
+        case SWR_ATTACHMENT_COLOR0:
+        case SWR_ATTACHMENT_COLOR1:
+        case SWR_ATTACHMENT_COLOR2:
+        case SWR_ATTACHMENT_COLOR3:
+        case SWR_ATTACHMENT_COLOR4:
+        case SWR_ATTACHMENT_COLOR5:
+        case SWR_ATTACHMENT_COLOR6:
+        case SWR_ATTACHMENT_COLOR7: return KNOB_COLOR_HOT_TILE_FORMAT;
+        case SWR_ATTACHMENT_DEPTH: return KNOB_DEPTH_HOT_TILE_FORMAT;
+        case SWR_ATTACHMENT_STENCIL: return KNOB_STENCIL_HOT_TILE_FORMAT;
+        default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); return KNOB_COLOR_HOT_TILE_FORMAT;
+        }
+    }
+
+    HotTileSet &GetHotTile(uint32_t macroID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(macroID, x, y);
+
+        return GetHotTileSet(x, y);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Brings resident hot tile memory back under budget at the end
+    ///        of a frame. Pooled buffers are released first, then resolved,
+    ///        invalid and cleared tiles, least recently used first. Dirty
+    ///        tiles are the only copy of their contents and are never
+    ///        evicted. A cleared tile only needs its clear value, which stays
+    ///        pending in the tile and is applied again when it is touched or
+    ///        stored. Cleared slices of layered tiles stay resident. Also
+    ///        advances the LRU frame, which may happen while workers run,
+    ///        but anything over budget must be trimmed with the backend idle.
+    /// @param budget - Budget in bytes, 0 for no limit.
+    void Trim(size_t budget)
+    {
+        mFrame.fetch_add(1, std::memory_order_relaxed);
+
+        if (budget == 0 || mTileBytes + mPooledBytes <= budget)
+        {
+            return;
+        }
+
+        ReleasePool(budget);
+        if (mTileBytes + mPooledBytes <= budget)
+        {
+            return;
+        }
+
+        struct EvictCandidate
+        {
+            HOTTILE* pHotTile;
+            uint32_t size;
+        };
+        std::vector<EvictCandidate> candidates;
+
+        for (uint32_t cx = 0; cx < NUM_CHUNKS_X; ++cx)
+        {
+            for (uint32_t cy = 0; cy < NUM_CHUNKS_Y; ++cy)
             {
-                SWR_FORMAT format;
-                switch (attachment)
+                HotTileSet* pChunk = mHotTileChunks[cx][cy];
+                if (pChunk == nullptr)
                 {
-                case SWR_ATTACHMENT_COLOR0:
-                case SWR_ATTACHMENT_COLOR1:
-                case SWR_ATTACHMENT_COLOR2:
-                case SWR_ATTACHMENT_COLOR3:
-                case SWR_ATTACHMENT_COLOR4:
-                case SWR_ATTACHMENT_COLOR5:
-                case SWR_ATTACHMENT_COLOR6:
-                case SWR_ATTACHMENT_COLOR7: format = KNOB_COLOR_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_DEPTH: format = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_STENCIL: format = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-                default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); format = KNOB_COLOR_HOT_TILE_FORMAT; break;
+                    continue;
                 }
 
-                if (hotTile.state == HOTTILE_DIRTY)
+                for (uint32_t t = 0; t < CHUNK_NUM_TILES; ++t)
                 {
-                    pContext->pfnStoreTile(GetPrivateState(pDC), format, attachment,
-                        x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, hotTile.renderTargetArrayIndex, hotTile.pBuffer);
+                    for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
+                    {
+                        HOTTILE& hotTile = pChunk[t].Attachment[a];
+                        for (HOTTILE* pSlice = &hotTile; pSlice != nullptr; pSlice = pSlice->pNextSlice)
+                        {
+                            bool evictable = (pSlice->state == HOTTILE_INVALID || pSlice->state == HOTTILE_RESOLVED) ||
+                                (pSlice->state == HOTTILE_CLEAR && hotTile.pNextSlice == nullptr);
+                            if (pSlice->pBuffer != NULL && evictable)
+                            {
+                                candidates.push_back({ pSlice, pSlice->numSamples * mHotTileSize[a] });
+                            }
+                        }
+                    }
                 }
+            }
+        }
 
-                pContext->pfnLoadTile(GetPrivateState(pDC), format, attachment,
-                    x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, renderTargetArrayIndex, hotTile.pBuffer);
+        std::sort(candidates.begin(), candidates.end(),
+            [](const EvictCandidate& a, const EvictCandidate& b)
+            {
+                return (int32_t)(a.pHotTile->lastUsedFrame - b.pHotTile->lastUsedFrame) < 0;
+            });
 
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
-                hotTile.state = HOTTILE_DIRTY;
+        for (const EvictCandidate& candidate : candidates)
+        {
+            if (mTileBytes <= budget)
+            {
+                break;
+            }
+
+            HOTTILE& hotTile = *candidate.pHotTile;
+            FreeNumaMemory(hotTile.pBuffer, candidate.size);
+            hotTile.pBuffer = NULL;
+            if (hotTile.state != HOTTILE_CLEAR)
+            {
+                hotTile.state = HOTTILE_INVALID;
+            }
+            mTileBytes -= candidate.size;
+            mNumEvicted++;
+        }
+
+        // drop evicted slices from the slice lists, keeping a resident slice current
+        for (uint32_t cx = 0; cx < NUM_CHUNKS_X; ++cx)
+        {
+            for (uint32_t cy = 0; cy < NUM_CHUNKS_Y; ++cy)
+            {
+                HotTileSet* pChunk = mHotTileChunks[cx][cy];
+                if (pChunk == nullptr)
+                {
+                    continue;
+                }
+
+                for (uint32_t t = 0; t < CHUNK_NUM_TILES; ++t)
+                {
+                    for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
+                    {
+                        HOTTILE& hotTile = pChunk[t].Attachment[a];
+                        HOTTILE** ppSlice = &hotTile.pNextSlice;
+                        while (*ppSlice != nullptr)
+                        {
+                            HOTTILE* pSlice = *ppSlice;
+                            if (pSlice->pBuffer == NULL)
+                            {
+                                *ppSlice = pSlice->pNextSlice;
+                                delete pSlice;
+                            }
+                            else
+                            {
+                                ppSlice = &pSlice->pNextSlice;
+                            }
+                        }
+
+                        if (hotTile.pBuffer == NULL && hotTile.pNextSlice != nullptr)
+                        {
+                            HOTTILE* pSlice = hotTile.pNextSlice;
+                            hotTile = *pSlice;
+                            delete pSlice;
+                        }
+                    }
+                }
             }
         }
-        return &tile.Attachment[attachment];
     }
 
-    HotTileSet &GetHotTile(uint32_t macroID)
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns hot tile memory usage.
+    void GetStats(SWR_HOT_TILE_STATS& stats)
     {
-        uint32_t x, y;
-        MacroTileMgr::getTileIndices(macroID, x, y);
-        assert(x < KNOB_NUM_HOT_TILES_X);
-        assert(y < KNOB_NUM_HOT_TILES_Y);
+        std::lock_guard<std::mutex> guard(mPoolLock);
 
-        return mHotTiles[x][y];
+        stats.ResidentBytes = mTileBytes + mPooledBytes;
+        stats.PooledBytes = mPooledBytes;
+        stats.PeakResidentBytes = mPeakBytes;
+        stats.TilesEvicted = mNumEvicted;
     }
 
 private:
-    HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
+    static const uint32_t NUM_CHUNKS_X = (KNOB_NUM_HOT_TILES_X + KNOB_HOT_TILE_CHUNK_DIM - 1) >> KNOB_HOT_TILE_CHUNK_DIM_SHIFT;
+    static const uint32_t NUM_CHUNKS_Y = (KNOB_NUM_HOT_TILES_Y + KNOB_HOT_TILE_CHUNK_DIM - 1) >> KNOB_HOT_TILE_CHUNK_DIM_SHIFT;
+    static const uint32_t CHUNK_NUM_TILES = KNOB_HOT_TILE_CHUNK_DIM * KNOB_HOT_TILE_CHUNK_DIM;
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the hot tile set for a macrotile, allocating the chunk
+    ///        of sets that holds it on first touch. Backend workers may race
+    ///        to allocate the same chunk; the loser frees its copy.
+    HotTileSet& GetHotTileSet(uint32_t x, uint32_t y)
+    {
+        SWR_ASSERT(x < KNOB_NUM_HOT_TILES_X);
+        SWR_ASSERT(y < KNOB_NUM_HOT_TILES_Y);
+
+        HotTileSet* volatile* ppChunk = &mHotTileChunks[x >> KNOB_HOT_TILE_CHUNK_DIM_SHIFT][y >> KNOB_HOT_TILE_CHUNK_DIM_SHIFT];
+        HotTileSet* pChunk = *ppChunk;
+        if (pChunk == nullptr)
+        {
+            size_t chunkSize = CHUNK_NUM_TILES * sizeof(HotTileSet);
+            HotTileSet* pNewChunk = (HotTileSet*)_aligned_malloc(chunkSize, KNOB_SIMD_WIDTH * 4);
+            memset(pNewChunk, 0, chunkSize);
+
+            pChunk = (HotTileSet*)InterlockedCompareExchangePointer((PVOID volatile*)ppChunk, pNewChunk, nullptr);
+            if (pChunk == nullptr)
+            {
+                pChunk = pNewChunk;
+            }
+            else
+            {
+                _aligned_free(pNewChunk);
+            }
+        }
+
+        uint32_t cx = x & (KNOB_HOT_TILE_CHUNK_DIM - 1);
+        uint32_t cy = y & (KNOB_HOT_TILE_CHUNK_DIM - 1);
+        return pChunk[cy * KNOB_HOT_TILE_CHUNK_DIM + cx];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Swaps the contents of two slices, leaving the slice links alone.
+    static void SwapSlice(HOTTILE& a, HOTTILE& b)
+    {
+        std::swap(a, b);
+        std::swap(a.pNextSlice, b.pNextSlice);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Writes a slice that is about to be evicted back to its surface.
+    void ResolveSlice(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t x, uint32_t y,
+        SWR_RENDERTARGET_ATTACHMENT attachment, HOTTILE& slice)
+    {
+        if (slice.state == HOTTILE_CLEAR)
+        {
+            switch (attachment)
+            {
+            case SWR_ATTACHMENT_DEPTH: ClearDepthHotTile(&slice); break;
+            case SWR_ATTACHMENT_STENCIL: ClearStencilHotTile(&slice); break;
+            default: ClearColorHotTile(&slice); break;
+            }
+            slice.state = HOTTILE_DIRTY;
+        }
+
+        if (slice.state == HOTTILE_DIRTY)
+        {
+            pContext->pfnStoreTile(GetPrivateState(pDC), GetHotTileFormat(attachment), attachment,
+                x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, slice.renderTargetArrayIndex, slice.numSamples, slice.pBuffer);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Makes a render target array slice the current slice of a hot
+    ///        tile. Up to KNOB_MAX_HOT_TILE_SLICES slices of a macrotile stay
+    ///        resident, so layered rendering only stores and loads tiles when
+    ///        the least recently used slice has to make room.
+    void SwitchSlice(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t x, uint32_t y,
+        SWR_RENDERTARGET_ATTACHMENT attachment, HOTTILE& hotTile, uint32_t renderTargetArrayIndex, uint32_t numaNode)
+    {
+        uint32_t numSlices = 1;
+        HOTTILE** ppLast = &hotTile.pNextSlice;
+        HOTTILE** ppSlice = &hotTile.pNextSlice;
+        while (*ppSlice != nullptr)
+        {
+            HOTTILE* pSlice = *ppSlice;
+            if (pSlice->renderTargetArrayIndex == renderTargetArrayIndex)
+            {
+                // already resident, the current slice takes its place at the front of the list
+                *ppSlice = pSlice->pNextSlice;
+                SwapSlice(hotTile, *pSlice);
+                pSlice->pNextSlice = hotTile.pNextSlice;
+                hotTile.pNextSlice = pSlice;
+                return;
+            }
+
+            ppLast = ppSlice;
+            ppSlice = &pSlice->pNextSlice;
+            numSlices++;
+        }
+
+        if (numSlices < KNOB_MAX_HOT_TILE_SLICES)
+        {
+            // keep the current slice resident and give the requested one a new buffer
+            HOTTILE* pSlice = new HOTTILE(hotTile);
+            hotTile.pNextSlice = pSlice;
+            hotTile.pBuffer = (BYTE*)AllocHotTileMem(hotTile.numSamples * mHotTileSize[attachment], numaNode);
+        }
+        else if (*ppLast != nullptr)
+        {
+            // evict the least recently used slice and load the requested one into its buffer
+            HOTTILE* pSlice = *ppLast;
+            *ppLast = nullptr;
+            ResolveSlice(pContext, pDC, x, y, attachment, *pSlice);
+            SwapSlice(hotTile, *pSlice);
+            pSlice->pNextSlice = hotTile.pNextSlice;
+            hotTile.pNextSlice = pSlice;
+        }
+        else
+        {
+            ResolveSlice(pContext, pDC, x, y, attachment, hotTile);
+        }
+
+        pContext->pfnLoadTile(GetPrivateState(pDC), GetHotTileFormat(attachment), attachment,
+            x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, renderTargetArrayIndex, hotTile.pBuffer);
+
+        hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+        hotTile.state = HOTTILE_DIRTY;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees all slices of a hot tile but the current one.
+    void FreeSlices(HOTTILE& hotTile, SWR_RENDERTARGET_ATTACHMENT attachment, uint32_t numaNode)
+    {
+        while (hotTile.pNextSlice != nullptr)
+        {
+            HOTTILE* pSlice = hotTile.pNextSlice;
+            SWR_REL_ASSERT(pSlice->state != HOTTILE_DIRTY, "Hot tile slice contents lost");
+            hotTile.pNextSlice = pSlice->pNextSlice;
+            FreeHotTileMem(pSlice->pBuffer, pSlice->numSamples * mHotTileSize[attachment], numaNode);
+            delete pSlice;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Allocates hot tile memory on the NUMA node owning the macrotile,
+    ///        reusing a pooled buffer of the same size and node if there is one.
+    void* AllocHotTileMem(size_t size, uint32_t numaNode)
+    {
+        std::lock_guard<std::mutex> guard(mPoolLock);
+
+        mTileBytes += size;
+        mPeakBytes = std::max(mPeakBytes, mTileBytes + mPooledBytes);
+
+        std::vector<void*>& pool = mPool[PoolKey(size, numaNode)];
+        if (!pool.empty())
+        {
+            void* p = pool.back();
+            pool.pop_back();
+            mPooledBytes -= size;
+            return p;
+        }
+
+        // Carve pool misses out of one larger allocation, so filling a frame's
+        // tiles costs a few mmap/mbind calls rather than one per tile. Pieces
+        // are page multiples and go back to the system one at a time.
+        uint32_t batch = (size % HOT_TILE_PAGE_SIZE == 0) ? HOT_TILE_ALLOC_BATCH : 1;
+        BYTE* p = (BYTE*)AllocNumaMemory(size * batch, numaNode);
+        SWR_ASSERT(p != nullptr);
+        if (p == nullptr)
+        {
+            mTileBytes -= size;
+            return nullptr;
+        }
+
+        for (uint32_t i = 1; i < batch; ++i)
+        {
+            pool.push_back(p + i * size);
+        }
+        mPooledBytes += size * (batch - 1);
+        mPeakBytes = std::max(mPeakBytes, mTileBytes + mPooledBytes);
+
+        return p;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns hot tile memory to the pool. Buffers are only given
+    ///        back to the system by Trim() or when the manager is destroyed.
+    void FreeHotTileMem(void* pBuffer, size_t size, uint32_t numaNode)
+    {
+        std::lock_guard<std::mutex> guard(mPoolLock);
+
+        mTileBytes -= size;
+        mPooledBytes += size;
+        mPool[PoolKey(size, numaNode)].push_back(pBuffer);
+    }
+
+#if defined(_WIN32)
+    // VirtualFree only releases whole allocations, so tiles can't share one.
+    static const uint32_t HOT_TILE_ALLOC_BATCH = 1;
+#else
+    static const uint32_t HOT_TILE_ALLOC_BATCH = 16;
+#endif
+    static const uint32_t HOT_TILE_PAGE_SIZE = 4096;
+
+    static uint64_t PoolKey(size_t size, uint32_t numaNode)
+    {
+        return ((uint64_t)size << 8) | numaNode;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees pooled buffers until resident memory is within budget.
+    ///        A budget of 0 empties the pool.
+    void ReleasePool(size_t budget)
+    {
+        std::lock_guard<std::mutex> guard(mPoolLock);
+
+        for (auto& entry : mPool)
+        {
+            size_t size = (size_t)(entry.first >> 8);
+            std::vector<void*>& pool = entry.second;
+            while (!pool.empty() && (budget == 0 || mTileBytes + mPooledBytes > budget))
+            {
+                FreeNumaMemory(pool.back(), size);
+                pool.pop_back();
+                mPooledBytes -= size;
+            }
+        }
+    }
+
+    HotTileSet* mHotTileChunks[NUM_CHUNKS_X][NUM_CHUNKS_Y];
     uint32_t mHotTileSize[SWR_NUM_ATTACHMENTS];
-};
 
+    // Frame counter for LRU trimming. Advanced by the API thread at every
+    // SwrEndFrame, possibly while workers are still stamping tiles with it.
+    // A tile touched across the switch may get either frame, which is fine
+    // for LRU ordering.
+    std::atomic<uint32_t> mFrame{ 0 };
+
+    // Buffers released by tiles that changed sample count or were evicted,
+    // keyed by size and NUMA node. Guarded by mPoolLock along with the byte
+    // counts, since backend workers allocate tiles concurrently.
+    std::mutex mPoolLock;
+    std::unordered_map<uint64_t, std::vector<void*>> mPool;
+    size_t mTileBytes{ 0 };
+    size_t mPooledBytes{ 0 };
+    size_t mPeakBytes{ 0 };
+    uint64_t mNumEvicted{ 0 };
+};
@@ -32,6 +32,7 @@
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
+#include "core/capture.h"
 #include "llvm/IR/DataLayout.h"
 
 #include <sstream>
@@ -590,5 +591,8 @@ extern "C" PFN_BLEND_JIT_FUNC JITCALL JitCompileBlend(HANDLE hJitMgr, const BLEN
     BlendJit theJit(pJitMgr);
     HANDLE hFunc = theJit.Create(state);
 
-    return JitBlendFunc(hJitMgr, hFunc);
+    PFN_BLEND_JIT_FUNC pfnBlend = JitBlendFunc(hJitMgr, hFunc);
+    CaptureJitFunction(SWR_CAPTURE_JIT_BLEND, (const void*)pfnBlend, &state, sizeof(state));
+
+    return pfnBlend;
 }
@@ -32,6 +32,7 @@
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
+#include "core/capture.h"
 #include "llvm/IR/DataLayout.h"
 #include <sstream>
 #include <tuple>
@@ -232,6 +233,12 @@ void FetchJit::JitLoadVertices(const FETCH_COMPILE_STATE &fetchState, Value* fet
 
     for(uint32_t nelt = 0; nelt < fetchState.numAttribs; ++nelt)
     {
+        // skip elements the vertex shader never reads
+        if(!(fetchState.activeElementMask & (1ull << nelt)))
+        {
+            continue;
+        }
+
         Value*    elements[4] = {0};
         const INPUT_ELEMENT_DESC& ied = fetchState.layout[nelt];
         const SWR_FORMAT_INFO &info = GetFormatInfo((SWR_FORMAT)ied.Format);
@@ -479,6 +486,16 @@ void FetchJit::JitGatherVertices(const FETCH_COMPILE_STATE &fetchState, Value* f
     for(uint32_t nInputElt = 0; nInputElt < fetchState.numAttribs; ++nInputElt)
     {
         const INPUT_ELEMENT_DESC& ied = fetchState.layout[nInputElt];
+
+        // skip elements the vertex shader never reads. Only fully packed elements
+        // starting on a simdvertex slot boundary own a whole slot and can be skipped.
+        if(!(fetchState.activeElementMask & (1ull << nInputElt)) &&
+           (ied.ComponentPacking == ComponentEnable::XYZW) && (currentVertexElement == 0))
+        {
+            outputElt++;
+            continue;
+        }
+
         const SWR_FORMAT_INFO &info = GetFormatInfo((SWR_FORMAT)ied.Format);
         uint32_t bpc = info.bpp / info.numComps;  ///@todo Code below assumes all components are same size. Need to fix.
 
@@ -1414,6 +1431,21 @@ PFN_FETCH_FUNC JitFetchFunc(HANDLE hJitMgr, const HANDLE hFunc)
     return pfnFetch;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Builds fetch shader IR into the JitManager's current module
+///        without finalizing it, so a client can inline it into another
+///        function (e.g. a vertex shader) before compiling the module.
+/// @param hJitMgr - JitManager handle
+/// @param state   - fetch state to build function from
+/// @return HANDLE - llvm::Function* of the fetch shader
+extern "C" HANDLE JITCALL JitBuildFetch(HANDLE hJitMgr, const FETCH_COMPILE_STATE& state)
+{
+    JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
+
+    FetchJit theJit(pJitMgr);
+    return theJit.Create(state);
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief JIT compiles fetch shader
 /// @param hJitMgr - JitManager handle
@@ -1427,5 +1459,14 @@ extern "C" PFN_FETCH_FUNC JITCALL JitCompileFetch(HANDLE hJitMgr, const FETCH_CO
     FetchJit theJit(pJitMgr);
     HANDLE hFunc = theJit.Create(state);
 
-    return JitFetchFunc(hJitMgr, hFunc);
+    PFN_FETCH_FUNC pfnFetch = JitFetchFunc(hJitMgr, hFunc);
+
+    uint32_t streamMask = 0;
+    for (uint32_t i = 0; i < state.numAttribs; ++i)
+    {
+        streamMask |= 1 << state.layout[i].StreamIndex;
+    }
+    CaptureJitFunction(SWR_CAPTURE_JIT_FETCH, (const void*)pfnFetch, &state, sizeof(state), streamMask);
+
+    return pfnFetch;
 }
@@ -96,6 +96,7 @@ struct FETCH_COMPILE_STATE
     INPUT_ELEMENT_DESC layout[KNOB_NUM_ATTRIBUTES];
     SWR_FORMAT indexType;
     uint32_t cutIndex{ 0xffffffff };
+    uint64_t activeElementMask{ ~0ull };    // elements read by the vertex shader; inactive XYZW elements are not fetched
 
     // Options that effect the JIT'd code
     bool bDisableVGATHER;           // if enabled, FetchJit will generate loads/shuffles instead of VGATHERs
@@ -113,6 +114,7 @@ struct FETCH_COMPILE_STATE
         if (bDisableIndexOOBCheck != other.bDisableIndexOOBCheck) return false;
         if (bEnableCutIndex != other.bEnableCutIndex) return false;
         if (cutIndex != other.cutIndex) return false;
+        if (activeElementMask != other.activeElementMask) return false;
 
         for(uint32_t i = 0; i < numAttribs; ++i)
         {
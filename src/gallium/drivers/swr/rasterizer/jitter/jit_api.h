@@ -90,6 +90,14 @@ void JITCALL JitDestroyShader(
 /// @param state   - Fetch state to build function from
 PFN_FETCH_FUNC JITCALL JitCompileFetch(HANDLE hJitContext, const FETCH_COMPILE_STATE& state);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Builds fetch shader IR into the current module without compiling
+///        it. Used to fuse fetch into a vertex shader.
+/// @param hJitContext - Jit Context
+/// @param state   - Fetch state to build function from
+/// @return HANDLE - llvm::Function* of the fetch shader
+HANDLE JITCALL JitBuildFetch(HANDLE hJitContext, const FETCH_COMPILE_STATE& state);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief JIT compiles streamout shader
 /// @param hJitContext - Jit Context
@@ -32,6 +32,7 @@
 #include "builder.h"
 #include "state_llvm.h"
 #include "common/containers.hpp"
+#include "core/capture.h"
 #include "llvm/IR/DataLayout.h"
 
 #include <sstream>
@@ -353,5 +354,8 @@ extern "C" PFN_SO_FUNC JITCALL JitCompileStreamout(HANDLE hJitMgr, const STREAMO
     StreamOutJit theJit(pJitMgr);
     HANDLE hFunc = theJit.Create(soState);
 
-    return JitStreamoutFunc(hJitMgr, hFunc);
+    PFN_SO_FUNC pfnStreamOut = JitStreamoutFunc(hJitMgr, hFunc);
+    CaptureJitFunction(SWR_CAPTURE_JIT_STREAMOUT, (const void*)pfnStreamOut, &state, sizeof(state));
+
+    return pfnStreamOut;
 }
@@ -33,7 +33,7 @@
 #include "memory/tilingtraits.h"
 #include "memory/Convert.h"
 
-typedef void(*PFN_STORE_TILES_CLEAR)(const FLOAT*, SWR_SURFACE_STATE*, UINT, UINT);
+typedef void(*PFN_STORE_TILES_CLEAR)(const FLOAT*, SWR_SURFACE_STATE*, UINT, UINT, uint32_t);
 
 //////////////////////////////////////////////////////////////////////////
 /// Clear Raster Tile Function Tables.
@@ -53,22 +53,45 @@ struct StoreRasterTileClear
     /// @param pColor - Pointer to clear color.
     /// @param pDstSurface - Destination surface state
     /// @param x, y - Coordinates to raster tile.
+    /// @param sampleNum - Sample to write.
+    /// @param renderTargetArrayIndex - Array slice relative to the surface's arrayIndex.
     INLINE static void StoreClear(
         const BYTE* dstFormattedColor,
         UINT dstBytesPerPixel,
         SWR_SURFACE_STATE* pDstSurface,
-        UINT x, UINT y) // (x, y) pixel coordinate to start of raster tile.
+        UINT x, UINT y, // (x, y) pixel coordinate to start of raster tile.
+        uint32_t sampleNum,
+        uint32_t renderTargetArrayIndex)
     {
+        uint32_t lodWidth = std::max(pDstSurface->width >> pDstSurface->lod, 1U);
+        uint32_t lodHeight = std::max(pDstSurface->height >> pDstSurface->lod, 1U);
+        uint32_t arrayIndex = pDstSurface->arrayIndex + renderTargetArrayIndex;
+
+        if (pDstSurface->tileMode != SWR_TILE_NONE)
+        {
+            // Tiled destinations don't have contiguous rows, so address each pixel.
+            for (UINT ry = 0; (ry < KNOB_TILE_Y_DIM) && ((y + ry) < lodHeight); ++ry)
+            {
+                for (UINT rx = 0; (rx < KNOB_TILE_X_DIM) && ((x + rx) < lodWidth); ++rx)
+                {
+                    BYTE* pDst = (BYTE*)ComputeSurfaceAddress<false>(x + rx, y + ry, arrayIndex, arrayIndex,
+                        sampleNum, pDstSurface->lod, pDstSurface);
+                    memcpy(pDst, dstFormattedColor, dstBytesPerPixel);
+                }
+            }
+            return;
+        }
+
         // Compute destination address for raster tile.
-        BYTE* pDstTile = (BYTE*)pDstSurface->pBaseAddress +
-            (y * pDstSurface->pitch) + (x * dstBytesPerPixel);
+        BYTE* pDstTile = (BYTE*)ComputeSurfaceAddress<false>(x, y, arrayIndex, arrayIndex,
+            sampleNum, pDstSurface->lod, pDstSurface);
 
         // start of first row
         BYTE* pDst = pDstTile;
         UINT dstBytesPerRow = 0;
 
         // For each raster tile pixel in row 0 (rx, 0)
-        for (UINT rx = 0; (rx < KNOB_TILE_X_DIM) && ((x + rx) < pDstSurface->width); ++rx)
+        for (UINT rx = 0; (rx < KNOB_TILE_X_DIM) && ((x + rx) < lodWidth); ++rx)
         {
             memcpy(pDst, dstFormattedColor, dstBytesPerPixel);
 
@@ -81,7 +104,7 @@ struct StoreRasterTileClear
         pDst = pDstTile + pDstSurface->pitch;
 
         // For each remaining row in the rest of the raster tile
-        for (UINT ry = 1; (ry < KNOB_TILE_Y_DIM) && ((y + ry) < pDstSurface->height); ++ry)
+        for (UINT ry = 1; (ry < KNOB_TILE_Y_DIM) && ((y + ry) < lodHeight); ++ry)
         {
             // copy row
             memcpy(pDst, pDstTile, dstBytesPerRow);
@@ -103,10 +126,11 @@ struct StoreMacroTileClear
     /// @param pColor - Pointer to color to write to pixels.
     /// @param pDstSurface - Destination surface state
     /// @param x, y - Coordinates to macro tile
+    /// @param renderTargetArrayIndex - Array slice relative to the surface's arrayIndex.
     static void StoreClear(
         const FLOAT *pColor,
         SWR_SURFACE_STATE* pDstSurface,
-        UINT x, UINT y)
+        UINT x, UINT y, uint32_t renderTargetArrayIndex)
     {
         UINT dstBytesPerPixel = (FormatTraits<DstFormat>::bpp / 8);
 
@@ -123,29 +147,35 @@ struct StoreMacroTileClear
         ConvertPixelFromFloat<DstFormat>(dstFormattedColor, srcColor);
 
         // Store each raster tile from the hot tile to the destination surface.
-        // TODO:  Put in check for partial coverage on x/y -- SWR_ASSERT if it happens.
-        //        Intent is for this function to only handle full tiles.
+        // Raster tiles straddling the right/bottom edge of the lod are clipped in StoreRasterTileClear.
         for (UINT row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
         {
             for (UINT col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
             {
-                StoreRasterTileClear<SrcFormat, DstFormat>::StoreClear(dstFormattedColor, dstBytesPerPixel, pDstSurface, (x + col), (y + row));
+                for (uint32_t sampleNum = 0; sampleNum < pDstSurface->numSamples; sampleNum++)
+                {
+                    StoreRasterTileClear<SrcFormat, DstFormat>::StoreClear(dstFormattedColor, dstBytesPerPixel, pDstSurface,
+                        (x + col), (y + row), sampleNum, renderTargetArrayIndex);
+                }
             }
         }
     }
 };
 
 //////////////////////////////////////////////////////////////////////////
-/// @brief Writes clear color to every pixel of a render surface
-/// @param hPrivateContext - Handle to private DC
+/// @brief Writes clear color to every pixel of a macro tile in a render surface
+/// @param pDstSurface - Destination surface state
 /// @param renderTargetIndex - Index to destination render target
-/// @param x, y - Coordinates to raster tile.
+/// @param x, y - Coordinates to macro tile.
+/// @param renderTargetArrayIndex - Array slice relative to the surface's arrayIndex.
 /// @param pClearColor - Pointer to clear color
-void StoreHotTileClear(
+/// @return false if the surface format has no clear store function.
+bool StoreHotTileClear(
     SWR_SURFACE_STATE *pDstSurface,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
     UINT x,
     UINT y,
+    uint32_t renderTargetArrayIndex,
     const float* pClearColor)
 {
     PFN_STORE_TILES_CLEAR pfnStoreTilesClear = NULL;
@@ -161,14 +191,16 @@ void StoreHotTileClear(
         pfnStoreTilesClear = sStoreTilesClearDepthTable[pDstSurface->format];
     }
 
-    SWR_ASSERT(pfnStoreTilesClear != NULL);
-
-    // Store a macro tile.
-    /// @todo Once all formats are supported then if check can go away. This is to help us near term to make progress.
-    if (pfnStoreTilesClear != NULL)
+    // Formats without a clear store function are handled by the caller storing
+    // the materialized hot tile.
+    if (pfnStoreTilesClear == NULL)
     {
-        pfnStoreTilesClear(pClearColor, pDstSurface, x, y);
+        return false;
     }
+
+    // Store a macro tile.
+    pfnStoreTilesClear(pClearColor, pDstSurface, x, y, renderTargetArrayIndex);
+    return true;
 }
 
 //////////////////////////////////////////////////////////////////////////
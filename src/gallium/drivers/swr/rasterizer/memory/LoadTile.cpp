@@ -113,12 +113,138 @@ struct LoadRasterTile
     }
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// ConvertDepthRow - Converts 4 depth pixels of a linear surface row to
+/// R32_FLOAT. Matches ConvertPixelToFloat bit for bit.
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT SrcFormat>
+struct ConvertDepthRow;
+
+template<>
+struct ConvertDepthRow<R32_FLOAT>
+{
+    INLINE static __m128 Convert(const uint8_t* pSrc)
+    {
+        return _mm_loadu_ps((const float*)pSrc);
+    }
+};
+
+template<>
+struct ConvertDepthRow<R16_UNORM>
+{
+    INLINE static __m128 Convert(const uint8_t* pSrc)
+    {
+        __m128i vSrc = _mm_loadl_epi64((const __m128i*)pSrc);
+        vSrc = _mm_unpacklo_epi16(vSrc, _mm_setzero_si128());
+        return _mm_mul_ps(_mm_cvtepi32_ps(vSrc), _mm_set1_ps(1.0f / 65535.0f));
+    }
+};
+
+template<>
+struct ConvertDepthRow<R24_UNORM_X8_TYPELESS>
+{
+    INLINE static __m128 Convert(const uint8_t* pSrc)
+    {
+        __m128i vSrc = _mm_loadu_si128((const __m128i*)pSrc);
+        vSrc = _mm_and_si128(vSrc, _mm_set1_epi32(0xFFFFFF));
+
+        // 24 bit unorm must use fp divide to maintain ulp requirements
+        return _mm_div_ps(_mm_cvtepi32_ps(vSrc), _mm_set1_ps(16777215.0f));
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// LoadDepthRasterTileLinear - Loads an 8x8 raster tile from a linear
+/// depth surface into the R32_FLOAT depth hot tile, 4 pixels at a time.
+/// Raster tiles that straddle the surface edge use LoadRasterTile.
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT SrcFormat>
+struct LoadDepthRasterTileLinear
+{
+    typedef TilingTraits<SWR_TILE_NONE, FormatTraits<SrcFormat>::bpp> TTraits;
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Loads an 8x8 raster tile from the src surface.
+    /// @param pSrcSurface - Src surface state
+    /// @param pDst - Destination hot tile pointer
+    /// @param x, y - Coordinates to raster tile.
+    INLINE static void Load(
+        SWR_SURFACE_STATE* pSrcSurface,
+        uint8_t* pDst,
+        uint32_t x, uint32_t y, uint32_t sampleNum, uint32_t renderTargetArrayIndex)
+    {
+        static_assert(SIMD_TILE_X_DIM == 4, "expected 4 pixel wide simd tiles");
+
+        uint32_t lodWidth = (pSrcSurface->width == 1) ? 1 : pSrcSurface->width >> pSrcSurface->lod;
+        uint32_t lodHeight = (pSrcSurface->height == 1) ? 1 : pSrcSurface->height >> pSrcSurface->lod;
+
+        if ((x + KNOB_TILE_X_DIM) > lodWidth || (y + KNOB_TILE_Y_DIM) > lodHeight)
+        {
+            LoadRasterTile<TTraits, SrcFormat, R32_FLOAT>::Load(pSrcSurface, pDst, x, y, sampleNum, renderTargetArrayIndex);
+            return;
+        }
+
+        const uint8_t* pSrc = (const uint8_t*)ComputeSurfaceAddress<false>(x, y, pSrcSurface->arrayIndex + renderTargetArrayIndex,
+            pSrcSurface->arrayIndex + renderTargetArrayIndex, sampleNum, pSrcSurface->lod, pSrcSurface);
+        float* pDstFloat = (float*)pDst;
+
+        for (uint32_t ry = 0; ry < KNOB_TILE_Y_DIM; ++ry)
+        {
+            for (uint32_t rx = 0; rx < KNOB_TILE_X_DIM; rx += SIMD_TILE_X_DIM)
+            {
+                uint32_t simdIndex = (ry / SIMD_TILE_Y_DIM) * (KNOB_TILE_X_DIM / SIMD_TILE_X_DIM) + (rx / SIMD_TILE_X_DIM);
+                uint32_t simdOffset = (ry % SIMD_TILE_Y_DIM) * SIMD_TILE_X_DIM;
+
+                __m128 vDepth = ConvertDepthRow<SrcFormat>::Convert(pSrc + rx * (FormatTraits<SrcFormat>::bpp / 8));
+                _mm_store_ps(&pDstFloat[simdIndex * KNOB_SIMD_WIDTH + simdOffset], vDepth);
+            }
+            pSrc += pSrcSurface->pitch;
+        }
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// LoadMacroTile - Loads a macro tile which consists of raster tiles.
 //////////////////////////////////////////////////////////////////////////
-template<typename TTraits, SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat>
+template<typename TTraits, SWR_FORMAT SrcFormat, SWR_FORMAT DstFormat,
+         typename TRasterTile = LoadRasterTile<TTraits, SrcFormat, DstFormat>>
 struct LoadMacroTile
 {
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Prefetches one row of raster tiles from a linear src surface
+    ///        into L2.
+    /// @param pSrcSurface - Src surface state
+    /// @param x, y - Coordinates to the first raster tile of the row.
+    INLINE static void PrefetchRasterTileRow(
+        SWR_SURFACE_STATE* pSrcSurface,
+        uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
+    {
+        uint32_t lodWidth = std::max(pSrcSurface->width >> pSrcSurface->lod, 1U);
+        uint32_t lodHeight = std::max(pSrcSurface->height >> pSrcSurface->lod, 1U);
+        if (x >= lodWidth || y >= lodHeight)
+        {
+            return;
+        }
+
+        uint32_t rowBytes = std::min<uint32_t>(KNOB_MACROTILE_X_DIM, lodWidth - x) * (FormatTraits<SrcFormat>::bpp / 8);
+        uint32_t numRows = std::min<uint32_t>(KNOB_TILE_Y_DIM, lodHeight - y);
+
+        for (uint32_t sampleNum = 0; sampleNum < pSrcSurface->numSamples; sampleNum++)
+        {
+            const uint8_t* pSrc = (const uint8_t*)ComputeSurfaceAddress<false>(x, y, pSrcSurface->arrayIndex + renderTargetArrayIndex,
+                pSrcSurface->arrayIndex + renderTargetArrayIndex, sampleNum, pSrcSurface->lod, pSrcSurface);
+
+            for (uint32_t ry = 0; ry < numRows; ++ry)
+            {
+                for (uint32_t offset = 0; offset < rowBytes; offset += 64) // one cache line per prefetch
+                {
+                    _mm_prefetch((const char*)(pSrc + offset), _MM_HINT_T1);
+                }
+                pSrc += pSrcSurface->pitch;
+            }
+        }
+    }
+
     //////////////////////////////////////////////////////////////////////////
     /// @brief Load a macrotile to the destination surface.
     /// @param pSrc - Pointer to macro tile.
@@ -129,14 +255,23 @@ struct LoadMacroTile
         uint8_t *pDstHotTile,
         uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex)
     {
+        // On linear surfaces the macrotile below this one is prefetched one
+        // raster tile row at a time, so it is spread across this load.
+        const bool bPrefetch = KNOB_PREFETCH_LOAD_TILES && (TTraits::TileMode == SWR_TILE_NONE);
+
         // Load each raster tile from the hot tile to the destination surface.
         for (uint32_t row = 0; row < KNOB_MACROTILE_Y_DIM; row += KNOB_TILE_Y_DIM)
         {
+            if (bPrefetch)
+            {
+                PrefetchRasterTileRow(pSrcSurface, x, y + KNOB_MACROTILE_Y_DIM + row, renderTargetArrayIndex);
+            }
+
             for (uint32_t col = 0; col < KNOB_MACROTILE_X_DIM; col += KNOB_TILE_X_DIM)
             {
                 for (uint32_t sampleNum = 0; sampleNum < pSrcSurface->numSamples; sampleNum++)
                 {
-                    LoadRasterTile<TTraits, SrcFormat, DstFormat>::Load(pSrcSurface, pDstHotTile, 
+                    TRasterTile::Load(pSrcSurface, pDstHotTile, 
                         (x + col), (y + row), sampleNum, renderTargetArrayIndex);
                     pDstHotTile += KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<DstFormat>::bpp / 8);
                 }
@@ -379,6 +514,14 @@ void InitSimLoadTilesTable()
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_NONE);
     INIT_LOAD_TILES_DEPTH_TABLE(SWR_TILE_NONE);
 
+    // Linear depth surfaces convert whole rows of a raster tile at once.
+    sLoadTilesDepthTable_SWR_TILE_NONE[R16_UNORM] = LoadMacroTile<TilingTraits<SWR_TILE_NONE, 16>, R16_UNORM, R32_FLOAT,
+        LoadDepthRasterTileLinear<R16_UNORM>>::Load;
+    sLoadTilesDepthTable_SWR_TILE_NONE[R32_FLOAT] = LoadMacroTile<TilingTraits<SWR_TILE_NONE, 32>, R32_FLOAT, R32_FLOAT,
+        LoadDepthRasterTileLinear<R32_FLOAT>>::Load;
+    sLoadTilesDepthTable_SWR_TILE_NONE[R24_UNORM_X8_TYPELESS] = LoadMacroTile<TilingTraits<SWR_TILE_NONE, 32>, R24_UNORM_X8_TYPELESS, R32_FLOAT,
+        LoadDepthRasterTileLinear<R24_UNORM_X8_TYPELESS>>::Load;
+
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_MODE_YMAJOR);
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_MODE_XMAJOR);
 
@@ -0,0 +1,224 @@
+/****************************************************************************
+* Copyright (C) 2014-2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file swr_pa_bench.cpp
+*
+* @brief Measures primitive assembly throughput in prims/sec per topology.
+*
+*        Each draw runs the FE's assembly loop on its own: vertex batches
+*        are written straight into the PA's vertex store, without fetch or
+*        vertex shading, and assembled prims are only summed. Indexed draws
+*        take the cut-aware PA where the FE would, and cut indices can be
+*        inserted at a fixed interval. Strip topologies on the cut-aware PA
+*        are measured with and without KNOB_STRIP_BATCH_ASSEMBLY.
+*
+******************************************************************************/
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "core/context.h"
+#include "core/frontend.h"
+#include "core/pa.h"
+
+struct PA_BENCH_OPTIONS
+{
+    uint32_t numVerts{ 1 << 16 };       // verts per draw
+    uint32_t numDraws{ 256 };
+    uint32_t restartInterval{ 0 };      // verts between cut indices, 0 for none
+};
+
+struct PA_BENCH_RESULT
+{
+    uint64_t numPrims;
+    double seconds;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Assembles one draw the way ProcessDraw does.
+/// @return number of assembled prims.
+template <bool IsIndexedT>
+static uint64_t AssembleDraw(DRAW_CONTEXT* pDC, const PA_BENCH_OPTIONS& options)
+{
+    const API_STATE& state = GetApiState(pDC);
+    PA_FACTORY<IsIndexedT> paFactory(pDC, state.topology, options.numVerts);
+    PA_STATE& pa = paFactory.GetPA();
+
+    uint64_t numPrims = 0;
+    uint32_t i = 0;
+    while (pa.HasWork())
+    {
+        if (IsIndexedT)
+        {
+            simdmask cutMask = 0;
+            if (options.restartInterval != 0)
+            {
+                for (uint32_t lane = 0; lane < KNOB_SIMD_WIDTH; ++lane)
+                {
+                    if ((i + lane + 1) % options.restartInterval == 0)
+                    {
+                        cutMask |= 1 << lane;
+                    }
+                }
+            }
+            pa.GetNextVsIndices() = cutMask;
+        }
+
+        simdvertex& vout = pa.GetNextVsOutput();
+        simdscalar vIndex = _simd_castsi_ps(_simd_add_epi32(_simd_set1_epi32(i),
+            _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0)));
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            vout.attrib[VERTEX_POSITION_SLOT][c] = vIndex;
+        }
+
+        do
+        {
+            simdvector prim[MAX_NUM_VERTS_PER_PRIM];
+            if (pa.Assemble(VERTEX_POSITION_SLOT, prim))
+            {
+                numPrims += pa.NumPrims();
+            }
+        } while (pa.NextPrim());
+
+        i += KNOB_SIMD_WIDTH;
+    }
+    pa.Reset();
+
+    return numPrims;
+}
+
+static PA_BENCH_RESULT RunTopology(DRAW_CONTEXT* pDC, PRIMITIVE_TOPOLOGY topo, bool isIndexed, const PA_BENCH_OPTIONS& options)
+{
+    pDC->pState->state.topology = topo;
+
+    PA_BENCH_RESULT result = {};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t d = 0; d < options.numDraws; ++d)
+    {
+        result.numPrims += isIndexed ? AssembleDraw<true>(pDC, options) : AssembleDraw<false>(pDC, options);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+static void PrintResult(const char* pName, const char* pVariant, const PA_BENCH_RESULT& result)
+{
+    printf("%-16s %-18s %12" PRIu64 " %10.2f\n", pName, pVariant, result.numPrims,
+        result.numPrims / result.seconds / 1e6);
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+        "usage: swr_pa_bench [options]\n"
+        "  -verts <n>      verts per draw (default 65536)\n"
+        "  -draws <n>      draws per topology (default 256)\n"
+        "  -restart <n>    cut index every n verts of indexed draws (default none)\n"
+        "Prints millions of assembled prims per second for each topology.\n");
+}
+
+static bool ParseOptions(int argc, char** argv, PA_BENCH_OPTIONS& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* pArg = argv[i];
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        uint32_t value = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        if (!strcmp(pArg, "-verts") && value != 0)    options.numVerts = value;
+        else if (!strcmp(pArg, "-draws") && value != 0) options.numDraws = value;
+        else if (!strcmp(pArg, "-restart"))         options.restartInterval = value;
+        else return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    PA_BENCH_OPTIONS options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // The PA only reads the topology, the GS enable and the FE attribute mask.
+    DRAW_STATE* pState = new DRAW_STATE();
+    memset(&pState->state, 0, sizeof(pState->state));
+    pState->state.feAttribMask = 1 << VERTEX_POSITION_SLOT;
+
+    DRAW_CONTEXT* pDC = new DRAW_CONTEXT();
+    pDC->pState = pState;
+
+    static const struct
+    {
+        const char* pName;
+        PRIMITIVE_TOPOLOGY topo;
+    } topologies[] =
+    {
+        { "point list",         TOP_POINT_LIST },
+        { "line list",          TOP_LINE_LIST },
+        { "line strip",         TOP_LINE_STRIP },
+        { "tri list",           TOP_TRIANGLE_LIST },
+        { "tri strip",          TOP_TRIANGLE_STRIP },
+        { "tri fan",            TOP_TRIANGLE_FAN },
+        { "line list adj",      TOP_LINE_LIST_ADJ },
+        { "line strip adj",     TOP_LISTSTRIP_ADJ },
+        { "tri list adj",       TOP_TRI_LIST_ADJ },
+        { "tri strip adj",      TOP_TRI_STRIP_ADJ },
+    };
+
+    printf("%-16s %-18s %12s %10s\n", "topology", "draw", "prims", "Mprims/s");
+    for (const auto& t : topologies)
+    {
+        PrintResult(t.pName, "non-indexed", RunTopology(pDC, t.topo, false, options));
+
+        bool isStrip = (t.topo == TOP_TRIANGLE_STRIP || t.topo == TOP_LINE_STRIP);
+        if (isStrip)
+        {
+            bool stripBatch = KNOB_STRIP_BATCH_ASSEMBLY;
+            SET_KNOB(STRIP_BATCH_ASSEMBLY, false);
+            PrintResult(t.pName, "indexed, per-vert", RunTopology(pDC, t.topo, true, options));
+            SET_KNOB(STRIP_BATCH_ASSEMBLY, true);
+            PrintResult(t.pName, "indexed, batched", RunTopology(pDC, t.topo, true, options));
+            SET_KNOB(STRIP_BATCH_ASSEMBLY, stripBatch);
+        }
+        else
+        {
+            PrintResult(t.pName, "indexed", RunTopology(pDC, t.topo, true, options));
+        }
+    }
+
+    delete pDC;
+    delete pState;
+    return 0;
+}
@@ -0,0 +1,634 @@
+/****************************************************************************
+* Copyright (C) 2014-2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file swr_replay.cpp
+*
+* @brief Replays an API capture (see core/capture.h) against the core, for
+*        benchmarking the core without a driver.
+*
+*        Fetch, streamout and blend functions are compiled again from their
+*        captured compile state. Shaders generated by the driver can't be,
+*        they are replaced by pass-through shaders: the VS outputs the first
+*        fetched attribute as position, the PS outputs barycentrics, GS and
+*        tessellation are disabled. Render target contents aren't captured,
+*        hot tiles aren't loaded from or stored to surfaces.
+*
+******************************************************************************/
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "core/api.h"
+#include "core/capture.h"
+#include "core/context.h"
+#include "jitter/jit_api.h"
+
+struct REPLAY_OPTIONS
+{
+    uint32_t numIterations{ 1 };
+    bool enableStats{ false };
+    const char* pFilename{ nullptr };
+};
+
+struct REPLAY_CONTEXT
+{
+    HANDLE hContext;
+    API_STATE* pCapturedState;      // captured state, buffers and functions by id
+    API_STATE* pState;              // captured state resolved for replay
+    bool isDrawable;                // all functions the state references are available
+};
+
+struct REPLAY
+{
+    REPLAY_OPTIONS options;
+
+    uint8_t* pCapture;
+    size_t captureSize;
+
+    std::vector<uint8_t*> buffers;                  // contents by buffer id
+    std::unordered_map<uint64_t, void*> jitFuncs;   // compiled functions by captured function
+    std::unordered_map<uint64_t, REPLAY_CONTEXT> contexts;
+
+    SWR_STATS stats;
+    uint32_t numFrames;
+    uint32_t numSubmits;
+    uint32_t numSkipped;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// Substitutes for functions that can't be compiled from the capture.
+//////////////////////////////////////////////////////////////////////////
+static void __cdecl ReplayVertexShader(HANDLE hPrivateData, SWR_VS_CONTEXT* pVsContext)
+{
+    const simdvertex& vin = *pVsContext->pVin;
+    simdvertex& vout = *pVsContext->pVout;
+
+    vout.attrib[VERTEX_POSITION_SLOT] = vin.attrib[0];
+    for (uint32_t slot = VERTEX_ATTRIB_START_SLOT; slot < VERTEX_ATTRIB_END_SLOT; ++slot)
+    {
+        vout.attrib[slot] = vin.attrib[slot - VERTEX_ATTRIB_START_SLOT];
+    }
+}
+
+static void __cdecl ReplayPixelShader(HANDLE hPrivateData, SWR_PS_CONTEXT* pPsContext)
+{
+    simdscalar vK = _simd_sub_ps(_simd_set1_ps(1.0f), _simd_add_ps(pPsContext->vI, pPsContext->vJ));
+
+    for (uint32_t rt = 0; rt < SWR_NUM_RENDERTARGETS; ++rt)
+    {
+        pPsContext->shaded[rt].x = pPsContext->vI;
+        pPsContext->shaded[rt].y = pPsContext->vJ;
+        pPsContext->shaded[rt].z = vK;
+        pPsContext->shaded[rt].w = _simd_set1_ps(1.0f);
+    }
+}
+
+static void __cdecl ReplayComputeShader(HANDLE hPrivateData, SWR_CS_CONTEXT* pCsContext)
+{
+}
+
+static void SWR_API ReplayLoadTile(HANDLE hPrivateContext, SWR_FORMAT dstFormat,
+    SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, BYTE *pDstHotTile)
+{
+}
+
+static void SWR_API ReplayStoreTile(HANDLE hPrivateContext, SWR_FORMAT srcFormat,
+    SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, uint32_t numSamples, BYTE *pSrcHotTile)
+{
+}
+
+static bool SWR_API ReplayClearTile(HANDLE hPrivateContext,
+    SWR_RENDERTARGET_ATTACHMENT rtIndex,
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex, const float* pClearColor)
+{
+    return true;
+}
+
+static void SWR_API ReplaySync(uint64_t data, uint64_t data2)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Calls func(record, pPayload) for each record of the capture.
+template <typename Func>
+static void ForEachRecord(const REPLAY& replay, Func func)
+{
+    size_t offset = sizeof(SWR_CAPTURE_HEADER);
+    while (offset + sizeof(SWR_CAPTURE_RECORD) <= replay.captureSize)
+    {
+        const SWR_CAPTURE_RECORD& record = *(const SWR_CAPTURE_RECORD*)&replay.pCapture[offset];
+        uint8_t* pPayload = &replay.pCapture[offset + sizeof(SWR_CAPTURE_RECORD)];
+
+        if (offset + sizeof(SWR_CAPTURE_RECORD) + record.size > replay.captureSize)
+        {
+            fprintf(stderr, "swr_replay: capture is truncated\n");
+            break;
+        }
+
+        func(record, pPayload);
+
+        offset += sizeof(SWR_CAPTURE_RECORD) + AlignUp(record.size, SWR_CAPTURE_ALIGN);
+    }
+}
+
+static bool LoadCapture(REPLAY& replay)
+{
+    FILE* pFile = fopen(replay.options.pFilename, "rb");
+    if (pFile == nullptr)
+    {
+        fprintf(stderr, "swr_replay: can't open %s\n", replay.options.pFilename);
+        return false;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    replay.captureSize = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    // Buffer contents are used in place, streamout writes into them.
+    replay.pCapture = (uint8_t*)_aligned_malloc(replay.captureSize, 64);
+    size_t numRead = fread(replay.pCapture, 1, replay.captureSize, pFile);
+    fclose(pFile);
+
+    const SWR_CAPTURE_HEADER& header = *(const SWR_CAPTURE_HEADER*)replay.pCapture;
+    if (numRead != replay.captureSize || replay.captureSize < sizeof(SWR_CAPTURE_HEADER) ||
+        header.magic != SWR_CAPTURE_MAGIC || header.version != SWR_CAPTURE_VERSION)
+    {
+        fprintf(stderr, "swr_replay: %s is not an SWR capture\n", replay.options.pFilename);
+        return false;
+    }
+
+    if (header.apiStateSize != sizeof(API_STATE) || header.simdWidth != KNOB_SIMD_WIDTH)
+    {
+        fprintf(stderr, "swr_replay: %s was captured with a different core build\n", replay.options.pFilename);
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Compiles the captured JIT functions and indexes buffer contents.
+static void PrepareCapture(REPLAY& replay)
+{
+    HANDLE hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
+
+    ForEachRecord(replay, [&](const SWR_CAPTURE_RECORD& record, uint8_t* pPayload)
+    {
+        if (record.op == SWR_CAPTURE_JIT_FUNCTION)
+        {
+            const SWR_CAPTURE_JIT_ARGS& args = *(const SWR_CAPTURE_JIT_ARGS*)pPayload;
+            const void* pState = pPayload + sizeof(SWR_CAPTURE_JIT_ARGS);
+            void* pfnFunc = nullptr;
+
+            switch (args.type)
+            {
+            case SWR_CAPTURE_JIT_FETCH:
+                pfnFunc = (void*)JitCompileFetch(hJitMgr, *(const FETCH_COMPILE_STATE*)pState);
+                break;
+            case SWR_CAPTURE_JIT_STREAMOUT:
+                pfnFunc = (void*)JitCompileStreamout(hJitMgr, *(const STREAMOUT_COMPILE_STATE*)pState);
+                break;
+            case SWR_CAPTURE_JIT_BLEND:
+                pfnFunc = (void*)JitCompileBlend(hJitMgr, *(const BLEND_COMPILE_STATE*)pState);
+                break;
+            }
+
+            replay.jitFuncs[args.func] = pfnFunc;
+        }
+        else if (record.op == SWR_CAPTURE_BUFFER)
+        {
+            const SWR_CAPTURE_BUFFER_ARGS& args = *(const SWR_CAPTURE_BUFFER_ARGS*)pPayload;
+            if (args.id >= replay.buffers.size())
+            {
+                replay.buffers.resize(args.id + 1, nullptr);
+            }
+            replay.buffers[args.id] = pPayload + sizeof(SWR_CAPTURE_BUFFER_ARGS);
+        }
+    });
+}
+
+template <typename T>
+static T* GetBuffer(const REPLAY& replay, T* pId)
+{
+    uint64_t id = (uint64_t)pId;
+    return (id != 0 && id < replay.buffers.size()) ? (T*)replay.buffers[id] : nullptr;
+}
+
+template <typename T>
+static T GetJitFunc(const REPLAY& replay, T pfnCaptured, bool& isDrawable)
+{
+    if (pfnCaptured == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto func = replay.jitFuncs.find((uint64_t)pfnCaptured);
+    if (func == replay.jitFuncs.end())
+    {
+        isDrawable = false;
+        return nullptr;
+    }
+    return (T)func->second;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Replaces buffer ids and captured functions of the captured state.
+static void ResolveState(const REPLAY& replay, REPLAY_CONTEXT& context)
+{
+    const API_STATE& captured = *context.pCapturedState;
+    API_STATE& state = *context.pState;
+    memcpy(&state, &captured, sizeof(API_STATE));
+
+    for (uint32_t i = 0; i < KNOB_NUM_STREAMS; ++i)
+    {
+        state.vertexBuffers[i].pData = GetBuffer(replay, captured.vertexBuffers[i].pData);
+    }
+    state.indexBuffer.pIndices = GetBuffer(replay, captured.indexBuffer.pIndices);
+
+    context.isDrawable = true;
+    for (uint32_t i = 0; i < MAX_SO_STREAMS; ++i)
+    {
+        state.soBuffer[i].pBuffer = GetBuffer(replay, captured.soBuffer[i].pBuffer);
+        state.soBuffer[i].pWriteOffset = GetBuffer(replay, captured.soBuffer[i].pWriteOffset);
+        state.pfnSoFunc[i] = GetJitFunc(replay, captured.pfnSoFunc[i], context.isDrawable);
+    }
+
+    for (uint32_t rt = 0; rt < SWR_NUM_RENDERTARGETS; ++rt)
+    {
+        state.pfnBlendFunc[rt] = GetJitFunc(replay, captured.pfnBlendFunc[rt], context.isDrawable);
+    }
+    state.pfnFetchFunc = GetJitFunc(replay, captured.pfnFetchFunc, context.isDrawable);
+
+    state.pfnVertexFunc = captured.pfnVertexFunc ? ReplayVertexShader : nullptr;
+    state.pfnFetchVsFunc = nullptr;
+    state.psState.pfnPixelShader = captured.psState.pfnPixelShader ? ReplayPixelShader : nullptr;
+    state.pfnCsFunc = captured.pfnCsFunc ? ReplayComputeShader : nullptr;
+
+    state.pfnGsFunc = nullptr;
+    state.gsState.gsEnable = false;
+    state.pfnHsFunc = nullptr;
+    state.pfnDsFunc = nullptr;
+    state.tsState.tsEnable = false;
+
+    state.enableStats = replay.options.enableStats;
+}
+
+static void DestroyReplayContext(REPLAY& replay, REPLAY_CONTEXT& context)
+{
+    SwrWaitForIdle(context.hContext);
+
+    if (replay.options.enableStats)
+    {
+        SWR_STATS stats;
+        SwrGetStats(context.hContext, &stats);
+
+        uint64_t* pTotal = (uint64_t*)&replay.stats;
+        const uint64_t* pStats = (const uint64_t*)&stats;
+        for (uint32_t i = 0; i < offsetof(SWR_STATS, SoWriteOffset) / sizeof(uint64_t); ++i)
+        {
+            pTotal[i] += pStats[i];
+        }
+    }
+
+    SwrDestroyContext(context.hContext);
+    _aligned_free(context.pCapturedState);
+    _aligned_free(context.pState);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Replays all records of the capture once.
+static void ReplayCapture(REPLAY& replay)
+{
+    ForEachRecord(replay, [&](const SWR_CAPTURE_RECORD& record, uint8_t* pPayload)
+    {
+        if (record.op == SWR_CAPTURE_JIT_FUNCTION || record.op == SWR_CAPTURE_BUFFER)
+        {
+            return;
+        }
+
+        if (record.op == SWR_CAPTURE_CREATE_CONTEXT)
+        {
+            const SWR_CAPTURE_CREATE_ARGS& args = *(const SWR_CAPTURE_CREATE_ARGS*)pPayload;
+
+            SWR_CREATECONTEXT_INFO createInfo = {};
+            createInfo.driver = (DRIVER_TYPE)args.driver;
+            createInfo.privateStateSize = args.privateStateSize;
+            createInfo.pfnLoadTile = ReplayLoadTile;
+            createInfo.pfnStoreTile = ReplayStoreTile;
+            createInfo.pfnClearTile = ReplayClearTile;
+
+            REPLAY_CONTEXT& context = replay.contexts[record.context];
+            context.hContext = SwrCreateContext(&createInfo);
+            context.pCapturedState = (API_STATE*)_aligned_malloc(sizeof(API_STATE), 64);
+            context.pState = (API_STATE*)_aligned_malloc(sizeof(API_STATE), 64);
+            memset(context.pCapturedState, 0, sizeof(API_STATE));
+            context.isDrawable = true;
+            return;
+        }
+
+        auto found = replay.contexts.find(record.context);
+        if (found == replay.contexts.end())
+        {
+            return;
+        }
+
+        REPLAY_CONTEXT& context = found->second;
+        HANDLE hContext = context.hContext;
+
+        switch (record.op)
+        {
+        case SWR_CAPTURE_DESTROY_CONTEXT:
+            DestroyReplayContext(replay, context);
+            replay.contexts.erase(found);
+            break;
+
+        case SWR_CAPTURE_STATE:
+        {
+            uint8_t* pRun = pPayload;
+            while (pRun < pPayload + record.size)
+            {
+                const SWR_CAPTURE_STATE_RUN& run = *(const SWR_CAPTURE_STATE_RUN*)pRun;
+                memcpy((uint8_t*)context.pCapturedState + run.offset, pRun + sizeof(run), run.size);
+                pRun += sizeof(run) + run.size;
+            }
+
+            ResolveState(replay, context);
+            CaptureApplyState(hContext, *context.pState);
+            break;
+        }
+
+        case SWR_CAPTURE_DRAW:
+        case SWR_CAPTURE_DRAW_INDEXED:
+        {
+            const SWR_CAPTURE_DRAW_ARGS& args = *(const SWR_CAPTURE_DRAW_ARGS*)pPayload;
+            if (!context.isDrawable)
+            {
+                replay.numSkipped++;
+                break;
+            }
+
+            if (record.op == SWR_CAPTURE_DRAW)
+            {
+                SwrDrawInstanced(hContext, (PRIMITIVE_TOPOLOGY)args.topology, args.numVerts,
+                    args.numInstances, args.start, args.startInstance);
+            }
+            else
+            {
+                SwrDrawIndexedInstanced(hContext, (PRIMITIVE_TOPOLOGY)args.topology, args.numVerts,
+                    args.numInstances, args.start, args.baseVertex, args.startInstance);
+            }
+            replay.numSubmits++;
+            break;
+        }
+
+        case SWR_CAPTURE_DRAW_INDIRECT:
+        case SWR_CAPTURE_DRAW_INDEXED_INDIRECT:
+        {
+            const SWR_CAPTURE_INDIRECT_ARGS& args = *(const SWR_CAPTURE_INDIRECT_ARGS*)pPayload;
+            const void* pArgs = pPayload + sizeof(SWR_CAPTURE_INDIRECT_ARGS);
+            if (!context.isDrawable)
+            {
+                replay.numSkipped++;
+                break;
+            }
+
+            if (record.op == SWR_CAPTURE_DRAW_INDIRECT)
+            {
+                SwrDrawIndirect(hContext, (PRIMITIVE_TOPOLOGY)args.topology, pArgs, args.drawCount, args.stride);
+            }
+            else
+            {
+                SwrDrawIndexedIndirect(hContext, (PRIMITIVE_TOPOLOGY)args.topology, pArgs, args.drawCount, args.stride);
+            }
+            replay.numSubmits++;
+            break;
+        }
+
+        case SWR_CAPTURE_DISPATCH:
+        {
+            const SWR_CAPTURE_DISPATCH_ARGS& args = *(const SWR_CAPTURE_DISPATCH_ARGS*)pPayload;
+            SwrDispatch(hContext, args.threadGroupCountX, args.threadGroupCountY, args.threadGroupCountZ);
+            replay.numSubmits++;
+            break;
+        }
+
+        case SWR_CAPTURE_CLEAR:
+        {
+            const SWR_CAPTURE_CLEAR_ARGS& args = *(const SWR_CAPTURE_CLEAR_ARGS*)pPayload;
+            SwrClearRenderTarget(hContext, args.clearMask, args.clearColor, args.z, (BYTE)args.stencil);
+            replay.numSubmits++;
+            break;
+        }
+
+        case SWR_CAPTURE_STORE_TILES:
+        {
+            const SWR_CAPTURE_STORE_ARGS& args = *(const SWR_CAPTURE_STORE_ARGS*)pPayload;
+            SwrStoreTiles(hContext, (SWR_RENDERTARGET_ATTACHMENT)args.attachment,
+                (SWR_TILE_STATE)args.postStoreTileState);
+            replay.numSubmits++;
+            break;
+        }
+
+        case SWR_CAPTURE_INVALIDATE_TILES:
+            SwrInvalidateTiles(hContext, *(const uint32_t*)pPayload);
+            replay.numSubmits++;
+            break;
+
+        case SWR_CAPTURE_SYNC:
+            SwrSync(hContext, ReplaySync, 0, 0);
+            break;
+
+        case SWR_CAPTURE_WAIT_FOR_IDLE:
+            SwrWaitForIdle(hContext);
+            break;
+
+        case SWR_CAPTURE_END_FRAME:
+            SwrEndFrame(hContext);
+            replay.numFrames++;
+            break;
+        }
+    });
+
+    // contexts the capture didn't destroy
+    for (auto& context : replay.contexts)
+    {
+        DestroyReplayContext(replay, context.second);
+    }
+    replay.contexts.clear();
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+        "usage: swr_replay [options] <capture file>\n"
+        "  -i <n>          replay the capture n times\n"
+        "  -stats          enable and print pipeline statistics\n"
+        "  -numa <n>       use at most n NUMA nodes for worker threads\n"
+        "  -cores <n>      use at most n cores per NUMA node\n"
+        "  -ht <n>         use at most n hyper-threads per core\n"
+        "  -st             render on the API thread\n"
+        "  -toss <stage>   stop draws at draw, fe, fetch, ia, vs, setup, bin or rs\n"
+        "Captures are written by setting KNOB_CAPTURE_FILE. Other knobs are read\n"
+        "from the environment.\n");
+}
+
+static bool SetTossKnob(const char* pStage)
+{
+    if (!strcmp(pStage, "draw"))        SET_KNOB(TOSS_DRAW, true);
+    else if (!strcmp(pStage, "fe"))     SET_KNOB(TOSS_QUEUE_FE, true);
+    else if (!strcmp(pStage, "fetch"))  SET_KNOB(TOSS_FETCH, true);
+    else if (!strcmp(pStage, "ia"))     SET_KNOB(TOSS_IA, true);
+    else if (!strcmp(pStage, "vs"))     SET_KNOB(TOSS_VS, true);
+    else if (!strcmp(pStage, "setup"))  SET_KNOB(TOSS_SETUP_TRIS, true);
+    else if (!strcmp(pStage, "bin"))    SET_KNOB(TOSS_BIN_TRIS, true);
+    else if (!strcmp(pStage, "rs"))     SET_KNOB(TOSS_RS, true);
+    else return false;
+
+    return true;
+}
+
+static bool ParseOptions(int argc, char** argv, REPLAY_OPTIONS& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* pArg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (!strcmp(pArg, "-i") && hasValue)
+        {
+            options.numIterations = std::max(atoi(argv[++i]), 1);
+        }
+        else if (!strcmp(pArg, "-stats"))
+        {
+            options.enableStats = true;
+        }
+        else if (!strcmp(pArg, "-numa") && hasValue)
+        {
+            SET_KNOB(MAX_NUMA_NODES, (uint32_t)atoi(argv[++i]));
+        }
+        else if (!strcmp(pArg, "-cores") && hasValue)
+        {
+            SET_KNOB(MAX_CORES_PER_NUMA_NODE, (uint32_t)atoi(argv[++i]));
+        }
+        else if (!strcmp(pArg, "-ht") && hasValue)
+        {
+            SET_KNOB(MAX_THREADS_PER_CORE, (uint32_t)atoi(argv[++i]));
+        }
+        else if (!strcmp(pArg, "-st"))
+        {
+            SET_KNOB(SINGLE_THREADED, true);
+        }
+        else if (!strcmp(pArg, "-toss") && hasValue)
+        {
+            if (!SetTossKnob(argv[++i]))
+            {
+                return false;
+            }
+        }
+        else if (pArg[0] != '-' && options.pFilename == nullptr)
+        {
+            options.pFilename = pArg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.pFilename != nullptr;
+}
+
+static void PrintStats(const SWR_STATS& stats)
+{
+#define PRINT_STAT(name) printf("  %-16s %" PRIu64 "\n", #name, stats.name)
+    PRINT_STAT(IaVertices);
+    PRINT_STAT(IaPrimitives);
+    PRINT_STAT(VsInvocations);
+    PRINT_STAT(CInvocations);
+    PRINT_STAT(CPrimitives);
+    PRINT_STAT(PsInvocations);
+    PRINT_STAT(CsInvocations);
+    PRINT_STAT(DepthPassCount);
+    PRINT_STAT(DrawsMerged);
+#undef PRINT_STAT
+}
+
+int main(int argc, char** argv)
+{
+    REPLAY replay = {};
+
+    if (!ParseOptions(argc, argv, replay.options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    // don't capture the replay
+    SET_KNOB(CAPTURE_FILE, std::string());
+
+    if (!LoadCapture(replay))
+    {
+        return 1;
+    }
+
+    PrepareCapture(replay);
+
+    double totalMs = 0.0;
+    double minMs = 0.0;
+    for (uint32_t i = 0; i < replay.options.numIterations; ++i)
+    {
+        replay.numFrames = 0;
+        replay.numSubmits = 0;
+        replay.numSkipped = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ReplayCapture(replay);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        totalMs += ms;
+        minMs = (i == 0) ? ms : std::min(minMs, ms);
+
+        printf("iteration %u: %.3f ms\n", i, ms);
+    }
+
+    uint32_t numFrames = std::max(replay.numFrames, 1u);
+    printf("%u frames, %u submissions, %u draws skipped\n", replay.numFrames, replay.numSubmits, replay.numSkipped);
+    printf("average %.3f ms, best %.3f ms, best %.3f ms/frame\n",
+        totalMs / replay.options.numIterations, minMs, minMs / numFrames);
+
+    if (replay.options.enableStats)
+    {
+        printf("pipeline statistics, all iterations:\n");
+        PrintStats(replay.stats);
+    }
+
+    _aligned_free(replay.pCapture);
+    return 0;
+}
@@ -0,0 +1,221 @@
+/****************************************************************************
+* Copyright (C) 2014-2016 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file swr_tile_bench.cpp
+*
+* @brief Measures hot tile load and store bandwidth for linear color surfaces.
+*
+*        Every macrotile of a surface larger than the caches is loaded into,
+*        or stored from, one hot tile, walking the macrotiles in row order
+*        and in column order. Loads are measured with and without
+*        KNOB_PREFETCH_LOAD_TILES, stores with and without
+*        KNOB_STREAMING_STORE_TILES. Bandwidth counts surface bytes only.
+*
+******************************************************************************/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "core/context.h"
+#include "memory/TilingFunctions.h"
+
+void LoadHotTile(
+    SWR_SURFACE_STATE *pSrcSurface,
+    SWR_FORMAT dstFormat,
+    SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+    uint8_t *pDstHotTile);
+
+void StoreHotTile(
+    SWR_SURFACE_STATE *pDstSurface,
+    SWR_FORMAT srcFormat,
+    SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+    uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+    uint32_t numSamples, uint8_t *pSrcHotTile);
+
+void InitSimLoadTilesTable();
+void InitSimStoreTilesTable();
+
+struct TILE_BENCH_OPTIONS
+{
+    uint32_t width{ 2048 };
+    uint32_t height{ 2048 };
+    uint32_t numPasses{ 8 };            // full surface walks per measurement
+};
+
+enum TILE_BENCH_ORDER
+{
+    TILE_BENCH_ROW_ORDER,               // macrotiles left to right, then down
+    TILE_BENCH_COLUMN_ORDER,            // macrotiles top to bottom, then right
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Loads or stores every macrotile of the surface numPasses times.
+/// @return surface GB/s.
+template <bool IsStoreT>
+static double RunSurface(SWR_SURFACE_STATE* pSurface, uint8_t* pHotTile,
+    TILE_BENCH_ORDER order, const TILE_BENCH_OPTIONS& options)
+{
+    const uint32_t numTilesX = (pSurface->width + KNOB_MACROTILE_X_DIM - 1) / KNOB_MACROTILE_X_DIM;
+    const uint32_t numTilesY = (pSurface->height + KNOB_MACROTILE_Y_DIM - 1) / KNOB_MACROTILE_Y_DIM;
+    const uint32_t numTiles = numTilesX * numTilesY;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t pass = 0; pass < options.numPasses; ++pass)
+    {
+        for (uint32_t t = 0; t < numTiles; ++t)
+        {
+            uint32_t tileX = (order == TILE_BENCH_ROW_ORDER) ? t % numTilesX : t / numTilesY;
+            uint32_t tileY = (order == TILE_BENCH_ROW_ORDER) ? t / numTilesX : t % numTilesY;
+            uint32_t x = tileX * KNOB_MACROTILE_X_DIM;
+            uint32_t y = tileY * KNOB_MACROTILE_Y_DIM;
+
+            if (IsStoreT)
+            {
+                StoreHotTile(pSurface, KNOB_COLOR_HOT_TILE_FORMAT, SWR_ATTACHMENT_COLOR0, x, y, 0, 1, pHotTile);
+            }
+            else
+            {
+                LoadHotTile(pSurface, KNOB_COLOR_HOT_TILE_FORMAT, SWR_ATTACHMENT_COLOR0, x, y, 0, pHotTile);
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double bytes = (double)pSurface->pitch * pSurface->height * options.numPasses;
+    return bytes / std::chrono::duration<double>(end - start).count() / 1e9;
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+        "usage: swr_tile_bench [options]\n"
+        "  -width <n>      surface width (default 2048)\n"
+        "  -height <n>     surface height (default 2048)\n"
+        "  -passes <n>     surface walks per measurement (default 8)\n"
+        "Prints surface GB/s of hot tile loads and stores per format.\n");
+}
+
+static bool ParseOptions(int argc, char** argv, TILE_BENCH_OPTIONS& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* pArg = argv[i];
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        uint32_t value = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        if (value == 0)                     return false;
+        else if (!strcmp(pArg, "-width"))   options.width = value;
+        else if (!strcmp(pArg, "-height"))  options.height = value;
+        else if (!strcmp(pArg, "-passes"))  options.numPasses = value;
+        else return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    TILE_BENCH_OPTIONS options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    InitSimLoadTilesTable();
+    InitSimStoreTilesTable();
+
+    const uint32_t hotTileBytes = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * (FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8);
+    uint8_t* pHotTile = (uint8_t*)_aligned_malloc(hotTileBytes, KNOB_SIMD_WIDTH * 4);
+    memset(pHotTile, 0x3c, hotTileBytes);
+
+    static const struct
+    {
+        const char* pName;
+        SWR_FORMAT format;
+    } formats[] =
+    {
+        { "RGBA8_UNORM",    R8G8B8A8_UNORM },
+        { "BGRA8_UNORM",    B8G8R8A8_UNORM },
+        { "RGBA16_FLOAT",   R16G16B16A16_FLOAT },
+        { "RGBA32_FLOAT",   R32G32B32A32_FLOAT },
+    };
+
+    static const struct
+    {
+        const char* pName;
+        TILE_BENCH_ORDER order;
+    } orders[] =
+    {
+        { "rows",           TILE_BENCH_ROW_ORDER },
+        { "columns",        TILE_BENCH_COLUMN_ORDER },
+    };
+
+    const bool prefetch = KNOB_PREFETCH_LOAD_TILES;
+    const bool streaming = KNOB_STREAMING_STORE_TILES;
+
+    printf("%-14s %-8s %10s %10s %10s %10s\n", "format", "order", "load", "prefetch", "store", "streaming");
+    for (const auto& f : formats)
+    {
+        SWR_SURFACE_STATE surface = {};
+        surface.type = SURFACE_2D;
+        surface.format = f.format;
+        surface.width = options.width;
+        surface.height = options.height;
+        surface.depth = 1;
+        surface.numSamples = 1;
+        surface.pitch = options.width * GetFormatInfo(f.format).Bpp;
+        surface.qpitch = options.height;
+        surface.tileMode = SWR_TILE_NONE;
+        surface.pBaseAddress = (uint8_t*)_aligned_malloc(surface.pitch * surface.height, 4096);
+        memset(surface.pBaseAddress, 0x5a, surface.pitch * surface.height);
+
+        for (const auto& o : orders)
+        {
+            SET_KNOB(PREFETCH_LOAD_TILES, false);
+            double load = RunSurface<false>(&surface, pHotTile, o.order, options);
+            SET_KNOB(PREFETCH_LOAD_TILES, true);
+            double loadPrefetch = RunSurface<false>(&surface, pHotTile, o.order, options);
+
+            SET_KNOB(STREAMING_STORE_TILES, false);
+            double store = RunSurface<true>(&surface, pHotTile, o.order, options);
+            SET_KNOB(STREAMING_STORE_TILES, true);
+            double storeStreaming = RunSurface<true>(&surface, pHotTile, o.order, options);
+
+            printf("%-14s %-8s %10.2f %10.2f %10.2f %10.2f\n", f.pName, o.pName,
+                load, loadPrefetch, store, storeStreaming);
+        }
+
+        _aligned_free(surface.pBaseAddress);
+    }
+
+    SET_KNOB(PREFETCH_LOAD_TILES, prefetch);
+    SET_KNOB(STREAMING_STORE_TILES, streaming);
+
+    _aligned_free(pHotTile);
+    return 0;
+}
@@ -35,6 +35,39 @@ KNOBS = [
                        'Will be slightly slower than using optimized (jitted) path'],
     }],
 
+    ['STREAMING_STORE_TILES', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Use non-temporal stores when storing hot tiles to linear surfaces',
+                       'whose raster tile rows fill whole cache lines (64bpp and wider).',
+                       'Stored tiles bypass the worker caches. swr_tile_bench measures',
+                       'the store bandwidth with the knob on and off.'],
+    }],
+
+    ['PREFETCH_LOAD_TILES', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['Prefetch the macrotile below into L2 while loading a hot tile',
+                       'from a linear surface. Hot tile loads are bound by format',
+                       'conversion, and swr_tile_bench shows no gain from it.'],
+    }],
+
+    ['FUSED_FETCH_VS', {
+        'type'      : 'bool',
+        'default'   : 'false',
+        'desc'      : ['JIT fetch and vertex shader into a single function per',
+                       '(vertex elements, vertex shader) pair. Vertex inputs stay in',
+                       'registers and elements the shader does not read are not fetched.'],
+    }],
+
+    ['STRIP_BATCH_ASSEMBLY', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Assemble a full SIMD of triangle or line strip prims in one',
+                       'step when the next verts have no cut indices. Output is identical',
+                       'to the per-vertex path. swr_pa_bench measures both paths.'],
+    }],
+
     ['SINGLE_THREADED', {
         'type'      : 'bool',
         'default'   : 'false',
@@ -46,7 +79,27 @@ KNOBS = [
         'type'      : 'bool',
         'default'   : 'true',
         'desc'      : ['Replace 3D primitive execute with a SWRClearRT operation and',
-                       'defer clear execution to first backend op on hottile, or hottile store'],
+                       'defer clear execution to first backend op on hottile, or hottile store.',
+                       'Macrotiles fully covered by the clear only record the clear value; tiles',
+                       'never rendered to afterwards are written straight to the surface on store.'],
+    }],
+
+    ['HOT_TILE_BUDGET_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '256',
+        'desc'      : ['Hot tile memory, in MB, a context keeps across frames.',
+                       'At SwrEndFrame resolved hot tiles are freed, least recently',
+                       'used first, until the context is within budget.',
+                       '  0 == No limit'],
+    }],
+
+    ['MAX_HOT_TILE_SLICES', {
+        'type'      : 'uint32_t',
+        'default'   : '6',
+        'desc'      : ['Maximum # of render target array slices kept resident per',
+                       'macrotile and attachment for layered rendering. Switching to a',
+                       'resident slice does not store or load the hot tile.',
+                       'The default covers the six faces of a cube map.'],
     }],
 
     ['MAX_NUMA_NODES', {
@@ -57,6 +110,14 @@ KNOBS = [
                        '  N == Use at most N NUMA-nodes for rendering'],
     }],
 
+    ['EMULATE_NUMA_NODES', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Split the cores into N emulated NUMA-nodes for worker threads.',
+                       'Exercises scheduling across NUMA-nodes on hosts with fewer nodes.',
+                       '  0 == Use the NUMA-nodes of the system'],
+    }],
+
     ['MAX_CORES_PER_NUMA_NODE', {
         'type'      : 'uint32_t',
         'default'   : '0',
@@ -86,6 +147,7 @@ KNOBS = [
         'type'      : 'uint32_t',
         'default'   : '1400',
         'desc'      : ['Frame at which to stop saving buckets data.',
+                       'Ignored if BUCKETS_START_FRAME is 0.',
                        '',
                        'NOTE: KNOB_ENABLE_RDTSC must be enabled in core/knobs.h',
                        'for this to have an effect.'],
@@ -97,6 +159,31 @@ KNOBS = [
         'desc'      : ['Enable threadviz output.'],
     }],
 
+    ['BUCKETS_TRACE_EVENTS', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Number of bucket events each thread keeps for trace export.',
+                       'Captured events are written to rdtsc_trace.json in Chrome',
+                       'trace format (chrome://tracing, Perfetto), tagged with draw',
+                       'and macrotile ids. Only the most recent N per thread are kept.',
+                       'Set BUCKETS_START_FRAME to 0 to capture continuously until',
+                       'the last context is destroyed.',
+                       '  0 == trace export disabled',
+                       '',
+                       'NOTE: KNOB_ENABLE_RDTSC must be enabled in core/knobs.h',
+                       'for this to have an effect.'],
+    }],
+
+    ['CAPTURE_FILE', {
+        'type'      : 'std::string',
+        'default'   : '""',
+        'desc'      : ['Record the API calls, state and buffers of all contexts to this',
+                       'file, for replay with swr_replay. Capturing waits for streamout',
+                       'and compute results before reading buffers, so it serializes',
+                       'those draws.',
+                       '  "" == capture disabled'],
+    }],
+
     ['TOSS_DRAW', {
         'type'      : 'bool',
         'default'   : 'false',
@@ -164,14 +251,34 @@ KNOBS = [
     ['WORKER_SPIN_LOOP_COUNT', {
         'type'      : 'uint32_t',
         'default'   : '5000',
-        'desc'      : ['Number of spin-loop iterations worker threads will perform',
-                       'before going to sleep when waiting for work'],
+        'desc'      : ['Maximum number of spin-loop iterations worker threads will perform',
+                       'before going to sleep when waiting for work. Workers spin less',
+                       'when work recently arrived further apart than this.'],
     }],
 
     ['MAX_DRAWS_IN_FLIGHT', {
         'type'      : 'uint32_t',
-        'default'   : '160',
-        'desc'      : ['Maximum number of draws outstanding before API thread blocks.'],
+        'default'   : '2048',
+        'desc'      : ['Maximum number of draws outstanding before API thread blocks.',
+                       'A draw context releases its arena memory when its draw retires,',
+                       'and a draw state once its last draw retires and a newer state',
+                       'has replaced it. The rings themselves are allocated up front,',
+                       'one draw context and one draw state per entry.',
+                       'See SwrGetDrawRingStats for occupancy and API thread stalls.'],
+    }],
+
+    ['MAX_DRAWS_PER_BATCH', {
+       'type'       : 'uint32_t',
+       'default'    : '64',
+       'desc'       : ['Maximum number of consecutive small draws with identical state',
+                       'merged into one draw context. 0 or 1 disables draw batching.'],
+    }],
+
+    ['MAX_BATCHED_DRAW_VERTS', {
+       'type'       : 'uint32_t',
+       'default'    : '96',
+       'desc'       : ['Draws with at most this many vertices (across all instances)',
+                       'are candidates for draw batching.'],
     }],
 
     ['MAX_PRIMS_PER_DRAW', {
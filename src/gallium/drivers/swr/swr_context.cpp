@@ -30,6 +30,8 @@ extern "C" {
 #include "util/u_surface.h"
 }
 
+#include "gallivm/lp_bld_sample.h"
+
 #include "swr_context.h"
 #include "swr_memory.h"
 #include "swr_screen.h"
@@ -119,6 +121,158 @@ swr_surface_destroy(struct pipe_context *pipe, struct pipe_surface *surf)
 }
 
 
+/*
+ * If the resource is an attached rendertarget, store its tiles and wait for
+ * idle so the CPU sees the rendered contents.
+ */
+static void
+swr_store_attached_resource(struct swr_context *ctx,
+                            struct swr_resource *spr,
+                            enum SWR_TILE_STATE post_tile_state)
+{
+   if (!(spr->base.bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL
+                           | PIPE_BIND_DISPLAY_TARGET)))
+      return;
+
+   for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++)
+      if (ctx->current.attachment[i] == &spr->swr) {
+         swr_store_render_target(ctx, i, post_tile_state);
+         /*
+          * Mesa thinks depth/stencil are fused, so we'll never get an
+          * explicit access for stencil.  So, if storing depth, then also
+          * store tile for stencil.
+          */
+         if (spr->has_stencil && (i == SWR_ATTACHMENT_DEPTH))
+            swr_store_render_target(
+               ctx, SWR_ATTACHMENT_STENCIL, post_tile_state);
+         SwrWaitForIdle(ctx->swrContext);
+         break;
+      }
+}
+
+/*
+ * Tiled resources can't be mapped directly.  Their transfers map a linear
+ * staging copy of the box instead, (de)tiled on map and unmap.
+ */
+struct swr_transfer {
+   struct pipe_transfer base;
+   uint8_t *staging;
+};
+
+/*
+ * Byte offset of x_bytes, y in a slice stored in the LP_TILE_* layout.
+ */
+static unsigned
+swr_tiled_offset(unsigned row_stride, unsigned x_bytes, unsigned y)
+{
+   const unsigned tile_size = LP_TILE_WIDTH_BYTES * LP_TILE_HEIGHT;
+   const unsigned column_size = LP_TILE_COLUMN_BYTES * LP_TILE_HEIGHT;
+
+   return (y / LP_TILE_HEIGHT) * row_stride * LP_TILE_HEIGHT
+      + (x_bytes / LP_TILE_WIDTH_BYTES) * tile_size
+      + (x_bytes % LP_TILE_WIDTH_BYTES) / LP_TILE_COLUMN_BYTES * column_size
+      + (y % LP_TILE_HEIGHT) * LP_TILE_COLUMN_BYTES
+      + x_bytes % LP_TILE_COLUMN_BYTES;
+}
+
+/*
+ * Copy a box of a tiled resource level between its tiles and a linear
+ * buffer, one tile column span at a time.
+ */
+static void
+swr_copy_tiled_box(struct swr_resource *spr,
+                   unsigned level,
+                   const struct pipe_box *box,
+                   uint8_t *linear,
+                   unsigned stride,
+                   unsigned layer_stride,
+                   bool to_tiles)
+{
+   const unsigned Bpp = util_format_get_blocksize(spr->base.format);
+   const unsigned row_stride = spr->row_stride[level];
+   const unsigned x_begin = box->x * Bpp;
+   const unsigned x_end = (box->x + box->width) * Bpp;
+
+   for (int z = 0; z < box->depth; z++) {
+      uint8_t *slice = spr->swr.pBaseAddress + spr->mip_offsets[level]
+         + (box->z + z) * spr->img_stride[level];
+
+      for (int y = 0; y < box->height; y++) {
+         uint8_t *row = linear + z * layer_stride + y * stride;
+
+         for (unsigned x_bytes = x_begin; x_bytes < x_end;) {
+            unsigned span = MIN2(
+               LP_TILE_COLUMN_BYTES - x_bytes % LP_TILE_COLUMN_BYTES,
+               x_end - x_bytes);
+            uint8_t *texels =
+               slice + swr_tiled_offset(row_stride, x_bytes, box->y + y);
+
+            if (to_tiles)
+               memcpy(texels, row, span);
+            else
+               memcpy(row, texels, span);
+
+            row += span;
+            x_bytes += span;
+         }
+      }
+   }
+}
+
+/*
+ * Move the stencil of a Z24S8 box between the separate R8 stencil surface
+ * the rasterizer uses and the top byte of the mapped depth texels,
+ * 16 texels at a time.  Only level 0 has stencil.
+ */
+static void
+swr_copy_stencil_box(struct swr_resource *res,
+                     const struct pipe_box *box,
+                     bool to_secondary)
+{
+   const __m128i depth_mask = _mm_set1_epi32(0x00FFFFFF);
+   const __m128i zero = _mm_setzero_si128();
+
+   for (int y = box->y; y < box->y + box->height; y++) {
+      uint8_t *zs = res->swr.pBaseAddress + y * res->swr.pitch + box->x * 4;
+      uint8_t *s = res->secondary.pBaseAddress + y * res->secondary.pitch
+         + box->x;
+      int x = 0;
+
+      if (to_secondary) {
+         for (; x + 16 <= box->width; x += 16) {
+            __m128i *src = (__m128i *)(zs + 4 * x);
+            __m128i v0 = _mm_srli_epi32(_mm_loadu_si128(src + 0), 24);
+            __m128i v1 = _mm_srli_epi32(_mm_loadu_si128(src + 1), 24);
+            __m128i v2 = _mm_srli_epi32(_mm_loadu_si128(src + 2), 24);
+            __m128i v3 = _mm_srli_epi32(_mm_loadu_si128(src + 3), 24);
+            __m128i lo = _mm_packs_epi32(v0, v1);
+            __m128i hi = _mm_packs_epi32(v2, v3);
+            _mm_storeu_si128((__m128i *)(s + x), _mm_packus_epi16(lo, hi));
+         }
+         for (; x < box->width; x++)
+            s[x] = zs[4 * x + 3];
+      } else {
+         for (; x + 16 <= box->width; x += 16) {
+            __m128i st = _mm_loadu_si128((__m128i *)(s + x));
+            __m128i lo = _mm_unpacklo_epi8(st, zero);
+            __m128i hi = _mm_unpackhi_epi8(st, zero);
+            __m128i sv[4] = {_mm_unpacklo_epi16(lo, zero),
+                             _mm_unpackhi_epi16(lo, zero),
+                             _mm_unpacklo_epi16(hi, zero),
+                             _mm_unpackhi_epi16(hi, zero)};
+            __m128i *dst = (__m128i *)(zs + 4 * x);
+            for (int i = 0; i < 4; i++) {
+               __m128i z = _mm_and_si128(_mm_loadu_si128(dst + i), depth_mask);
+               _mm_storeu_si128(dst + i,
+                                _mm_or_si128(z, _mm_slli_epi32(sv[i], 24)));
+            }
+         }
+         for (; x < box->width; x++)
+            zs[4 * x + 3] = s[x];
+      }
+   }
+}
+
 static void *
 swr_transfer_map(struct pipe_context *pipe,
                  struct pipe_resource *resource,
@@ -128,6 +282,7 @@ swr_transfer_map(struct pipe_context *pipe,
                  struct pipe_transfer **transfer)
 {
    struct swr_resource *spr = swr_resource(resource);
+   struct swr_transfer *st;
    struct pipe_transfer *pt;
    enum pipe_format format = resource->format;
 
@@ -139,42 +294,53 @@ swr_transfer_map(struct pipe_context *pipe,
     * before giving CPU access to the surface.
     * (set postStoreTileState to SWR_TILE_INVALID so tiles are reloaded)
     */
-   if (resource->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL
-                         | PIPE_BIND_DISPLAY_TARGET)) {
-      struct swr_context *ctx = swr_context(pipe);
-      for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++)
-         if (ctx->current.attachment[i] == &spr->swr) {
-            swr_store_render_target(ctx, i, SWR_TILE_INVALID);
-            /*
-             * Mesa thinks depth/stencil are fused, so we'll never get an
-             * explicit map for stencil.  So, if mapping depth, then also
-             * store tile for stencil.
-             */
-            if (spr->has_stencil && (i == SWR_ATTACHMENT_DEPTH))
-               swr_store_render_target(
-                  ctx, SWR_ATTACHMENT_STENCIL, SWR_TILE_INVALID);
-            SwrWaitForIdle(ctx->swrContext);
-            break;
-         }
-   }
+   swr_store_attached_resource(swr_context(pipe), spr, SWR_TILE_INVALID);
 
 
-   pt = CALLOC_STRUCT(pipe_transfer);
-   if (!pt)
+   bool tiled = spr->swr.tileMode != SWR_TILE_NONE;
+   if (tiled && (usage & PIPE_TRANSFER_MAP_DIRECTLY))
+      return NULL;
+
+   st = CALLOC_STRUCT(swr_transfer);
+   if (!st)
       return NULL;
+   pt = &st->base;
    pipe_resource_reference(&pt->resource, resource);
    pt->level = level;
+   pt->usage = (enum pipe_transfer_usage)usage;
    pt->box = *box;
+
+   if (tiled) {
+      pt->stride = box->width * util_format_get_blocksize(format);
+      pt->layer_stride = pt->stride * box->height;
+
+      st->staging = (uint8_t *)MALLOC(pt->layer_stride * box->depth);
+      if (!st->staging) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(st);
+         return NULL;
+      }
+
+      /* partial writes need the rest of the box */
+      if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+         swr_copy_tiled_box(spr, level, box, st->staging,
+                            pt->stride, pt->layer_stride, false);
+
+      *transfer = pt;
+      return st->staging;
+   }
+
    pt->stride = spr->row_stride[level];
    pt->layer_stride = spr->img_stride[level];
 
-   /* if we're mapping the depth/stencil, copy in stencil */
+   /* if we're mapping the depth/stencil, copy in stencil for the box,
+    * unless the caller is going to overwrite it */
    if (spr->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && spr->has_stencil) {
-      for (unsigned i = 0; i < spr->alignedWidth * spr->alignedHeight; i++) {
-         spr->swr.pBaseAddress[4 * i + 3] = spr->secondary.pBaseAddress[i];
-      }
-   }
+       && spr->has_stencil && level == 0
+       && !(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+      swr_copy_stencil_box(spr, box, false);
 
    unsigned offset = box->z * pt->layer_stride + box->y * pt->stride
       + box->x * util_format_get_blocksize(format);
@@ -199,14 +365,29 @@ swr_transfer_unmap(struct pipe_context *pipe, struct pipe_transfer *transfer)
    struct swr_resource *res = swr_resource(transfer->resource);
    res->bound_to_context = (void *)pipe;
 
-   /* if we're mapping the depth/stencil, copy out stencil */
-   if (res->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && res->has_stencil) {
-      for (unsigned i = 0; i < res->alignedWidth * res->alignedHeight; i++) {
-         res->secondary.pBaseAddress[i] = res->swr.pBaseAddress[4 * i + 3];
-      }
+   if ((transfer->usage & PIPE_TRANSFER_WRITE) && transfer->level == 0) {
+      struct u_rect damage = {transfer->box.x,
+                              transfer->box.x + transfer->box.width,
+                              transfer->box.y,
+                              transfer->box.y + transfer->box.height};
+      swr_resource_damage(res, &damage);
+   }
+
+   struct swr_transfer *st = (struct swr_transfer *)transfer;
+   if (st->staging) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         swr_copy_tiled_box(res, transfer->level, &transfer->box, st->staging,
+                            transfer->stride, transfer->layer_stride, true);
+      FREE(st->staging);
    }
 
+   /* if we're mapping the depth/stencil, copy out stencil the caller
+    * may have written */
+   if (res->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
+       && res->has_stencil && transfer->level == 0
+       && (transfer->usage & PIPE_TRANSFER_WRITE))
+      swr_copy_stencil_box(res, &transfer->box, true);
+
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
 }
@@ -234,6 +415,93 @@ swr_resource_copy(struct pipe_context *pipe,
 }
 
 
+/*
+ * Resolve one attachment: each macrotile of the source is loaded into a
+ * multisampled hot tile, which the store path resolves with SIMD box
+ * filtering on its way to the single sampled destination.
+ */
+static void
+swr_resolve_attachment(SWR_SURFACE_STATE *src,
+                       SWR_SURFACE_STATE *dst,
+                       SWR_RENDERTARGET_ATTACHMENT attachment,
+                       SWR_FORMAT hot_tile_format,
+                       unsigned width, unsigned height)
+{
+   unsigned hot_tile_size = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM
+      * GetFormatInfo(hot_tile_format).Bpp * src->numSamples;
+   BYTE *hot_tile = (BYTE *)_aligned_malloc(hot_tile_size, 64);
+
+   for (unsigned y = 0; y < height; y += KNOB_MACROTILE_Y_DIM)
+      for (unsigned x = 0; x < width; x += KNOB_MACROTILE_X_DIM) {
+         LoadHotTile(src, hot_tile_format, attachment, x, y, 0, hot_tile);
+         StoreHotTile(dst, hot_tile_format, attachment, x, y, 0,
+                      src->numSamples, hot_tile);
+      }
+
+   _aligned_free(hot_tile);
+}
+
+/*
+ * Multisample resolve without the blitter. Handles the full surface,
+ * unscaled resolves the state tracker issues for framebuffer blits.
+ * Returns false if the blit has to go through another path.
+ */
+static bool
+swr_resolve(struct swr_context *ctx, const struct pipe_blit_info *info)
+{
+   struct swr_resource *src = swr_resource(info->src.resource);
+   struct swr_resource *dst = swr_resource(info->dst.resource);
+
+   if (info->src.format != src->base.format
+       || info->dst.format != dst->base.format
+       || util_format_description(src->base.format)->colorspace
+          != util_format_description(dst->base.format)->colorspace
+       || info->scissor_enable
+       || info->src.level != 0 || info->dst.level != 0
+       || info->src.box.z != 0 || info->dst.box.z != 0
+       || info->src.box.depth != 1 || info->dst.box.depth != 1)
+      return false;
+
+   /* Whole macrotiles are written, so only full surface resolves between
+    * equally sized, macrotile aligned resources are handled here. */
+   if (info->src.box.x != 0 || info->src.box.y != 0
+       || info->dst.box.x != 0 || info->dst.box.y != 0
+       || info->src.box.width != (int)src->base.width0
+       || info->src.box.height != (int)src->base.height0
+       || info->dst.box.width != (int)dst->base.width0
+       || info->dst.box.height != (int)dst->base.height0
+       || src->alignedWidth != dst->alignedWidth
+       || src->alignedHeight != dst->alignedHeight
+       || !(dst->base.bind & (PIPE_BIND_RENDER_TARGET
+                              | PIPE_BIND_DEPTH_STENCIL
+                              | PIPE_BIND_DISPLAY_TARGET)))
+      return false;
+
+   swr_store_attached_resource(ctx, src, SWR_TILE_RESOLVED);
+   swr_store_attached_resource(ctx, dst, SWR_TILE_INVALID);
+
+   swr_resource_damage_all(dst);
+
+   if (info->mask & PIPE_MASK_RGBA)
+      swr_resolve_attachment(&src->swr, &dst->swr, SWR_ATTACHMENT_COLOR0,
+                             KNOB_COLOR_HOT_TILE_FORMAT,
+                             src->alignedWidth, src->alignedHeight);
+   if ((info->mask & PIPE_MASK_Z) && src->has_depth)
+      swr_resolve_attachment(&src->swr, &dst->swr, SWR_ATTACHMENT_DEPTH,
+                             KNOB_DEPTH_HOT_TILE_FORMAT,
+                             src->alignedWidth, src->alignedHeight);
+   if ((info->mask & PIPE_MASK_S) && src->has_stencil)
+      swr_resolve_attachment(src->has_depth ? &src->secondary : &src->swr,
+                             dst->has_depth ? &dst->secondary : &dst->swr,
+                             SWR_ATTACHMENT_STENCIL,
+                             KNOB_STENCIL_HOT_TILE_FORMAT,
+                             src->alignedWidth, src->alignedHeight);
+
+   dst->bound_to_context = (void *)&ctx->pipe;
+
+   return true;
+}
+
 static void
 swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
 {
@@ -243,10 +511,12 @@ swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
    if (blit_info->render_condition_enable && !swr_check_render_cond(pipe))
       return;
 
-   if (info.src.resource->nr_samples > 1 && info.dst.resource->nr_samples <= 1
-       && !util_format_is_depth_or_stencil(info.src.resource->format)
-       && !util_format_is_pure_integer(info.src.resource->format)) {
-      debug_printf("swr: color resolve unimplemented\n");
+   if (info.src.resource->nr_samples > 1
+       && info.dst.resource->nr_samples <= 1) {
+      if (!swr_resolve(ctx, &info))
+         debug_printf("swr: unsupported resolve %s -> %s\n",
+                      util_format_short_name(info.src.resource->format),
+                      util_format_short_name(info.dst.resource->format));
       return;
    }
 
@@ -271,7 +541,7 @@ swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
    util_blitter_save_vertex_buffer_slot(ctx->blitter, ctx->vertex_buffer);
    util_blitter_save_vertex_elements(ctx->blitter, (void *)ctx->velems);
    util_blitter_save_vertex_shader(ctx->blitter, (void *)ctx->vs);
-   /*util_blitter_save_geometry_shader(ctx->blitter, (void*)ctx->gs);*/
+   util_blitter_save_geometry_shader(ctx->blitter, (void *)ctx->gs);
    util_blitter_save_so_targets(
       ctx->blitter,
       ctx->num_so_targets,
@@ -315,6 +585,7 @@ swr_destroy(struct pipe_context *pipe)
       SwrDestroyContext(ctx->swrContext);
 
    delete ctx->blendJIT;
+   delete ctx->soJIT;
 
    swr_destroy_scratch_buffers(ctx);
 
@@ -342,6 +613,8 @@ swr_create_context(struct pipe_screen *screen, void *priv)
    struct swr_context *ctx = CALLOC_STRUCT(swr_context);
    ctx->blendJIT =
       new std::unordered_map<BLEND_COMPILE_STATE, PFN_BLEND_JIT_FUNC>;
+   ctx->soJIT =
+      new std::unordered_map<STREAMOUT_COMPILE_STATE, PFN_SO_FUNC>;
 
    SWR_CREATECONTEXT_INFO createInfo;
    createInfo.driver = GL;
@@ -47,7 +47,9 @@
 #define SWR_NEW_FRAMEBUFFER (1 << 13)
 #define SWR_NEW_CLIP (1 << 14)
 #define SWR_NEW_SO (1 << 15)
-#define SWR_NEW_ALL 0x0000ffff
+#define SWR_NEW_GS (1 << 16)
+#define SWR_NEW_GSCONSTANTS (1 << 17)
+#define SWR_NEW_ALL 0x0003ffff
 
 namespace std
 {
@@ -57,6 +59,20 @@ template <> struct hash<BLEND_COMPILE_STATE> {
       return util_hash_crc32(&k, sizeof(k));
    }
 };
+
+template <> struct hash<STREAMOUT_COMPILE_STATE> {
+   std::size_t operator()(const STREAMOUT_COMPILE_STATE &k) const
+   {
+      /* only hash what operator== compares */
+      uint32_t hash = k.numVertsPerPrim ^ (k.stream.numDecls << 8);
+      for (uint32_t i = 0; i < k.stream.numDecls; i++) {
+         const STREAMOUT_DECL &decl = k.stream.decl[i];
+         hash = hash * 31 + (decl.bufferIndex ^ (decl.attribSlot << 2)
+                             ^ (decl.componentMask << 10) ^ (decl.hole << 14));
+      }
+      return hash;
+   }
+};
 };
 
 struct swr_context {
@@ -71,6 +87,7 @@ struct swr_context {
    struct pipe_rasterizer_state *rasterizer;
 
    struct swr_vertex_shader *vs;
+   struct swr_geometry_shader *gs;
    struct swr_fragment_shader *fs;
    struct swr_vertex_element_state *velems;
 
@@ -114,6 +131,9 @@ struct swr_context {
    // blend jit functions
    std::unordered_map<BLEND_COMPILE_STATE, PFN_BLEND_JIT_FUNC> *blendJIT;
 
+   // streamout jit functions, shared by shaders with matching outputs
+   std::unordered_map<STREAMOUT_COMPILE_STATE, PFN_SO_FUNC> *soJIT;
+
    /* Shadows of current SWR API DrawState */
    struct swr_shadow_state current;
 
@@ -144,6 +164,8 @@ struct swr_draw_context {
    unsigned num_constantsVS[PIPE_MAX_CONSTANT_BUFFERS];
    const float *constantFS[PIPE_MAX_CONSTANT_BUFFERS];
    unsigned num_constantsFS[PIPE_MAX_CONSTANT_BUFFERS];
+   const float *constantGS[PIPE_MAX_CONSTANT_BUFFERS];
+   unsigned num_constantsGS[PIPE_MAX_CONSTANT_BUFFERS];
 
    swr_jit_texture texturesVS[PIPE_MAX_SHADER_SAMPLER_VIEWS];
    swr_jit_sampler samplersVS[PIPE_MAX_SAMPLERS];
@@ -160,6 +182,13 @@ swr_context(struct pipe_context *pipe)
    return (struct swr_context *)pipe;
 }
 
+/* Info of the last stage before rasterization (GS if bound, else VS) */
+static INLINE struct tgsi_shader_info *
+swr_last_vertex_stage_info(struct swr_context *ctx)
+{
+   return ctx->gs ? &ctx->gs->info.base : &ctx->vs->info.base;
+}
+
 struct pipe_context *swr_create_context(struct pipe_screen *, void *priv);
 
 void swr_state_init(struct pipe_context *pipe);
@@ -97,6 +97,11 @@ Gen_swr_draw_context(JitManager *pShG)
                      PIPE_MAX_CONSTANT_BUFFERS)); // constantFS
    members.push_back(ArrayType::get(
       Type::getInt32Ty(ctx), PIPE_MAX_CONSTANT_BUFFERS)); // num_constantsFS
+   members.push_back(
+      ArrayType::get(PointerType::get(Type::getFloatTy(ctx), 0),
+                     PIPE_MAX_CONSTANT_BUFFERS)); // constantGS
+   members.push_back(ArrayType::get(
+      Type::getInt32Ty(ctx), PIPE_MAX_CONSTANT_BUFFERS)); // num_constantsGS
    members.push_back(
       ArrayType::get(Gen_swr_jit_texture(pShG),
                      PIPE_MAX_SHADER_SAMPLER_VIEWS)); // texturesVS
@@ -117,8 +122,10 @@ static const UINT swr_draw_context_constantVS = 0;
 static const UINT swr_draw_context_num_constantsVS = 1;
 static const UINT swr_draw_context_constantFS = 2;
 static const UINT swr_draw_context_num_constantsFS = 3;
-static const UINT swr_draw_context_texturesVS = 4;
-static const UINT swr_draw_context_samplersVS = 5;
-static const UINT swr_draw_context_texturesFS = 6;
-static const UINT swr_draw_context_samplersFS = 7;
-static const UINT swr_draw_context_renderTargets = 8;
+static const UINT swr_draw_context_constantGS = 4;
+static const UINT swr_draw_context_num_constantsGS = 5;
+static const UINT swr_draw_context_texturesVS = 6;
+static const UINT swr_draw_context_samplersVS = 7;
+static const UINT swr_draw_context_texturesFS = 8;
+static const UINT swr_draw_context_samplersFS = 9;
+static const UINT swr_draw_context_renderTargets = 10;
@@ -73,6 +73,27 @@ swr_convert_prim_topology(const unsigned mode)
 };
 
 
+/*
+ * Indirect draws are handed to the core, which reads the arguments when the
+ * draw executes.  Client arrays are sized from the draw's index range at
+ * validation time, so those still go through util_draw_indirect.
+ */
+static boolean
+swr_can_draw_indirect(struct swr_context *ctx,
+                      const struct pipe_draw_info *info)
+{
+   for (unsigned i = 0; i < ctx->num_vertex_buffers; i++) {
+      if (ctx->vertex_buffer[i].user_buffer)
+         return FALSE;
+   }
+
+   if (info->indexed && ctx->index_buffer.user_buffer)
+      return FALSE;
+
+   return TRUE;
+}
+
+
 /*
  * Draw vertex arrays, with optional indexing, optional instancing.
  */
@@ -84,7 +105,7 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (!swr_check_render_cond(pipe))
       return;
 
-   if (info->indirect) {
+   if (info->indirect && !swr_can_draw_indirect(ctx, info)) {
       util_draw_indirect(pipe, info);
       return;
    }
@@ -93,50 +114,81 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (ctx->dirty)
       swr_update_derived(ctx, info);
 
-   if (ctx->vs->pipe.stream_output.num_outputs) {
-      if (!ctx->vs->soFunc[info->mode]) {
-         STREAMOUT_COMPILE_STATE state = {0};
-         struct pipe_stream_output_info *so = &ctx->vs->pipe.stream_output;
+   /* streamout comes from the last vertex stage */
+   struct pipe_stream_output_info *so = ctx->gs
+      ? &ctx->gs->pipe.stream_output
+      : &ctx->vs->pipe.stream_output;
+   PFN_SO_FUNC (*soFunc)[PIPE_PRIM_MAX] =
+      ctx->gs ? ctx->gs->soFunc : ctx->vs->soFunc;
+
+   if (so->num_outputs) {
+      uint32_t streams = 0;
+      for (uint32_t i = 0; i < so->num_outputs; i++)
+         streams |= 1 << so->output[i].stream;
+
+      while (streams) {
+         uint32_t stream = u_bit_scan(&streams);
+
+         if (!soFunc[stream][info->mode]) {
+            STREAMOUT_COMPILE_STATE state = {0};
+
+            state.numVertsPerPrim = ctx->gs
+               ? u_vertices_per_prim(
+                    ctx->gs->info.base.properties[TGSI_PROPERTY_GS_OUTPUT_PRIM])
+               : u_vertices_per_prim(info->mode);
+
+            uint32_t offsets[MAX_SO_STREAMS] = {0};
+            uint32_t num = 0;
+
+            for (uint32_t i = 0; i < so->num_outputs; i++) {
+               if (so->output[i].stream != stream)
+                  continue;
+
+               uint32_t output_buffer = so->output[i].output_buffer;
+               if (so->output[i].dst_offset != offsets[output_buffer]) {
+                  // hole - need to fill
+                  state.stream.decl[num].bufferIndex = output_buffer;
+                  state.stream.decl[num].hole = true;
+                  state.stream.decl[num].componentMask =
+                     (1 << (so->output[i].dst_offset - offsets[output_buffer]))
+                     - 1;
+                  num++;
+                  offsets[output_buffer] = so->output[i].dst_offset;
+               }
 
-         state.numVertsPerPrim = u_vertices_per_prim(info->mode);
-
-         uint32_t offsets[MAX_SO_STREAMS] = {0};
-         uint32_t num = 0;
-
-         for (uint32_t i = 0; i < so->num_outputs; i++) {
-            assert(so->output[i].stream == 0); // @todo
-            uint32_t output_buffer = so->output[i].output_buffer;
-            if (so->output[i].dst_offset != offsets[output_buffer]) {
-               // hole - need to fill
                state.stream.decl[num].bufferIndex = output_buffer;
-               state.stream.decl[num].hole = true;
+               state.stream.decl[num].attribSlot =
+                  so->output[i].register_index - 1;
                state.stream.decl[num].componentMask =
-                  (1 << (so->output[i].dst_offset - offsets[output_buffer]))
-                  - 1;
+                  ((1 << so->output[i].num_components) - 1)
+                  << so->output[i].start_component;
+               state.stream.decl[num].hole = false;
                num++;
-               offsets[output_buffer] = so->output[i].dst_offset;
-            }
 
-            state.stream.decl[num].bufferIndex = output_buffer;
-            state.stream.decl[num].attribSlot = so->output[i].register_index - 1;
-            state.stream.decl[num].componentMask =
-               ((1 << so->output[i].num_components) - 1)
-               << so->output[i].start_component;
-            state.stream.decl[num].hole = false;
-            num++;
+               offsets[output_buffer] += so->output[i].num_components;
+            }
 
-            offsets[output_buffer] += so->output[i].num_components;
+            state.stream.numDecls = num;
+
+            /* Shaders with the same output layout share one SO function */
+            auto search = ctx->soJIT->find(state);
+            if (search != ctx->soJIT->end()) {
+               soFunc[stream][info->mode] = search->second;
+            } else {
+               HANDLE hJitMgr = swr_screen(pipe->screen)->hJitMgr;
+               soFunc[stream][info->mode] =
+                  JitCompileStreamout(hJitMgr, state);
+               debug_printf("so shader    %p\n",
+                            soFunc[stream][info->mode]);
+               assert(soFunc[stream][info->mode] &&
+                      "Error: SoShader = NULL");
+               ctx->soJIT->insert(
+                  std::make_pair(state, soFunc[stream][info->mode]));
+            }
          }
 
-         state.stream.numDecls = num;
-
-         HANDLE hJitMgr = swr_screen(pipe->screen)->hJitMgr;
-         ctx->vs->soFunc[info->mode] = JitCompileStreamout(hJitMgr, state);
-         debug_printf("so shader    %p\n", ctx->vs->soFunc[info->mode]);
-         assert(ctx->vs->soFunc[info->mode] && "Error: SoShader = NULL");
+         SwrSetSoFunc(ctx->swrContext, soFunc[stream][info->mode], stream);
       }
-
-      SwrSetSoFunc(ctx->swrContext, ctx->vs->soFunc[info->mode], 0);
    }
 
    struct swr_vertex_element_state *velems = ctx->velems;
@@ -157,7 +209,47 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 
    SwrSetFetchFunc(ctx->swrContext, velems->fsFunc);
 
-   if (info->indexed)
+   /* Fused fetch + vertex shader, specialized on the VS inputs */
+   PFN_FETCH_VS_FUNC fetchVsFunc = NULL;
+   if (KNOB_FUSED_FETCH_VS) {
+      FETCH_COMPILE_STATE key = velems->fsState;
+      key.activeElementMask = 0;
+      for (uint32_t i = 0; i < ctx->vs->info.base.num_inputs; i++) {
+         if (ctx->vs->info.base.input_usage_mask[i])
+            key.activeElementMask |= 1ull << i;
+      }
+
+      auto search = ctx->vs->fetchVsMap.find(key);
+      if (search != ctx->vs->fetchVsMap.end()) {
+         fetchVsFunc = search->second;
+      } else {
+         fetchVsFunc = swr_compile_fetch_vs(&ctx->pipe, ctx->vs, key);
+         ctx->vs->fetchVsMap.insert(std::make_pair(key, fetchVsFunc));
+      }
+   }
+   SwrSetFetchVsFunc(ctx->swrContext, fetchVsFunc);
+
+   if (info->indirect) {
+      const void *args =
+         (const uint8_t *)swr_resource_data(info->indirect)
+         + info->indirect_offset;
+
+      /* arguments are read when the draw executes; keep the buffer alive */
+      swr_resource(info->indirect)->bound_to_context = (void *)pipe;
+
+      if (info->indexed)
+         SwrDrawIndexedIndirect(ctx->swrContext,
+                                swr_convert_prim_topology(info->mode),
+                                args,
+                                1,
+                                0);
+      else
+         SwrDrawIndirect(ctx->swrContext,
+                         swr_convert_prim_topology(info->mode),
+                         args,
+                         1,
+                         0);
+   } else if (info->indexed)
       SwrDrawIndexedInstanced(ctx->swrContext,
                               swr_convert_prim_topology(info->mode),
                               info->count,
@@ -256,6 +348,24 @@ swr_store_render_target(struct swr_context *ctx,
                     (enum SWR_RENDERTARGET_ATTACHMENT)attachment,
                     post_tile_state);
 
+      /* Only macrotiles rendered to since the last store were written.
+       * Color attachments are always the swr surface of their resource. */
+      BBOX rect;
+      if (attachment <= SWR_ATTACHMENT_COLOR7
+          && SwrGetLastStoreRect(ctx->swrContext,
+                                 (enum SWR_RENDERTARGET_ATTACHMENT)attachment,
+                                 &rect)) {
+         struct SWR_SURFACE_STATE *stored =
+            surface ? surface : ctx->current.attachment[attachment];
+         if (stored) {
+            struct swr_resource *res = (struct swr_resource *)
+               ((char *)stored - offsetof(struct swr_resource, swr));
+            struct u_rect damage =
+               {rect.left, rect.right, rect.top, rect.bottom};
+            swr_resource_damage(res, &damage);
+         }
+      }
+
       /* Restore viewport and scissor enable */
       if (change_viewport)
          SwrSetViewports(ctx->swrContext, 1, &ctx->current.vp, &ctx->current.vpm);
@@ -35,13 +35,14 @@ void StoreHotTile(
     SWR_FORMAT srcFormat,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
     UINT x, UINT y, uint32_t renderTargetArrayIndex,
-    BYTE *pSrcHotTile);
+    uint32_t numSamples, BYTE *pSrcHotTile);
 
-void StoreHotTileClear(
+bool StoreHotTileClear(
     SWR_SURFACE_STATE *pDstSurface,
     SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
     UINT x,
     UINT y,
+    uint32_t renderTargetArrayIndex,
     const float* pClearColor);
 
 INLINE void
@@ -63,27 +64,30 @@ swr_StoreHotTile(HANDLE hPrivateContext,
                  SWR_FORMAT srcFormat,
                  SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
                  UINT x, UINT y,
-                 uint32_t renderTargetArrayIndex, BYTE* pSrcHotTile)
+                 uint32_t renderTargetArrayIndex, uint32_t numSamples,
+                 BYTE* pSrcHotTile)
 {
    // Grab destination surface state from private context
    swr_draw_context *pDC = (swr_draw_context*)hPrivateContext;
    SWR_SURFACE_STATE *pDstSurface = &pDC->renderTargets[renderTargetIndex];
 
-   StoreHotTile(pDstSurface, srcFormat, renderTargetIndex, x, y, renderTargetArrayIndex, pSrcHotTile);
+   StoreHotTile(pDstSurface, srcFormat, renderTargetIndex, x, y, renderTargetArrayIndex, numSamples, pSrcHotTile);
 }
 
-INLINE void
+INLINE bool
 swr_StoreHotTileClear(HANDLE hPrivateContext,
                       SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
                       UINT x,
                       UINT y,
+                      uint32_t renderTargetArrayIndex,
                       const float* pClearColor)
 {
    // Grab destination surface state from private context
    swr_draw_context *pDC = (swr_draw_context*)hPrivateContext;
    SWR_SURFACE_STATE *pDstSurface = &pDC->renderTargets[renderTargetIndex];
 
-   StoreHotTileClear(pDstSurface, renderTargetIndex, x, y, pClearColor);
+   return StoreHotTileClear(pDstSurface, renderTargetIndex, x, y,
+                            renderTargetArrayIndex, pClearColor);
 }
 
 void InitSimLoadTilesTable();
@@ -25,6 +25,7 @@
 #define SWR_RESOURCE_H
 
 #include "pipe/p_state.h"
+#include "util/u_rect.h"
 #include "api.h"
 
 struct sw_displaytarget;
@@ -47,6 +48,9 @@ struct swr_resource {
    unsigned img_stride[PIPE_MAX_TEXTURE_LEVELS];
    unsigned mip_offsets[PIPE_MAX_TEXTURE_LEVELS];
 
+   /* Level 0 region written since the last present, x1/y1 exclusive */
+   struct u_rect damage;
+
    /* Opaque pointer to swr_context to mark resource in use */
    void *bound_to_context;
 };
@@ -58,6 +62,22 @@ swr_resource(struct pipe_resource *resource)
    return (struct swr_resource *)resource;
 }
 
+static INLINE void
+swr_resource_damage(struct swr_resource *res, const struct u_rect *rect)
+{
+   if (res->damage.x1 <= res->damage.x0 || res->damage.y1 <= res->damage.y0)
+      res->damage = *rect;
+   else
+      u_rect_union(&res->damage, &res->damage, rect);
+}
+
+static INLINE void
+swr_resource_damage_all(struct swr_resource *res)
+{
+   struct u_rect all = {0, (int)res->base.width0, 0, (int)res->base.height0};
+   swr_resource_damage(res, &all);
+}
+
 static INLINE boolean
 swr_resource_is_texture(const struct pipe_resource *resource)
 {
@@ -26,12 +26,14 @@
 #include "util/u_memory.h"
 #include "util/u_format.h"
 #include "util/u_inlines.h"
+#include "util/u_box.h"
 #include "util/u_cpu_detect.h"
 
 #include "state_tracker/sw_winsys.h"
 
 extern "C" {
 #include "gallivm/lp_bld_limits.h"
+#include "gallivm/lp_bld_sample.h"
 }
 
 #include "swr_public.h"
@@ -80,8 +82,20 @@ swr_is_format_supported(struct pipe_screen *screen,
    if (!format_desc)
       return FALSE;
 
-   if (sample_count > 1)
-      return FALSE;
+   if (sample_count > 1) {
+      /* Multisampled hot tiles are supported for 2x/4x/8x/16x render and
+       * depth targets. Texturing from them needs per-sample texel fetch,
+       * which the sampler doesn't do.
+       */
+      if (!util_is_power_of_two(sample_count)
+          || sample_count > SWR_MAX_NUM_MULTISAMPLES)
+         return FALSE;
+      if (target != PIPE_TEXTURE_2D && target != PIPE_TEXTURE_RECT)
+         return FALSE;
+      if (bind & (PIPE_BIND_SAMPLER_VIEW | PIPE_BIND_DISPLAY_TARGET
+                  | PIPE_BIND_SCANOUT | PIPE_BIND_SHARED))
+         return FALSE;
+   }
 
    if (bind
        & (PIPE_BIND_DISPLAY_TARGET | PIPE_BIND_SCANOUT | PIPE_BIND_SHARED)) {
@@ -177,7 +191,7 @@ swr_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_MAX_GEOMETRY_TOTAL_OUTPUT_COMPONENTS:
       return 1024;
    case PIPE_CAP_MAX_VERTEX_STREAMS:
-      return 1;
+      return MAX_SO_STREAMS;
    case PIPE_CAP_MAX_VERTEX_ATTRIB_STRIDE:
       return 2048;
    case PIPE_CAP_PRIMITIVE_RESTART:
@@ -212,6 +226,9 @@ swr_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUADS_FOLLOW_PROVOKING_VERTEX_CONVENTION:
       return 0;
    case PIPE_CAP_COMPUTE:
+      /* the core has SwrDispatch, but gallivm can't build TGSI compute
+       * shaders yet (no block/thread ids, RESOURCE loads/stores or
+       * barriers), so there is nothing for launch_grid to run */
       return 0;
    case PIPE_CAP_USER_VERTEX_BUFFERS:
    case PIPE_CAP_USER_INDEX_BUFFERS:
@@ -316,10 +333,11 @@ swr_get_shader_param(struct pipe_screen *screen,
                      unsigned shader,
                      enum pipe_shader_cap param)
 {
-   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_FRAGMENT)
+   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_FRAGMENT
+       || shader == PIPE_SHADER_GEOMETRY)
       return gallivm_get_shader_param(param);
 
-   // Todo: geometry, tesselation, compute
+   // Todo: tesselation, compute (see PIPE_CAP_COMPUTE)
    return 0;
 }
 
@@ -416,6 +434,48 @@ swr_displaytarget_layout(struct swr_screen *screen, struct swr_resource *res)
    return TRUE;
 }
 
+/*
+ * Sampled textures are stored in the LP_TILE_* Y-major layout, which keeps
+ * texels of neighbouring rows in the same cache lines and pages.  This is
+ * the core's SWR_TILE_MODE_YMAJOR, so textures that are also rendered to
+ * are tiled and untiled by the hot tile loads and stores.  Anything the
+ * winsys displays or the CPU maps for streaming stays linear.
+ */
+static bool
+swr_resource_use_tiling(const struct pipe_resource *templat,
+                        unsigned Bpp)
+{
+   if (!(templat->bind & PIPE_BIND_SAMPLER_VIEW)
+       || (templat->bind & ~(PIPE_BIND_SAMPLER_VIEW
+                             | PIPE_BIND_RENDER_TARGET)))
+      return false;
+
+   if (templat->usage == PIPE_USAGE_STAGING || templat->nr_samples > 1)
+      return false;
+
+   switch (templat->target) {
+   case PIPE_TEXTURE_2D:
+   case PIPE_TEXTURE_2D_ARRAY:
+   case PIPE_TEXTURE_RECT:
+   case PIPE_TEXTURE_3D:
+   case PIPE_TEXTURE_CUBE:
+   case PIPE_TEXTURE_CUBE_ARRAY:
+      break;
+   default:
+      /* buffers and 1D textures have no vertical neighbours */
+      return false;
+   }
+
+   const struct util_format_description *desc =
+      util_format_description(templat->format);
+   if (desc->block.width != 1 || desc->block.height != 1
+       || desc->block.bits != Bpp * 8)
+      return false;
+
+   /* texels may not straddle tile columns */
+   return util_is_power_of_two(Bpp) && Bpp <= LP_TILE_COLUMN_BYTES;
+}
+
 static struct pipe_resource *
 swr_resource_create(struct pipe_screen *_screen,
                     const struct pipe_resource *templat)
@@ -446,10 +506,15 @@ swr_resource_create(struct pipe_screen *_screen,
    res->swr.type = SURFACE_2D;
    res->swr.tileMode = SWR_TILE_NONE;
    res->swr.format = mesa_to_swr_format(fmt);
-   res->swr.numSamples = (1 << templat->nr_samples);
+   res->swr.numSamples = MAX2(templat->nr_samples, 1);
 
    SWR_FORMAT_INFO finfo = GetFormatInfo(res->swr.format);
 
+   bool tiled = !res->has_depth && !res->has_stencil
+      && swr_resource_use_tiling(templat, finfo.Bpp);
+   if (tiled)
+      res->swr.tileMode = SWR_TILE_MODE_YMAJOR;
+
    unsigned total_size = 0;
    unsigned width = templat->width0;
    unsigned height = templat->height0;
@@ -471,6 +536,13 @@ swr_resource_create(struct pipe_screen *_screen,
          alignedHeight = height;
       }
 
+      if (tiled) {
+         /* whole tiles, so every level and slice starts on a tile */
+         alignedWidth = align(alignedWidth * finfo.Bpp, LP_TILE_WIDTH_BYTES)
+            / finfo.Bpp;
+         alignedHeight = align(alignedHeight, LP_TILE_HEIGHT);
+      }
+
       if (level == 0) {
          res->alignedWidth = alignedWidth;
          res->alignedHeight = alignedHeight;
@@ -490,6 +562,9 @@ swr_resource_create(struct pipe_screen *_screen,
       else
          num_slices = 1;
 
+      /* samples are stored as consecutive slices of each layer */
+      num_slices *= res->swr.numSamples;
+
       total_size += res->img_stride[level] * num_slices;
 
       width = u_minify(width, 1);
@@ -500,7 +575,9 @@ swr_resource_create(struct pipe_screen *_screen,
    res->swr.halign = res->alignedWidth;
    res->swr.valign = res->alignedHeight;
    res->swr.pitch = res->row_stride[0];
-   res->swr.pBaseAddress = (BYTE *)_aligned_malloc(total_size, 64);
+   res->swr.qpitch = res->alignedHeight;
+   res->swr.pBaseAddress = (BYTE *)_aligned_malloc(
+      total_size, tiled ? LP_TILE_WIDTH_BYTES * LP_TILE_HEIGHT : 64);
 
    if (res->has_depth && res->has_stencil) {
       res->secondary.width = templat->width0;
@@ -509,12 +586,14 @@ swr_resource_create(struct pipe_screen *_screen,
       res->secondary.type = SURFACE_2D;
       res->secondary.tileMode = SWR_TILE_NONE;
       res->secondary.format = R8_UINT;
-      res->secondary.numSamples = (1 << templat->nr_samples);
+      res->secondary.numSamples = res->swr.numSamples;
 
       SWR_FORMAT_INFO finfo = GetFormatInfo(res->secondary.format);
       res->secondary.pitch = res->alignedWidth * finfo.Bpp;
+      res->secondary.qpitch = res->alignedHeight;
       res->secondary.pBaseAddress = (BYTE *)_aligned_malloc(
-         res->alignedHeight * res->secondary.pitch, 64);
+         res->alignedHeight * res->secondary.pitch
+         * res->secondary.numSamples, 64);
    }
 
    if (swr_resource_is_texture(&res->base)) {
@@ -523,6 +602,9 @@ swr_resource_create(struct pipe_screen *_screen,
          /* displayable surface */
          if (!swr_displaytarget_layout(screen, res))
             goto fail;
+
+         /* the display target starts out cleared, not with our contents */
+         swr_resource_damage_all(res);
       }
    }
 
@@ -584,13 +666,37 @@ swr_flush_frontbuffer(struct pipe_screen *p_screen,
    /* Ensure fence set at flush is finished, before reading frame buffer */
    swr_fence_finish(p_screen, screen->flush_fence, 0);
 
-   SwrEndFrame(swr_context((pipe_context *)res->bound_to_context));
+   if (res->bound_to_context)
+      SwrEndFrame(swr_context((pipe_context *)res->bound_to_context)->swrContext);
+
+   /* Only the region written since the last present needs copying, the
+    * rest of the display target still holds the same contents. */
+   struct u_rect bounds = {0, (int)colorBuffer.width, 0, (int)colorBuffer.height};
+   struct u_rect damage = res->damage;
+   u_rect_possible_intersection(&bounds, &damage);
+   res->damage.x0 = res->damage.x1 = res->damage.y0 = res->damage.y1 = 0;
+
+   struct pipe_box damage_box;
+   if (damage.x1 > damage.x0 && damage.y1 > damage.y0) {
+      unsigned Bpp = util_format_get_blocksize(res->base.format);
+      unsigned offset = damage.y0 * colorBuffer.pitch + damage.x0 * Bpp;
+      unsigned row_size = (damage.x1 - damage.x0) * Bpp;
+
+      BYTE *map = (BYTE *)winsys->displaytarget_map(
+         winsys, res->display_target, PIPE_TRANSFER_WRITE);
+      for (int y = damage.y0; y < damage.y1; y++) {
+         memcpy(map + offset, colorBuffer.pBaseAddress + offset, row_size);
+         offset += colorBuffer.pitch;
+      }
+      winsys->displaytarget_unmap(winsys, res->display_target);
 
-   void *map = winsys->displaytarget_map(
-      winsys, res->display_target, PIPE_TRANSFER_WRITE);
-   memcpy(
-      map, colorBuffer.pBaseAddress, colorBuffer.pitch * colorBuffer.height);
-   winsys->displaytarget_unmap(winsys, res->display_target);
+      /* present the damaged region, unless the caller asked for one */
+      if (!sub_box) {
+         u_box_2d(damage.x0, damage.y0,
+                  damage.x1 - damage.x0, damage.y1 - damage.y0, &damage_box);
+         sub_box = &damage_box;
+      }
+   }
 
    assert(res->display_target);
    if (res->display_target)
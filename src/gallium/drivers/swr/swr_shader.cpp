@@ -28,6 +28,7 @@
 
 #include "llvm-c/Core.h"
 #include "llvm/Support/CBindingWrapping.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include "tgsi/tgsi_strings.h"
 #include "gallivm/lp_bld_init.h"
@@ -39,24 +40,47 @@
 #include "swr_context_llvm.h"
 #include "swr_state.h"
 #include "swr_screen.h"
+#include "swr_resource.h"
 
 bool operator==(const swr_jit_key &lhs, const swr_jit_key &rhs)
 {
    return !memcmp(&lhs, &rhs, sizeof(lhs));
 }
 
+bool operator==(const swr_gs_key &lhs, const swr_gs_key &rhs)
+{
+   return !memcmp(&lhs, &rhs, sizeof(lhs));
+}
+
+/*
+ * Static texture state, plus the storage layout of the texture which the
+ * generated address computations depend on.
+ */
+static void
+swr_sampler_static_texture_state(struct lp_static_texture_state *state,
+                                 const struct pipe_sampler_view *view)
+{
+   lp_sampler_static_texture_state(state, view);
+
+   if (view && view->texture)
+      state->tiled =
+         swr_resource(view->texture)->swr.tileMode != SWR_TILE_NONE;
+}
+
 void
 swr_generate_fs_key(struct swr_jit_key &key,
                     struct swr_context *ctx,
                     swr_fragment_shader *swr_fs)
 {
+   struct tgsi_shader_info *last_info = swr_last_vertex_stage_info(ctx);
+
    key.nr_cbufs = ctx->framebuffer.nr_cbufs;
    key.light_twoside = ctx->rasterizer->light_twoside;
    memcpy(&key.vs_output_semantic_name,
-          &ctx->vs->info.base.output_semantic_name,
+          &last_info->output_semantic_name,
           sizeof(key.vs_output_semantic_name));
    memcpy(&key.vs_output_semantic_idx,
-          &ctx->vs->info.base.output_semantic_index,
+          &last_info->output_semantic_index,
           sizeof(key.vs_output_semantic_idx));
 
    key.nr_samplers = swr_fs->info.base.file_max[TGSI_FILE_SAMPLER] + 1;
@@ -79,7 +103,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
          swr_fs->info.base.file_max[TGSI_FILE_SAMPLER_VIEW] + 1;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_sampler_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -88,7 +112,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
       key.nr_sampler_views = key.nr_samplers;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_sampler_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -96,6 +120,20 @@ swr_generate_fs_key(struct swr_jit_key &key,
    }
 }
 
+void
+swr_generate_gs_key(struct swr_gs_key &key,
+                    struct swr_context *ctx,
+                    swr_geometry_shader *swr_gs)
+{
+   key.nr_vs_outputs = ctx->vs->info.base.num_outputs;
+   memcpy(&key.vs_output_semantic_name,
+          &ctx->vs->info.base.output_semantic_name,
+          sizeof(key.vs_output_semantic_name));
+   memcpy(&key.vs_output_semantic_idx,
+          &ctx->vs->info.base.output_semantic_index,
+          sizeof(key.vs_output_semantic_idx));
+}
+
 struct BuilderSWR : public Builder {
    BuilderSWR(JitManager *pJitMgr)
       : Builder(pJitMgr)
@@ -105,70 +143,90 @@ struct BuilderSWR : public Builder {
 
    PFN_VERTEX_FUNC
    CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
+   PFN_FETCH_VS_FUNC
+   CompileFetchVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs,
+                  const FETCH_COMPILE_STATE &fetchState);
+   PFN_GS_FUNC
+   CompileGS(struct swr_context *ctx, swr_geometry_shader *swr_gs,
+             const swr_gs_key &key);
    PFN_PIXEL_KERNEL CompileFS(struct swr_context *ctx, swr_jit_key &key);
+
+   void ComputeVSLinkage(swr_vertex_shader *swr_vs);
+
+   LLVMValueRef
+   swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                           struct lp_build_tgsi_context *bld_base,
+                           boolean is_vindex_indirect,
+                           LLVMValueRef vertex_index,
+                           boolean is_aindex_indirect,
+                           LLVMValueRef attrib_index,
+                           LLVMValueRef swizzle_index);
+   void swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_base,
+                                struct lp_build_tgsi_context *bld_base,
+                                LLVMValueRef (*outputs)[4],
+                                LLVMValueRef emitted_vertices_vec,
+                                unsigned stream);
+   void swr_gs_llvm_end_primitive(const struct lp_build_tgsi_gs_iface *gs_base,
+                                  struct lp_build_tgsi_context *bld_base,
+                                  LLVMValueRef verts_per_prim_vec,
+                                  LLVMValueRef emitted_prims_vec,
+                                  unsigned stream);
+   void swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_base,
+                             struct lp_build_tgsi_context *bld_base,
+                             LLVMValueRef total_emitted_vertices_vec,
+                             LLVMValueRef emitted_prims_vec);
+   void BuildVS(struct gallivm_state *gallivm, swr_vertex_shader *swr_vs,
+                Value *hPrivateData, Value *pVsCtx,
+                Value *vtxInput, Value *vertexId);
 };
 
-PFN_VERTEX_FUNC
-BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
+static unsigned
+compute_linkage_mask(const struct tgsi_shader_info *info)
 {
-   swr_vs->linkageMask = 0;
+   unsigned linkageMask = 0;
 
-   for (unsigned i = 0; i < swr_vs->info.base.num_outputs; i++) {
-      switch (swr_vs->info.base.output_semantic_name[i]) {
+   for (unsigned i = 0; i < info->num_outputs; i++) {
+      switch (info->output_semantic_name[i]) {
       case TGSI_SEMANTIC_POSITION:
          break;
       default:
-         swr_vs->linkageMask |= (1 << i);
+         linkageMask |= (1 << i);
          break;
       }
    }
 
-   //   tgsi_dump(swr_vs->pipe.tokens, 0);
+   return linkageMask;
+}
 
-   struct gallivm_state *gallivm =
-      gallivm_create("VS", wrap(&JM()->mContext));
-   gallivm->module = wrap(JM()->mpCurrentModule);
+void
+BuilderSWR::ComputeVSLinkage(swr_vertex_shader *swr_vs)
+{
+   swr_vs->linkageMask = compute_linkage_mask(&swr_vs->info.base);
+}
 
+/*
+ * Emit the vertex shader body at the current insert point, reading inputs
+ * from vtxInput (a simdvertex) and writing outputs to pVsCtx->pVout.
+ */
+void
+BuilderSWR::BuildVS(struct gallivm_state *gallivm,
+                    swr_vertex_shader *swr_vs,
+                    Value *hPrivateData,
+                    Value *pVsCtx,
+                    Value *vtxInput,
+                    Value *vertexId)
+{
    LLVMValueRef inputs[PIPE_MAX_SHADER_INPUTS][TGSI_NUM_CHANNELS];
    LLVMValueRef outputs[PIPE_MAX_SHADER_OUTPUTS][TGSI_NUM_CHANNELS];
 
    memset(outputs, 0, sizeof(outputs));
 
-   AttrBuilder attrBuilder;
-   attrBuilder.addStackAlignmentAttr(JM()->mVWidth * sizeof(float));
-   AttributeSet attrSet = AttributeSet::get(
-      JM()->mContext, AttributeSet::FunctionIndex, attrBuilder);
-
-   std::vector<Type *> vsArgs{PointerType::get(Gen_swr_draw_context(JM()), 0),
-                              PointerType::get(Gen_SWR_VS_CONTEXT(JM()), 0)};
-   FunctionType *vsFuncType =
-      FunctionType::get(Type::getVoidTy(JM()->mContext), vsArgs, false);
-
-   // create new vertex shader function
-   auto pFunction = Function::Create(vsFuncType,
-                                     GlobalValue::ExternalLinkage,
-                                     "VS",
-                                     JM()->mpCurrentModule);
-   pFunction->addAttributes(AttributeSet::FunctionIndex, attrSet);
-
-   BasicBlock *block = BasicBlock::Create(JM()->mContext, "entry", pFunction);
-   IRB()->SetInsertPoint(block);
-   LLVMPositionBuilderAtEnd(gallivm->builder, wrap(block));
-
-   auto argitr = pFunction->arg_begin();
-   Value *hPrivateData = &*argitr++;
-   hPrivateData->setName("hPrivateData");
-   Value *pVsCtx = &*argitr++;
-   pVsCtx->setName("vsCtx");
-
    Value *consts_ptr = GEP(hPrivateData, {0, swr_draw_context_constantVS});
    consts_ptr->setName("vs_constants");
    Value *const_sizes_ptr =
       GEP(hPrivateData, {0, swr_draw_context_num_constantsVS});
    const_sizes_ptr->setName("num_vs_constants");
 
-   Value *vtxInput = LOAD(pVsCtx, {0, SWR_VS_CONTEXT_pVin});
-
    for (uint32_t attrib = 0; attrib < PIPE_MAX_SHADER_INPUTS; attrib++) {
       const unsigned mask = swr_vs->info.base.input_usage_mask[attrib];
       for (uint32_t channel = 0; channel < TGSI_NUM_CHANNELS; channel++) {
@@ -182,7 +240,7 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
    struct lp_bld_tgsi_system_values system_values;
    memset(&system_values, 0, sizeof(system_values));
    system_values.instance_id = wrap(LOAD(pVsCtx, {0, SWR_VS_CONTEXT_InstanceID}));
-   system_values.vertex_id = wrap(LOAD(pVsCtx, {0, SWR_VS_CONTEXT_VertexID}));
+   system_values.vertex_id = wrap(vertexId);
 
    lp_build_tgsi_soa(gallivm,
                      swr_vs->pipe.tokens,
@@ -215,6 +273,50 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
          STORE(val, vtxOutput, {0, 0, outSlot, channel});
       }
    }
+}
+
+PFN_VERTEX_FUNC
+BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
+{
+   ComputeVSLinkage(swr_vs);
+
+   //   tgsi_dump(swr_vs->pipe.tokens, 0);
+
+   struct gallivm_state *gallivm =
+      gallivm_create("VS", wrap(&JM()->mContext));
+   gallivm->module = wrap(JM()->mpCurrentModule);
+
+   AttrBuilder attrBuilder;
+   attrBuilder.addStackAlignmentAttr(JM()->mVWidth * sizeof(float));
+   AttributeSet attrSet = AttributeSet::get(
+      JM()->mContext, AttributeSet::FunctionIndex, attrBuilder);
+
+   std::vector<Type *> vsArgs{PointerType::get(Gen_swr_draw_context(JM()), 0),
+                              PointerType::get(Gen_SWR_VS_CONTEXT(JM()), 0)};
+   FunctionType *vsFuncType =
+      FunctionType::get(Type::getVoidTy(JM()->mContext), vsArgs, false);
+
+   // create new vertex shader function
+   auto pFunction = Function::Create(vsFuncType,
+                                     GlobalValue::ExternalLinkage,
+                                     "VS",
+                                     JM()->mpCurrentModule);
+   pFunction->addAttributes(AttributeSet::FunctionIndex, attrSet);
+
+   BasicBlock *block = BasicBlock::Create(JM()->mContext, "entry", pFunction);
+   IRB()->SetInsertPoint(block);
+   LLVMPositionBuilderAtEnd(gallivm->builder, wrap(block));
+
+   auto argitr = pFunction->arg_begin();
+   Value *hPrivateData = &*argitr++;
+   hPrivateData->setName("hPrivateData");
+   Value *pVsCtx = &*argitr++;
+   pVsCtx->setName("vsCtx");
+
+   Value *vtxInput = LOAD(pVsCtx, {0, SWR_VS_CONTEXT_pVin});
+   Value *vertexId = LOAD(pVsCtx, {0, SWR_VS_CONTEXT_VertexID});
+
+   BuildVS(gallivm, swr_vs, hPrivateData, pVsCtx, vtxInput, vertexId);
 
    RET_VOID();
 
@@ -236,6 +338,86 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
    return pFunc;
 }
 
+/*
+ * Build fetch and vertex shader as a single function. The fetch shader is
+ * inlined and writes to a stack simdvertex, which the optimizer promotes to
+ * registers, so VS inputs never round-trip through memory. Elements the VS
+ * doesn't read are dropped via fetchState.activeElementMask.
+ */
+PFN_FETCH_VS_FUNC
+BuilderSWR::CompileFetchVS(struct pipe_context *ctx,
+                           swr_vertex_shader *swr_vs,
+                           const FETCH_COMPILE_STATE &fetchState)
+{
+   ComputeVSLinkage(swr_vs);
+
+   struct gallivm_state *gallivm =
+      gallivm_create("FetchVS", wrap(&JM()->mContext));
+   gallivm->module = wrap(JM()->mpCurrentModule);
+
+   // fetch IR goes into the same module so it can be inlined
+   Function *pFetch = (Function *)JitBuildFetch(JM(), fetchState);
+
+   AttrBuilder attrBuilder;
+   attrBuilder.addStackAlignmentAttr(JM()->mVWidth * sizeof(float));
+   AttributeSet attrSet = AttributeSet::get(
+      JM()->mContext, AttributeSet::FunctionIndex, attrBuilder);
+
+   std::vector<Type *> fetchVsArgs{
+      PointerType::get(Gen_swr_draw_context(JM()), 0),
+      PointerType::get(Gen_SWR_FETCH_CONTEXT(JM()), 0),
+      PointerType::get(Gen_SWR_VS_CONTEXT(JM()), 0)};
+   FunctionType *fetchVsFuncType =
+      FunctionType::get(Type::getVoidTy(JM()->mContext), fetchVsArgs, false);
+
+   auto pFunction = Function::Create(fetchVsFuncType,
+                                     GlobalValue::ExternalLinkage,
+                                     "FetchVS",
+                                     JM()->mpCurrentModule);
+   pFunction->addAttributes(AttributeSet::FunctionIndex, attrSet);
+
+   BasicBlock *block = BasicBlock::Create(JM()->mContext, "entry", pFunction);
+   IRB()->SetInsertPoint(block);
+   LLVMPositionBuilderAtEnd(gallivm->builder, wrap(block));
+
+   auto argitr = pFunction->arg_begin();
+   Value *hPrivateData = &*argitr++;
+   hPrivateData->setName("hPrivateData");
+   Value *pFetchInfo = &*argitr++;
+   pFetchInfo->setName("fetchInfo");
+   Value *pVsCtx = &*argitr++;
+   pVsCtx->setName("vsCtx");
+
+   Value *vtxInput = ALLOCA(Gen_simdvertex(JM()));
+   vtxInput->setName("vtxInput");
+
+   CallInst *pCall = CALL(pFetch, {pFetchInfo, vtxInput});
+   Value *vertexId = LOAD(pFetchInfo, {0, SWR_FETCH_CONTEXT_VertexID});
+
+   BuildVS(gallivm, swr_vs, hPrivateData, pVsCtx, vtxInput, vertexId);
+
+   RET_VOID();
+
+   InlineFunctionInfo inlineInfo;
+   InlineFunction(pCall, inlineInfo);
+   pFetch->eraseFromParent();
+
+   gallivm_verify_function(gallivm, wrap(pFunction));
+   gallivm_compile_module(gallivm);
+
+   PFN_FETCH_VS_FUNC pFunc =
+      (PFN_FETCH_VS_FUNC)gallivm_jit_function(gallivm, wrap(pFunction));
+
+   debug_printf("fetch+vert shader  %p\n", pFunc);
+   assert(pFunc && "Error: FetchVertShader = NULL");
+
+#if (LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR >= 5)
+   JM()->mIsModuleFinalized = true;
+#endif
+
+   return pFunc;
+}
+
 PFN_VERTEX_FUNC
 swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 {
@@ -244,6 +426,508 @@ swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
    return builder.CompileVS(ctx, swr_vs);
 }
 
+PFN_FETCH_VS_FUNC
+swr_compile_fetch_vs(struct pipe_context *ctx,
+                     swr_vertex_shader *swr_vs,
+                     const FETCH_COMPILE_STATE &fetchState)
+{
+   BuilderSWR builder(
+      reinterpret_cast<JitManager *>(swr_screen(ctx->screen)->hJitMgr));
+   return builder.CompileFetchVS(ctx, swr_vs, fetchState);
+}
+
+/*
+ * Geometry shader output layout. Each emitted vertex is packed to
+ * gsState.outputVertexSize slots; the frontend sizes the GS output
+ * buffers from the same SWR_GS_STATE.
+ */
+static unsigned
+gs_output_slot(const struct tgsi_shader_info *info, unsigned output)
+{
+   switch (info->output_semantic_name[output]) {
+   case TGSI_SEMANTIC_PSIZE:
+      return VERTEX_POINT_SIZE_SLOT;
+   case TGSI_SEMANTIC_LAYER:
+      return VERTEX_RTAI_SLOT;
+   case TGSI_SEMANTIC_PRIMID:
+      return VERTEX_PRIMID_SLOT;
+   default:
+      return output;
+   }
+}
+
+void
+swr_generate_gs_state(swr_geometry_shader *swr_gs)
+{
+   const struct tgsi_shader_info *info = &swr_gs->info.base;
+   SWR_GS_STATE *gsState = &swr_gs->gsState;
+
+   swr_gs->linkageMask = compute_linkage_mask(info);
+
+   memset(gsState, 0, sizeof(*gsState));
+   gsState->gsEnable = true;
+   // numInputAttribs depends on the bound VS, set on state dirty
+
+   switch (info->properties[TGSI_PROPERTY_GS_OUTPUT_PRIM]) {
+   case PIPE_PRIM_POINTS:
+      gsState->outputTopology = TOP_POINT_LIST;
+      break;
+   case PIPE_PRIM_LINE_STRIP:
+      gsState->outputTopology = TOP_LINE_STRIP;
+      break;
+   default:
+      gsState->outputTopology = TOP_TRIANGLE_STRIP;
+      break;
+   }
+
+   gsState->maxNumVerts = info->properties[TGSI_PROPERTY_GS_MAX_OUTPUT_VERTICES];
+   gsState->instanceCount =
+      MAX2(info->properties[TGSI_PROPERTY_GS_INVOCATIONS], 1);
+   assert(gsState->instanceCount <= MAX_GS_INSTANCES);
+
+   /* only streams that are captured get a buffer; stream 0 is the one
+    * that is rasterized, EMITs to any other stream are dropped */
+   gsState->numStreams = 1;
+   const pipe_stream_output_info *so = &swr_gs->pipe.stream_output;
+   for (unsigned i = 0; i < so->num_outputs; i++)
+      gsState->numStreams = MAX2(gsState->numStreams, so->output[i].stream + 1);
+
+   uint32_t numSlots = 0;
+   for (unsigned i = 0; i < info->num_outputs; i++) {
+      switch (info->output_semantic_name[i]) {
+      case TGSI_SEMANTIC_LAYER:
+         gsState->emitsRenderTargetArrayIndex = true;
+         break;
+      case TGSI_SEMANTIC_PRIMID:
+         gsState->emitsPrimitiveID = true;
+         break;
+      }
+      numSlots = MAX2(numSlots, gs_output_slot(info, i) + 1);
+   }
+   gsState->outputVertexSize = numSlots;
+}
+
+struct swr_gs_llvm_iface {
+   struct lp_build_tgsi_gs_iface base;
+   struct tgsi_shader_info *info;
+
+   BuilderSWR *pBuilder;
+
+   Value *pGsCtx;
+   Value *pDummy; // sink for inactive lanes
+   uint32_t inputSlot[PIPE_MAX_SHADER_INPUTS];
+
+   // must match GsBufferLayout in the frontend
+   uint32_t vertexStride;
+   uint32_t inputPrimStride;
+   uint32_t cutPrimStride;
+
+   // gallivm only counts vertices across all streams
+   uint32_t numStreams;
+   Value *pVtxCount[MAX_SO_STREAMS]; // vertices emitted on the stream
+   Value *pPrimVtxCount[MAX_SO_STREAMS]; // vertices since the last cut
+};
+
+// trampoline functions so we can use the builder llvm construction methods
+static LLVMValueRef
+swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                        struct lp_build_tgsi_context *bld_base,
+                        boolean is_vindex_indirect,
+                        LLVMValueRef vertex_index,
+                        boolean is_aindex_indirect,
+                        LLVMValueRef attrib_index,
+                        LLVMValueRef swizzle_index)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+
+   return iface->pBuilder->swr_gs_llvm_fetch_input(gs_iface, bld_base,
+                                                   is_vindex_indirect,
+                                                   vertex_index,
+                                                   is_aindex_indirect,
+                                                   attrib_index,
+                                                   swizzle_index);
+}
+
+static void
+swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_base,
+                        struct lp_build_tgsi_context *bld_base,
+                        LLVMValueRef (*outputs)[4],
+                        LLVMValueRef emitted_vertices_vec,
+                        unsigned stream)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+
+   iface->pBuilder->swr_gs_llvm_emit_vertex(gs_base, bld_base,
+                                            outputs,
+                                            emitted_vertices_vec,
+                                            stream);
+}
+
+static void
+swr_gs_llvm_end_primitive(const struct lp_build_tgsi_gs_iface *gs_base,
+                          struct lp_build_tgsi_context *bld_base,
+                          LLVMValueRef verts_per_prim_vec,
+                          LLVMValueRef emitted_prims_vec,
+                          unsigned stream)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+
+   iface->pBuilder->swr_gs_llvm_end_primitive(gs_base, bld_base,
+                                              verts_per_prim_vec,
+                                              emitted_prims_vec,
+                                              stream);
+}
+
+static void
+swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_base,
+                     struct lp_build_tgsi_context *bld_base,
+                     LLVMValueRef total_emitted_vertices_vec,
+                     LLVMValueRef emitted_prims_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+
+   iface->pBuilder->swr_gs_llvm_epilogue(gs_base, bld_base,
+                                         total_emitted_vertices_vec,
+                                         emitted_prims_vec);
+}
+
+/*
+ * Execution mask of the current EMIT/ENDPRIM, as computed by gallivm
+ * before it calls the interface.
+ */
+static Value *
+swr_gs_exec_mask(struct lp_build_tgsi_context *bld_base)
+{
+   struct lp_build_tgsi_soa_context *bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+
+   LLVMValueRef mask = lp_build_mask_value(bld->mask);
+   if (bld->exec_mask.has_mask)
+      mask = LLVMBuildAnd(builder, mask, bld->exec_mask.exec_mask, "");
+
+   return unwrap(mask);
+}
+
+LLVMValueRef
+BuilderSWR::swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                                    struct lp_build_tgsi_context *bld_base,
+                                    boolean is_vindex_indirect,
+                                    LLVMValueRef vertex_index,
+                                    boolean is_aindex_indirect,
+                                    LLVMValueRef attrib_index,
+                                    LLVMValueRef swizzle_index)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+
+   IRB()->SetInsertPoint(
+      unwrap(LLVMGetInsertBlock(bld_base->base.gallivm->builder)));
+
+   if (is_vindex_indirect || is_aindex_indirect) {
+      std::vector<Constant *> slots;
+      for (uint32_t i = 0; i < PIPE_MAX_SHADER_INPUTS; i++)
+         slots.push_back(C(iface->inputSlot[i]));
+      Value *vSlots = ConstantVector::get(slots);
+
+      Value *res = VIMMED1(0.0f);
+      for (uint32_t lane = 0; lane < JM()->mVWidth; lane++) {
+         Value *vertex = is_vindex_indirect
+            ? VEXTRACT(unwrap(vertex_index), C(lane))
+            : unwrap(vertex_index);
+         Value *attrib = is_aindex_indirect
+            ? VEXTRACT(unwrap(attrib_index), C(lane))
+            : unwrap(attrib_index);
+         Value *slot = VEXTRACT(vSlots, attrib);
+
+         Value *pVector = GEP(iface->pGsCtx,
+                              {C(0), C(SWR_GS_CONTEXT_vert), vertex,
+                               C(simdvertex_attrib), slot,
+                               unwrap(swizzle_index)});
+         res = VINSERT(res, VEXTRACT(LOAD(pVector), C(lane)), C(lane));
+      }
+
+      return wrap(res);
+   }
+
+   uint32_t vertex = LLVMConstIntGetZExtValue(vertex_index);
+   uint32_t attrib = LLVMConstIntGetZExtValue(attrib_index);
+   uint32_t swizzle = LLVMConstIntGetZExtValue(swizzle_index);
+
+   return wrap(LOAD(iface->pGsCtx,
+                    {0, SWR_GS_CONTEXT_vert, vertex, simdvertex_attrib,
+                     iface->inputSlot[attrib], swizzle}));
+}
+
+/*
+ * Emitted vertices are scattered per lane into the stream's buffer:
+ * lane * inputPrimStride + (vertex / 8) * vertexStride + slot * 128 +
+ * chan * 32 + (vertex % 8) * 4, the layout PA_STATE_CUT reads back.
+ * Inactive lanes store to a stack dummy so no branches are needed.
+ */
+void
+BuilderSWR::swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_base,
+                                    struct lp_build_tgsi_context *bld_base,
+                                    LLVMValueRef (*outputs)[4],
+                                    LLVMValueRef emitted_vertices_vec,
+                                    unsigned stream)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+   struct lp_build_tgsi_soa_context *bld = lp_soa_context(bld_base);
+
+   if (stream >= iface->numStreams)
+      return;
+
+   IRB()->SetInsertPoint(
+      unwrap(LLVMGetInsertBlock(bld_base->base.gallivm->builder)));
+
+   // gallivm clamps its counters to max_vertices but not our stores;
+   // max_vertices applies to the sum over all streams
+   Value *vMask = AND(swr_gs_exec_mask(bld_base),
+                      S_EXT(ICMP_ULT(unwrap(emitted_vertices_vec),
+                                     unwrap(bld->max_output_vertices_vec)),
+                            mSimdInt32Ty));
+
+   Value *pStream = LOAD(iface->pGsCtx, {0, SWR_GS_CONTEXT_pStream, stream});
+   Value *vVertex = LOAD(iface->pVtxCount[stream]);
+
+   for (uint32_t lane = 0; lane < JM()->mVWidth; lane++) {
+      Value *active = ICMP_NE(VEXTRACT(vMask, C(lane)), C(0));
+      Value *vertex = VEXTRACT(vVertex, C(lane));
+
+      Value *offset = ADD(C(lane * iface->inputPrimStride),
+                          MUL(LSHR(vertex, C(3)), C(iface->vertexStride)));
+      offset = ADD(offset, MUL(AND(vertex, C(7)), C((uint32_t)sizeof(float))));
+      Value *pVertex = GEP(pStream, offset);
+
+      for (uint32_t attrib = 0; attrib < iface->info->num_outputs; attrib++) {
+         uint32_t slot = gs_output_slot(iface->info, attrib);
+         for (uint32_t channel = 0; channel < TGSI_NUM_CHANNELS; channel++) {
+            if (!outputs[attrib][channel])
+               continue;
+
+            Value *val = VEXTRACT(LOAD(unwrap(outputs[attrib][channel])),
+                                  C(lane));
+            uint32_t chanOffset = (slot * 4 + channel) * JM()->mVWidth *
+               sizeof(float);
+            Value *pDst = SELECT(active, GEP(pVertex, C(chanOffset)),
+                                 iface->pDummy);
+            STORE(val, BITCAST(pDst, PointerType::get(mFP32Ty, 0)));
+         }
+      }
+   }
+
+   // active lanes are -1
+   STORE(SUB(vVertex, vMask), iface->pVtxCount[stream]);
+   STORE(SUB(LOAD(iface->pPrimVtxCount[stream]), vMask),
+         iface->pPrimVtxCount[stream]);
+}
+
+/*
+ * Set the cut bit of the last vertex emitted on the stream by each active
+ * lane. gallivm's verts_per_prim_vec counts all streams, so the stream's
+ * own count decides which lanes have an open primitive.
+ */
+void
+BuilderSWR::swr_gs_llvm_end_primitive(const struct lp_build_tgsi_gs_iface *gs_base,
+                                      struct lp_build_tgsi_context *bld_base,
+                                      LLVMValueRef verts_per_prim_vec,
+                                      LLVMValueRef emitted_prims_vec,
+                                      unsigned stream)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+
+   if (stream >= iface->numStreams)
+      return;
+
+   IRB()->SetInsertPoint(
+      unwrap(LLVMGetInsertBlock(bld_base->base.gallivm->builder)));
+
+   Value *vPrimVerts = LOAD(iface->pPrimVtxCount[stream]);
+   Value *vMask = AND(swr_gs_exec_mask(bld_base),
+                      S_EXT(ICMP_NE(vPrimVerts, VIMMED1(0)), mSimdInt32Ty));
+   Value *vTotal = LOAD(iface->pVtxCount[stream]);
+
+   Value *pCutBuffer =
+      LOAD(iface->pGsCtx, {0, SWR_GS_CONTEXT_pCutBuffer, stream});
+
+   for (uint32_t lane = 0; lane < JM()->mVWidth; lane++) {
+      Value *active = ICMP_NE(VEXTRACT(vMask, C(lane)), C(0));
+      Value *vertex = SUB(VEXTRACT(vTotal, C(lane)), C(1));
+
+      Value *offset = ADD(C(lane * iface->cutPrimStride), LSHR(vertex, C(3)));
+      Value *pByte = SELECT(active, GEP(pCutBuffer, offset), iface->pDummy);
+
+      Value *bit = TRUNC(SHL(C(1), AND(vertex, C(7))), mInt8Ty);
+      STORE(OR(LOAD(pByte), bit), pByte);
+   }
+
+   STORE(AND(vPrimVerts, NOT(vMask)), iface->pPrimVtxCount[stream]);
+}
+
+void
+BuilderSWR::swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_base,
+                                 struct lp_build_tgsi_context *bld_base,
+                                 LLVMValueRef total_emitted_vertices_vec,
+                                 LLVMValueRef emitted_prims_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_base;
+
+   IRB()->SetInsertPoint(
+      unwrap(LLVMGetInsertBlock(bld_base->base.gallivm->builder)));
+
+   for (uint32_t stream = 0; stream < iface->numStreams; stream++)
+      STORE(LOAD(iface->pVtxCount[stream]), iface->pGsCtx,
+            {0, SWR_GS_CONTEXT_vertexCount, stream});
+}
+
+PFN_GS_FUNC
+BuilderSWR::CompileGS(struct swr_context *ctx,
+                      swr_geometry_shader *swr_gs,
+                      const swr_gs_key &key)
+{
+   struct tgsi_shader_info *info = &swr_gs->info.base;
+   const SWR_GS_STATE *gsState = &swr_gs->gsState;
+
+   //   tgsi_dump(swr_gs->pipe.tokens, 0);
+
+   struct gallivm_state *gallivm =
+      gallivm_create("GS", wrap(&JM()->mContext));
+   gallivm->module = wrap(JM()->mpCurrentModule);
+
+   LLVMValueRef outputs[PIPE_MAX_SHADER_OUTPUTS][TGSI_NUM_CHANNELS];
+   memset(outputs, 0, sizeof(outputs));
+
+   AttrBuilder attrBuilder;
+   attrBuilder.addStackAlignmentAttr(JM()->mVWidth * sizeof(float));
+   AttributeSet attrSet = AttributeSet::get(
+      JM()->mContext, AttributeSet::FunctionIndex, attrBuilder);
+
+   std::vector<Type *> gsArgs{PointerType::get(Gen_swr_draw_context(JM()), 0),
+                              PointerType::get(Gen_SWR_GS_CONTEXT(JM()), 0)};
+   FunctionType *gsFuncType =
+      FunctionType::get(Type::getVoidTy(JM()->mContext), gsArgs, false);
+
+   // create new geometry shader function
+   auto pFunction = Function::Create(gsFuncType,
+                                     GlobalValue::ExternalLinkage,
+                                     "GS",
+                                     JM()->mpCurrentModule);
+   pFunction->addAttributes(AttributeSet::FunctionIndex, attrSet);
+
+   BasicBlock *block = BasicBlock::Create(JM()->mContext, "entry", pFunction);
+   IRB()->SetInsertPoint(block);
+   LLVMPositionBuilderAtEnd(gallivm->builder, wrap(block));
+
+   auto argitr = pFunction->arg_begin();
+   Value *hPrivateData = &*argitr++;
+   hPrivateData->setName("hPrivateData");
+   Value *pGsCtx = &*argitr++;
+   pGsCtx->setName("gsCtx");
+
+   Value *consts_ptr = GEP(hPrivateData, {0, swr_draw_context_constantGS});
+   consts_ptr->setName("gs_constants");
+   Value *const_sizes_ptr =
+      GEP(hPrivateData, {0, swr_draw_context_num_constantsGS});
+   const_sizes_ptr->setName("num_gs_constants");
+
+   struct lp_bld_tgsi_system_values system_values;
+   memset(&system_values, 0, sizeof(system_values));
+   system_values.prim_id = wrap(LOAD(pGsCtx, {0, SWR_GS_CONTEXT_PrimitiveID}));
+   system_values.invocation_id =
+      wrap(LOAD(pGsCtx, {0, SWR_GS_CONTEXT_InstanceID}));
+
+   struct swr_gs_llvm_iface gs_iface;
+   gs_iface.base.fetch_input = ::swr_gs_llvm_fetch_input;
+   gs_iface.base.emit_vertex = ::swr_gs_llvm_emit_vertex;
+   gs_iface.base.end_primitive = ::swr_gs_llvm_end_primitive;
+   gs_iface.base.gs_epilogue = ::swr_gs_llvm_epilogue;
+   gs_iface.info = info;
+   gs_iface.pBuilder = this;
+   gs_iface.pGsCtx = pGsCtx;
+   gs_iface.pDummy = ALLOCA(mInt8Ty, C(4));
+
+   /* link GS inputs to VS output slots; unlinked inputs read slot 0 */
+   for (uint32_t i = 0; i < PIPE_MAX_SHADER_INPUTS; i++) {
+      gs_iface.inputSlot[i] = VERTEX_POSITION_SLOT;
+      if (i >= info->num_inputs)
+         continue;
+      for (uint32_t j = 0; j < key.nr_vs_outputs; j++) {
+         if (key.vs_output_semantic_name[j] == info->input_semantic_name[i]
+             && key.vs_output_semantic_idx[j]
+                == info->input_semantic_index[i]) {
+            gs_iface.inputSlot[i] =
+               key.vs_output_semantic_name[j] == TGSI_SEMANTIC_PSIZE
+               ? VERTEX_POINT_SIZE_SLOT
+               : j;
+            break;
+         }
+      }
+   }
+
+   gs_iface.vertexStride =
+      gsState->outputVertexSize * JM()->mVWidth * 4 * sizeof(float);
+   gs_iface.inputPrimStride =
+      ((gsState->maxNumVerts + JM()->mVWidth - 1) / JM()->mVWidth)
+      * gs_iface.vertexStride;
+   gs_iface.cutPrimStride = (gsState->maxNumVerts + 7) / 8;
+
+   gs_iface.numStreams = gsState->numStreams;
+   for (uint32_t stream = 0; stream < gs_iface.numStreams; stream++) {
+      gs_iface.pVtxCount[stream] = ALLOCA(mSimdInt32Ty);
+      gs_iface.pPrimVtxCount[stream] = ALLOCA(mSimdInt32Ty);
+      STORE(VIMMED1(0), gs_iface.pVtxCount[stream]);
+      STORE(VIMMED1(0), gs_iface.pPrimVtxCount[stream]);
+   }
+
+   struct lp_build_mask_context mask;
+   lp_build_mask_begin(
+      &mask, gallivm, lp_type_float_vec(32, 32 * 8), wrap(VIMMED1(-1)));
+
+   lp_build_tgsi_soa(gallivm,
+                     swr_gs->pipe.tokens,
+                     lp_type_float_vec(32, 32 * 8),
+                     &mask,
+                     wrap(consts_ptr),
+                     wrap(const_sizes_ptr),
+                     &system_values,
+                     NULL, // inputs come through fetch_input
+                     outputs,
+                     NULL, // wrap(hPrivateData), (sampler context)
+                     NULL, // sampler
+                     info,
+                     &gs_iface.base);
+
+   lp_build_mask_end(&mask);
+
+   IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
+
+   RET_VOID();
+
+   gallivm_verify_function(gallivm, wrap(pFunction));
+   gallivm_compile_module(gallivm);
+
+   PFN_GS_FUNC pFunc =
+      (PFN_GS_FUNC)gallivm_jit_function(gallivm, wrap(pFunction));
+
+   debug_printf("geom shader  %p\n", pFunc);
+   assert(pFunc && "Error: GeomShader = NULL");
+
+#if (LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR >= 5)
+   JM()->mIsModuleFinalized = true;
+#endif
+
+   return pFunc;
+}
+
+PFN_GS_FUNC
+swr_compile_gs(struct swr_context *ctx,
+               swr_geometry_shader *swr_gs,
+               const swr_gs_key &key)
+{
+   BuilderSWR builder(
+      reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr));
+   return builder.CompileGS(ctx, swr_gs, key);
+}
+
 static unsigned
 locate_linkage(ubyte name, ubyte index, struct tgsi_shader_info *info)
 {
@@ -270,6 +954,7 @@ PFN_PIXEL_KERNEL
 BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 {
    struct swr_fragment_shader *swr_fs = ctx->fs;
+   struct tgsi_shader_info *last_info = swr_last_vertex_stage_info(ctx);
 
    //   tgsi_dump(swr_fs->pipe.tokens, 0);
 
@@ -375,11 +1060,11 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
       }
 
       unsigned linkedAttrib =
-         locate_linkage(semantic_name, semantic_idx, &ctx->vs->info.base);
+         locate_linkage(semantic_name, semantic_idx, last_info);
       if (linkedAttrib == 0xFFFFFFFF) {
          // not found - check for point sprite
          if (ctx->rasterizer->sprite_coord_enable) {
-            linkedAttrib = ctx->vs->info.base.num_outputs - 1;
+            linkedAttrib = last_info->num_outputs - 1;
             swr_fs->pointSpriteMask |= (1 << linkedAttrib);
          } else {
             fprintf(stderr,
@@ -403,7 +1088,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
             if ((semantic_name == TGSI_SEMANTIC_COLOR)
                 && ctx->rasterizer->light_twoside) {
                unsigned bcolorAttrib = locate_linkage(
-                  TGSI_SEMANTIC_BCOLOR, semantic_idx, &ctx->vs->info.base);
+                  TGSI_SEMANTIC_BCOLOR, semantic_idx, last_info);
 
                unsigned diff = 12 * (bcolorAttrib - linkedAttrib);
 
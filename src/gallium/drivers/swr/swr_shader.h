@@ -24,12 +24,26 @@
 #pragma once
 
 class swr_vertex_shader;
+class swr_geometry_shader;
 class swr_fragment_shader;
 class swr_jit_key;
+class swr_gs_key;
 
 PFN_VERTEX_FUNC
 swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
 
+PFN_FETCH_VS_FUNC
+swr_compile_fetch_vs(struct pipe_context *ctx,
+                     swr_vertex_shader *swr_vs,
+                     const FETCH_COMPILE_STATE &fetchState);
+
+void swr_generate_gs_state(swr_geometry_shader *swr_gs);
+
+PFN_GS_FUNC
+swr_compile_gs(struct swr_context *ctx,
+               swr_geometry_shader *swr_gs,
+               const swr_gs_key &key);
+
 PFN_PIXEL_KERNEL
 swr_compile_fs(struct swr_context *ctx, swr_jit_key &key);
 
@@ -37,6 +51,10 @@ void swr_generate_fs_key(struct swr_jit_key &key,
                          struct swr_context *ctx,
                          swr_fragment_shader *swr_fs);
 
+void swr_generate_gs_key(struct swr_gs_key &key,
+                         struct swr_context *ctx,
+                         swr_geometry_shader *swr_gs);
+
 struct swr_jit_key {
    unsigned nr_cbufs;
    unsigned light_twoside;
@@ -58,3 +76,22 @@ template <> struct hash<swr_jit_key> {
 };
 
 bool operator==(const swr_jit_key &lhs, const swr_jit_key &rhs);
+
+/* GS inputs are linked to VS outputs at compile time */
+struct swr_gs_key {
+   unsigned nr_vs_outputs;
+   ubyte vs_output_semantic_name[PIPE_MAX_SHADER_OUTPUTS];
+   ubyte vs_output_semantic_idx[PIPE_MAX_SHADER_OUTPUTS];
+};
+
+namespace std
+{
+template <> struct hash<swr_gs_key> {
+   std::size_t operator()(const swr_gs_key &k) const
+   {
+      return util_hash_crc32(&k, sizeof(k));
+   }
+};
+};
+
+bool operator==(const swr_gs_key &lhs, const swr_gs_key &rhs);
@@ -304,12 +304,36 @@ swr_sampler_view_destroy(struct pipe_context *pipe,
    FREE(view);
 }
 
+static void
+swr_generate_so_state(SWR_STREAMOUT_STATE *soState,
+                      const pipe_stream_output_info *stream_output)
+{
+   *soState = {0};
+
+   if (stream_output->num_outputs) {
+      soState->soEnable = true;
+      // soState.rasterizerDisable set on state dirty
+      // soState.streamToRasterizer not used
+
+      for (uint32_t i = 0; i < stream_output->num_outputs; i++) {
+         soState->streamMasks[stream_output->output[i].stream] |=
+            1 << (stream_output->output[i].register_index - 1);
+         soState->bufferMasks[stream_output->output[i].stream] |=
+            1 << stream_output->output[i].output_buffer;
+         soState->streamEnable[stream_output->output[i].stream] = true;
+      }
+      for (uint32_t i = 0; i < MAX_SO_STREAMS; i++) {
+         soState->streamNumEntries[i] =
+            _mm_popcnt_u32(soState->streamMasks[i]);
+      }
+   }
+}
+
 static void *
 swr_create_vs_state(struct pipe_context *pipe,
                     const struct pipe_shader_state *vs)
 {
-   struct swr_vertex_shader *swr_vs =
-      (swr_vertex_shader *)CALLOC_STRUCT(swr_vertex_shader);
+   struct swr_vertex_shader *swr_vs = new swr_vertex_shader();
    if (!swr_vs)
       return NULL;
 
@@ -320,24 +344,7 @@ swr_create_vs_state(struct pipe_context *pipe,
 
    swr_vs->func = swr_compile_vs(pipe, swr_vs);
 
-   swr_vs->soState = {0};
-
-   if (swr_vs->pipe.stream_output.num_outputs) {
-      pipe_stream_output_info *stream_output = &swr_vs->pipe.stream_output;
-
-      swr_vs->soState.soEnable = true;
-      // soState.rasterizerDisable set on state dirty
-      // soState.streamToRasterizer not used
-
-      for (uint32_t i = 0; i < stream_output->num_outputs; i++) {
-         swr_vs->soState.streamMasks[stream_output->output[i].stream] |=
-            1 << (stream_output->output[i].register_index - 1);
-      }
-      for (uint32_t i = 0; i < MAX_SO_STREAMS; i++) {
-        swr_vs->soState.streamNumEntries[i] =
-             _mm_popcnt_u32(swr_vs->soState.streamMasks[i]);
-       }
-   }
+   swr_generate_so_state(&swr_vs->soState, &swr_vs->pipe.stream_output);
 
    return swr_vs;
 }
@@ -359,7 +366,48 @@ swr_delete_vs_state(struct pipe_context *pipe, void *vs)
 {
    struct swr_vertex_shader *swr_vs = (swr_vertex_shader *)vs;
    FREE((void *)swr_vs->pipe.tokens);
-   FREE(vs);
+   delete swr_vs;
+}
+
+static void *
+swr_create_gs_state(struct pipe_context *pipe,
+                    const struct pipe_shader_state *gs)
+{
+   struct swr_geometry_shader *swr_gs = new swr_geometry_shader();
+   if (!swr_gs)
+      return NULL;
+
+   swr_gs->pipe.tokens = tgsi_dup_tokens(gs->tokens);
+   swr_gs->pipe.stream_output = gs->stream_output;
+
+   lp_build_tgsi_info(gs->tokens, &swr_gs->info);
+
+   /* compiled on state dirty, since inputs link against the bound VS */
+   swr_generate_gs_state(swr_gs);
+
+   swr_generate_so_state(&swr_gs->soState, &swr_gs->pipe.stream_output);
+
+   return swr_gs;
+}
+
+static void
+swr_bind_gs_state(struct pipe_context *pipe, void *gs)
+{
+   struct swr_context *ctx = swr_context(pipe);
+
+   if (ctx->gs == gs)
+      return;
+
+   ctx->gs = (swr_geometry_shader *)gs;
+   ctx->dirty |= SWR_NEW_GS;
+}
+
+static void
+swr_delete_gs_state(struct pipe_context *pipe, void *gs)
+{
+   struct swr_geometry_shader *swr_gs = (swr_geometry_shader *)gs;
+   FREE((void *)swr_gs->pipe.tokens);
+   delete swr_gs;
 }
 
 static void *
@@ -414,8 +462,10 @@ swr_set_constant_buffer(struct pipe_context *pipe,
    /* note: reference counting */
    util_copy_constant_buffer(&ctx->constants[shader][index], cb);
 
-   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_GEOMETRY) {
+   if (shader == PIPE_SHADER_VERTEX) {
       ctx->dirty |= SWR_NEW_VSCONSTANTS;
+   } else if (shader == PIPE_SHADER_GEOMETRY) {
+      ctx->dirty |= SWR_NEW_GSCONSTANTS;
    } else if (shader == PIPE_SHADER_FRAGMENT) {
       ctx->dirty |= SWR_NEW_FSCONSTANTS;
    }
@@ -617,10 +667,55 @@ swr_set_sample_mask(struct pipe_context *pipe, unsigned sample_mask)
 
    if (sample_mask != ctx->sample_mask) {
       ctx->sample_mask = sample_mask;
-      ctx->dirty |= SWR_NEW_RASTERIZER;
+      ctx->dirty |= SWR_NEW_BLEND;
    }
 }
 
+/*
+ * Returns true if the fragment shader can't affect anything but the depth
+ * and stencil tests, i.e. depth prepasses and shadow map renders.  The
+ * core then runs its null PS backend, which skips shading and never
+ * touches color hot tiles.
+ */
+static boolean
+swr_fs_is_depth_only(struct swr_context *ctx)
+{
+   struct pipe_framebuffer_state *fb = &ctx->framebuffer;
+   struct tgsi_shader_info *info = &ctx->fs->info.base;
+   struct pipe_depth_stencil_alpha_state *dsa = ctx->depth_stencil;
+
+   /* The null PS backend is single sampled */
+   if (util_framebuffer_get_num_samples(fb) > 1)
+      return FALSE;
+
+   /* Nothing to gain without a depth or stencil test, and the core drops
+    * the draw entirely in that case, which would break occlusion queries */
+   if (!dsa->depth.enabled && !dsa->stencil[0].enabled)
+      return FALSE;
+
+   if (info->uses_kill || info->writes_z || info->writes_stencil)
+      return FALSE;
+   for (unsigned i = 0; i < info->num_outputs; i++)
+      if (info->output_semantic_name[i] == TGSI_SEMANTIC_SAMPLEMASK)
+         return FALSE;
+
+   if (!(ctx->sample_mask & 1))
+      return FALSE;
+
+   for (unsigned i = 0; i < fb->nr_cbufs; i++) {
+      if (!fb->cbufs[i])
+         continue;
+      /* Alpha test and alpha to coverage run in the blend jit */
+      if (dsa->alpha.enabled || ctx->blend->pipe.alpha_to_coverage)
+         return FALSE;
+      unsigned rt = ctx->blend->pipe.independent_blend_enable ? i : 0;
+      if (ctx->blend->pipe.rt[rt].colormask)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
 
 void
 swr_update_derived(struct swr_context *ctx,
@@ -727,14 +822,25 @@ swr_update_derived(struct swr_context *ctx,
          ? ctx->rasterizer->line_width
          : 1.0f;
 
+      rastState->lineStippleEnable = ctx->rasterizer->line_stipple_enable;
+      rastState->lineStipplePattern = ctx->rasterizer->line_stipple_pattern;
+      rastState->lineStippleFactor = ctx->rasterizer->line_stipple_factor + 1;
+
       rastState->pointParam = ctx->rasterizer->point_size_per_vertex;
 
       rastState->pointSpriteEnable = ctx->rasterizer->sprite_coord_enable;
       rastState->pointSpriteTopOrigin =
          ctx->rasterizer->sprite_coord_mode == PIPE_SPRITE_COORD_UPPER_LEFT;
 
-      /* XXX TODO: Add multisample */
-      rastState->sampleCount = SWR_MULTISAMPLE_1X;
+      /* Hot tiles carry as many samples as the framebuffer. With
+       * multisample rasterization off, all samples sit at the pixel center
+       * and share the center coverage.
+       */
+      rastState->sampleCount = swr_convert_sample_count(
+         util_framebuffer_get_num_samples(&ctx->framebuffer));
+      rastState->samplePattern = ctx->rasterizer->multisample
+         ? SWR_MSAA_STANDARD_PATTERN
+         : SWR_MSAA_CENTER_PATTERN;
 
       bool do_offset = false;
       switch (ctx->rasterizer->fill_front) {
@@ -944,18 +1050,48 @@ swr_update_derived(struct swr_context *ctx,
       SwrSetVertexFunc(ctx->swrContext, ctx->vs->func);
    }
 
+   /* GeometryShader */
+   if (ctx->dirty & (SWR_NEW_GS | SWR_NEW_VS)) {
+      if (ctx->gs) {
+         swr_gs_key key;
+         memset(&key, 0, sizeof(key));
+         swr_generate_gs_key(key, ctx, ctx->gs);
+         auto search = ctx->gs->map.find(key);
+         PFN_GS_FUNC func;
+         if (search != ctx->gs->map.end()) {
+            func = search->second;
+         } else {
+            func = swr_compile_gs(ctx, ctx->gs, key);
+            ctx->gs->map.insert(std::make_pair(key, func));
+         }
+
+         SWR_GS_STATE gsState = ctx->gs->gsState;
+         gsState.numInputAttribs = ctx->vs->info.base.num_outputs - 1;
+
+         SwrSetGsFunc(ctx->swrContext, func);
+         SwrSetGsState(ctx->swrContext, &gsState);
+      } else {
+         SWR_GS_STATE gsState = {0};
+         SwrSetGsState(ctx->swrContext, &gsState);
+      }
+   }
+
    swr_jit_key key;
    if (ctx->dirty & (SWR_NEW_FS | SWR_NEW_SAMPLER | SWR_NEW_SAMPLER_VIEW
-                     | SWR_NEW_RASTERIZER | SWR_NEW_FRAMEBUFFER)) {
+                     | SWR_NEW_RASTERIZER | SWR_NEW_FRAMEBUFFER | SWR_NEW_VS
+                     | SWR_NEW_GS | SWR_NEW_BLEND
+                     | SWR_NEW_DEPTH_STENCIL_ALPHA)) {
       memset(&key, 0, sizeof(key));
       swr_generate_fs_key(key, ctx, ctx->fs);
-      auto search = ctx->fs->map.find(key);
-      PFN_PIXEL_KERNEL func;
-      if (search != ctx->fs->map.end()) {
-         func = search->second;
-      } else {
-         func = swr_compile_fs(ctx, key);
-         ctx->fs->map.insert(std::make_pair(key, func));
+      PFN_PIXEL_KERNEL func = NULL;
+      if (!swr_fs_is_depth_only(ctx)) {
+         auto search = ctx->fs->map.find(key);
+         if (search != ctx->fs->map.end()) {
+            func = search->second;
+         } else {
+            func = swr_compile_fs(ctx, key);
+            ctx->fs->map.insert(std::make_pair(key, func));
+         }
       }
       SWR_PS_STATE psState = {0};
       psState.pfnPixelShader = func;
@@ -1046,6 +1182,32 @@ swr_update_derived(struct swr_context *ctx,
       }
    }
 
+   /* GeometryShader Constants */
+   if (ctx->dirty & SWR_NEW_GSCONSTANTS) {
+      swr_draw_context *pDC =
+         (swr_draw_context *)SwrGetPrivateContextState(ctx->swrContext);
+
+      for (UINT i = 0; i < PIPE_MAX_CONSTANT_BUFFERS; i++) {
+         const pipe_constant_buffer *cb =
+            &ctx->constants[PIPE_SHADER_GEOMETRY][i];
+         pDC->num_constantsGS[i] = cb->buffer_size;
+         if (cb->buffer)
+            pDC->constantGS[i] =
+               (const float *)((const BYTE *)cb->buffer + cb->buffer_offset);
+         else {
+            /* Need to copy these constants to scratch space */
+            if (cb->user_buffer && cb->buffer_size) {
+               const void *ptr =
+                  ((const BYTE *)cb->user_buffer + cb->buffer_offset);
+               uint32_t size = AlignUp(cb->buffer_size, 4);
+               ptr = swr_copy_to_scratch_space(
+                  ctx, &ctx->scratch->gs_constants, ptr, size);
+               pDC->constantGS[i] = (const float *)ptr;
+            }
+         }
+      }
+   }
+
    /* FragmentShader Constants */
    if (ctx->dirty & SWR_NEW_FSCONSTANTS) {
       swr_draw_context *pDC =
@@ -1139,6 +1301,10 @@ swr_update_derived(struct swr_context *ctx,
       blendState.constantColor[3] = ctx->blend_color.color[3];
       blendState.alphaTestReference =
          *((uint32_t*)&ctx->depth_stencil->alpha.ref_value);
+      blendState.sampleMask = ctx->sample_mask;
+
+      unsigned num_samples = util_framebuffer_get_num_samples(fb);
+      unsigned all_samples_mask = (1 << num_samples) - 1;
 
       /* If there are no color buffers bound, disable writes on RT0
        * and skip loop */
@@ -1172,8 +1338,9 @@ swr_update_derived(struct swr_context *ctx,
                ctx->blend->pipe.independent_blend_enable;
             compileState.desc.alphaToCoverageEnable =
                ctx->blend->pipe.alpha_to_coverage;
-            compileState.desc.sampleMaskEnable = 0; // XXX
-            compileState.desc.numSamples = 1; // XXX
+            compileState.desc.sampleMaskEnable =
+               (ctx->sample_mask & all_samples_mask) != all_samples_mask;
+            compileState.desc.numSamples = num_samples;
 
             compileState.alphaTestFunction =
                swr_convert_depth_func(ctx->depth_stencil->alpha.func);
@@ -1201,12 +1368,17 @@ swr_update_derived(struct swr_context *ctx,
       /* XXX What to do with this one??? SWR doesn't stipple */
    }
 
-   if (ctx->dirty & (SWR_NEW_VS | SWR_NEW_SO | SWR_NEW_RASTERIZER)) {
-      ctx->vs->soState.rasterizerDisable =
-         ctx->rasterizer->rasterizer_discard;
-      SwrSetSoState(ctx->swrContext, &ctx->vs->soState);
+   if (ctx->dirty
+       & (SWR_NEW_VS | SWR_NEW_GS | SWR_NEW_SO | SWR_NEW_RASTERIZER)) {
+      /* streamout comes from the last vertex stage */
+      SWR_STREAMOUT_STATE *soState =
+         ctx->gs ? &ctx->gs->soState : &ctx->vs->soState;
+      soState->rasterizerDisable = ctx->rasterizer->rasterizer_discard;
+      SwrSetSoState(ctx->swrContext, soState);
 
-      pipe_stream_output_info *stream_output = &ctx->vs->pipe.stream_output;
+      pipe_stream_output_info *stream_output = ctx->gs
+         ? &ctx->gs->pipe.stream_output
+         : &ctx->vs->pipe.stream_output;
 
       for (uint32_t i = 0; i < ctx->num_so_targets; i++) {
          SWR_STREAMOUT_BUFFER buffer = {0};
@@ -1223,9 +1395,9 @@ swr_update_derived(struct swr_context *ctx,
       }
    }
 
-   uint32_t linkage = ctx->vs->linkageMask;
+   uint32_t linkage = ctx->gs ? ctx->gs->linkageMask : ctx->vs->linkageMask;
    if (ctx->rasterizer->sprite_coord_enable)
-      linkage |= (1 << ctx->vs->info.base.num_outputs);
+      linkage |= (1 << swr_last_vertex_stage_info(ctx)->num_outputs);
 
    SwrSetLinkage(ctx->swrContext, linkage, NULL);
 
@@ -1328,6 +1500,10 @@ swr_state_init(struct pipe_context *pipe)
    pipe->bind_vs_state = swr_bind_vs_state;
    pipe->delete_vs_state = swr_delete_vs_state;
 
+   pipe->create_gs_state = swr_create_gs_state;
+   pipe->bind_gs_state = swr_bind_gs_state;
+   pipe->delete_gs_state = swr_delete_gs_state;
+
    pipe->create_fs_state = swr_create_fs_state;
    pipe->bind_fs_state = swr_bind_fs_state;
    pipe->delete_fs_state = swr_delete_fs_state;
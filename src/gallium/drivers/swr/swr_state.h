@@ -35,6 +35,23 @@
 #include "swr_shader.h"
 #include <unordered_map>
 
+namespace std
+{
+template <> struct hash<FETCH_COMPILE_STATE> {
+   std::size_t operator()(const FETCH_COMPILE_STATE &k) const
+   {
+      /* only hash what operator== compares */
+      uint32_t hash = util_hash_crc32(&k.layout[0],
+                                      k.numAttribs * sizeof(k.layout[0]));
+      hash ^= k.numAttribs ^ (k.indexType << 8) ^ k.cutIndex;
+      hash ^= (uint32_t)k.activeElementMask ^ (uint32_t)(k.activeElementMask >> 32);
+      hash ^= (k.bEnableCutIndex << 28) ^ (k.bDisableVGATHER << 29)
+         ^ (k.bDisableIndexOOBCheck << 30);
+      return hash;
+   }
+};
+};
+
 /* skeleton */
 struct swr_vertex_shader {
    struct pipe_shader_state pipe;
@@ -42,7 +59,18 @@ struct swr_vertex_shader {
    unsigned linkageMask;
    PFN_VERTEX_FUNC func;
    SWR_STREAMOUT_STATE soState;
-   PFN_SO_FUNC soFunc[PIPE_PRIM_MAX];
+   PFN_SO_FUNC soFunc[MAX_SO_STREAMS][PIPE_PRIM_MAX];
+   std::unordered_map<FETCH_COMPILE_STATE, PFN_FETCH_VS_FUNC> fetchVsMap;
+};
+
+struct swr_geometry_shader {
+   struct pipe_shader_state pipe;
+   struct lp_tgsi_info info;
+   unsigned linkageMask;
+   SWR_GS_STATE gsState;
+   SWR_STREAMOUT_STATE soState;
+   PFN_SO_FUNC soFunc[MAX_SO_STREAMS][PIPE_PRIM_MAX];
+   std::unordered_map<swr_gs_key, PFN_GS_FUNC> map;
 };
 
 struct swr_fragment_shader {
@@ -171,6 +199,26 @@ swr_convert_cull_mode(const UINT cull_face)
    }
 }
 
+static INLINE SWR_MULTISAMPLE_COUNT
+swr_convert_sample_count(const UINT sample_count)
+{
+   switch (sample_count) {
+   case 1:
+      return SWR_MULTISAMPLE_1X;
+   case 2:
+      return SWR_MULTISAMPLE_2X;
+   case 4:
+      return SWR_MULTISAMPLE_4X;
+   case 8:
+      return SWR_MULTISAMPLE_8X;
+   case 16:
+      return SWR_MULTISAMPLE_16X;
+   default:
+      assert(0 && "Unsupported sample count");
+      return SWR_MULTISAMPLE_1X;
+   }
+}
+
 static INLINE SWR_BLEND_OP
 swr_convert_blend_func(const UINT blend_func)
 {
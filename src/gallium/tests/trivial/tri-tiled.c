@@ -0,0 +1,357 @@
+/**************************************************************************
+ *
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Renders the same triangle into a linear render target and into a texture
+ * created the way st/mesa creates GL textures, bound as both sampler view
+ * and render target. swr stores such textures tiled, which shows up as a
+ * failing PIPE_TRANSFER_MAP_DIRECTLY. Reading both back through regular
+ * transfers must give identical images, so the hot tile stores and the
+ * transfer detiling agree on the layout. The size is not a multiple of the
+ * tile or macrotile dimensions so partial tiles are covered as well.
+ */
+
+#define WIDTH 100
+#define HEIGHT 70
+
+/* pipe_*_state structs */
+#include "pipe/p_state.h"
+/* pipe_context */
+#include "pipe/p_context.h"
+/* pipe_screen */
+#include "pipe/p_screen.h"
+/* PIPE_* */
+#include "pipe/p_defines.h"
+/* TGSI_SEMANTIC_{POSITION|GENERIC} */
+#include "pipe/p_shader_tokens.h"
+/* pipe_buffer_* helpers */
+#include "util/u_inlines.h"
+
+/* constant state object helper */
+#include "cso_cache/cso_context.h"
+
+/* util_draw_vertex_buffer helper */
+#include "util/u_draw_quad.h"
+/* FREE & CALLOC_STRUCT */
+#include "util/u_memory.h"
+/* util_make_[fragment|vertex]_passthrough_shader */
+#include "util/u_simple_shaders.h"
+/* to get a hardware pipe driver */
+#include "pipe-loader/pipe_loader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct program
+{
+	struct pipe_loader_device *dev;
+	struct pipe_screen *screen;
+	struct pipe_context *pipe;
+	struct cso_context *cso;
+
+	struct pipe_blend_state blend;
+	struct pipe_depth_stencil_alpha_state depthstencil;
+	struct pipe_rasterizer_state rasterizer;
+	struct pipe_viewport_state viewport;
+	struct pipe_framebuffer_state framebuffer;
+	struct pipe_vertex_element velem[2];
+
+	void *vs;
+	void *fs;
+
+	union pipe_color_union clear_color;
+
+	struct pipe_resource *vbuf;
+	struct pipe_resource *linear;
+	struct pipe_resource *texture;
+};
+
+static struct pipe_resource *create_target(struct program *p, unsigned bind)
+{
+	struct pipe_resource tmplt;
+
+	memset(&tmplt, 0, sizeof(tmplt));
+	tmplt.target = PIPE_TEXTURE_2D;
+	tmplt.format = PIPE_FORMAT_B8G8R8A8_UNORM; /* All drivers support this */
+	tmplt.width0 = WIDTH;
+	tmplt.height0 = HEIGHT;
+	tmplt.depth0 = 1;
+	tmplt.array_size = 1;
+	tmplt.last_level = 0;
+	tmplt.bind = bind;
+
+	return p->screen->resource_create(p->screen, &tmplt);
+}
+
+static void init_prog(struct program *p)
+{
+	int ret;
+
+	/* find a hardware device */
+	ret = pipe_loader_probe(&p->dev, 1);
+	assert(ret);
+
+	/* init a pipe screen */
+	p->screen = pipe_loader_create_screen(p->dev, PIPE_SEARCH_DIR);
+	assert(p->screen);
+
+	/* create the pipe driver context and cso context */
+	p->pipe = p->screen->context_create(p->screen, NULL);
+	p->cso = cso_create_context(p->pipe);
+
+	/* set clear color */
+	p->clear_color.f[0] = 0.3;
+	p->clear_color.f[1] = 0.1;
+	p->clear_color.f[2] = 0.3;
+	p->clear_color.f[3] = 1.0;
+
+	/* vertex buffer */
+	{
+		float vertices[4][2][4] = {
+			{
+				{ 0.0f, -0.9f, 0.0f, 1.0f },
+				{ 1.0f, 0.0f, 0.0f, 1.0f }
+			},
+			{
+				{ -0.9f, 0.9f, 0.0f, 1.0f },
+				{ 0.0f, 1.0f, 0.0f, 1.0f }
+			},
+			{
+				{ 0.9f, 0.9f, 0.0f, 1.0f },
+				{ 0.0f, 0.0f, 1.0f, 1.0f }
+			}
+		};
+
+		p->vbuf = pipe_buffer_create(p->screen, PIPE_BIND_VERTEX_BUFFER,
+					     PIPE_USAGE_DEFAULT, sizeof(vertices));
+		pipe_buffer_write(p->pipe, p->vbuf, 0, sizeof(vertices), vertices);
+	}
+
+	/* render targets, the second one with st/mesa's texture bind flags */
+	p->linear = create_target(p, PIPE_BIND_RENDER_TARGET);
+	p->texture = create_target(p, PIPE_BIND_SAMPLER_VIEW |
+				      PIPE_BIND_RENDER_TARGET);
+
+	/* disabled blending/masking */
+	memset(&p->blend, 0, sizeof(p->blend));
+	p->blend.rt[0].colormask = PIPE_MASK_RGBA;
+
+	/* no-op depth/stencil/alpha */
+	memset(&p->depthstencil, 0, sizeof(p->depthstencil));
+
+	/* rasterizer */
+	memset(&p->rasterizer, 0, sizeof(p->rasterizer));
+	p->rasterizer.cull_face = PIPE_FACE_NONE;
+	p->rasterizer.half_pixel_center = 1;
+	p->rasterizer.bottom_edge_rule = 1;
+	p->rasterizer.depth_clip = 1;
+
+	/* drawing destination, the surface is set per target */
+	memset(&p->framebuffer, 0, sizeof(p->framebuffer));
+	p->framebuffer.width = WIDTH;
+	p->framebuffer.height = HEIGHT;
+	p->framebuffer.nr_cbufs = 1;
+
+	/* viewport */
+	{
+		float half_width = (float)WIDTH / 2.0f;
+		float half_height = (float)HEIGHT / 2.0f;
+
+		p->viewport.scale[0] = half_width;
+		p->viewport.scale[1] = half_height;
+		p->viewport.scale[2] = 1.0f;
+
+		p->viewport.translate[0] = half_width;
+		p->viewport.translate[1] = half_height;
+		p->viewport.translate[2] = 0.0f;
+	}
+
+	/* vertex elements state */
+	memset(p->velem, 0, sizeof(p->velem));
+	p->velem[0].src_offset = 0 * 4 * sizeof(float); /* offset 0, first element */
+	p->velem[0].instance_divisor = 0;
+	p->velem[0].vertex_buffer_index = 0;
+	p->velem[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+	p->velem[1].src_offset = 1 * 4 * sizeof(float); /* offset 16, second element */
+	p->velem[1].instance_divisor = 0;
+	p->velem[1].vertex_buffer_index = 0;
+	p->velem[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+	/* vertex shader */
+	{
+			const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
+							TGSI_SEMANTIC_COLOR };
+			const uint semantic_indexes[] = { 0, 0 };
+			p->vs = util_make_vertex_passthrough_shader(p->pipe, 2, semantic_names, semantic_indexes, FALSE);
+	}
+
+	/* fragment shader */
+	p->fs = util_make_fragment_passthrough_shader(p->pipe,
+                    TGSI_SEMANTIC_COLOR, TGSI_INTERPOLATE_PERSPECTIVE, TRUE);
+}
+
+static void close_prog(struct program *p)
+{
+	cso_destroy_context(p->cso);
+
+	p->pipe->delete_vs_state(p->pipe, p->vs);
+	p->pipe->delete_fs_state(p->pipe, p->fs);
+
+	pipe_resource_reference(&p->texture, NULL);
+	pipe_resource_reference(&p->linear, NULL);
+	pipe_resource_reference(&p->vbuf, NULL);
+
+	p->pipe->destroy(p->pipe);
+	p->screen->destroy(p->screen);
+	pipe_loader_release(&p->dev, 1);
+
+	FREE(p);
+}
+
+static void draw(struct program *p, struct pipe_resource *target)
+{
+	struct pipe_surface surf_tmpl;
+
+	memset(&surf_tmpl, 0, sizeof(surf_tmpl));
+	surf_tmpl.format = PIPE_FORMAT_B8G8R8A8_UNORM;
+	surf_tmpl.u.tex.level = 0;
+	surf_tmpl.u.tex.first_layer = 0;
+	surf_tmpl.u.tex.last_layer = 0;
+	p->framebuffer.cbufs[0] = p->pipe->create_surface(p->pipe, target, &surf_tmpl);
+
+	/* set the render target */
+	cso_set_framebuffer(p->cso, &p->framebuffer);
+
+	/* clear the render target */
+	p->pipe->clear(p->pipe, PIPE_CLEAR_COLOR, &p->clear_color, 0, 0);
+
+	/* set misc state we care about */
+	cso_set_blend(p->cso, &p->blend);
+	cso_set_depth_stencil_alpha(p->cso, &p->depthstencil);
+	cso_set_rasterizer(p->cso, &p->rasterizer);
+	cso_set_viewport(p->cso, &p->viewport);
+
+	/* shaders */
+	cso_set_fragment_shader_handle(p->cso, p->fs);
+	cso_set_vertex_shader_handle(p->cso, p->vs);
+
+	/* vertex element data */
+	cso_set_vertex_elements(p->cso, 2, p->velem);
+
+	util_draw_vertex_buffer(p->pipe, p->cso,
+	                        p->vbuf, 0, 0,
+	                        PIPE_PRIM_TRIANGLES,
+	                        3,  /* verts */
+	                        2); /* attribs/vert */
+
+	p->pipe->flush(p->pipe, NULL, 0);
+
+	pipe_surface_reference(&p->framebuffer.cbufs[0], NULL);
+}
+
+static boolean is_tiled(struct program *p, struct pipe_resource *target)
+{
+	struct pipe_transfer *transfer;
+	void *map;
+
+	/* tiled storage can't be handed out as a linear mapping */
+	map = pipe_transfer_map(p->pipe, target, 0, 0,
+	                        PIPE_TRANSFER_READ | PIPE_TRANSFER_MAP_DIRECTLY,
+	                        0, 0, WIDTH, HEIGHT, &transfer);
+	if (!map)
+		return TRUE;
+
+	pipe_transfer_unmap(p->pipe, transfer);
+	return FALSE;
+}
+
+static int check(struct program *p)
+{
+	struct pipe_transfer *linear_transfer, *texture_transfer;
+	uint8_t *linear_map, *texture_map;
+	uint32_t corner, center;
+	int bad_rows = 0;
+	int y;
+
+	if (is_tiled(p, p->linear)) {
+		printf("FAIL: the linear render target can't be mapped directly\n");
+		return 1;
+	}
+
+	if (!is_tiled(p, p->texture)) {
+		printf("FAIL: the sampler view and render target texture is linear\n");
+		return 1;
+	}
+
+	linear_map = pipe_transfer_map(p->pipe, p->linear, 0, 0, PIPE_TRANSFER_READ,
+	                               0, 0, WIDTH, HEIGHT, &linear_transfer);
+	texture_map = pipe_transfer_map(p->pipe, p->texture, 0, 0, PIPE_TRANSFER_READ,
+	                                0, 0, WIDTH, HEIGHT, &texture_transfer);
+
+	for (y = 0; y < HEIGHT; y++)
+		if (memcmp(linear_map + y * linear_transfer->stride,
+		           texture_map + y * texture_transfer->stride, WIDTH * 4))
+			bad_rows++;
+
+	corner = *(uint32_t *)texture_map;
+	center = *(uint32_t *)(texture_map + (HEIGHT / 2) * texture_transfer->stride + (WIDTH / 2) * 4);
+
+	pipe_transfer_unmap(p->pipe, texture_transfer);
+	pipe_transfer_unmap(p->pipe, linear_transfer);
+
+	if (bad_rows) {
+		printf("FAIL: %d of %d rows differ from the linear render target\n",
+		       bad_rows, HEIGHT);
+		return 1;
+	}
+
+	/* the corner keeps the clear color, the triangle center must not */
+	if (center == corner) {
+		printf("FAIL: triangle not rendered (0x%08x)\n", center);
+		return 1;
+	}
+
+	printf("PASS\n");
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	struct program *p;
+	int ret;
+
+	p = CALLOC_STRUCT(program);
+	init_prog(p);
+
+	draw(p, p->linear);
+	draw(p, p->texture);
+
+	ret = check(p);
+	close_prog(p);
+
+	return ret;
+}